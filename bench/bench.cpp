@@ -0,0 +1,402 @@
+// Ray casting benchmark for the BVH builders and the CPU traversal kernels.
+// Results go to stdout (or --output) as JSON, one run per line in a log makes regressions easy to track.
+//
+// bench.out [--scenes random,sphere,cornell] [--sizes 1000,10000,100000,1000000] [--mesh file.obj]...
+//           [--width 512] [--height 512] [--min-time 0.5] [--analysis-rays 16384] [--output bench.json]
+
+#include "mesh_generator.hpp"
+
+#include "../src/cpu_renderer/cpu_bvh.hpp"
+#include "../src/model/bvh.hpp"
+#include "../src/model/bvh_analysis.hpp"
+#include "../src/model/lbvh.hpp"
+#include "../src/scene/scene.hpp"
+
+#include <chrono>
+#include <cfloat>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace nugiEngine {
+	namespace {
+		struct BenchConfigInfo {
+			std::vector<std::string> scenes = { "random", "sphere", "cornell" };
+			std::vector<uint32_t> sizes = { 1000, 10000, 100000, 1000000 };
+			std::vector<std::string> meshPaths;
+
+			uint32_t width = 512;
+			uint32_t height = 512;
+			double minTime = 0.5;
+
+			// sampled rays of the tree quality analysis, the same set for every builder of a scene
+			uint32_t analysisRayCount = 16384;
+
+			std::string outputPath;
+		};
+
+		struct BvhBuilder {
+			const char* name;
+			std::function<std::vector<BvhNode>(const RayTraceModelData&)> build;
+		};
+
+		// every builder the engine has, each gets timed and traversed on every scene
+		std::vector<BvhBuilder> getBvhBuilders() {
+			return {
+				{ "median_split", [](const RayTraceModelData& data) {
+					std::vector<ObjectBoundBox> objects;
+					objects.reserve(data.objects.size());
+
+					for (int i = 0; i < static_cast<int>(data.objects.size()); i++) {
+						objects.push_back({i, data.objects[i]});
+					}
+
+					return createBvh(objects);
+				} },
+				{ "lbvh", [](const RayTraceModelData& data) {
+					return createLbvh(data.objects);
+				} },
+				{ "lbvh_treelet", [](const RayTraceModelData& data) {
+					LbvhConfigInfo configInfo{};
+					configInfo.treeletRounds = 3;
+
+					return createLbvh(data.objects, configInfo);
+				} }
+			};
+		}
+
+		struct RaySets {
+			std::vector<CpuRay> primary;
+			std::vector<CpuRay> diffuse;
+			std::vector<CpuRay> shadow;
+		};
+
+		std::vector<std::string> split(const std::string& text) {
+			std::vector<std::string> items;
+			std::stringstream stream{text};
+
+			for (std::string item; std::getline(stream, item, ',');) {
+				if (!item.empty()) {
+					items.emplace_back(item);
+				}
+			}
+
+			return items;
+		}
+
+		std::string escapeJson(const std::string& text) {
+			std::string escaped;
+			for (char character : text) {
+				if (character == '"' || character == '\\') {
+					escaped += '\\';
+				}
+
+				escaped += character;
+			}
+
+			return escaped;
+		}
+
+		double secondsSince(std::chrono::high_resolution_clock::time_point startTime) {
+			return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count();
+		}
+
+		// repeats trace until minTime has passed, returns millions of rays per second
+		double measureMraysPerSecond(size_t rayCount, double minTime, const std::function<uint32_t()>& trace) {
+			if (rayCount == 0) {
+				return 0.0;
+			}
+
+			static volatile uint32_t hitSink = 0;
+
+			// one untimed pass warms the caches
+			hitSink = hitSink + trace();
+
+			auto startTime = std::chrono::high_resolution_clock::now();
+			size_t passCount = 0;
+
+			do {
+				hitSink = hitSink + trace();
+				passCount++;
+			} while (secondsSince(startTime) < minTime);
+
+			return static_cast<double>(rayCount) * passCount / secondsSince(startTime) / 1e6;
+		}
+
+		RayTraceUbo createSceneCamera(const std::string& sceneName, const RayTraceModelData& data, uint32_t width, uint32_t height) {
+			if (sceneName == "cornell") {
+				return createCornellBoxCamera(width, height);
+			}
+
+			glm::vec3 minimum(FLT_MAX), maximum(-FLT_MAX);
+			for (auto &&object : data.objects) {
+				for (auto &&point : { object.triangle.point0, object.triangle.point1, object.triangle.point2 }) {
+					minimum = glm::min(minimum, point);
+					maximum = glm::max(maximum, point);
+				}
+			}
+
+			glm::vec3 center = (minimum + maximum) * 0.5f;
+			float radius = glm::length(maximum - minimum) * 0.5f;
+
+			return createCamera(center - glm::vec3(0.0f, 0.0f, radius * 2.5f), center, glm::vec3(0.0f, 1.0f, 0.0f), 40.0f, width, height);
+		}
+
+		// primary rays through the pixel centers, then a cosine distributed bounce and a shadow ray to the first light from every hit
+		RaySets createRaySets(const RayTraceModelData& data, const EngineCpuBvh& bvh, const RayTraceUbo& ubo, uint32_t width, uint32_t height) {
+			RaySets raySets;
+			raySets.primary.reserve(static_cast<size_t>(width) * height);
+
+			for (uint32_t y = 0; y < height; y++) {
+				for (uint32_t x = 0; x < width; x++) {
+					glm::vec2 uv = (glm::vec2(x, y) + glm::vec2(0.5f)) / glm::vec2(width, height);
+					raySets.primary.emplace_back(CpuRay{ ubo.origin, ubo.lowerLeftCorner + uv.x * ubo.horizontal - uv.y * ubo.vertical - ubo.origin });
+				}
+			}
+
+			std::mt19937 generator{7};
+			std::uniform_real_distribution<float> random{0.0f, 1.0f};
+
+			const Triangle &light = data.lights[0].triangle;
+
+			for (auto &&ray : raySets.primary) {
+				CpuHit hit = bvh.intersect(ray);
+				if (!hit.isHit()) {
+					continue;
+				}
+
+				const Triangle &triangle = data.objects[hit.objIndex].triangle;
+				glm::vec3 normal = glm::normalize(glm::cross(triangle.point1 - triangle.point0, triangle.point2 - triangle.point0));
+				if (glm::dot(normal, ray.direction) > 0.0f) {
+					normal = -normal;
+				}
+
+				glm::vec3 point = ray.origin + hit.t * ray.direction;
+
+				glm::vec3 a = std::abs(normal.x) > 0.9f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+				glm::vec3 tangent = glm::normalize(glm::cross(normal, a));
+				glm::vec3 bitangent = glm::cross(normal, tangent);
+
+				float r1 = random(generator), r2 = random(generator);
+				float phi = 2.0f * 3.14159265359f * r1;
+
+				glm::vec3 bounce = std::cos(phi) * std::sqrt(r2) * tangent + std::sin(phi) * std::sqrt(r2) * bitangent + std::sqrt(1.0f - r2) * normal;
+				raySets.diffuse.emplace_back(CpuRay{ point, bounce });
+
+				float u1 = random(generator), u2 = random(generator);
+				if (u1 + u2 > 1.0f) {
+					u1 = 1.0f - u1;
+					u2 = 1.0f - u2;
+				}
+
+				glm::vec3 lightPoint = light.point0 + u1 * (light.point1 - light.point0) + u2 * (light.point2 - light.point0);
+				raySets.shadow.emplace_back(CpuRay{ point, lightPoint - point, 0.001f, 0.999f });
+			}
+
+			return raySets;
+		}
+
+		uint32_t traceSingle(const EngineCpuBvh& bvh, const std::vector<CpuRay>& rays) {
+			uint32_t hitCount = 0;
+			for (auto &&ray : rays) {
+				hitCount += bvh.intersect(ray).isHit();
+			}
+
+			return hitCount;
+		}
+
+		uint32_t tracePackets(const EngineCpuBvh& bvh, const std::vector<CpuRay>& rays) {
+			uint32_t hitCount = 0;
+			CpuHit hits[8];
+
+			for (size_t first = 0; first + 8 <= rays.size(); first += 8) {
+				bvh.intersect8(&rays[first], hits);
+
+				for (auto &&hit : hits) {
+					hitCount += hit.isHit();
+				}
+			}
+
+			return hitCount;
+		}
+
+		uint32_t traceShadow(const EngineCpuBvh& bvh, const std::vector<CpuRay>& rays) {
+			uint32_t hitCount = 0;
+			for (auto &&ray : rays) {
+				hitCount += bvh.occluded(ray);
+			}
+
+			return hitCount;
+		}
+
+		void benchmarkScene(const BenchConfigInfo& configInfo, const std::string& sceneName, const RayTraceModelData& data, std::ostream& json) {
+			std::cerr << "bench: " << sceneName << ", " << data.objects.size() << " triangles" << std::endl;
+
+			json << "{\"scene\":\"" << escapeJson(sceneName) << "\",\"triangles\":" << data.objects.size() << ",\"builders\":[";
+
+			auto ubo = createSceneCamera(sceneName, data, configInfo.width, configInfo.height);
+			RaySets raySets;
+
+			auto builders = getBvhBuilders();
+			for (size_t builderIndex = 0; builderIndex < builders.size(); builderIndex++) {
+				auto buildStartTime = std::chrono::high_resolution_clock::now();
+				auto bvhNodes = builders[builderIndex].build(data);
+				double buildTime = secondsSince(buildStartTime);
+
+				auto collapseStartTime = std::chrono::high_resolution_clock::now();
+				EngineCpuBvh bvh{data.objects, bvhNodes};
+				double collapseTime = secondsSince(collapseStartTime);
+
+				BvhAnalysisConfigInfo analysisInfo{};
+				analysisInfo.sampledRayCount = configInfo.analysisRayCount;
+
+				auto statistics = analyzeBvh(bvhNodes, data.objects, analysisInfo);
+
+				// the rays only depend on the scene, any correct BVH produces the same set
+				if (builderIndex == 0) {
+					raySets = createRaySets(data, bvh, ubo, configInfo.width, configInfo.height);
+				}
+
+				json << (builderIndex > 0 ? "," : "") << "{\"name\":\"" << builders[builderIndex].name << "\""
+					<< ",\"build_ms\":" << buildTime * 1e3 << ",\"nodes\":" << bvhNodes.size()
+					<< ",\"bvh8_collapse_ms\":" << collapseTime * 1e3 << ",\"bvh8_nodes\":" << bvh.getNodes().size()
+					<< ",\"quality\":";
+
+				statistics.writeJson(json);
+				json << ",\"traversal\":[";
+
+				bool isFirstIsa = true;
+				for (CpuIsa isa : { CpuIsa::Scalar, CpuIsa::SSE, CpuIsa::AVX2, CpuIsa::AVX512 }) {
+					if (!EngineCpuBvh::isIsaSupported(isa)) {
+						continue;
+					}
+
+					bvh.setIsa(isa);
+
+					double primarySingle = measureMraysPerSecond(raySets.primary.size(), configInfo.minTime, [&]() { return traceSingle(bvh, raySets.primary); });
+					double primaryPacket = measureMraysPerSecond(raySets.primary.size() / 8 * 8, configInfo.minTime, [&]() { return tracePackets(bvh, raySets.primary); });
+					double diffuseSingle = measureMraysPerSecond(raySets.diffuse.size(), configInfo.minTime, [&]() { return traceSingle(bvh, raySets.diffuse); });
+					double diffusePacket = measureMraysPerSecond(raySets.diffuse.size() / 8 * 8, configInfo.minTime, [&]() { return tracePackets(bvh, raySets.diffuse); });
+					double shadow = measureMraysPerSecond(raySets.shadow.size(), configInfo.minTime, [&]() { return traceShadow(bvh, raySets.shadow); });
+
+					json << (isFirstIsa ? "" : ",") << "{\"isa\":\"" << EngineCpuBvh::getIsaName(isa) << "\""
+						<< ",\"primary_mrays\":" << primarySingle << ",\"primary_packet8_mrays\":" << primaryPacket
+						<< ",\"diffuse_mrays\":" << diffuseSingle << ",\"diffuse_packet8_mrays\":" << diffusePacket
+						<< ",\"shadow_mrays\":" << shadow << "}";
+
+					isFirstIsa = false;
+				}
+
+				json << "]}";
+			}
+
+			json << "],\"rays\":{\"primary\":" << raySets.primary.size() << ",\"diffuse\":" << raySets.diffuse.size()
+				<< ",\"shadow\":" << raySets.shadow.size() << "}}";
+		}
+
+		BenchConfigInfo parseArguments(int argc, char const *argv[]) {
+			BenchConfigInfo configInfo{};
+
+			for (int i = 1; i < argc; i++) {
+				std::string argument = argv[i];
+				if (i + 1 >= argc) {
+					throw std::invalid_argument("missing value for " + argument);
+				}
+
+				std::string value = argv[++i];
+
+				if (argument == "--scenes") {
+					configInfo.scenes = split(value);
+				} else if (argument == "--sizes") {
+					configInfo.sizes.clear();
+					for (auto &&size : split(value)) {
+						configInfo.sizes.emplace_back(static_cast<uint32_t>(std::stoul(size)));
+					}
+				} else if (argument == "--mesh") {
+					configInfo.meshPaths.emplace_back(value);
+				} else if (argument == "--width") {
+					configInfo.width = static_cast<uint32_t>(std::stoul(value));
+				} else if (argument == "--height") {
+					configInfo.height = static_cast<uint32_t>(std::stoul(value));
+				} else if (argument == "--min-time") {
+					configInfo.minTime = std::stod(value);
+				} else if (argument == "--analysis-rays") {
+					configInfo.analysisRayCount = static_cast<uint32_t>(std::stoul(value));
+				} else if (argument == "--output") {
+					configInfo.outputPath = value;
+				} else {
+					throw std::invalid_argument("unknown argument: " + argument);
+				}
+			}
+
+			return configInfo;
+		}
+	}
+} // namespace nugiEngine
+
+int main(int argc, char const *argv[])
+{
+	using namespace nugiEngine;
+
+	try {
+		BenchConfigInfo configInfo = parseArguments(argc, argv);
+
+		std::ostringstream json;
+		json << "{\"version\":1,\"timestamp\":" << std::time(nullptr) << ",\"width\":" << configInfo.width << ",\"height\":" << configInfo.height
+			<< ",\"detected_isa\":\"" << EngineCpuBvh::getIsaName(EngineCpuBvh::detectIsa()) << "\",\"results\":[";
+
+		bool isFirstScene = true;
+
+		for (auto &&sceneName : configInfo.scenes) {
+			for (uint32_t size : configInfo.sizes) {
+				RayTraceModelData data;
+
+				if (sceneName == "random") {
+					data = generateRandomTriangles(size);
+				} else if (sceneName == "sphere") {
+					data = generateSphere(size);
+				} else if (sceneName == "cornell") {
+					data = generateCornellBox(size);
+				} else {
+					throw std::invalid_argument("unknown scene: " + sceneName);
+				}
+
+				json << (isFirstScene ? "" : ",");
+				benchmarkScene(configInfo, sceneName, data, json);
+				isFirstScene = false;
+			}
+		}
+
+		for (auto &&meshPath : configInfo.meshPaths) {
+			json << (isFirstScene ? "" : ",");
+			benchmarkScene(configInfo, meshPath, loadObjMesh(meshPath), json);
+			isFirstScene = false;
+		}
+
+		json << "]}\n";
+
+		if (configInfo.outputPath.empty()) {
+			std::cout << json.str();
+		} else {
+			std::ofstream file{configInfo.outputPath, std::ios::trunc};
+			file << json.str();
+
+			if (!file) {
+				throw std::runtime_error("failed to write " + configInfo.outputPath);
+			}
+		}
+	} catch (const std::exception &e) {
+		std::cerr << e.what() << "\n";
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
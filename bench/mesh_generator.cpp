@@ -0,0 +1,151 @@
+#include "mesh_generator.hpp"
+
+#include "../src/scene/scene.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <tiny_obj_loader.h>
+
+namespace nugiEngine {
+	namespace {
+		void addDefaultMaterialAndLight(RayTraceModelData& data) {
+			data.materials.emplace_back(Material{ glm::vec3(0.8f, 0.8f, 0.8f), 0.2f, 0.1f, 0.5f });
+
+			glm::vec3 minimum(FLT_MAX), maximum(-FLT_MAX);
+			for (auto &&object : data.objects) {
+				for (auto &&point : { object.triangle.point0, object.triangle.point1, object.triangle.point2 }) {
+					minimum = glm::min(minimum, point);
+					maximum = glm::max(maximum, point);
+				}
+			}
+
+			glm::vec3 center = (minimum + maximum) * 0.5f;
+			glm::vec3 extent = (maximum - minimum) * 0.25f;
+			float height = maximum.y + (maximum.y - minimum.y) * 0.1f + 1.0f;
+
+			data.lights.emplace_back(Light{ Triangle{ glm::vec3{center.x - extent.x, height, center.z - extent.z}, 
+				glm::vec3{center.x + extent.x, height, center.z - extent.z}, glm::vec3{center.x + extent.x, height, center.z + extent.z} }, 
+				glm::vec3(10.0f, 10.0f, 10.0f), 100.0f });
+		}
+	}
+
+	RayTraceModelData generateRandomTriangles(uint32_t triangleCount, uint32_t seed) {
+		RayTraceModelData data{};
+		data.objects.reserve(triangleCount);
+
+		std::mt19937 generator{seed};
+		std::uniform_real_distribution<float> position{0.0f, 555.0f};
+
+		// sized so the triangles cover the volume about once whatever their count
+		float size = 555.0f / std::cbrt(static_cast<float>(triangleCount));
+		std::uniform_real_distribution<float> offset{-size, size};
+
+		for (uint32_t i = 0; i < triangleCount; i++) {
+			glm::vec3 center{ position(generator), position(generator), position(generator) };
+
+			data.objects.emplace_back(Object{ Triangle{ 
+				center + glm::vec3{ offset(generator), offset(generator), offset(generator) },
+				center + glm::vec3{ offset(generator), offset(generator), offset(generator) },
+				center + glm::vec3{ offset(generator), offset(generator), offset(generator) } }, 1, 0 });
+		}
+
+		addDefaultMaterialAndLight(data);
+		return data;
+	}
+
+	RayTraceModelData generateSphere(uint32_t triangleCount) {
+		RayTraceModelData data{};
+
+		uint32_t stackCount = std::max(2u, static_cast<uint32_t>(std::sqrt(triangleCount / 4.0f)));
+		uint32_t sliceCount = std::max(3u, triangleCount / (2 * stackCount));
+
+		const glm::vec3 center{ 278.0f, 278.0f, 278.0f };
+		const float radius = 200.0f;
+		const float pi = 3.14159265359f;
+
+		auto pointAt = [&](uint32_t stack, uint32_t slice) {
+			float theta = pi * static_cast<float>(stack) / static_cast<float>(stackCount);
+			float phi = 2.0f * pi * static_cast<float>(slice) / static_cast<float>(sliceCount);
+
+			return center + radius * glm::vec3{ std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) };
+		};
+
+		data.objects.reserve(2 * stackCount * sliceCount);
+
+		for (uint32_t stack = 0; stack < stackCount; stack++) {
+			for (uint32_t slice = 0; slice < sliceCount; slice++) {
+				glm::vec3 p00 = pointAt(stack, slice), p01 = pointAt(stack, slice + 1);
+				glm::vec3 p10 = pointAt(stack + 1, slice), p11 = pointAt(stack + 1, slice + 1);
+
+				data.objects.emplace_back(Object{ Triangle{ p00, p10, p11 }, 1, 0 });
+				data.objects.emplace_back(Object{ Triangle{ p11, p01, p00 }, 1, 0 });
+			}
+		}
+
+		addDefaultMaterialAndLight(data);
+		return data;
+	}
+
+	RayTraceModelData generateCornellBox(uint32_t triangleCount) {
+		RayTraceModelData data = createCornellBoxScene();
+
+		while (data.objects.size() < triangleCount) {
+			std::vector<Object> subdivided;
+			subdivided.reserve(data.objects.size() * 4);
+
+			for (auto &&object : data.objects) {
+				const Triangle &t = object.triangle;
+
+				glm::vec3 m01 = (t.point0 + t.point1) * 0.5f;
+				glm::vec3 m12 = (t.point1 + t.point2) * 0.5f;
+				glm::vec3 m20 = (t.point2 + t.point0) * 0.5f;
+
+				subdivided.emplace_back(Object{ Triangle{ t.point0, m01, m20 }, object.materialType, object.materialIndex });
+				subdivided.emplace_back(Object{ Triangle{ m01, t.point1, m12 }, object.materialType, object.materialIndex });
+				subdivided.emplace_back(Object{ Triangle{ m20, m12, t.point2 }, object.materialType, object.materialIndex });
+				subdivided.emplace_back(Object{ Triangle{ m01, m12, m20 }, object.materialType, object.materialIndex });
+			}
+
+			data.objects = std::move(subdivided);
+		}
+
+		return data;
+	}
+
+	RayTraceModelData loadObjMesh(const std::string& filePath) {
+		tinyobj::attrib_t attrib;
+		std::vector<tinyobj::shape_t> shapes;
+		std::vector<tinyobj::material_t> materials;
+		std::string warn, err;
+
+		if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filePath.c_str())) {
+			throw std::runtime_error(warn + err);
+		}
+
+		RayTraceModelData data{};
+
+		auto vertexAt = [&](const tinyobj::index_t& index) {
+			return glm::vec3{ attrib.vertices[3 * index.vertex_index + 0], attrib.vertices[3 * index.vertex_index + 1], 
+				attrib.vertices[3 * index.vertex_index + 2] };
+		};
+
+		for (auto &&shape : shapes) {
+			for (size_t i = 0; i + 2 < shape.mesh.indices.size(); i += 3) {
+				data.objects.emplace_back(Object{ Triangle{ vertexAt(shape.mesh.indices[i]), vertexAt(shape.mesh.indices[i + 1]), 
+					vertexAt(shape.mesh.indices[i + 2]) }, 1, 0 });
+			}
+		}
+
+		if (data.objects.empty()) {
+			throw std::runtime_error("no triangles in " + filePath);
+		}
+
+		addDefaultMaterialAndLight(data);
+		return data;
+	}
+} // namespace nugiEngine
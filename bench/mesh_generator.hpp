@@ -0,0 +1,22 @@
+#pragma once
+
+#include "../src/model/ray_trace_model_data.hpp"
+
+#include <cstdint>
+#include <string>
+
+namespace nugiEngine {
+	// procedural scenes for the benchmarks, each has one material and at least one light above the geometry
+
+	// uniformly scattered small triangles filling the Cornell box volume, the worst case for a median split
+	RayTraceModelData generateRandomTriangles(uint32_t triangleCount, uint32_t seed = 1);
+
+	// a UV sphere, long thin triangles near the poles
+	RayTraceModelData generateSphere(uint32_t triangleCount);
+
+	// the app's Cornell box with every triangle subdivided until the scene has at least triangleCount triangles
+	RayTraceModelData generateCornellBox(uint32_t triangleCount);
+
+	// every face of an OBJ file, triangulated by tinyobj
+	RayTraceModelData loadObjMesh(const std::string& filePath);
+} // namespace nugiEngine
@@ -1,2 +1,2 @@
-glslc src/shader/ray_trace_weekend.comp -o bin/shader/ray_trace_weekend.comp.spv
-glslc src/shader/ray_trace_sampling.frag -o bin/shader/ray_trace_sampling.frag.spv
+# compiles every shader and variant into bin/shader and embeds them into src/shader_library/embedded_shaders.inc
+python3 tools/embed_shaders.py "$@"
@@ -1,15 +1,75 @@
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <stdexcept>
+#include <string>
 
 #include "src/app/app.hpp"
+#include "src/app/cpu_app.hpp"
+
+// --cpu [--width N] [--height N] [--samples N] [--frames N] [--threads N] [--output file.ppm] [--measure-traversal]
+// renders on the CPU without opening a window, for machines without a Vulkan device.
+// --gpu-bvh builds the BVH of the Vulkan renderer with compute shaders instead of on the CPU.
+// --scene-cache file loads the scene of the Vulkan renderer from a scene cache, written on the first run.
+// --memory-stats prints the device memory blocks of the Vulkan renderer once the scene is loaded
+static bool parseCpuArguments(int argc, char const *argv[], nugiEngine::CpuAppConfigInfo &configInfo, bool &isBuildingBvhOnGpu, std::string &sceneCachePath,
+    bool &isPrintingMemoryStatistics) {
+    bool isCpu = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (argument == "--cpu") {
+            isCpu = true;
+        } else if (argument == "--width" && hasValue) {
+            configInfo.width = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (argument == "--height" && hasValue) {
+            configInfo.height = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (argument == "--samples" && hasValue) {
+            configInfo.nSample = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (argument == "--frames" && hasValue) {
+            configInfo.nFrame = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (argument == "--threads" && hasValue) {
+            configInfo.threadCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (argument == "--output" && hasValue) {
+            configInfo.outputPath = argv[++i];
+        } else if (argument == "--measure-traversal") {
+            configInfo.isMeasuringTraversal = true;
+        } else if (argument == "--gpu-bvh") {
+            isBuildingBvhOnGpu = true;
+        } else if (argument == "--scene-cache" && hasValue) {
+            sceneCachePath = argv[++i];
+        } else if (argument == "--memory-stats") {
+            isPrintingMemoryStatistics = true;
+        } else {
+            throw std::invalid_argument("unknown argument: " + argument);
+        }
+    }
+
+    return isCpu;
+}
 
 int main(int argc, char const *argv[])
 {
-    nugiEngine::EngineApp app{};
-
     try {
-        app.run();
+        nugiEngine::CpuAppConfigInfo cpuConfigInfo{};
+        cpuConfigInfo.framesPerSeed = nugiEngine::EngineDevice::MAX_FRAMES_IN_FLIGHT;
+        bool isBuildingBvhOnGpu = false;
+        std::string sceneCachePath;
+        bool isPrintingMemoryStatistics = false;
+
+        if (parseCpuArguments(argc, argv, cpuConfigInfo, isBuildingBvhOnGpu, sceneCachePath, isPrintingMemoryStatistics)) {
+            nugiEngine::EngineCpuApp cpuApp{cpuConfigInfo};
+            cpuApp.run();
+        } else {
+            if (isBuildingBvhOnGpu && !sceneCachePath.empty()) {
+                throw std::invalid_argument("--scene-cache stores the CPU built BVH and can't be combined with --gpu-bvh");
+            }
+
+            nugiEngine::EngineApp app{isBuildingBvhOnGpu, sceneCachePath, isPrintingMemoryStatistics};
+            app.run();
+        }
     } catch(const std::exception &e) {
         std::cerr << e.what() << "\n";
         return EXIT_FAILURE;
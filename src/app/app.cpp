@@ -4,7 +4,9 @@
 #include "../mouse_controller/mouse_controller.hpp"
 #include "../keyboard_controller/keyboard_controller.hpp"
 #include "../buffer/buffer.hpp"
+#include "../upload_service/upload_service.hpp"
 #include "../frame_info.hpp"
+#include "../scene/scene.hpp"
 
 
 #define GLM_FORCE_RADIANS
@@ -21,18 +23,40 @@
 #include <thread>
 
 namespace nugiEngine {
-	EngineApp::EngineApp() {
+	EngineApp::EngineApp(bool isBuildingBvhOnGpu, const std::string &sceneCachePath, bool isPrintingMemoryStatistics) {
 		this->renderer = std::make_unique<EngineHybridRenderer>(this->window, this->device);
 
-		this->loadObjects();
+		this->loadObjects(isBuildingBvhOnGpu, sceneCachePath);
 		this->loadQuadModels();
+
+		// the upload thread batches every upload of the scene that is pending, they all have to land before the first frame
+		this->device.getUploadService()->waitIdle();
+
 		this->recreateSubRendererAndSubsystem();
+
+		// every pipeline has been compiled by now, keep them on disk even if this run does not exit cleanly
+		this->device.savePipelineCache();
+
+		if (isPrintingMemoryStatistics) {
+			this->device.getMemoryAllocator()->printStatistics(std::cout);
+		}
+
+		#ifndef NDEBUG
+			this->watchShaders();
+		#endif
 	}
 
 	EngineApp::~EngineApp() {}
 
 	void EngineApp::renderLoop() {
 		while (this->isRendering) {
+			// a frame boundary, no command buffer is being recorded
+			if (this->shaderManager != nullptr && this->shaderManager->applyReloads() && this->isReplayingCommands) {
+				// the recorded command buffers still bind the old pipelines
+				this->renderer->getFrameScheduler()->waitIdle();
+				this->recordCommandBuffers();
+			}
+
 			if (this->renderer->acquireFrame()) {
 				uint32_t frameIndex = this->renderer->getFrameIndex();
 				uint32_t imageIndex = this->renderer->getImageIndex();				
@@ -42,20 +66,28 @@ namespace nugiEngine {
 					this->traceRayRender->isFrameUpdated[frameIndex] = true;
 				}
 
-				auto commandBuffer = this->renderer->beginCommand();
-				this->traceRayRender->prepareFrame(commandBuffer, frameIndex);
-
-				this->traceRayRender->render(commandBuffer, frameIndex, this->randomSeed);
-				this->traceRayRender->transferFrame(commandBuffer, frameIndex);
-				
-				this->swapChainSubRenderer->beginRenderPass(commandBuffer, imageIndex);
-				this->samplingRayRender->render(commandBuffer, frameIndex, this->quadModels, this->randomSeed);
-				this->swapChainSubRenderer->endRenderPass(commandBuffer);
+				this->traceRayRender->writeRandomSeed(frameIndex, this->randomSeed);
 
-				this->traceRayRender->finishFrame(commandBuffer, frameIndex);				
+				if (this->models->isBvhBuildPending()) {
+					this->submitBvhBuild();
+				}
 
-				this->renderer->endCommand(commandBuffer);
-				this->renderer->submitCommand(commandBuffer);
+				if (this->isReplayingCommands) {
+					uint32_t imageCount = static_cast<uint32_t>(this->renderer->getSwapChain()->imageCount());
+
+					this->renderer->submitComputeCommand(this->traceCommandBuffers[frameIndex]);
+					this->renderer->submitCommand(this->samplingCommandBuffers[frameIndex * imageCount + imageIndex]);
+				} else {
+					auto computeCommandBuffer = this->renderer->beginComputeCommand();
+					this->recordTraceCommand(computeCommandBuffer, frameIndex);
+					this->renderer->endCommand(computeCommandBuffer);
+					this->renderer->submitComputeCommand(computeCommandBuffer);
+
+					auto commandBuffer = this->renderer->beginCommand();
+					this->recordSamplingCommand(commandBuffer, frameIndex, imageIndex);
+					this->renderer->endCommand(commandBuffer);
+					this->renderer->submitCommand(commandBuffer);
+				}
 
 				if (!this->renderer->presentFrame()) {
 					this->recreateSubRendererAndSubsystem();
@@ -71,6 +103,60 @@ namespace nugiEngine {
 		}
 	}
 
+	void EngineApp::recordTraceCommand(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex) {
+		this->traceRayRender->prepareFrame(commandBuffer, frameIndex);
+		this->traceRayRender->render(commandBuffer, frameIndex);
+		this->traceRayRender->transferFrame(commandBuffer, frameIndex);
+	}
+
+	void EngineApp::recordSamplingCommand(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex, uint32_t imageIndex) {
+		this->traceRayRender->receiveFrame(commandBuffer, frameIndex);
+		
+		this->swapChainSubRenderer->beginRenderPass(commandBuffer, imageIndex);
+		this->samplingRayRender->render(commandBuffer, frameIndex, this->quadModels);
+		this->swapChainSubRenderer->endRenderPass(commandBuffer);
+
+		this->traceRayRender->finishFrame(commandBuffer, frameIndex);
+	}
+
+	void EngineApp::submitBvhBuild() {
+		// a command buffer of its own, so the replayed trace command buffers stay as they were recorded
+		auto commandBuffer = std::make_shared<EngineCommandBuffer>(this->device, this->device.getComputeCommandPool());
+		commandBuffer->beginSingleTimeCommand();
+		this->models->recordBvhBuild(commandBuffer);
+		commandBuffer->endCommand();
+
+		// the trace dispatch follows on the same compute queue, behind the barrier the build ends with
+		this->renderer->submitComputeCommand(commandBuffer);
+		this->renderer->getFrameScheduler()->deferDestroy([commandBuffer]() {});
+	}
+
+	void EngineApp::recordCommandBuffers() {
+		// only the random seed changes between frames and it is read from a mapped buffer,
+		// so every frame in flight / swap chain image pair can be recorded once and resubmitted as is
+		uint32_t imageCount = static_cast<uint32_t>(this->renderer->getSwapChain()->imageCount());
+
+		this->traceCommandBuffers = EngineCommandBuffer::createCommandBuffers(this->device, EngineDevice::MAX_FRAMES_IN_FLIGHT, 
+			this->device.getComputeCommandPool());
+		this->samplingCommandBuffers = EngineCommandBuffer::createCommandBuffers(this->device, EngineDevice::MAX_FRAMES_IN_FLIGHT * imageCount);
+
+		for (uint32_t frameIndex = 0; frameIndex < EngineDevice::MAX_FRAMES_IN_FLIGHT; frameIndex++) {
+			auto traceCommandBuffer = this->traceCommandBuffers[frameIndex];
+
+			traceCommandBuffer->beginReccuringCommand();
+			this->recordTraceCommand(traceCommandBuffer, frameIndex);
+			traceCommandBuffer->endCommand();
+
+			for (uint32_t imageIndex = 0; imageIndex < imageCount; imageIndex++) {
+				auto samplingCommandBuffer = this->samplingCommandBuffers[frameIndex * imageCount + imageIndex];
+
+				samplingCommandBuffer->beginReccuringCommand();
+				this->recordSamplingCommand(samplingCommandBuffer, frameIndex, imageIndex);
+				samplingCommandBuffer->endCommand();
+			}
+		}
+	}
+
 	void EngineApp::run() {
 		auto currentTime = std::chrono::high_resolution_clock::now();
 		uint32_t t = 0;
@@ -103,78 +189,18 @@ namespace nugiEngine {
 		this->isRendering = false;
 		renderThread.join();
 
-		vkDeviceWaitIdle(this->device.getLogicalDevice());
+		this->device.waitIdle();
 	}
 
-	void EngineApp::loadObjects() {
-		RayTraceModelData modeldata{};
-
-		modeldata.objects.emplace_back(Object{ Triangle{ glm::vec3{555.0f, 0.0f, 0.0f}, glm::vec3{555.0f, 555.0f, 0.0f}, glm::vec3{555.0f, 555.0f, 555.0f} }, 1, 1 });
-		modeldata.objects.emplace_back(Object{ Triangle{ glm::vec3{555.0f, 555.0f, 555.0f}, glm::vec3{555.0f, 0.0f, 555.0f}, glm::vec3{555.0f, 0.0f, 0.0f} }, 1, 1 });
-
-		modeldata.objects.emplace_back(Object{ Triangle{ glm::vec3{0.0f, 0.0f, 0.0f}, glm::vec3{0.0f, 555.0f, 0.0f}, glm::vec3{0.0f, 555.0f, 555.0f} }, 1, 2});
-		modeldata.objects.emplace_back(Object{ Triangle{ glm::vec3{0.0f, 555.0f, 555.0f}, glm::vec3{0.0f, 0.0f, 555.0f}, glm::vec3{0.0f, 0.0f, 0.0f} } , 1, 2 }); 
-
-		modeldata.objects.emplace_back(Object{ Triangle{ glm::vec3{0.0f, 0.0f, 0.0f}, glm::vec3{555.0f, 0.0f, 0.0f}, glm::vec3{555.0f, 0.0f, 555.0f} }  , 1, 0 });
-		modeldata.objects.emplace_back(Object{ Triangle{ glm::vec3{555.0f, 0.0f, 555.0f}, glm::vec3{0.0f, 0.0f, 555.0f}, glm::vec3{0.0f, 0.0f, 0.0f} } , 1, 0 }); 
-
-		modeldata.objects.emplace_back(Object{ Triangle{ glm::vec3{0.0f, 555.0f, 0.0f,}, glm::vec3{555.0f, 555.0f, 0.0f}, glm::vec3{555.0f, 555.0f, 555.0f} }, 1, 0 });
-		modeldata.objects.emplace_back(Object{ Triangle{ glm::vec3{555.0f, 555.0f, 555.0f}, glm::vec3{0.0f, 555.0f, 555.0f}, glm::vec3{0.0f, 555.0f, 0.0f} }, 1, 0 });  
+	void EngineApp::loadObjects(bool isBuildingBvhOnGpu, const std::string &sceneCachePath) {
+		RayTraceModelData modeldata = createCornellBoxScene();
 
-		modeldata.objects.emplace_back(Object{ Triangle{ glm::vec3{0.0f, 0.0f, 555.0f}, glm::vec3{0.0f, 555.0f, 555.0f}, glm::vec3{555.0f, 555.0f, 555.0f} }, 1, 0 });
-		modeldata.objects.emplace_back(Object{ Triangle{ glm::vec3{555.0f, 555.0f, 555.0f}, glm::vec3{555.0f, 0.0f, 555.0f}, glm::vec3{0.0f, 0.0f, 555.0f} }, 1, 0 });
-
-		// ----------------------------------------------------------------------------
-
-		modeldata.objects.emplace_back(Object{ Triangle{ glm::vec3{265.0f, 0.0f, 295.0f}, glm::vec3{430.0f, 0.0f, 295.0f}, glm::vec3{430.0f, 330.0f, 295.0f} }, 2, 3 });
-		modeldata.objects.emplace_back(Object{ Triangle{ glm::vec3{430.0f, 330.0f, 295.0f}, glm::vec3{265.0f, 330.0f, 295.0f}, glm::vec3{265.0f, 0.0f, 295.0f} }, 2, 3 });
-
-		modeldata.objects.emplace_back(Object{ Triangle{ glm::vec3{430.0f, 0.0f, 295.0f}, glm::vec3{430.0f, 0.0f, 460.0f}, glm::vec3{430.0f, 330.0f, 460.0f} }, 2, 3 });
-		modeldata.objects.emplace_back(Object{ Triangle{ glm::vec3{430.0f, 330.0f, 460.0f}, glm::vec3{430.0f, 330.0f, 295.0f}, glm::vec3{430.0f, 0.0f, 295.0f} } , 2, 3 });
-
-		modeldata.objects.emplace_back(Object{ Triangle{ glm::vec3{430.0f, 0.0f, 460.0f}, glm::vec3{265.0f, 0.0f, 460.0f}, glm::vec3{265.0f, 330.0f, 460.0f} }, 2, 3 });
-		modeldata.objects.emplace_back(Object{ Triangle{ glm::vec3{265.0f, 330.0f, 460.0f}, glm::vec3{430.0f, 330.0f, 460.0f}, glm::vec3{430.0f, 0.0f, 460.0f} }, 2, 3 });
-
-		modeldata.objects.emplace_back(Object{ Triangle{ glm::vec3{265.0f, 0.0f, 460.0f}, glm::vec3{265.0f, 0.0f, 295.0f}, glm::vec3{265.0f, 330.0f, 295.0f} }, 2, 3 });
-		modeldata.objects.emplace_back(Object{ Triangle{ glm::vec3{265.0f, 330.0f, 295.0f}, glm::vec3{265.0f, 330.0f, 460.0f}, glm::vec3{265.0f, 0.0f, 460.0f} }, 2, 3 });
-
-		modeldata.objects.emplace_back(Object{ Triangle{ glm::vec3{265.0f, 0.0f, 295.0f}, glm::vec3{430.0f, 0.0f, 295.0f}, glm::vec3{430.0f, 0.0f, 460.0f} }, 2, 3 });
-		modeldata.objects.emplace_back(Object{ Triangle{ glm::vec3{430.0f, 0.0f, 460.0f}, glm::vec3{265.0f, 0.0f, 460.0f}, glm::vec3{265.0f, 0.0f, 295.0f} }, 2, 3 });
-
-		modeldata.objects.emplace_back(Object{ Triangle{ glm::vec3{265.0f, 330.0f, 295.0f}, glm::vec3{430.0f, 330.0f, 295.0f}, glm::vec3{430.0f, 330.0f, 460.0f} }, 2, 3 });
-		modeldata.objects.emplace_back(Object{ Triangle{ glm::vec3{430.0f, 330.0f, 460.0f}, glm::vec3{265.0f, 330.0f, 460.0f}, glm::vec3{265.0f, 330.0f, 295.0f} }, 2, 3 });
-
-		// ----------------------------------------------------------------------------
-
-		modeldata.objects.emplace_back(Object{ Triangle{ glm::vec3{130.0f, 0.0f, 65.0f}, glm::vec3{295.0f, 0.0f, 65.0f}, glm::vec3{295.0f, 165.0f, 65.0f} }, 1, 0 });
-		modeldata.objects.emplace_back(Object{ Triangle{ glm::vec3{295.0f, 165.0f, 65.0f}, glm::vec3{130.0f, 165.0f, 65.0f}, glm::vec3{130.0f, 0.0f, 65.0f} }, 1, 0 });
-
-		modeldata.objects.emplace_back(Object{ Triangle{ glm::vec3{295.0f, 0.0f, 65.0f}, glm::vec3{295.0f, 0.0f, 230.0f}, glm::vec3{295.0f, 165.0f, 230.0f} }, 1, 0 });
-		modeldata.objects.emplace_back(Object{ Triangle{ glm::vec3{295.0f, 165.0f, 230.0f}, glm::vec3{295.0f, 165.0f, 65.0f}, glm::vec3{295.0f, 0.0f, 65.0f} } , 1, 0 });
-
-		modeldata.objects.emplace_back(Object{ Triangle{ glm::vec3{295.0f, 0.0f, 230.0f}, glm::vec3{130.0f, 0.0f, 230.0f}, glm::vec3{130.0f, 165.0f, 230.0f} }, 1, 0 });
-		modeldata.objects.emplace_back(Object{ Triangle{ glm::vec3{130.0f, 165.0f, 230.0f}, glm::vec3{295.0f, 165.0f, 230.0f}, glm::vec3{295.0f, 0.0f, 230.0f} }, 1, 0 });
-
-		modeldata.objects.emplace_back(Object{ Triangle{ glm::vec3{130.0f, 0.0f, 230.0f}, glm::vec3{130.0f, 0.0f, 65.0f}, glm::vec3{130.0f, 165.0f, 65.0f} }, 1, 0 });
-		modeldata.objects.emplace_back(Object{ Triangle{ glm::vec3{130.0f, 165.0f, 65.0f}, glm::vec3{130.0f, 165.0f, 230.0f}, glm::vec3{130.0f, 0.0f, 230.0f} }, 1, 0 });
-
-		modeldata.objects.emplace_back(Object{ Triangle{ glm::vec3{130.0f, 0.0f, 65.0f}, glm::vec3{295.0f, 0.0f, 65.0f}, glm::vec3{295.0f, 0.0f, 230.0f} }, 1, 0 });
-		modeldata.objects.emplace_back(Object{ Triangle{ glm::vec3{295.0f, 0.0f, 230.0f}, glm::vec3{130.0f, 0.0f, 230.0f}, glm::vec3{130.0f, 0.0f, 65.0f} }, 1, 0 });
-
-		modeldata.objects.emplace_back(Object{ Triangle{ glm::vec3{130.0f, 165.0f, 65.0f}, glm::vec3{295.0f, 165.0f, 65.0f}, glm::vec3{295.0f, 165.0f, 230.0f} }, 1, 0 });
-		modeldata.objects.emplace_back(Object{ Triangle{ glm::vec3{295.0f, 165.0f, 230.0f}, glm::vec3{130, 165.0f, 230.0f}, glm::vec3{130.0f, 165.0f, 65.0f} }, 1, 0 });
-
-		// ----------------------------------------------------------------------------
-
-		modeldata.materials.emplace_back(Material{ glm::vec3(1.0f, 1.0f, 1.0f), 0.2f, 0.1f, 0.5f });
-		modeldata.materials.emplace_back(Material{ glm::vec3(0.05f, 0.65f, 0.05f), 0.2f, 0.1f, 0.5f });
-		modeldata.materials.emplace_back(Material{ glm::vec3(0.65f, 0.05f, 0.05f), 0.2f, 0.1f, 0.5f });
-		modeldata.materials.emplace_back(Material{ glm::vec3(1.0f, 1.0f, 1.0f), 0.2f, 0.1f, 0.5f });
-
-		modeldata.lights.emplace_back(Light{ Triangle{ glm::vec3{213.0f, 554.0f, 227.0f}, glm::vec3{343.0f, 554.0f, 227.0f}, glm::vec3{343.0f, 554.0f, 332.0f} }, glm::vec3(10.0f, 10.0f, 10.0f), 100.f} );
-		modeldata.lights.emplace_back(Light{ Triangle{ glm::vec3{343.0f, 554.0f, 332.0f}, glm::vec3{213.0f, 554.0f, 332.0f}, glm::vec3{213.0f, 554.0f, 227.0f} }, glm::vec3(10.0f, 10.0f, 10.0f), 100.f} );
+		if (!sceneCachePath.empty()) {
+			this->models = EngineRayTraceModel::createModelWithCache(this->device, modeldata, sceneCachePath);
+			return;
+		}
 
-		this->models = std::make_unique<EngineRayTraceModel>(this->device, modeldata);
+		this->models = std::make_unique<EngineRayTraceModel>(this->device, modeldata, isBuildingBvhOnGpu);
 	}
 
 	void EngineApp::loadQuadModels() {
@@ -203,31 +229,24 @@ namespace nugiEngine {
 	}
 
 	RayTraceUbo EngineApp::updateCamera(uint32_t width, uint32_t height) {
-		RayTraceUbo ubo{};
-
-		glm::vec3 lookFrom = glm::vec3(278.0f, 278.0f, -800.0f);
-		glm::vec3 lookAt = glm::vec3(278.0f, 278.0f, 0.0f);
-		glm::vec3 vup = glm::vec3(0.0f, 1.0f, 0.0f);
-		
-		float vfov = 40.0f;
-		float aspectRatio = static_cast<float>(width) / static_cast<float>(height);
+		return createCornellBoxCamera(width, height);
+	}
 
-		float theta = glm::radians(vfov);
-		float h = glm::tan(theta / 2.0f);
-		float viewportHeight = 2.0f * h;
-		float viewportWidth = aspectRatio * viewportHeight;
+	void EngineApp::watchShaders() {
+		this->shaderManager = std::make_unique<EngineShaderManager>();
 
-		glm::vec3 w = glm::normalize(lookFrom - lookAt);
-		glm::vec3 u = glm::normalize(glm::cross(vup, w));
-		glm::vec3 v = glm::cross(w, u);
+		auto reloadTrace = [this]() { 
+			this->traceRayRender->reloadPipeline(this->renderer->getFrameScheduler()); 
+		};
 
-		ubo.origin = lookFrom;
-		ubo.horizontal = viewportWidth * u;
-		ubo.vertical = viewportHeight * v;
-		ubo.lowerLeftCorner = ubo.origin - ubo.horizontal / 2.0f + ubo.vertical / 2.0f - w;
-		ubo.background = glm::vec3(0.0f, 0.0f, 0.0f);
+		auto reloadSampling = [this]() { 
+			this->samplingRayRender->reloadPipeline(this->renderer->getFrameScheduler(), this->swapChainSubRenderer->getRenderPass()->getRenderPass()); 
+		};
 
-		return ubo;
+		this->shaderManager->watch(SHADER_SOURCE_DIR "ray_trace_pbrt.comp", "shader/ray_trace_pbrt.comp.spv", {}, reloadTrace);
+		this->shaderManager->watch(SHADER_SOURCE_DIR "ray_trace_pbrt.comp", "shader/ray_trace_pbrt_bda.comp.spv", { "USE_BUFFER_REFERENCE" }, reloadTrace);
+		this->shaderManager->watch(SHADER_SOURCE_DIR "ray_trace_sampling.vert", "shader/ray_trace_sampling.vert.spv", {}, reloadSampling);
+		this->shaderManager->watch(SHADER_SOURCE_DIR "ray_trace_sampling.frag", "shader/ray_trace_sampling.frag.spv", {}, reloadSampling);
 	}
 
 	void EngineApp::recreateSubRendererAndSubsystem() {
@@ -240,18 +259,42 @@ namespace nugiEngine {
 
 		std::shared_ptr<EngineDescriptorPool> descriptorPool = this->renderer->getDescriptorPool();
 		std::vector<std::shared_ptr<EngineImage>> swapChainImages = this->renderer->getSwapChain()->getswapChainImages();
+		VkFormat swapChainImageFormat = this->renderer->getSwapChain()->getSwapChainImageFormat();
 
 		this->swapChainSubRenderer = std::make_unique<EngineSwapChainSubRenderer>(this->device, this->renderer->getSwapChain()->getswapChainImages(), 
-			this->renderer->getSwapChain()->getSwapChainImageFormat(), this->renderer->getSwapChain()->imageCount(), 
+			swapChainImageFormat, this->renderer->getSwapChain()->imageCount(), 
 			width, height);
 
+		// a resize keeps the pipelines, layouts and descriptor sets, only the images and the descriptors pointing to them are renewed.
+		// A new swap chain format makes the old render pass incompatible, so then everything is built again
+		if (this->traceRayRender != nullptr && this->samplingRayRender != nullptr && swapChainImageFormat == this->swapChainImageFormat) {
+			this->traceRayRender->resize(width, height);
+			this->samplingRayRender->resize(width, height, this->traceRayRender->getStorageImages());
+
+			if (this->isReplayingCommands) {
+				this->recordCommandBuffers();
+			}
+
+			return;
+		}
+
+		this->samplingRayRender.reset();
+		this->traceRayRender.reset();
+		descriptorPool->resetPool();
+
+		this->swapChainImageFormat = swapChainImageFormat;
+
 		std::vector<VkDescriptorBufferInfo> buffersInfo { this->models->getObjectInfo(), this->models->getBvhInfo(), this->models->getMaterialInfo(), this->models->getLightInfo() };
 
 		this->traceRayRender = std::make_unique<EngineTraceRayRenderSystem>(this->device, descriptorPool, 
-			width, height, nSample, buffersInfo);
+			width, height, nSample, buffersInfo, this->models->getSceneAddress());
 
 		this->samplingRayRender = std::make_unique<EngineSamplingRayRasterRenderSystem>(this->device, 
 			this->renderer->getDescriptorPool(), width, height, this->traceRayRender->getStorageImages(), 
-			nSample, this->swapChainSubRenderer->getRenderPass()->getRenderPass());
+			this->traceRayRender->getSeedBuffersInfo(), this->swapChainSubRenderer->getRenderPass()->getRenderPass());
+
+		if (this->isReplayingCommands) {
+			this->recordCommandBuffers();
+		}
 	}
 }
\ No newline at end of file
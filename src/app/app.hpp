@@ -9,13 +9,20 @@
 #include "../renderer_sub/swapchain_sub_renderer.hpp"
 #include "../renderer_system/trace_ray_render_system.hpp"
 #include "../renderer_system/sampling_ray_raster_render_system.hpp"
+#include "../shader_manager/shader_manager.hpp"
 
 
 #include <memory>
+#include <string>
 #include <vector>
 
 #define APP_TITLE "Testing Vulkan"
 
+// where the GLSL sources are found for hot reload, relative to the working directory (bin)
+#ifndef SHADER_SOURCE_DIR
+#define SHADER_SOURCE_DIR "../src/shader/"
+#endif
+
 namespace nugiEngine {
 	class EngineApp
 	{
@@ -23,7 +30,9 @@ namespace nugiEngine {
 			static constexpr int WIDTH = 800;
 			static constexpr int HEIGHT = 800;
 
-			EngineApp();
+			// a non-empty sceneCachePath loads the scene from that cache, or writes it there first when it is missing or stale.
+			// The cache holds the CPU built BVH, so it can't be combined with isBuildingBvhOnGpu
+			EngineApp(bool isBuildingBvhOnGpu = false, const std::string &sceneCachePath = "", bool isPrintingMemoryStatistics = false);
 			~EngineApp();
 
 			EngineApp(const EngineApp&) = delete;
@@ -33,11 +42,17 @@ namespace nugiEngine {
 			void renderLoop();
 
 		private:
-			void loadObjects();
+			void loadObjects(bool isBuildingBvhOnGpu, const std::string &sceneCachePath);
 			void loadQuadModels();
 
 			RayTraceUbo updateCamera(uint32_t width, uint32_t height);
 			void recreateSubRendererAndSubsystem();
+			void watchShaders();
+
+			void recordTraceCommand(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex);
+			void recordSamplingCommand(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex, uint32_t imageIndex);
+			void recordCommandBuffers();
+			void submitBvhBuild();
 
 			EngineWindow window{WIDTH, HEIGHT, APP_TITLE};
 			EngineDevice device{window};
@@ -47,11 +62,18 @@ namespace nugiEngine {
 			std::unique_ptr<EngineTraceRayRenderSystem> traceRayRender{};
 			std::unique_ptr<EngineSamplingRayRasterRenderSystem> samplingRayRender{};
 
+			std::unique_ptr<EngineShaderManager> shaderManager{};
+
 			std::unique_ptr<EngineRayTraceModel> models;
 			std::shared_ptr<EngineModel> quadModels;
 
+			std::vector<std::shared_ptr<EngineCommandBuffer>> traceCommandBuffers;
+			std::vector<std::shared_ptr<EngineCommandBuffer>> samplingCommandBuffers;
+
 			uint32_t randomSeed = 0;
+			VkFormat swapChainImageFormat = VK_FORMAT_UNDEFINED;
 			bool isRendering = true;
+			bool isReplayingCommands = true;
 			RayTraceUbo globalUbo;
 	};
 }
\ No newline at end of file
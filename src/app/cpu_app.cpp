@@ -0,0 +1,94 @@
+#include "cpu_app.hpp"
+
+#include "../scene/scene.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace nugiEngine {
+	EngineCpuApp::EngineCpuApp(const CpuAppConfigInfo& configInfo) : configInfo{configInfo} {
+		this->rayTracer = std::make_unique<EngineCpuRayTracer>(createCornellBoxScene(), this->configInfo.width, 
+			this->configInfo.height, this->configInfo.nSample, this->configInfo.threadCount);
+	}
+
+	void EngineCpuApp::run() {
+		if (this->configInfo.isMeasuringTraversal) {
+			this->measureTraversal();
+			return;
+		}
+
+		auto ubo = createCornellBoxCamera(this->configInfo.width, this->configInfo.height);
+		auto startTime = std::chrono::high_resolution_clock::now();
+
+		// same seed schedule as the Vulkan render loop, so both renderers converge to the same image
+		for (uint32_t frame = 0; frame < this->configInfo.nFrame; frame++) {
+			uint32_t randomSeed = frame / std::max(this->configInfo.framesPerSeed, 1u);
+
+			this->rayTracer->renderFrame(ubo, randomSeed);
+			std::cout << "\rcpu renderer: frame " << frame + 1 << " / " << this->configInfo.nFrame << std::flush;
+		}
+
+		float renderTime = std::chrono::duration<float, std::chrono::seconds::period>(
+			std::chrono::high_resolution_clock::now() - startTime).count();
+
+		std::cout << "\ncpu renderer: " << renderTime << " s on " << this->rayTracer->getThreadCount() << " threads" << std::endl;
+
+		this->rayTracer->writeImage(this->configInfo.outputPath);
+		std::cout << "cpu renderer: written to " << this->configInfo.outputPath << std::endl;
+	}
+
+	void EngineCpuApp::measureTraversal() {
+		auto ubo = createCornellBoxCamera(this->configInfo.width, this->configInfo.height);
+		auto &bvh = this->rayTracer->getBvh();
+
+		// primary rays through the pixel centers, eight neighbouring pixels of a row per packet
+		std::vector<CpuRay> rays;
+		rays.reserve(static_cast<size_t>(this->configInfo.width) * this->configInfo.height);
+
+		for (uint32_t y = 0; y < this->configInfo.height; y++) {
+			for (uint32_t x = 0; x < this->configInfo.width; x++) {
+				glm::vec2 uv = (glm::vec2(x, y) + glm::vec2(0.5f)) / glm::vec2(this->configInfo.width, this->configInfo.height);
+				rays.emplace_back(CpuRay{ ubo.origin, ubo.lowerLeftCorner + uv.x * ubo.horizontal - uv.y * ubo.vertical - ubo.origin });
+			}
+		}
+
+		size_t packetCount = rays.size() / 8;
+		std::vector<CpuHit> hits(rays.size());
+
+		CpuIsa detectedIsa = bvh.getIsa();
+
+		for (CpuIsa isa : { CpuIsa::Scalar, CpuIsa::SSE, CpuIsa::AVX2, CpuIsa::AVX512 }) {
+			if (!EngineCpuBvh::isIsaSupported(isa)) {
+				continue;
+			}
+
+			bvh.setIsa(isa);
+
+			auto startTime = std::chrono::high_resolution_clock::now();
+			for (uint32_t frame = 0; frame < this->configInfo.nFrame; frame++) {
+				for (size_t i = 0; i < rays.size(); i++) {
+					hits[i] = bvh.intersect(rays[i]);
+				}
+			}
+
+			auto singleTime = std::chrono::high_resolution_clock::now();
+			for (uint32_t frame = 0; frame < this->configInfo.nFrame; frame++) {
+				for (size_t i = 0; i < packetCount; i++) {
+					bvh.intersect8(&rays[i * 8], &hits[i * 8]);
+				}
+			}
+
+			auto packetTime = std::chrono::high_resolution_clock::now();
+
+			double singleRays = static_cast<double>(rays.size()) * this->configInfo.nFrame;
+			double packetRays = static_cast<double>(packetCount * 8) * this->configInfo.nFrame;
+
+			std::cout << "cpu traversal (" << EngineCpuBvh::getIsaName(isa) << "): "
+				<< singleRays / std::chrono::duration<double>(singleTime - startTime).count() / 1e6 << " Mrays/s single, "
+				<< packetRays / std::chrono::duration<double>(packetTime - singleTime).count() / 1e6 << " Mrays/s packet of 8" << std::endl;
+		}
+
+		bvh.setIsa(detectedIsa);
+	}
+} // namespace nugiEngine
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "../cpu_renderer/cpu_ray_tracer.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace nugiEngine {
+	struct CpuAppConfigInfo {
+		uint32_t width = 800;
+		uint32_t height = 800;
+		uint32_t nSample = 4;
+		uint32_t nFrame = 16;
+		uint32_t threadCount = 0;
+
+		// the Vulkan render loop keeps a seed for EngineDevice::MAX_FRAMES_IN_FLIGHT frames before moving to the next one
+		uint32_t framesPerSeed = 2;
+
+		// print the single ray and packet traversal speed of every supported ISA instead of rendering
+		bool isMeasuringTraversal = false;
+
+		std::string outputPath = "cpu_render.ppm";
+	};
+
+	// renders the app's scene with the CPU ray tracer into an image file, no window or Vulkan device is created
+	class EngineCpuApp {
+		public:
+			EngineCpuApp(const CpuAppConfigInfo& configInfo);
+
+			EngineCpuApp(const EngineCpuApp&) = delete;
+			EngineCpuApp& operator = (const EngineCpuApp&) = delete;
+
+			void run();
+
+		private:
+			void measureTraversal();
+
+			CpuAppConfigInfo configInfo;
+			std::unique_ptr<EngineCpuRayTracer> rayTracer;
+	};
+} // namespace nugiEngine
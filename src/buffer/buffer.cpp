@@ -29,6 +29,34 @@ namespace nugiEngine {
     return instanceSize;
   }
   
+  /**
+   * Returns the category the memory of a buffer is reported under
+   *
+   * @param usageFlags Usage flags of the buffer
+   * @param memoryPropertyFlags Memory property flags of the buffer
+   *
+   * @return EngineMemoryCategory of the buffer
+   */
+  EngineMemoryCategory EngineBuffer::getMemoryCategory(VkBufferUsageFlags usageFlags, VkMemoryPropertyFlags memoryPropertyFlags) {
+    if ((memoryPropertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) && usageFlags == VK_BUFFER_USAGE_TRANSFER_SRC_BIT) {
+      return EngineMemoryCategory::Staging;
+    }
+
+    if (usageFlags & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT) {
+      return EngineMemoryCategory::Uniform;
+    }
+
+    if (usageFlags & (VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT)) {
+      return EngineMemoryCategory::Vertex;
+    }
+
+    if (usageFlags & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) {
+      return EngineMemoryCategory::Storage;
+    }
+
+    return EngineMemoryCategory::Other;
+  }
+  
   EngineBuffer::EngineBuffer(
       EngineDevice &device,
       VkDeviceSize instanceSize,
@@ -52,21 +80,33 @@ namespace nugiEngine {
   EngineBuffer::~EngineBuffer() {
     this->unmap();
     vkDestroyBuffer(this->engineDevice.getLogicalDevice(), this->buffer, nullptr);
-    vkFreeMemory(this->engineDevice.getLogicalDevice(), this->memory, nullptr);
+    this->engineDevice.getMemoryAllocator()->free(this->allocation);
   }
   
   /**
    * Map a memory range of this buffer. If successful, mapped points to the specified buffer range.
    *
+   * @note Host visible memory blocks are kept mapped by the allocator, so this only points into them
+   *
    * @param size (Optional) Size of the memory range to map. Pass VK_WHOLE_SIZE to map the complete
    * buffer range.
    * @param offset (Optional) Byte offset from beginning
    *
-   * @return VkResult of the buffer mapping call
+   * @return VkResult of the buffer mapping call, VK_ERROR_MEMORY_MAP_FAILED when the range is outside of the buffer
    */
   VkResult EngineBuffer::map(VkDeviceSize size, VkDeviceSize offset) {
-    assert(this->buffer && this->memory && "Called map on buffer before create");
-    return vkMapMemory(this->engineDevice.getLogicalDevice(), this->memory, offset, size, 0, &this->mapped);
+    assert(this->buffer && this->allocation.memory && "Called map on buffer before create");
+
+    if (this->allocation.mapped == nullptr || offset > this->bufferSize) {
+      return VK_ERROR_MEMORY_MAP_FAILED;
+    }
+
+    if (size != VK_WHOLE_SIZE && size > this->bufferSize - offset) {
+      return VK_ERROR_MEMORY_MAP_FAILED;
+    }
+
+    this->mapped = static_cast<char*>(this->allocation.mapped) + offset;
+    return VK_SUCCESS;
   }
   
   /**
@@ -75,10 +115,7 @@ namespace nugiEngine {
    * @note Does not return a result as vkUnmapMemory can't fail
    */
   void EngineBuffer::unmap() {
-    if (this->mapped) {
-      vkUnmapMemory(this->engineDevice.getLogicalDevice(), this->memory);
-      this->mapped = nullptr;
-    }
+    this->mapped = nullptr;
   }
   
   /**
@@ -135,12 +172,7 @@ namespace nugiEngine {
    * @return VkResult of the flush call
    */
   VkResult EngineBuffer::flush(VkDeviceSize size, VkDeviceSize offset) {
-    VkMappedMemoryRange mappedRange = {};
-    mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-    mappedRange.memory = this->memory;
-    mappedRange.offset = offset;
-    mappedRange.size = size;
-    return vkFlushMappedMemoryRanges(this->engineDevice.getLogicalDevice(), 1, &mappedRange);
+    return this->engineDevice.getMemoryAllocator()->flush(this->allocation, size, offset);
   }
   
   /**
@@ -155,12 +187,7 @@ namespace nugiEngine {
    * @return VkResult of the invalidate call
    */
   VkResult EngineBuffer::invalidate(VkDeviceSize size, VkDeviceSize offset) {
-    VkMappedMemoryRange mappedRange = {};
-    mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-    mappedRange.memory = this->memory;
-    mappedRange.offset = offset;
-    mappedRange.size = size;
-    return vkInvalidateMappedMemoryRanges(this->engineDevice.getLogicalDevice(), 1, &mappedRange);
+    return this->engineDevice.getMemoryAllocator()->invalidate(this->allocation, size, offset);
   }
   
   /**
@@ -249,16 +276,20 @@ namespace nugiEngine {
     VkMemoryRequirements memRequirements;
     vkGetBufferMemoryRequirements(this->engineDevice.getLogicalDevice(), this->buffer, &memRequirements);
 
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = this->engineDevice.findMemoryType(memRequirements.memoryTypeBits, properties);
+    this->allocation = this->engineDevice.getMemoryAllocator()->allocate(memRequirements, properties, true, 
+      EngineBuffer::getMemoryCategory(usage, properties));
 
-    if (vkAllocateMemory(this->engineDevice.getLogicalDevice(), &allocInfo, nullptr, &this->memory) != VK_SUCCESS) {
-      throw std::runtime_error("failed to allocate vertex buffer memory!");
+    if (vkBindBufferMemory(this->engineDevice.getLogicalDevice(), this->buffer, this->allocation.memory, this->allocation.offset) != VK_SUCCESS) {
+      throw std::runtime_error("failed to bind vertex buffer memory!");
     }
 
-    vkBindBufferMemory(this->engineDevice.getLogicalDevice(), this->buffer, this->memory, 0);
+    if (usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) {
+      VkBufferDeviceAddressInfo addressInfo{};
+      addressInfo.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
+      addressInfo.buffer = this->buffer;
+
+      this->deviceAddress = vkGetBufferDeviceAddress(this->engineDevice.getLogicalDevice(), &addressInfo);
+    }
   }
 
   void EngineBuffer::copyBuffer(VkBuffer srcBuffer, VkDeviceSize size) {
@@ -272,7 +303,7 @@ namespace nugiEngine {
     vkCmdCopyBuffer(commandBuffer.getCommandBuffer(), srcBuffer, this->buffer, 1, &copyRegion);
 
     commandBuffer.endCommand();
-    commandBuffer.submitCommand(this->engineDevice.getTransferQueue(0));
+    commandBuffer.submitCommand(this->engineDevice.getGraphicsQueue(0));
   }
 
   void EngineBuffer::copyBufferToImage(VkImage image, uint32_t width, uint32_t height, uint32_t layerCount) {
@@ -302,7 +333,57 @@ namespace nugiEngine {
     );
 
     commandBuffer.endCommand();
-    commandBuffer.submitCommand(this->engineDevice.getTransferQueue(0));
+    commandBuffer.submitCommand(this->engineDevice.getGraphicsQueue(0));
+  }
+
+  /**
+   * Move the ownership of the whole buffer from one queue family to another, so its content is kept
+   * when it is used by a queue of a different family than the one which wrote it
+   *
+   * @note Does nothing when both queue families are the same
+   *
+   * @param srcQueueFamilyIndex, srcQueue, srcCommandPool The family currently owning the buffer, where the release is submitted
+   * @param dstQueueFamilyIndex, dstQueue, dstCommandPool The family receiving the buffer, where the acquire is submitted
+   * @param dstAccess, dstStage The first access of the buffer on the destination family
+   */
+  void EngineBuffer::transferOwnership(uint32_t srcQueueFamilyIndex, VkQueue srcQueue, VkCommandPool srcCommandPool, 
+    uint32_t dstQueueFamilyIndex, VkQueue dstQueue, VkCommandPool dstCommandPool, VkAccessFlags dstAccess, VkPipelineStageFlags dstStage) 
+  {
+    if (srcQueueFamilyIndex == dstQueueFamilyIndex) {
+      return;
+    }
+
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = srcQueueFamilyIndex;
+    barrier.dstQueueFamilyIndex = dstQueueFamilyIndex;
+    barrier.buffer = this->buffer;
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
+
+    EngineCommandBuffer releaseCommandBuffer{this->engineDevice, srcCommandPool};
+    releaseCommandBuffer.beginSingleTimeCommand();
+
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = 0;
+
+    vkCmdPipelineBarrier(releaseCommandBuffer.getCommandBuffer(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+      0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+    releaseCommandBuffer.endCommand();
+    releaseCommandBuffer.submitCommand(srcQueue);
+
+    EngineCommandBuffer acquireCommandBuffer{this->engineDevice, dstCommandPool};
+    acquireCommandBuffer.beginSingleTimeCommand();
+
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = dstAccess;
+
+    vkCmdPipelineBarrier(acquireCommandBuffer.getCommandBuffer(), VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dstStage,
+      0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+    acquireCommandBuffer.endCommand();
+    acquireCommandBuffer.submitCommand(dstQueue);
   }
   
  
@@ -21,6 +21,8 @@ class EngineBuffer {
   void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties);
   void copyBuffer(VkBuffer srcBuffer, VkDeviceSize size);
   void copyBufferToImage(VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
+  void transferOwnership(uint32_t srcQueueFamilyIndex, VkQueue srcQueue, VkCommandPool srcCommandPool, 
+    uint32_t dstQueueFamilyIndex, VkQueue dstQueue, VkCommandPool dstCommandPool, VkAccessFlags dstAccess, VkPipelineStageFlags dstStage);
  
   VkResult map(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
   void unmap();
@@ -45,15 +47,20 @@ class EngineBuffer {
   VkBufferUsageFlags getUsageFlags() const { return usageFlags; }
   VkMemoryPropertyFlags getMemoryPropertyFlags() const { return memoryPropertyFlags; }
   VkDeviceSize getBufferSize() const { return bufferSize; }
+
+  // only valid for buffers created with VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+  VkDeviceAddress getDeviceAddress() const { return deviceAddress; }
  
  private:
   static VkDeviceSize getAlignment(VkDeviceSize instanceSize, VkDeviceSize minOffsetAlignment);
+  static EngineMemoryCategory getMemoryCategory(VkBufferUsageFlags usageFlags, VkMemoryPropertyFlags memoryPropertyFlags);
  
   EngineDevice& engineDevice;
 
   void* mapped = nullptr;
   VkBuffer buffer = VK_NULL_HANDLE;
-  VkDeviceMemory memory = VK_NULL_HANDLE;
+  VkDeviceAddress deviceAddress = 0;
+  EngineMemoryAllocation allocation{};
  
   VkDeviceSize bufferSize;
   uint32_t instanceCount;
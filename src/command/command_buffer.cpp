@@ -1,25 +1,77 @@
 #include "command_buffer.hpp"
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 
 namespace nugiEngine {
+	namespace {
+		constexpr VkAccessFlags WRITE_ACCESS_MASK = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT 
+			| VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT 
+			| VK_ACCESS_MEMORY_WRITE_BIT;
+
+		bool isSameRange(const VkImageSubresourceRange &a, const VkImageSubresourceRange &b) {
+			return a.aspectMask == b.aspectMask && a.baseMipLevel == b.baseMipLevel && a.levelCount == b.levelCount
+				&& a.baseArrayLayer == b.baseArrayLayer && a.layerCount == b.layerCount;
+		}
+
+		// the queue is only locked for the submit itself, waiting on a fence instead of the queue leaves it free for other threads
+		void submitToQueue(EngineDevice &appDevice, VkQueue queue, const VkSubmitInfo &submitInfo, VkFence fence, bool isWaiting) {
+			VkFence waitFence = VK_NULL_HANDLE;
+
+			if (isWaiting) {
+				VkFenceCreateInfo fenceInfo{};
+				fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+				if (vkCreateFence(appDevice.getLogicalDevice(), &fenceInfo, nullptr, &waitFence) != VK_SUCCESS) {
+					std::cerr << "Failed to create submit fence" << '\n';
+				}
+
+				fence = waitFence;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(appDevice.getQueueMutex(queue));
+
+				if (vkQueueSubmit(queue, 1, &submitInfo, fence) != VK_SUCCESS) {
+					std::cerr << "Failed to submitting command buffer" << '\n';
+				}
+			}
+
+			if (waitFence == VK_NULL_HANDLE) {
+				return;
+			}
+
+			// a fence signal covers everything submitted earlier to the queue, the same as waiting for it to idle
+			if (vkWaitForFences(appDevice.getLogicalDevice(), 1, &waitFence, VK_TRUE, std::numeric_limits<uint64_t>::max()) != VK_SUCCESS) {
+				std::cerr << "Failed to waiting queue" << '\n';
+			}
+
+			vkDestroyFence(appDevice.getLogicalDevice(), waitFence, nullptr);
+		}
+	} // namespace
+
 	EngineCommandBuffer::~EngineCommandBuffer() {
 		vkFreeCommandBuffers(
       this->appDevice.getLogicalDevice(), 
-      this->appDevice.getCommandPool(), 
+      this->commandPool, 
       1, 
       &this->commandBuffer
     );
 	}
 
-  std::vector<std::shared_ptr<EngineCommandBuffer>> EngineCommandBuffer::createCommandBuffers(EngineDevice &appDevice, uint32_t size) {
+  std::vector<std::shared_ptr<EngineCommandBuffer>> EngineCommandBuffer::createCommandBuffers(EngineDevice &appDevice, uint32_t size, VkCommandPool commandPool) {
+		if (commandPool == VK_NULL_HANDLE) {
+			commandPool = appDevice.getCommandPool();
+		}
+
 		std::vector<VkCommandBuffer> commandBuffers{size};
 		std::vector<std::shared_ptr<EngineCommandBuffer>> appCommandBuffers;
 
 		VkCommandBufferAllocateInfo allocInfo{};
 		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
 		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		allocInfo.commandPool = appDevice.getCommandPool();
+		allocInfo.commandPool = commandPool;
 		allocInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
 
 		if (vkAllocateCommandBuffers(appDevice.getLogicalDevice(), &allocInfo, commandBuffers.data()) != VK_SUCCESS) {
@@ -28,24 +80,28 @@ namespace nugiEngine {
 
 		for (size_t i = 0; i < size; i++) {
 			appCommandBuffers.push_back(
-				std::make_shared<EngineCommandBuffer>(appDevice, commandBuffers[i])
+				std::make_shared<EngineCommandBuffer>(appDevice, commandBuffers[i], commandPool)
 			);
 		}
 
 		return appCommandBuffers;
 	}
 
-	EngineCommandBuffer::EngineCommandBuffer(EngineDevice& device, VkCommandBuffer commandBuffer) 
-		: appDevice{device}, commandBuffer {commandBuffer} 
+	EngineCommandBuffer::EngineCommandBuffer(EngineDevice& device, VkCommandBuffer commandBuffer, VkCommandPool commandPool) 
+		: appDevice{device}, commandBuffer {commandBuffer}, commandPool{commandPool}
 	{
 
 	}
 
-	EngineCommandBuffer::EngineCommandBuffer(EngineDevice& device) : appDevice{device} {
+	EngineCommandBuffer::EngineCommandBuffer(EngineDevice& device, VkCommandPool commandPool) : appDevice{device}, commandPool{commandPool} {
+		if (this->commandPool == VK_NULL_HANDLE) {
+			this->commandPool = this->appDevice.getCommandPool();
+		}
+
 		VkCommandBufferAllocateInfo allocInfo{};
 		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
 		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		allocInfo.commandPool = this->appDevice.getCommandPool();
+		allocInfo.commandPool = this->commandPool;
 		allocInfo.commandBufferCount = 1;
 
 		if (vkAllocateCommandBuffers(appDevice.getLogicalDevice(), &allocInfo, &this->commandBuffer) != VK_SUCCESS) {
@@ -61,6 +117,8 @@ namespace nugiEngine {
 		if (vkBeginCommandBuffer(this->commandBuffer, &beginInfo) != VK_SUCCESS) {
 			std::cerr << "Failed to start recording buffer" << '\n';
 		}
+
+		this->trackedImageCount = 0;
 	}
 
 	void EngineCommandBuffer::beginReccuringCommand() {
@@ -70,9 +128,13 @@ namespace nugiEngine {
 		if (vkBeginCommandBuffer(this->commandBuffer, &beginInfo) != VK_SUCCESS) {
 			std::cerr << "Failed to start recording command buffer" << '\n';
 		}
+
+		this->trackedImageCount = 0;
 	}
 
 	void EngineCommandBuffer::endCommand() {
+		this->flushBarriers();
+
 		if (vkEndCommandBuffer(this->commandBuffer) != VK_SUCCESS) {
 			std::cerr << "Failed to end recording command buffer" << '\n';
 		}
@@ -104,13 +166,16 @@ namespace nugiEngine {
 			submitInfo.pSignalSemaphores = signalSemaphores.data();
 		}
 
-		if (vkQueueSubmit(queue, 1, &submitInfo, fence) != VK_SUCCESS) {
-			std::cerr << "Failed to submitting command buffer" << '\n';
-		}
+		// a fence or a signaled semaphore already tracks completion, so the queue may keep running
+		submitToQueue(this->appDevice, queue, submitInfo, fence, fence == VK_NULL_HANDLE && signalSemaphores.empty());
+	}
 
-		if (vkQueueWaitIdle(queue) != VK_SUCCESS) {
-			std::cerr << "Failed to waiting queue" << '\n';
-		}
+	void EngineCommandBuffer::submitCommand(VkQueue queue, uint32_t waitSemaphoreCount, const VkSemaphore* waitSemaphores, 
+		const VkPipelineStageFlags* waitStages, const uint64_t* waitValues, uint32_t signalSemaphoreCount, 
+		const VkSemaphore* signalSemaphores, const uint64_t* signalValues) 
+	{
+		EngineCommandBuffer::submitCommands(this->appDevice, 1, &this->commandBuffer, queue, waitSemaphoreCount, waitSemaphores, waitStages, 
+			waitValues, signalSemaphoreCount, signalSemaphores, signalValues);
 	}
 
 	void EngineCommandBuffer::submitCommands(std::vector<std::shared_ptr<EngineCommandBuffer>> commandBuffers, VkQueue queue, std::vector<VkSemaphore> waitSemaphores, 
@@ -144,13 +209,120 @@ namespace nugiEngine {
 			submitInfo.pSignalSemaphores = signalSemaphores.data();
 		}
 
-		if (vkQueueSubmit(queue, 1, &submitInfo, fence) != VK_SUCCESS) {
-			std::cerr << "Failed to submitting command buffer" << '\n';
+		// a fence or a signaled semaphore already tracks completion, so the queue may keep running
+		submitToQueue(commandBuffers.front()->appDevice, queue, submitInfo, fence, fence == VK_NULL_HANDLE && signalSemaphores.empty());
+	}
+
+	void EngineCommandBuffer::submitCommands(EngineDevice &appDevice, uint32_t commandBufferCount, const VkCommandBuffer* commandBuffers, VkQueue queue, 
+		uint32_t waitSemaphoreCount, const VkSemaphore* waitSemaphores, const VkPipelineStageFlags* waitStages, 
+		const uint64_t* waitValues, uint32_t signalSemaphoreCount, const VkSemaphore* signalSemaphores, const uint64_t* signalValues) 
+	{
+		// values of binary semaphores in the arrays are ignored by the driver
+		VkTimelineSemaphoreSubmitInfo timelineInfo{};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineInfo.waitSemaphoreValueCount = waitSemaphoreCount;
+		timelineInfo.pWaitSemaphoreValues = waitValues;
+		timelineInfo.signalSemaphoreValueCount = signalSemaphoreCount;
+		timelineInfo.pSignalSemaphoreValues = signalValues;
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = &timelineInfo;
+		submitInfo.commandBufferCount = commandBufferCount;
+		submitInfo.pCommandBuffers = commandBuffers;
+
+		submitInfo.waitSemaphoreCount = waitSemaphoreCount;
+		submitInfo.pWaitSemaphores = waitSemaphores;
+		submitInfo.pWaitDstStageMask = waitStages;
+
+		submitInfo.signalSemaphoreCount = signalSemaphoreCount;
+		submitInfo.pSignalSemaphores = signalSemaphores;
+
+		submitToQueue(appDevice, queue, submitInfo, VK_NULL_HANDLE, false);
+	}
+
+	bool EngineCommandBuffer::addImageBarrier(const VkImageMemoryBarrier &barrier, VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage) {
+		// read after read in the same layout and on the same queue needs no barrier, as long as the earlier one
+		// already made the image visible to every stage and access asked for here
+		auto trackedImage = this->findTrackedImage(barrier);
+		bool isRedundant = trackedImage != nullptr 
+			&& barrier.oldLayout == barrier.newLayout && barrier.newLayout == trackedImage->layout
+			&& barrier.srcQueueFamilyIndex == barrier.dstQueueFamilyIndex && barrier.dstQueueFamilyIndex == trackedImage->queueFamilyIndex
+			&& ((barrier.srcAccessMask | barrier.dstAccessMask | trackedImage->access) & WRITE_ACCESS_MASK) == 0
+			&& (barrier.dstAccessMask & ~trackedImage->access) == 0
+			&& (dstStage & ~trackedImage->stage) == 0;
+
+		if (isRedundant) {
+			return false;
+		}
+
+		if (this->imageBarrierCount == MAX_BATCHED_BARRIERS) {
+			this->flushBarriers();
+		}
+
+		this->imageBarriers[this->imageBarrierCount++] = barrier;
+		this->barrierSrcStage |= srcStage;
+		this->barrierDstStage |= dstStage;
+
+		this->trackImageBarrier(barrier, dstStage);
+		return true;
+	}
+
+	EngineCommandBuffer::TrackedImageState* EngineCommandBuffer::findTrackedImage(const VkImageMemoryBarrier &barrier) {
+		uint32_t count = std::min(this->trackedImageCount, MAX_TRACKED_IMAGES);
+
+		for (uint32_t i = 0; i < count; i++) {
+			auto &trackedImage = this->trackedImages[i];
+			if (trackedImage.image == barrier.image && isSameRange(trackedImage.range, barrier.subresourceRange)) {
+				return &trackedImage;
+			}
+		}
+
+		return nullptr;
+	}
+
+	void EngineCommandBuffer::trackImageBarrier(const VkImageMemoryBarrier &barrier, VkPipelineStageFlags dstStage) {
+		auto trackedImage = this->findTrackedImage(barrier);
+		if (trackedImage == nullptr) {
+			trackedImage = &this->trackedImages[this->trackedImageCount++ % MAX_TRACKED_IMAGES];
+		}
+
+		trackedImage->image = barrier.image;
+		trackedImage->range = barrier.subresourceRange;
+		trackedImage->layout = barrier.newLayout;
+		trackedImage->access = barrier.dstAccessMask;
+		trackedImage->stage = dstStage;
+		trackedImage->queueFamilyIndex = barrier.dstQueueFamilyIndex;
+	}
+
+	void EngineCommandBuffer::addBufferBarrier(const VkBufferMemoryBarrier &barrier, VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage) {
+		if (this->bufferBarrierCount == MAX_BATCHED_BARRIERS) {
+			this->flushBarriers();
 		}
 
-		if (vkQueueWaitIdle(queue) != VK_SUCCESS) {
-			std::cerr << "Failed to waiting queue" << '\n';
+		this->bufferBarriers[this->bufferBarrierCount++] = barrier;
+		this->barrierSrcStage |= srcStage;
+		this->barrierDstStage |= dstStage;
+	}
+
+	void EngineCommandBuffer::flushBarriers() {
+		if (this->imageBarrierCount == 0 && this->bufferBarrierCount == 0) {
+			return;
 		}
-		
+
+		vkCmdPipelineBarrier(
+			this->commandBuffer,
+			this->barrierSrcStage,
+			this->barrierDstStage,
+			0,
+			0, nullptr,
+			this->bufferBarrierCount, this->bufferBarriers.data(),
+			this->imageBarrierCount, this->imageBarriers.data()
+		);
+
+		this->imageBarrierCount = 0;
+		this->bufferBarrierCount = 0;
+		this->barrierSrcStage = 0;
+		this->barrierDstStage = 0;
 	}
 } // namespace nugiEngine
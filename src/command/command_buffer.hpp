@@ -2,6 +2,7 @@
 
 #include "../device/device.hpp"
 
+#include <array>
 #include <vector>
 #include <memory>
 
@@ -9,15 +10,15 @@ namespace nugiEngine
 {
   class EngineCommandBuffer {
     public:
-      EngineCommandBuffer(EngineDevice& device, VkCommandBuffer commandBuffer);
-      EngineCommandBuffer(EngineDevice& device);
+      EngineCommandBuffer(EngineDevice& device, VkCommandBuffer commandBuffer, VkCommandPool commandPool);
+      EngineCommandBuffer(EngineDevice& device, VkCommandPool commandPool = VK_NULL_HANDLE);
 
       ~EngineCommandBuffer();
 
       EngineCommandBuffer(const EngineCommandBuffer&) = delete;
       EngineCommandBuffer& operator=(const EngineCommandBuffer&) = delete;
 
-      static std::vector<std::shared_ptr<EngineCommandBuffer>> createCommandBuffers(EngineDevice &appDevice, uint32_t size);
+      static std::vector<std::shared_ptr<EngineCommandBuffer>> createCommandBuffers(EngineDevice &appDevice, uint32_t size, VkCommandPool commandPool = VK_NULL_HANDLE);
 
       void beginSingleTimeCommand();
       void beginReccuringCommand();
@@ -25,16 +26,57 @@ namespace nugiEngine
       void submitCommand(VkQueue queue, std::vector<VkSemaphore> waitSemaphores = {}, 
         std::vector<VkPipelineStageFlags> waitStages = {}, std::vector<VkSemaphore> signalSemaphores = {}, 
         VkFence fence = VK_NULL_HANDLE);
+      void submitCommand(VkQueue queue, uint32_t waitSemaphoreCount, const VkSemaphore* waitSemaphores, 
+        const VkPipelineStageFlags* waitStages, const uint64_t* waitValues, uint32_t signalSemaphoreCount, 
+        const VkSemaphore* signalSemaphores, const uint64_t* signalValues);
 
       static void submitCommands(std::vector<std::shared_ptr<EngineCommandBuffer>> commandBuffers, VkQueue queue, std::vector<VkSemaphore> waitSemaphores = {}, 
         std::vector<VkPipelineStageFlags> waitStages = {}, std::vector<VkSemaphore> signalSemaphores = {}, 
         VkFence fence = VK_NULL_HANDLE);
+      static void submitCommands(EngineDevice &appDevice, uint32_t commandBufferCount, const VkCommandBuffer* commandBuffers, VkQueue queue, 
+        uint32_t waitSemaphoreCount, const VkSemaphore* waitSemaphores, const VkPipelineStageFlags* waitStages, 
+        const uint64_t* waitValues, uint32_t signalSemaphoreCount, const VkSemaphore* signalSemaphores, const uint64_t* signalValues);
 
       VkCommandBuffer getCommandBuffer() const { return this->commandBuffer; }
 
+      // Barriers are collected here and recorded with a single vkCmdPipelineBarrier on flushBarriers().
+      // A full batch is flushed automatically, so the storage never grows.
+      // An image barrier is dropped (and false returned) when an earlier barrier recorded into this same command buffer
+      // already left the image readable in that layout by those stages and nothing asks to wait for a write since.
+      // Only barriers of this command buffer are trusted, so a recorded buffer stays correct whatever order it is replayed in
+      bool addImageBarrier(const VkImageMemoryBarrier &barrier, VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage);
+      void addBufferBarrier(const VkBufferMemoryBarrier &barrier, VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage);
+      void flushBarriers();
+
+      static constexpr uint32_t MAX_BATCHED_BARRIERS = 16;
+      static constexpr uint32_t MAX_TRACKED_IMAGES = 32;
+
     private:
+      // what the image barriers recorded since begin left an image subresource range in
+      struct TrackedImageState {
+        VkImage image = VK_NULL_HANDLE;
+        VkImageSubresourceRange range{};
+        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkAccessFlags access = 0;
+        VkPipelineStageFlags stage = 0;
+        uint32_t queueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      };
+
       EngineDevice& appDevice;
       VkCommandBuffer commandBuffer;
+      VkCommandPool commandPool;
+
+      std::array<VkImageMemoryBarrier, MAX_BATCHED_BARRIERS> imageBarriers{};
+      std::array<VkBufferMemoryBarrier, MAX_BATCHED_BARRIERS> bufferBarriers{};
+      uint32_t imageBarrierCount = 0, bufferBarrierCount = 0;
+      VkPipelineStageFlags barrierSrcStage = 0, barrierDstStage = 0;
+
+      // reset on every begin, the oldest entry is overwritten once it is full
+      std::array<TrackedImageState, MAX_TRACKED_IMAGES> trackedImages{};
+      uint32_t trackedImageCount = 0;
+
+      TrackedImageState* findTrackedImage(const VkImageMemoryBarrier &barrier);
+      void trackImageBarrier(const VkImageMemoryBarrier &barrier, VkPipelineStageFlags dstStage);
   };
   
 } // namespace nugiEngine
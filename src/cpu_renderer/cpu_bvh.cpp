@@ -0,0 +1,261 @@
+#include "cpu_bvh.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <stdexcept>
+
+namespace nugiEngine {
+	namespace {
+		// a child of the 8-wide node being built: a subtree of the binary BVH, or the objects of one binary node
+		struct CollapseEntry {
+			int binaryNodeIndex;
+			bool isLeaf;
+
+			glm::vec3 minimum;
+			glm::vec3 maximum;
+		};
+
+		float surfaceArea(const CollapseEntry& entry) {
+			glm::vec3 extent = entry.maximum - entry.minimum;
+			return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+		}
+
+		bool hasChildNodes(const BvhNode& node) {
+			return node.leftNode >= 0 || node.rightNode >= 0;
+		}
+
+		bool hasObjects(const BvhNode& node) {
+			return node.leftObjIndex >= 0 || node.rightObjIndex >= 0;
+		}
+
+		// the objects get the same padding as objectBoundingBox in bvh.hpp, flat triangles need a box with volume
+		CollapseEntry createLeafEntry(const std::vector<Object>& objects, const std::vector<BvhNode>& bvhNodes, int binaryNodeIndex) {
+			const glm::vec3 padding(0.0001f);
+
+			CollapseEntry entry{ binaryNodeIndex, true, glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX) };
+			const BvhNode &node = bvhNodes[binaryNodeIndex];
+
+			for (int objIndex : { node.leftObjIndex, node.rightObjIndex }) {
+				if (objIndex < 0) {
+					continue;
+				}
+
+				const Triangle &triangle = objects[objIndex].triangle;
+				entry.minimum = glm::min(entry.minimum, glm::min(glm::min(triangle.point0, triangle.point1), triangle.point2) - padding);
+				entry.maximum = glm::max(entry.maximum, glm::max(glm::max(triangle.point0, triangle.point1), triangle.point2) + padding);
+			}
+
+			return entry;
+		}
+
+		void expandEntry(const std::vector<Object>& objects, const std::vector<BvhNode>& bvhNodes, int binaryNodeIndex, 
+			std::vector<CollapseEntry>& entries) 
+		{
+			const BvhNode &node = bvhNodes[binaryNodeIndex];
+
+			for (int childIndex : { node.leftNode, node.rightNode }) {
+				if (childIndex < 0) {
+					continue;
+				}
+
+				const BvhNode &child = bvhNodes[childIndex];
+
+				if (hasChildNodes(child)) {
+					entries.emplace_back(CollapseEntry{ childIndex, false, child.minimum, child.maximum });
+				} else {
+					entries.emplace_back(createLeafEntry(objects, bvhNodes, childIndex));
+				}
+			}
+
+			// the flattened format allows objects next to child nodes, createBvh never emits that but other builders may
+			if (hasObjects(node)) {
+				entries.emplace_back(createLeafEntry(objects, bvhNodes, binaryNodeIndex));
+			}
+		}
+	}
+
+	EngineCpuBvh::EngineCpuBvh(const std::vector<Object>& objects, const std::vector<BvhNode>& bvhNodes) {
+		this->setIsa(EngineCpuBvh::detectIsa());
+
+		if (bvhNodes.empty() || objects.empty()) {
+			return;
+		}
+
+		this->nodes.reserve(bvhNodes.size() / 4 + 1);
+		this->triangles.reserve(objects.size());
+
+		this->collapseNode(objects, bvhNodes, 0);
+	}
+
+	uint32_t EngineCpuBvh::collapseNode(const std::vector<Object>& objects, const std::vector<BvhNode>& bvhNodes, int binaryNodeIndex) {
+		std::vector<CollapseEntry> entries;
+
+		if (hasChildNodes(bvhNodes[binaryNodeIndex])) {
+			expandEntry(objects, bvhNodes, binaryNodeIndex, entries);
+		} else {
+			entries.emplace_back(createLeafEntry(objects, bvhNodes, binaryNodeIndex));
+		}
+
+		// keep opening the largest subtree until all eight lanes are used, big boxes gain the most from being split
+		while (true) {
+			int largestEntry = -1;
+			float largestArea = -1.0f;
+
+			for (int i = 0; i < static_cast<int>(entries.size()); i++) {
+				if (entries[i].isLeaf) {
+					continue;
+				}
+
+				const BvhNode &node = bvhNodes[entries[i].binaryNodeIndex];
+				size_t expandedCount = (node.leftNode >= 0) + (node.rightNode >= 0) + (hasObjects(node) ? 1 : 0);
+
+				if (entries.size() - 1 + expandedCount > Bvh8Node::WIDTH) {
+					continue;
+				}
+
+				float area = surfaceArea(entries[i]);
+				if (area > largestArea) {
+					largestArea = area;
+					largestEntry = i;
+				}
+			}
+
+			if (largestEntry < 0) {
+				break;
+			}
+
+			int binaryIndex = entries[largestEntry].binaryNodeIndex;
+			entries.erase(entries.begin() + largestEntry);
+
+			expandEntry(objects, bvhNodes, binaryIndex, entries);
+		}
+
+		uint32_t nodeIndex = static_cast<uint32_t>(this->nodes.size());
+		this->nodes.emplace_back();
+
+		Bvh8Node node{};
+		for (uint32_t lane = 0; lane < Bvh8Node::WIDTH; lane++) {
+			node.minX[lane] = node.minY[lane] = node.minZ[lane] = FLT_MAX;
+			node.maxX[lane] = node.maxY[lane] = node.maxZ[lane] = -FLT_MAX;
+		}
+
+		for (uint32_t lane = 0; lane < entries.size(); lane++) {
+			const CollapseEntry &entry = entries[lane];
+
+			node.minX[lane] = entry.minimum.x;
+			node.minY[lane] = entry.minimum.y;
+			node.minZ[lane] = entry.minimum.z;
+			node.maxX[lane] = entry.maximum.x;
+			node.maxY[lane] = entry.maximum.y;
+			node.maxZ[lane] = entry.maximum.z;
+
+			node.validMask |= 1u << lane;
+
+			if (entry.isLeaf) {
+				const BvhNode &binaryNode = bvhNodes[entry.binaryNodeIndex];
+
+				node.children[lane] = static_cast<uint32_t>(this->triangles.size());
+				node.primCounts[lane] = 0;
+
+				for (int objIndex : { binaryNode.leftObjIndex, binaryNode.rightObjIndex }) {
+					if (objIndex < 0) {
+						continue;
+					}
+
+					const Triangle &triangle = objects[objIndex].triangle;
+					this->triangles.emplace_back(CpuTriangle{ triangle.point0, triangle.point1 - triangle.point0, 
+						triangle.point2 - triangle.point0, static_cast<uint32_t>(objIndex) });
+
+					node.primCounts[lane]++;
+				}
+			} else {
+				node.children[lane] = this->collapseNode(objects, bvhNodes, entry.binaryNodeIndex);
+				node.primCounts[lane] = 0;
+			}
+		}
+
+		// the recursion above may have grown the vector, so the node is only stored now
+		this->nodes[nodeIndex] = node;
+		return nodeIndex;
+	}
+
+	CpuHit EngineCpuBvh::intersect(const CpuRay& ray) const {
+		CpuHit hit{};
+		this->kernels->intersect(*this, ray, hit);
+
+		return hit;
+	}
+
+	bool EngineCpuBvh::occluded(const CpuRay& ray) const {
+		return this->kernels->occluded(*this, ray);
+	}
+
+	void EngineCpuBvh::intersect4(const CpuRay rays[4], CpuHit hits[4]) const {
+		this->intersectRays(rays, hits, 4);
+	}
+
+	void EngineCpuBvh::intersect8(const CpuRay rays[8], CpuHit hits[8]) const {
+		this->intersectRays(rays, hits, 8);
+	}
+
+	void EngineCpuBvh::intersectRays(const CpuRay* rays, CpuHit* hits, uint32_t rayCount) const {
+		uint32_t packetWidth = this->kernels->packetWidth;
+
+		for (uint32_t first = 0; first < rayCount; first += packetWidth) {
+			this->kernels->intersectPacket(*this, rays + first, hits + first, std::min(packetWidth, rayCount - first));
+		}
+	}
+
+	void EngineCpuBvh::setIsa(CpuIsa isa) {
+		uint32_t level = static_cast<uint32_t>(isa);
+
+		while (level > 0 && !EngineCpuBvh::isIsaSupported(static_cast<CpuIsa>(level))) {
+			level--;
+		}
+
+		switch (static_cast<CpuIsa>(level)) {
+			case CpuIsa::AVX512: this->kernels = getAvx512BvhKernels(); break;
+			case CpuIsa::AVX2: this->kernels = getAvx2BvhKernels(); break;
+			case CpuIsa::SSE: this->kernels = getSseBvhKernels(); break;
+			default: this->kernels = getScalarBvhKernels(); break;
+		}
+	}
+
+	bool EngineCpuBvh::isIsaSupported(CpuIsa isa) {
+		switch (isa) {
+			case CpuIsa::Scalar:
+				return true;
+
+		#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+			case CpuIsa::SSE:
+				return getSseBvhKernels() != nullptr && __builtin_cpu_supports("sse2");
+			case CpuIsa::AVX2:
+				return getAvx2BvhKernels() != nullptr && __builtin_cpu_supports("avx2");
+			case CpuIsa::AVX512:
+				return getAvx512BvhKernels() != nullptr && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl");
+		#endif
+
+			default:
+				return false;
+		}
+	}
+
+	CpuIsa EngineCpuBvh::detectIsa() {
+		for (CpuIsa isa : { CpuIsa::AVX512, CpuIsa::AVX2, CpuIsa::SSE }) {
+			if (EngineCpuBvh::isIsaSupported(isa)) {
+				return isa;
+			}
+		}
+
+		return CpuIsa::Scalar;
+	}
+
+	const char* EngineCpuBvh::getIsaName(CpuIsa isa) {
+		switch (isa) {
+			case CpuIsa::SSE: return "sse";
+			case CpuIsa::AVX2: return "avx2";
+			case CpuIsa::AVX512: return "avx512";
+			default: return "scalar";
+		}
+	}
+} // namespace nugiEngine
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "../ray_ubo.hpp"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace nugiEngine {
+	enum class CpuIsa : uint32_t {
+		Scalar = 0,
+		SSE = 1,
+		AVX2 = 2,
+		AVX512 = 3
+	};
+
+	struct CpuRay {
+		glm::vec3 origin;
+		glm::vec3 direction;
+
+		float tMin = 0.001f;
+		float tMax = 1000000.0f;
+	};
+
+	struct CpuHit {
+		static constexpr uint32_t NO_HIT = ~0u;
+
+		uint32_t objIndex = NO_HIT;
+		float t = 0.0f;
+		float u = 0.0f;
+		float v = 0.0f;
+
+		bool isHit() const { return this->objIndex != NO_HIT; }
+	};
+
+	// eight children per node, bounds stored per axis so one slab test covers them all
+	struct alignas(32) Bvh8Node {
+		static constexpr uint32_t WIDTH = 8;
+
+		float minX[WIDTH], minY[WIDTH], minZ[WIDTH];
+		float maxX[WIDTH], maxY[WIDTH], maxZ[WIDTH];
+
+		// primCounts[i] == 0 means children[i] is a node, otherwise children[i] is the first triangle of a leaf
+		uint32_t children[WIDTH];
+		uint32_t primCounts[WIDTH];
+
+		uint32_t validMask = 0;
+	};
+
+	// triangles laid out in leaf order, with the edges the intersection test needs already computed
+	struct CpuTriangle {
+		glm::vec3 point0;
+		glm::vec3 edge1;
+		glm::vec3 edge2;
+
+		uint32_t objIndex;
+	};
+
+	class EngineCpuBvh;
+
+	struct CpuBvhKernels {
+		CpuIsa isa;
+		uint32_t packetWidth;
+
+		void (*intersect)(const EngineCpuBvh& bvh, const CpuRay& ray, CpuHit& hit);
+		bool (*occluded)(const EngineCpuBvh& bvh, const CpuRay& ray);
+
+		// traces rayCount <= packetWidth coherent rays together
+		void (*intersectPacket)(const EngineCpuBvh& bvh, const CpuRay* rays, CpuHit* hits, uint32_t rayCount);
+	};
+
+	/*
+	 * CPU traversal of the flattened BvhNode array the trace shader reads.
+	 * The binary tree is collapsed into 8-wide nodes, each visit tests the ray against all eight child boxes at once.
+	 * Packets of 4 or 8 coherent rays (e.g. primary rays of a tile) walk the tree together, one box against all of their rays.
+	 * The kernels are compiled for scalar, SSE, AVX2 and AVX-512 and the widest one the CPU supports is picked at runtime.
+	 * Hits follow the rules of hitTriangle in ray_trace_pbrt.comp, so results match the GPU traversal
+	 */
+	class EngineCpuBvh {
+		public:
+			EngineCpuBvh(const std::vector<Object>& objects, const std::vector<BvhNode>& bvhNodes);
+
+			EngineCpuBvh(const EngineCpuBvh&) = delete;
+			EngineCpuBvh& operator = (const EngineCpuBvh&) = delete;
+
+			CpuHit intersect(const CpuRay& ray) const;
+			bool occluded(const CpuRay& ray) const;
+
+			void intersect4(const CpuRay rays[4], CpuHit hits[4]) const;
+			void intersect8(const CpuRay rays[8], CpuHit hits[8]) const;
+
+			CpuIsa getIsa() const { return this->kernels->isa; }
+
+			// falls back to the widest supported ISA at or below the requested one
+			void setIsa(CpuIsa isa);
+
+			const std::vector<Bvh8Node>& getNodes() const { return this->nodes; }
+			const std::vector<CpuTriangle>& getTriangles() const { return this->triangles; }
+
+			static CpuIsa detectIsa();
+			static bool isIsaSupported(CpuIsa isa);
+			static const char* getIsaName(CpuIsa isa);
+
+		private:
+			uint32_t collapseNode(const std::vector<Object>& objects, const std::vector<BvhNode>& bvhNodes, int binaryNodeIndex);
+			void intersectRays(const CpuRay* rays, CpuHit* hits, uint32_t rayCount) const;
+
+			std::vector<Bvh8Node> nodes;
+			std::vector<CpuTriangle> triangles;
+
+			const CpuBvhKernels* kernels = nullptr;
+	};
+
+	// one kernel table per ISA, the SIMD ones are null when the compiler does not target x86
+	const CpuBvhKernels* getScalarBvhKernels();
+	const CpuBvhKernels* getSseBvhKernels();
+	const CpuBvhKernels* getAvx2BvhKernels();
+	const CpuBvhKernels* getAvx512BvhKernels();
+} // namespace nugiEngine
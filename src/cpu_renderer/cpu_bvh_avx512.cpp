@@ -0,0 +1,71 @@
+#include "cpu_bvh.hpp"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include <immintrin.h>
+
+// AVX-512VL on 256-bit registers: compares go straight into mask registers, so no movemask is needed
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2,avx512f,avx512vl"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2,avx512f,avx512vl")
+#endif
+
+namespace nugiEngine {
+	namespace {
+		constexpr uint32_t W = 8;
+
+		struct VFloat {
+			__m256 value;
+		};
+
+		using VMask = __mmask8;
+
+		inline VFloat vset(float value) { return { _mm256_set1_ps(value) }; }
+		inline VFloat vload(const float* values) { return { _mm256_loadu_ps(values) }; }
+		inline void vstore(float* values, VFloat value) { _mm256_storeu_ps(values, value.value); }
+
+		inline VFloat operator + (VFloat a, VFloat b) { return { _mm256_add_ps(a.value, b.value) }; }
+		inline VFloat operator - (VFloat a, VFloat b) { return { _mm256_sub_ps(a.value, b.value) }; }
+		inline VFloat operator * (VFloat a, VFloat b) { return { _mm256_mul_ps(a.value, b.value) }; }
+		inline VFloat operator / (VFloat a, VFloat b) { return { _mm256_div_ps(a.value, b.value) }; }
+
+		inline VFloat vmin(VFloat a, VFloat b) { return { _mm256_min_ps(a.value, b.value) }; }
+		inline VFloat vmax(VFloat a, VFloat b) { return { _mm256_max_ps(a.value, b.value) }; }
+
+		inline VMask vle(VFloat a, VFloat b) { return _mm256_cmp_ps_mask(a.value, b.value, _CMP_LE_OQ); }
+		inline VMask vlt(VFloat a, VFloat b) { return _mm256_cmp_ps_mask(a.value, b.value, _CMP_LT_OQ); }
+		inline VMask vand(VMask a, VMask b) { return static_cast<VMask>(a & b); }
+		inline uint32_t vbits(VMask mask) { return static_cast<uint32_t>(mask); }
+	}
+
+	#include "cpu_bvh_kernels.inl"
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+namespace nugiEngine {
+	const CpuBvhKernels* getAvx512BvhKernels() {
+		static const CpuBvhKernels kernels{ CpuIsa::AVX512, W, intersect, occluded, intersectPacket };
+		return &kernels;
+	}
+} // namespace nugiEngine
+
+#else
+
+namespace nugiEngine {
+	const CpuBvhKernels* getAvx512BvhKernels() {
+		return nullptr;
+	}
+} // namespace nugiEngine
+
+#endif
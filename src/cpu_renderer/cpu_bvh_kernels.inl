@@ -0,0 +1,352 @@
+// Traversal kernels shared by every ISA, included once per cpu_bvh_<isa>.cpp.
+// The including file provides, for its vector width W:
+//   VFloat, VMask, vset, vload, vstore, vmin, vmax, vle, vlt, vand, vbits and the arithmetic operators on VFloat.
+// Everything here has internal linkage, so each translation unit gets its own copy compiled for its own ISA.
+// <cmath>, <limits> and <stdexcept> have to be included by that file before its target pragma
+
+namespace {
+	constexpr float KEPSILON = 0.00001f;
+	constexpr uint32_t STACK_SIZE = 256;
+
+	struct RayData {
+		VFloat originX, originY, originZ;
+		VFloat invDirX, invDirY, invDirZ;
+		VFloat tMin;
+	};
+
+	struct StackEntry {
+		uint32_t nodeIndex;
+		float tNear;
+	};
+
+	struct PacketStackEntry {
+		uint32_t nodeIndex;
+		uint32_t rayMask;
+	};
+
+	inline RayData createRayData(const CpuRay& ray) {
+		RayData rayData;
+		rayData.originX = vset(ray.origin.x);
+		rayData.originY = vset(ray.origin.y);
+		rayData.originZ = vset(ray.origin.z);
+		rayData.invDirX = vset(1.0f / ray.direction.x);
+		rayData.invDirY = vset(1.0f / ray.direction.y);
+		rayData.invDirZ = vset(1.0f / ray.direction.z);
+		rayData.tMin = vset(ray.tMin);
+
+		return rayData;
+	}
+
+	// returns a bit per child whose box the ray enters before tMax, with the entry distance in tNear
+	inline uint32_t intersectChildren(const Bvh8Node& node, const RayData& ray, float tMax, float* tNear) {
+		VFloat maxDistance = vset(tMax);
+		uint32_t hitMask = 0;
+
+		for (uint32_t group = 0; group < Bvh8Node::WIDTH; group += W) {
+			VFloat tx0 = (vload(node.minX + group) - ray.originX) * ray.invDirX;
+			VFloat tx1 = (vload(node.maxX + group) - ray.originX) * ray.invDirX;
+			VFloat ty0 = (vload(node.minY + group) - ray.originY) * ray.invDirY;
+			VFloat ty1 = (vload(node.maxY + group) - ray.originY) * ray.invDirY;
+			VFloat tz0 = (vload(node.minZ + group) - ray.originZ) * ray.invDirZ;
+			VFloat tz1 = (vload(node.maxZ + group) - ray.originZ) * ray.invDirZ;
+
+			VFloat entryDistance = vmax(vmax(vmin(tx0, tx1), vmin(ty0, ty1)), vmax(vmin(tz0, tz1), ray.tMin));
+			VFloat exitDistance = vmin(vmin(vmax(tx0, tx1), vmax(ty0, ty1)), vmin(vmax(tz0, tz1), maxDistance));
+
+			vstore(tNear + group, entryDistance);
+			hitMask |= vbits(vle(entryDistance, exitDistance)) << group;
+		}
+
+		return hitMask & node.validMask;
+	}
+
+	// the same test as hitTriangle in ray_trace_pbrt.comp
+	inline bool intersectTriangle(const CpuTriangle& triangle, const CpuRay& ray, float tMax, float& t, float& u, float& v) {
+		glm::vec3 pvec = glm::cross(ray.direction, triangle.edge2);
+		float det = glm::dot(triangle.edge1, pvec);
+
+		if (std::abs(det) < KEPSILON) {
+			return false;
+		}
+
+		float invDet = 1.0f / det;
+
+		glm::vec3 tvec = ray.origin - triangle.point0;
+		u = glm::dot(tvec, pvec) * invDet;
+		if (u < 0.0f || u > 1.0f) {
+			return false;
+		}
+
+		glm::vec3 qvec = glm::cross(tvec, triangle.edge1);
+		v = glm::dot(ray.direction, qvec) * invDet;
+		if (v < 0.0f || u + v > 1.0f) {
+			return false;
+		}
+
+		t = glm::dot(triangle.edge2, qvec) * invDet;
+		return t > KEPSILON && t >= ray.tMin && t <= tMax;
+	}
+
+	inline void pushStack(StackEntry* stack, uint32_t& stackSize, StackEntry entry) {
+		if (stackSize == STACK_SIZE) {
+			throw std::runtime_error("bvh is too deep for the cpu traversal stack");
+		}
+
+		stack[stackSize++] = entry;
+	}
+
+	void intersect(const EngineCpuBvh& bvh, const CpuRay& ray, CpuHit& hit) {
+		hit = CpuHit{};
+
+		const auto &nodes = bvh.getNodes();
+		const auto &triangles = bvh.getTriangles();
+
+		if (nodes.empty()) {
+			return;
+		}
+
+		RayData rayData = createRayData(ray);
+		float tMax = ray.tMax;
+
+		StackEntry stack[STACK_SIZE];
+		uint32_t stackSize = 0;
+
+		pushStack(stack, stackSize, { 0, -std::numeric_limits<float>::infinity() });
+
+		while (stackSize > 0) {
+			StackEntry entry = stack[--stackSize];
+			if (entry.tNear > tMax) {
+				continue;
+			}
+
+			const Bvh8Node &node = nodes[entry.nodeIndex];
+
+			alignas(32) float tNear[Bvh8Node::WIDTH];
+			uint32_t hitMask = intersectChildren(node, rayData, tMax, tNear);
+
+			// leaves are tested right away, they may shorten tMax before any child node is pushed
+			StackEntry childEntries[Bvh8Node::WIDTH];
+			uint32_t childCount = 0;
+
+			for (uint32_t lane = 0; lane < Bvh8Node::WIDTH; lane++) {
+				if ((hitMask & (1u << lane)) == 0) {
+					continue;
+				}
+
+				if (node.primCounts[lane] == 0) {
+					childEntries[childCount++] = { node.children[lane], tNear[lane] };
+					continue;
+				}
+
+				for (uint32_t i = 0; i < node.primCounts[lane]; i++) {
+					const CpuTriangle &triangle = triangles[node.children[lane] + i];
+					float t, u, v;
+
+					if (intersectTriangle(triangle, ray, tMax, t, u, v)) {
+						tMax = t;
+						hit = CpuHit{ triangle.objIndex, t, u, v };
+					}
+				}
+			}
+
+			// farthest first, so the nearest child is popped next
+			for (uint32_t i = 1; i < childCount; i++) {
+				StackEntry childEntry = childEntries[i];
+				uint32_t j = i;
+
+				for (; j > 0 && childEntries[j - 1].tNear < childEntry.tNear; j--) {
+					childEntries[j] = childEntries[j - 1];
+				}
+
+				childEntries[j] = childEntry;
+			}
+
+			for (uint32_t i = 0; i < childCount; i++) {
+				if (childEntries[i].tNear <= tMax) {
+					pushStack(stack, stackSize, childEntries[i]);
+				}
+			}
+		}
+	}
+
+	bool occluded(const EngineCpuBvh& bvh, const CpuRay& ray) {
+		const auto &nodes = bvh.getNodes();
+		const auto &triangles = bvh.getTriangles();
+
+		if (nodes.empty()) {
+			return false;
+		}
+
+		RayData rayData = createRayData(ray);
+
+		StackEntry stack[STACK_SIZE];
+		uint32_t stackSize = 0;
+
+		pushStack(stack, stackSize, { 0, 0.0f });
+
+		while (stackSize > 0) {
+			const Bvh8Node &node = nodes[stack[--stackSize].nodeIndex];
+
+			alignas(32) float tNear[Bvh8Node::WIDTH];
+			uint32_t hitMask = intersectChildren(node, rayData, ray.tMax, tNear);
+
+			for (uint32_t lane = 0; lane < Bvh8Node::WIDTH; lane++) {
+				if ((hitMask & (1u << lane)) == 0) {
+					continue;
+				}
+
+				if (node.primCounts[lane] == 0) {
+					pushStack(stack, stackSize, { node.children[lane], tNear[lane] });
+					continue;
+				}
+
+				for (uint32_t i = 0; i < node.primCounts[lane]; i++) {
+					float t, u, v;
+					if (intersectTriangle(triangles[node.children[lane] + i], ray, ray.tMax, t, u, v)) {
+						return true;
+					}
+				}
+			}
+		}
+
+		return false;
+	}
+
+	// one triangle against every ray of the packet, lanes outside rayMask are left alone
+	inline void intersectTrianglePacket(const CpuTriangle& triangle, uint32_t rayMask, const VFloat* origin, const VFloat* direction, 
+		const VFloat& tMin, float* tMax, CpuHit* hits) 
+	{
+		VFloat edge1X = vset(triangle.edge1.x), edge1Y = vset(triangle.edge1.y), edge1Z = vset(triangle.edge1.z);
+		VFloat edge2X = vset(triangle.edge2.x), edge2Y = vset(triangle.edge2.y), edge2Z = vset(triangle.edge2.z);
+
+		VFloat pvecX = direction[1] * edge2Z - direction[2] * edge2Y;
+		VFloat pvecY = direction[2] * edge2X - direction[0] * edge2Z;
+		VFloat pvecZ = direction[0] * edge2Y - direction[1] * edge2X;
+
+		VFloat det = edge1X * pvecX + edge1Y * pvecY + edge1Z * pvecZ;
+		VFloat absDet = vmax(det, vset(0.0f) - det);
+		VFloat invDet = vset(1.0f) / det;
+
+		VFloat tvecX = origin[0] - vset(triangle.point0.x);
+		VFloat tvecY = origin[1] - vset(triangle.point0.y);
+		VFloat tvecZ = origin[2] - vset(triangle.point0.z);
+
+		VFloat u = (tvecX * pvecX + tvecY * pvecY + tvecZ * pvecZ) * invDet;
+
+		VFloat qvecX = tvecY * edge1Z - tvecZ * edge1Y;
+		VFloat qvecY = tvecZ * edge1X - tvecX * edge1Z;
+		VFloat qvecZ = tvecX * edge1Y - tvecY * edge1X;
+
+		VFloat v = (direction[0] * qvecX + direction[1] * qvecY + direction[2] * qvecZ) * invDet;
+		VFloat t = (edge2X * qvecX + edge2Y * qvecY + edge2Z * qvecZ) * invDet;
+
+		VFloat zero = vset(0.0f), one = vset(1.0f), epsilon = vset(KEPSILON);
+
+		VMask valid = vand(vle(epsilon, absDet), vand(vle(zero, u), vle(u, one)));
+		valid = vand(valid, vand(vle(zero, v), vle(u + v, one)));
+		valid = vand(valid, vand(vlt(epsilon, t), vand(vle(tMin, t), vle(t, vload(tMax)))));
+
+		uint32_t hitMask = vbits(valid) & rayMask;
+		if (hitMask == 0) {
+			return;
+		}
+
+		alignas(32) float hitT[W], hitU[W], hitV[W];
+		vstore(hitT, t);
+		vstore(hitU, u);
+		vstore(hitV, v);
+
+		for (uint32_t lane = 0; lane < W; lane++) {
+			if (hitMask & (1u << lane)) {
+				tMax[lane] = hitT[lane];
+				hits[lane] = CpuHit{ triangle.objIndex, hitT[lane], hitU[lane], hitV[lane] };
+			}
+		}
+	}
+
+	void intersectPacket(const EngineCpuBvh& bvh, const CpuRay* rays, CpuHit* hits, uint32_t rayCount) {
+		const auto &nodes = bvh.getNodes();
+		const auto &triangles = bvh.getTriangles();
+
+		alignas(32) float originX[W], originY[W], originZ[W];
+		alignas(32) float directionX[W], directionY[W], directionZ[W];
+		alignas(32) float invDirX[W], invDirY[W], invDirZ[W];
+		alignas(32) float tMin[W], tMax[W];
+
+		CpuHit packetHits[W];
+
+		// unused lanes repeat the first ray and are masked out
+		for (uint32_t lane = 0; lane < W; lane++) {
+			const CpuRay &ray = rays[lane < rayCount ? lane : 0];
+
+			originX[lane] = ray.origin.x;
+			originY[lane] = ray.origin.y;
+			originZ[lane] = ray.origin.z;
+			directionX[lane] = ray.direction.x;
+			directionY[lane] = ray.direction.y;
+			directionZ[lane] = ray.direction.z;
+			invDirX[lane] = 1.0f / ray.direction.x;
+			invDirY[lane] = 1.0f / ray.direction.y;
+			invDirZ[lane] = 1.0f / ray.direction.z;
+			tMin[lane] = ray.tMin;
+			tMax[lane] = ray.tMax;
+		}
+
+		uint32_t activeMask = (rayCount >= 32) ? ~0u : (1u << rayCount) - 1u;
+
+		if (!nodes.empty()) {
+			VFloat origin[3] = { vload(originX), vload(originY), vload(originZ) };
+			VFloat direction[3] = { vload(directionX), vload(directionY), vload(directionZ) };
+			VFloat invDir[3] = { vload(invDirX), vload(invDirY), vload(invDirZ) };
+			VFloat minDistance = vload(tMin);
+
+			PacketStackEntry stack[STACK_SIZE];
+			uint32_t stackSize = 0;
+
+			stack[stackSize++] = { 0, activeMask };
+
+			while (stackSize > 0) {
+				PacketStackEntry entry = stack[--stackSize];
+				const Bvh8Node &node = nodes[entry.nodeIndex];
+
+				for (uint32_t lane = 0; lane < Bvh8Node::WIDTH; lane++) {
+					if ((node.validMask & (1u << lane)) == 0) {
+						continue;
+					}
+
+					VFloat tx0 = (vset(node.minX[lane]) - origin[0]) * invDir[0];
+					VFloat tx1 = (vset(node.maxX[lane]) - origin[0]) * invDir[0];
+					VFloat ty0 = (vset(node.minY[lane]) - origin[1]) * invDir[1];
+					VFloat ty1 = (vset(node.maxY[lane]) - origin[1]) * invDir[1];
+					VFloat tz0 = (vset(node.minZ[lane]) - origin[2]) * invDir[2];
+					VFloat tz1 = (vset(node.maxZ[lane]) - origin[2]) * invDir[2];
+
+					VFloat entryDistance = vmax(vmax(vmin(tx0, tx1), vmin(ty0, ty1)), vmax(vmin(tz0, tz1), minDistance));
+					VFloat exitDistance = vmin(vmin(vmax(tx0, tx1), vmax(ty0, ty1)), vmin(vmax(tz0, tz1), vload(tMax)));
+
+					uint32_t rayMask = vbits(vle(entryDistance, exitDistance)) & entry.rayMask;
+					if (rayMask == 0) {
+						continue;
+					}
+
+					if (node.primCounts[lane] == 0) {
+						if (stackSize == STACK_SIZE) {
+							throw std::runtime_error("bvh is too deep for the cpu traversal stack");
+						}
+
+						stack[stackSize++] = { node.children[lane], rayMask };
+						continue;
+					}
+
+					for (uint32_t i = 0; i < node.primCounts[lane]; i++) {
+						intersectTrianglePacket(triangles[node.children[lane] + i], rayMask, origin, direction, minDistance, tMax, packetHits);
+					}
+				}
+			}
+		}
+
+		for (uint32_t lane = 0; lane < rayCount; lane++) {
+			hits[lane] = packetHits[lane];
+		}
+	}
+}
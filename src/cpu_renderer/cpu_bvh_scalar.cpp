@@ -0,0 +1,34 @@
+#include "cpu_bvh.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace nugiEngine {
+	namespace {
+		constexpr uint32_t W = 1;
+
+		using VFloat = float;
+		using VMask = bool;
+
+		inline VFloat vset(float value) { return value; }
+		inline VFloat vload(const float* values) { return *values; }
+		inline void vstore(float* values, VFloat value) { *values = value; }
+
+		inline VFloat vmin(VFloat a, VFloat b) { return std::min(a, b); }
+		inline VFloat vmax(VFloat a, VFloat b) { return std::max(a, b); }
+
+		inline VMask vle(VFloat a, VFloat b) { return a <= b; }
+		inline VMask vlt(VFloat a, VFloat b) { return a < b; }
+		inline VMask vand(VMask a, VMask b) { return a && b; }
+		inline uint32_t vbits(VMask mask) { return mask ? 1u : 0u; }
+	}
+
+	#include "cpu_bvh_kernels.inl"
+
+	const CpuBvhKernels* getScalarBvhKernels() {
+		static const CpuBvhKernels kernels{ CpuIsa::Scalar, W, intersect, occluded, intersectPacket };
+		return &kernels;
+	}
+} // namespace nugiEngine
@@ -0,0 +1,71 @@
+#include "cpu_bvh.hpp"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include <immintrin.h>
+
+// SSE2 is part of x86-64, the pragma only matters for 32-bit builds
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("sse2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+
+namespace nugiEngine {
+	namespace {
+		constexpr uint32_t W = 4;
+
+		struct VFloat {
+			__m128 value;
+		};
+
+		using VMask = __m128;
+
+		inline VFloat vset(float value) { return { _mm_set1_ps(value) }; }
+		inline VFloat vload(const float* values) { return { _mm_loadu_ps(values) }; }
+		inline void vstore(float* values, VFloat value) { _mm_storeu_ps(values, value.value); }
+
+		inline VFloat operator + (VFloat a, VFloat b) { return { _mm_add_ps(a.value, b.value) }; }
+		inline VFloat operator - (VFloat a, VFloat b) { return { _mm_sub_ps(a.value, b.value) }; }
+		inline VFloat operator * (VFloat a, VFloat b) { return { _mm_mul_ps(a.value, b.value) }; }
+		inline VFloat operator / (VFloat a, VFloat b) { return { _mm_div_ps(a.value, b.value) }; }
+
+		inline VFloat vmin(VFloat a, VFloat b) { return { _mm_min_ps(a.value, b.value) }; }
+		inline VFloat vmax(VFloat a, VFloat b) { return { _mm_max_ps(a.value, b.value) }; }
+
+		inline VMask vle(VFloat a, VFloat b) { return _mm_cmple_ps(a.value, b.value); }
+		inline VMask vlt(VFloat a, VFloat b) { return _mm_cmplt_ps(a.value, b.value); }
+		inline VMask vand(VMask a, VMask b) { return _mm_and_ps(a, b); }
+		inline uint32_t vbits(VMask mask) { return static_cast<uint32_t>(_mm_movemask_ps(mask)); }
+	}
+
+	#include "cpu_bvh_kernels.inl"
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+namespace nugiEngine {
+	const CpuBvhKernels* getSseBvhKernels() {
+		static const CpuBvhKernels kernels{ CpuIsa::SSE, W, intersect, occluded, intersectPacket };
+		return &kernels;
+	}
+} // namespace nugiEngine
+
+#else
+
+namespace nugiEngine {
+	const CpuBvhKernels* getSseBvhKernels() {
+		return nullptr;
+	}
+} // namespace nugiEngine
+
+#endif
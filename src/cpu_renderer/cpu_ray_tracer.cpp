@@ -0,0 +1,435 @@
+#include "cpu_ray_tracer.hpp"
+
+#include "../model/bvh.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+
+namespace nugiEngine {
+	namespace {
+		constexpr float KEPSILON = 0.00001f;
+		constexpr float pi = 3.14159265359f;
+
+		// ------------- Random -------------
+
+		uint32_t stepRNG(uint32_t rngState) {
+			return rngState * 747796405u + 1u;
+		}
+
+		float stepAndOutputRNGFloat(uint32_t& rngState) {
+			rngState = stepRNG(rngState);
+			uint32_t word = ((rngState >> ((rngState >> 28) + 4)) ^ rngState) * 277803737u;
+			word = (word >> 22) ^ word;
+			return static_cast<float>(word) / 4294967295.0f;
+		}
+
+		// ------------- Hit Shape -------------
+
+		void buildOnb(const glm::vec3& normal, glm::vec3 onb[3]) {
+			glm::vec3 a = std::abs(glm::normalize(normal).x) > 0.9f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+
+			onb[2] = glm::normalize(normal);
+			onb[1] = glm::normalize(glm::cross(onb[2], a));
+			onb[0] = glm::cross(onb[2], onb[1]);
+		}
+
+		template<typename HitRecord, typename Ray>
+		HitRecord hitTriangle(const Triangle& obj, const Ray& r, float tMin, float tMax) {
+			HitRecord hit{};
+
+			glm::vec3 v0v1 = obj.point1 - obj.point0;
+			glm::vec3 v0v2 = obj.point2 - obj.point0;
+			glm::vec3 pvec = glm::cross(r.direction, v0v2);
+			float det = glm::dot(v0v1, pvec);
+
+			if (std::abs(det) < KEPSILON) {
+				return hit;
+			}
+
+			float invDet = 1.0f / det;
+
+			glm::vec3 tvec = r.origin - obj.point0;
+			float u = glm::dot(tvec, pvec) * invDet;
+			if (u < 0.0f || u > 1.0f) {
+				return hit;
+			}
+
+			glm::vec3 qvec = glm::cross(tvec, v0v1);
+			float v = glm::dot(r.direction, qvec) * invDet;
+			if (v < 0.0f || u + v > 1.0f) {
+				return hit;
+			}
+
+			float t = glm::dot(v0v2, qvec) * invDet;
+
+			if (t <= KEPSILON || t < tMin || t > tMax) {
+				return hit;
+			}
+
+			hit.isHit = true;
+			hit.t = t;
+			hit.point = r.origin + t * r.direction;
+			hit.uv = glm::vec2(u, v);
+
+			glm::vec3 outwardNormal = glm::normalize(glm::cross(v0v1, v0v2));
+			hit.frontFace = glm::dot(r.direction, outwardNormal) < 0.0f;
+			hit.normal = hit.frontFace ? outwardNormal : -1.0f * outwardNormal;
+
+			return hit;
+		}
+
+		// ------------- Denoiser Shape -------------
+
+		float areaTriangle(const Triangle& obj) {
+			glm::vec3 pvec = glm::cross(obj.point1 - obj.point0, obj.point2 - obj.point0);
+			return 0.5f * std::sqrt(glm::dot(pvec, pvec));
+		}
+
+		// ------------- GGX -------------
+
+		float fresnelSchlick(float VoH, float F0) {
+			return F0 + (1.0f - F0) * std::pow(1.0f - VoH, 5.0f);
+		}
+
+		float D_GGX(float NoH, float roughness) {
+			float r = std::max(roughness, 0.05f);
+
+			float alpha = r * r;
+			float alpha2 = alpha * alpha;
+
+			float b = (NoH * NoH * (alpha2 - 1.0f) + 1.0f);
+			return alpha2 / (pi * b * b);
+		}
+
+		float G1_GGX(float cosine, float roughness) {
+			float alpha = roughness * roughness;
+			float alpha2 = alpha * alpha;
+
+			float b = alpha2 + (1.0f - alpha2) * cosine * cosine;
+			return 2.0f * cosine / (cosine + std::sqrt(b));
+		}
+
+		float G_Smith(float NoV, float NoL, float roughness) {
+			return G1_GGX(NoL, roughness) * G1_GGX(NoV, roughness);
+		}
+
+		float ggxPdfValue(float NoH, float NoL, float roughness) {
+			return D_GGX(NoH, roughness) * NoH / (4.0f * NoL);
+		}
+
+		float cosinePdfValue(const glm::vec3& normal, const glm::vec3& direction) {
+			float cosine = glm::dot(glm::normalize(direction), normal);
+			return std::max(cosine, 0.0001f) / pi;
+		}
+
+		uint8_t toSrgb(float linear) {
+			linear = glm::clamp(linear, 0.0f, 1.0f);
+			float srgb = linear <= 0.0031308f ? linear * 12.92f : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+
+			return static_cast<uint8_t>(srgb * 255.0f + 0.5f);
+		}
+	}
+
+	float EngineCpuRayTracer::RandomState::randomFloat(uint32_t index) {
+		return stepAndOutputRNGFloat(this->states[index]);
+	}
+
+	int EngineCpuRayTracer::RandomState::randomInt(float min, float max, uint32_t index) {
+		// the shader can return max + 1 when the stream yields exactly 1.0, the CPU version must not index past the end
+		return std::min(static_cast<int>(min + (max + 1.0f - min) * this->randomFloat(index)), static_cast<int>(max));
+	}
+
+	EngineCpuRayTracer::EngineCpuRayTracer(const RayTraceModelData& data, std::vector<BvhNode> bvhNodes, uint32_t width, uint32_t height, 
+		uint32_t nSample, uint32_t threadCount) : data{data}, width{width}, height{height}, nSample{nSample}, scheduler{threadCount}
+	{
+		if (this->data.lights.empty()) {
+			throw std::runtime_error("the cpu ray tracer needs at least one light");
+		}
+
+		this->bvh = std::make_unique<EngineCpuBvh>(this->data.objects, bvhNodes);
+		this->accumulatedColors.resize(static_cast<size_t>(this->width) * this->height, glm::vec4(0.0f));
+	}
+
+	EngineCpuRayTracer::EngineCpuRayTracer(const RayTraceModelData& data, uint32_t width, uint32_t height, uint32_t nSample, uint32_t threadCount)
+		: EngineCpuRayTracer(data, EngineCpuRayTracer::createBvhNodes(data), width, height, nSample, threadCount) {}
+
+	std::vector<BvhNode> EngineCpuRayTracer::createBvhNodes(const RayTraceModelData& data) {
+		std::vector<ObjectBoundBox> objects;
+		for (size_t i = 0; i < data.objects.size(); i++) {
+			objects.push_back({static_cast<int>(i), data.objects[i]});
+		}
+
+		return createBvh(objects);
+	}
+
+	void EngineCpuRayTracer::resetAccumulation() {
+		std::fill(this->accumulatedColors.begin(), this->accumulatedColors.end(), glm::vec4(0.0f));
+		this->frameCount = 0;
+	}
+
+	void EngineCpuRayTracer::renderFrame(const RayTraceUbo& ubo, uint32_t randomSeed) {
+		uint32_t tileCountX = (this->width + TILE_SIZE - 1) / TILE_SIZE;
+		uint32_t tileCountY = (this->height + TILE_SIZE - 1) / TILE_SIZE;
+
+		// the shader seeds its streams from gl_NumWorkGroups * gl_WorkGroupSize, which is the image rounded up to the 8x8 group
+		uint32_t dispatchWidth = (this->width + 7) / 8 * 8;
+		uint32_t dispatchHeight = (this->height + 7) / 8 * 8;
+
+		this->scheduler.run(tileCountX * tileCountY, [&](uint32_t tileIndex, uint32_t) {
+			uint32_t firstX = (tileIndex % tileCountX) * TILE_SIZE;
+			uint32_t firstY = (tileIndex / tileCountX) * TILE_SIZE;
+
+			uint32_t lastX = std::min(firstX + TILE_SIZE, this->width);
+			uint32_t lastY = std::min(firstY + TILE_SIZE, this->height);
+
+			for (uint32_t y = firstY; y < lastY; y++) {
+				for (uint32_t x = firstX; x < lastX; x++) {
+					RandomState random{};
+					random.states[0] = (dispatchWidth * x + y) * (randomSeed + 1);
+					random.states[1] = (dispatchWidth * x) * (randomSeed + 1);
+					random.states[2] = (dispatchHeight * y) * (randomSeed + 1);
+
+					// every pixel is written by exactly one tile, no synchronization is needed
+					this->accumulatedColors[static_cast<size_t>(y) * this->width + x] += this->tracePixel(ubo, x, y, random);
+				}
+			}
+		});
+
+		this->frameCount++;
+	}
+
+	glm::vec4 EngineCpuRayTracer::tracePixel(const RayTraceUbo& ubo, uint32_t x, uint32_t y, RandomState& random) const {
+		glm::vec4 totalColor{0.0f};
+
+		for (uint32_t sampleIndex = 0; sampleIndex < this->nSample; sampleIndex++) {
+			float noiseX = random.randomFloat(1) * 2.0f - 1.0f;
+			float noiseY = random.randomFloat(2) * 2.0f - 1.0f;
+
+			glm::vec2 uv = (glm::vec2(x, y) + glm::vec2(noiseX, noiseY)) / glm::vec2(this->width, this->height);
+
+			Ray curRay;
+			curRay.origin = ubo.origin;
+			curRay.direction = ubo.lowerLeftCorner + uv.x * ubo.horizontal - uv.y * ubo.vertical - ubo.origin;
+
+			// nothing in the shader emits, so its affine ray transform reduces to a product of attenuations
+			glm::vec4 lastNum{0.0f};
+			glm::vec3 attenuation{1.0f};
+
+			for (uint32_t i = 0; i < MAX_BOUNCE; i++) {
+				HitRecord hit = this->hitBvh(curRay, 0.001f, 1000000.0f);
+				if (!hit.isHit) {
+					lastNum = glm::vec4(ubo.background, 1.0f);
+					break;
+				}
+
+				HitRecord hittedLight = this->hitLightList(curRay, 0.001f, hit.t);
+				if (hittedLight.isHit) {
+					lastNum = glm::vec4(this->radiance(curRay, hittedLight, hittedLight.objIndex), 1.0f);
+					break;
+				}
+
+				glm::vec3 colorAttenuation;
+				curRay = this->shade(curRay, hit, this->data.objects[hit.objIndex].materialIndex, random, colorAttenuation);
+
+				attenuation *= colorAttenuation;
+			}
+
+			totalColor += glm::clamp(glm::vec4(attenuation * glm::vec3(lastNum), lastNum.w), 0.0f, 1.0f);
+		}
+
+		return totalColor / static_cast<float>(this->nSample);
+	}
+
+	EngineCpuRayTracer::HitRecord EngineCpuRayTracer::hitBvh(const Ray& r, float tMin, float tMax) const {
+		HitRecord hit{};
+		hit.t = tMax;
+
+		CpuHit bvhHit = this->bvh->intersect(CpuRay{ r.origin, r.direction, tMin, tMax });
+		if (!bvhHit.isHit()) {
+			return hit;
+		}
+
+		const Triangle &triangle = this->data.objects[bvhHit.objIndex].triangle;
+
+		hit.isHit = true;
+		hit.objIndex = bvhHit.objIndex;
+		hit.t = bvhHit.t;
+		hit.point = r.origin + bvhHit.t * r.direction;
+		hit.uv = glm::vec2(bvhHit.u, bvhHit.v);
+
+		glm::vec3 outwardNormal = glm::normalize(glm::cross(triangle.point1 - triangle.point0, triangle.point2 - triangle.point0));
+		hit.frontFace = glm::dot(r.direction, outwardNormal) < 0.0f;
+		hit.normal = hit.frontFace ? outwardNormal : -1.0f * outwardNormal;
+
+		return hit;
+	}
+
+	EngineCpuRayTracer::HitRecord EngineCpuRayTracer::hitLightList(const Ray& r, float tMin, float tMax) const {
+		HitRecord hit{};
+		hit.t = tMax;
+
+		for (uint32_t i = 0; i < this->data.lights.size(); i++) {
+			HitRecord tempHit = hitTriangle<HitRecord>(this->data.lights[i].triangle, r, tMin, hit.t);
+			if (tempHit.isHit) {
+				hit = tempHit;
+				hit.objIndex = i;
+			}
+		}
+
+		return hit;
+	}
+
+	float EngineCpuRayTracer::triangleListPdfValue(const Ray& r) const {
+		float weight = 1.0f / static_cast<float>(this->data.lights.size());
+		float sum = 0.0f;
+
+		for (auto &&light : this->data.lights) {
+			HitRecord hit = hitTriangle<HitRecord>(light.triangle, r, 0.001f, 1000.0f);
+			if (!hit.isHit) {
+				continue;
+			}
+
+			float cosine = std::abs(glm::dot(r.direction, hit.normal) / glm::length(r.direction));
+			float distanceSquared = hit.t * hit.t * glm::dot(r.direction, r.direction);
+
+			sum += weight * distanceSquared / (cosine * areaTriangle(light.triangle));
+		}
+
+		return sum;
+	}
+
+	glm::vec3 EngineCpuRayTracer::triangleListGenerateRandom(const glm::vec3& origin, RandomState& random) const {
+		int lightIndex = random.randomInt(0.0f, static_cast<float>(this->data.lights.size() - 1), 1);
+		const Triangle &obj = this->data.lights[lightIndex].triangle;
+
+		glm::vec3 a = obj.point1 - obj.point0;
+		glm::vec3 b = obj.point2 - obj.point0;
+
+		float u1 = random.randomFloat(1);
+		float u2 = random.randomFloat(2);
+
+		if (u1 + u2 > 1.0f) {
+			u1 = 1.0f - u1;
+			u2 = 1.0f - u2;
+		}
+
+		return u1 * a + u2 * b + obj.point0 - origin;
+	}
+
+	EngineCpuRayTracer::Ray EngineCpuRayTracer::shade(const Ray& r, const HitRecord& hit, uint32_t materialIndex, RandomState& random, 
+		glm::vec3& colorAttenuation) const 
+	{
+		const Material &material = this->data.materials[materialIndex];
+		Ray raySpecular;
+
+		float f0 = 0.16f * (material.fresnelReflect * material.fresnelReflect);
+		glm::vec3 unitDirection = glm::normalize(r.direction);
+		glm::vec3 reflected = glm::reflect(unitDirection, hit.normal);
+
+		raySpecular.origin = hit.point;
+		float rand = random.randomFloat(0);
+
+		glm::vec3 globalOnb[3];
+
+		if (material.metallicness >= rand) {
+			buildOnb(reflected, globalOnb);
+
+			// randomGGX
+			float r1 = random.randomFloat(1);
+			float r2 = random.randomFloat(2);
+
+			float a = material.roughness * material.roughness;
+			float phi = 2.0f * pi * r2;
+
+			float cosTheta = std::sqrt((1.0f - r1) / ((a * a - 1.0f) * r1 + 1.0f));
+			float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+
+			raySpecular.direction = std::cos(phi) * sinTheta * globalOnb[0] + std::sin(phi) * sinTheta * globalOnb[1] + cosTheta * globalOnb[2];
+		} else {
+			buildOnb(hit.normal, globalOnb);
+
+			if (random.randomInt(0.0f, 1.0f, 0) == 0) {
+				raySpecular.direction = this->triangleListGenerateRandom(hit.point, random);
+			} else {
+				// randomCosineDirection
+				float r1 = random.randomFloat(1);
+				float r2 = random.randomFloat(2);
+				float phi = 2.0f * pi * r1;
+
+				raySpecular.direction = std::cos(phi) * std::sqrt(r2) * globalOnb[0] + std::sin(phi) * std::sqrt(r2) * globalOnb[1] + 
+					std::sqrt(1.0f - r2) * globalOnb[2];
+			}
+		}
+
+		glm::vec3 unitLightDirection = glm::normalize(raySpecular.direction);
+		glm::vec3 H = glm::normalize(raySpecular.direction - r.direction);
+
+		float NoV = glm::clamp(glm::dot(hit.normal, -1.0f * unitDirection), 0.001f, 1.0f);
+		float NoL = glm::clamp(glm::dot(hit.normal, unitLightDirection), 0.001f, 1.0f);
+		float NoH = glm::clamp(glm::dot(hit.normal, H), 0.001f, 1.0f);
+		float VoH = glm::clamp(glm::dot(unitDirection, H), 0.001f, 1.0f);
+
+		// specular microfacet (cook-torrance) BRDF
+		float F = fresnelSchlick(VoH, f0);
+		float D = D_GGX(NoH, material.roughness);
+		float G = G_Smith(NoV, NoL, material.roughness);
+		float spec = (F * D * G) / (4.0f * NoV * NoL);
+
+		float diff = 1.0f / pi;
+
+		float specPdf = ggxPdfValue(NoH, NoL, material.roughness);
+		float diffPdf = 0.5f * (cosinePdfValue(hit.normal, raySpecular.direction) + this->triangleListPdfValue(raySpecular));
+
+		float pdfVal = glm::mix(diffPdf, specPdf, material.metallicness);
+		float totalBrdf = glm::mix(diff, spec, material.metallicness);
+
+		colorAttenuation = material.baseColor * totalBrdf * NoL / pdfVal;
+		return raySpecular;
+	}
+
+	glm::vec3 EngineCpuRayTracer::radiance(const Ray& r, const HitRecord& hit, uint32_t lightIndex) const {
+		const Light &light = this->data.lights[lightIndex];
+
+		float distance = glm::length(r.origin + hit.t * r.direction) / 10.0f;
+
+		float nom = glm::clamp(1.0f - std::pow(distance / light.radius, 4.0f), 0.0f, 1.0f);
+		float cosine = glm::clamp(glm::dot(hit.normal, -1.0f * glm::normalize(r.direction)), 0.0f, 1.0f);
+
+		float falloff = (nom * nom + 1.0f) / (std::pow(distance, 2.0f) + 1.0f);
+
+		return light.color * falloff * cosine * areaTriangle(light.triangle);
+	}
+
+	std::vector<glm::vec4> EngineCpuRayTracer::getImage() const {
+		std::vector<glm::vec4> image(this->accumulatedColors.size(), glm::vec4(0.0f));
+		if (this->frameCount == 0) {
+			return image;
+		}
+
+		for (size_t i = 0; i < image.size(); i++) {
+			image[i] = this->accumulatedColors[i] / static_cast<float>(this->frameCount);
+		}
+
+		return image;
+	}
+
+	void EngineCpuRayTracer::writeImage(const std::string& filePath) const {
+		std::ofstream file{filePath, std::ios::binary | std::ios::trunc};
+		if (!file.is_open()) {
+			throw std::runtime_error("failed to open image file: " + filePath);
+		}
+
+		file << "P6\n" << this->width << " " << this->height << "\n255\n";
+
+		for (auto &&color : this->getImage()) {
+			uint8_t rgb[3] = { toSrgb(color.r), toSrgb(color.g), toSrgb(color.b) };
+			file.write(reinterpret_cast<const char*>(rgb), sizeof(rgb));
+		}
+
+		if (!file) {
+			throw std::runtime_error("failed to write image file: " + filePath);
+		}
+	}
+} // namespace nugiEngine
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "cpu_bvh.hpp"
+#include "tile_scheduler.hpp"
+#include "../model/ray_trace_model_data.hpp"
+#include "../ray_ubo.hpp"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace nugiEngine {
+	/*
+	 * CPU port of ray_trace_pbrt.comp, for machines without a Vulkan device and as a reference for the GPU output.
+	 * It reads the same RayTraceModelData and flattened BvhNode array (traversed through EngineCpuBvh), draws its random numbers from the same
+	 * PCG streams seeded the same way, and shades with the same GGX / Lambert mix and light sampling.
+	 * Frames are averaged like the sampling raster pass does, so N frames here match N frames on the GPU within noise
+	 */
+	class EngineCpuRayTracer {
+		public:
+			static constexpr uint32_t TILE_SIZE = 16;
+			static constexpr uint32_t MAX_BOUNCE = 50;
+
+			EngineCpuRayTracer(const RayTraceModelData& data, std::vector<BvhNode> bvhNodes, uint32_t width, uint32_t height, 
+				uint32_t nSample, uint32_t threadCount = 0);
+
+			// builds the BVH with createBvh, the same way EngineRayTraceModel does
+			EngineCpuRayTracer(const RayTraceModelData& data, uint32_t width, uint32_t height, uint32_t nSample, uint32_t threadCount = 0);
+
+			EngineCpuRayTracer(const EngineCpuRayTracer&) = delete;
+			EngineCpuRayTracer& operator = (const EngineCpuRayTracer&) = delete;
+
+			// traces nSample paths per pixel with this seed and averages them into the accumulated image
+			void renderFrame(const RayTraceUbo& ubo, uint32_t randomSeed);
+			void resetAccumulation();
+
+			uint32_t getWidth() const { return this->width; }
+			uint32_t getHeight() const { return this->height; }
+			uint32_t getFrameCount() const { return this->frameCount; }
+			uint32_t getThreadCount() const { return this->scheduler.getThreadCount(); }
+
+			const EngineCpuBvh& getBvh() const { return *this->bvh; }
+			EngineCpuBvh& getBvh() { return *this->bvh; }
+
+			// linear color of every pixel, row by row from the top
+			std::vector<glm::vec4> getImage() const;
+
+			// binary PPM, sRGB encoded as the swap chain would present it
+			void writeImage(const std::string& filePath) const;
+
+		private:
+			struct Ray {
+				glm::vec3 origin;
+				glm::vec3 direction;
+			};
+
+			struct HitRecord {
+				bool isHit = false;
+				uint32_t objIndex = 0;
+
+				float t = 0.0f;
+				glm::vec3 point{};
+				glm::vec2 uv{};
+
+				bool frontFace = false;
+				glm::vec3 normal{};
+			};
+
+			// the three PCG streams of helper/random.glsl
+			struct RandomState {
+				uint32_t states[3];
+
+				float randomFloat(uint32_t index);
+				int randomInt(float min, float max, uint32_t index);
+			};
+
+			static std::vector<BvhNode> createBvhNodes(const RayTraceModelData& data);
+
+			glm::vec4 tracePixel(const RayTraceUbo& ubo, uint32_t x, uint32_t y, RandomState& random) const;
+
+			HitRecord hitBvh(const Ray& r, float tMin, float tMax) const;
+			HitRecord hitLightList(const Ray& r, float tMin, float tMax) const;
+
+			float triangleListPdfValue(const Ray& r) const;
+			glm::vec3 triangleListGenerateRandom(const glm::vec3& origin, RandomState& random) const;
+
+			Ray shade(const Ray& r, const HitRecord& hit, uint32_t materialIndex, RandomState& random, glm::vec3& colorAttenuation) const;
+			glm::vec3 radiance(const Ray& r, const HitRecord& hit, uint32_t lightIndex) const;
+
+			RayTraceModelData data;
+			std::unique_ptr<EngineCpuBvh> bvh;
+
+			uint32_t width, height, nSample;
+			uint32_t frameCount = 0;
+
+			std::vector<glm::vec4> accumulatedColors;
+			EngineTileScheduler scheduler;
+	};
+} // namespace nugiEngine
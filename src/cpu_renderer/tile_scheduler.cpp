@@ -0,0 +1,98 @@
+#include "tile_scheduler.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <thread>
+
+namespace nugiEngine {
+	EngineTileScheduler::EngineTileScheduler(uint32_t threadCount) : threadCount{threadCount} {
+		if (this->threadCount == 0) {
+			this->threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+		}
+
+		for (uint32_t i = 0; i < this->threadCount; i++) {
+			this->queues.emplace_back(std::make_unique<WorkQueue>());
+		}
+	}
+
+	void EngineTileScheduler::run(uint32_t taskCount, const std::function<void(uint32_t taskIndex, uint32_t threadIndex)>& task) {
+		// neighbouring tiles usually cost about the same, so each worker starts on a contiguous run of them
+		for (uint32_t i = 0; i < this->threadCount; i++) {
+			uint32_t first = static_cast<uint32_t>(static_cast<uint64_t>(taskCount) * i / this->threadCount);
+			uint32_t last = static_cast<uint32_t>(static_cast<uint64_t>(taskCount) * (i + 1) / this->threadCount);
+
+			auto &queue = *this->queues[i];
+			std::lock_guard<std::mutex> lock{queue.mutex};
+
+			queue.tasks.clear();
+			for (uint32_t taskIndex = first; taskIndex < last; taskIndex++) {
+				queue.tasks.emplace_back(taskIndex);
+			}
+		}
+
+		std::exception_ptr firstError;
+		std::mutex errorMutex;
+
+		auto worker = [&](uint32_t threadIndex) {
+			uint32_t taskIndex = 0;
+
+			while (this->popTask(threadIndex, taskIndex) || this->stealTask(threadIndex, taskIndex)) {
+				try {
+					task(taskIndex, threadIndex);
+				} catch (...) {
+					std::lock_guard<std::mutex> lock{errorMutex};
+					if (!firstError) {
+						firstError = std::current_exception();
+					}
+				}
+			}
+		};
+
+		std::vector<std::thread> threads;
+		for (uint32_t i = 1; i < this->threadCount; i++) {
+			threads.emplace_back(worker, i);
+		}
+
+		// the calling thread is worker 0
+		worker(0);
+
+		for (auto &&thread : threads) {
+			thread.join();
+		}
+
+		if (firstError) {
+			std::rethrow_exception(firstError);
+		}
+	}
+
+	bool EngineTileScheduler::popTask(uint32_t threadIndex, uint32_t& taskIndex) {
+		auto &queue = *this->queues[threadIndex];
+		std::lock_guard<std::mutex> lock{queue.mutex};
+
+		if (queue.tasks.empty()) {
+			return false;
+		}
+
+		taskIndex = queue.tasks.front();
+		queue.tasks.pop_front();
+
+		return true;
+	}
+
+	bool EngineTileScheduler::stealTask(uint32_t threadIndex, uint32_t& taskIndex) {
+		// victims are visited starting next to the thief, so the workers do not all pile onto the same queue
+		for (uint32_t i = 1; i < this->threadCount; i++) {
+			auto &queue = *this->queues[(threadIndex + i) % this->threadCount];
+			std::lock_guard<std::mutex> lock{queue.mutex};
+
+			if (!queue.tasks.empty()) {
+				taskIndex = queue.tasks.back();
+				queue.tasks.pop_back();
+
+				return true;
+			}
+		}
+
+		return false;
+	}
+} // namespace nugiEngine
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace nugiEngine {
+	/*
+	 * Runs a batch of independent tasks (image tiles) across all cores.
+	 * Every worker starts with a contiguous run of tiles in its own queue and takes them from the front,
+	 * a worker whose queue is empty steals from the back of another one, so cheap tiles (background)
+	 * and expensive tiles (many bounces) even out without any tuning
+	 */
+	class EngineTileScheduler {
+		public:
+			// 0 uses every hardware thread
+			EngineTileScheduler(uint32_t threadCount = 0);
+
+			EngineTileScheduler(const EngineTileScheduler&) = delete;
+			EngineTileScheduler& operator = (const EngineTileScheduler&) = delete;
+
+			uint32_t getThreadCount() const { return this->threadCount; }
+
+			// blocks until every task has run, task receives the task index and the index of the worker running it
+			void run(uint32_t taskCount, const std::function<void(uint32_t taskIndex, uint32_t threadIndex)>& task);
+
+		private:
+			struct WorkQueue {
+				std::deque<uint32_t> tasks;
+				std::mutex mutex;
+			};
+
+			bool popTask(uint32_t threadIndex, uint32_t& taskIndex);
+			bool stealTask(uint32_t threadIndex, uint32_t& taskIndex);
+
+			uint32_t threadCount;
+			std::vector<std::unique_ptr<WorkQueue>> queues;
+	};
+} // namespace nugiEngine
@@ -0,0 +1,157 @@
+#include "bindless_descriptor.hpp"
+ 
+// std
+#include <algorithm>
+#include <stdexcept>
+ 
+namespace nugiEngine {
+  // *************** Slot Allocator *********************
+
+  uint32_t EngineBindlessDescriptor::SlotAllocator::allocate() {
+    if (!this->freeIndices.empty()) {
+      uint32_t index = this->freeIndices.back();
+      this->freeIndices.pop_back();
+
+      return index;
+    }
+
+    if (this->nextIndex >= this->capacity) {
+      throw std::runtime_error("bindless descriptor is full!");
+    }
+
+    return this->nextIndex++;
+  }
+
+  void EngineBindlessDescriptor::SlotAllocator::free(uint32_t index) {
+    bool isAllocated = index < this->nextIndex 
+      && std::find(this->freeIndices.begin(), this->freeIndices.end(), index) == this->freeIndices.end();
+
+    if (!isAllocated) {
+      throw std::runtime_error("bindless descriptor slot is not allocated!");
+    }
+
+    this->freeIndices.push_back(index);
+  }
+
+  // *************** Bindless Descriptor *********************
+
+  EngineBindlessDescriptor::EngineBindlessDescriptor(
+      EngineDevice &engineDevice, 
+      uint32_t maxSampledImages, 
+      uint32_t maxStorageImages, 
+      uint32_t maxStorageBuffers,
+      VkShaderStageFlags stageFlags) 
+      : engineDevice{engineDevice} 
+  {
+    if (!this->engineDevice.isBindlessSupported()) {
+      throw std::runtime_error("descriptor indexing is not supported by the device!");
+    }
+
+    VkPhysicalDeviceVulkan12Properties vulkan12Properties{};
+    vulkan12Properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+
+    VkPhysicalDeviceProperties2 properties{};
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties.pNext = &vulkan12Properties;
+    vkGetPhysicalDeviceProperties2(this->engineDevice.getPhysicalDevice(), &properties);
+
+    this->sampledImageSlots.capacity = std::min({ maxSampledImages, vulkan12Properties.maxDescriptorSetUpdateAfterBindSampledImages, 
+      vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSampledImages });
+    this->storageImageSlots.capacity = std::min({ maxStorageImages, vulkan12Properties.maxDescriptorSetUpdateAfterBindStorageImages, 
+      vulkan12Properties.maxPerStageDescriptorUpdateAfterBindStorageImages });
+    this->storageBufferSlots.capacity = std::min({ maxStorageBuffers, vulkan12Properties.maxDescriptorSetUpdateAfterBindStorageBuffers, 
+      vulkan12Properties.maxPerStageDescriptorUpdateAfterBindStorageBuffers });
+
+    VkDescriptorBindingFlags bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT 
+      | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+
+    this->descSetLayout = 
+      EngineDescriptorSetLayout::Builder(this->engineDevice)
+        .addBinding(SAMPLED_IMAGE_BINDING, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, stageFlags, this->sampledImageSlots.capacity, bindingFlags)
+        .addBinding(STORAGE_IMAGE_BINDING, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, stageFlags, this->storageImageSlots.capacity, bindingFlags)
+        .addBinding(STORAGE_BUFFER_BINDING, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stageFlags, this->storageBufferSlots.capacity, bindingFlags)
+        .build();
+
+    this->descriptorPool = 
+      EngineDescriptorPool::Builder(this->engineDevice)
+        .setMaxSets(1)
+        .setPoolFlags(VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT)
+        .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, this->sampledImageSlots.capacity)
+        .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, this->storageImageSlots.capacity)
+        .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, this->storageBufferSlots.capacity)
+        .build();
+
+    if (!this->descriptorPool->allocateDescriptor(this->descSetLayout->getDescriptorSetLayout(), &this->descriptorSet)) {
+      throw std::runtime_error("failed to allocate bindless descriptor set!");
+    }
+  }
+
+  void EngineBindlessDescriptor::writeImage(uint32_t binding, uint32_t index, VkDescriptorImageInfo imageInfo) {
+    EngineDescriptorWriter(*this->descSetLayout, *this->descriptorPool)
+      .writeImage(binding, &imageInfo, 1, index)
+      .overwrite(&this->descriptorSet);
+  }
+
+  void EngineBindlessDescriptor::writeBuffer(uint32_t binding, uint32_t index, VkDescriptorBufferInfo bufferInfo) {
+    EngineDescriptorWriter(*this->descSetLayout, *this->descriptorPool)
+      .writeBuffer(binding, &bufferInfo, 1, index)
+      .overwrite(&this->descriptorSet);
+  }
+
+  uint32_t EngineBindlessDescriptor::addSampledImage(VkDescriptorImageInfo imageInfo) {
+    std::lock_guard<std::mutex> lock(this->slotMutex);
+
+    uint32_t index = this->sampledImageSlots.allocate();
+    this->writeImage(SAMPLED_IMAGE_BINDING, index, imageInfo);
+
+    return index;
+  }
+
+  uint32_t EngineBindlessDescriptor::addStorageImage(VkDescriptorImageInfo imageInfo) {
+    std::lock_guard<std::mutex> lock(this->slotMutex);
+
+    uint32_t index = this->storageImageSlots.allocate();
+    this->writeImage(STORAGE_IMAGE_BINDING, index, imageInfo);
+
+    return index;
+  }
+
+  uint32_t EngineBindlessDescriptor::addStorageBuffer(VkDescriptorBufferInfo bufferInfo) {
+    std::lock_guard<std::mutex> lock(this->slotMutex);
+
+    uint32_t index = this->storageBufferSlots.allocate();
+    this->writeBuffer(STORAGE_BUFFER_BINDING, index, bufferInfo);
+
+    return index;
+  }
+
+  void EngineBindlessDescriptor::updateSampledImage(uint32_t index, VkDescriptorImageInfo imageInfo) {
+    std::lock_guard<std::mutex> lock(this->slotMutex);
+    this->writeImage(SAMPLED_IMAGE_BINDING, index, imageInfo);
+  }
+
+  void EngineBindlessDescriptor::updateStorageImage(uint32_t index, VkDescriptorImageInfo imageInfo) {
+    std::lock_guard<std::mutex> lock(this->slotMutex);
+    this->writeImage(STORAGE_IMAGE_BINDING, index, imageInfo);
+  }
+
+  void EngineBindlessDescriptor::updateStorageBuffer(uint32_t index, VkDescriptorBufferInfo bufferInfo) {
+    std::lock_guard<std::mutex> lock(this->slotMutex);
+    this->writeBuffer(STORAGE_BUFFER_BINDING, index, bufferInfo);
+  }
+
+  void EngineBindlessDescriptor::removeSampledImage(uint32_t index) {
+    std::lock_guard<std::mutex> lock(this->slotMutex);
+    this->sampledImageSlots.free(index);
+  }
+
+  void EngineBindlessDescriptor::removeStorageImage(uint32_t index) {
+    std::lock_guard<std::mutex> lock(this->slotMutex);
+    this->storageImageSlots.free(index);
+  }
+
+  void EngineBindlessDescriptor::removeStorageBuffer(uint32_t index) {
+    std::lock_guard<std::mutex> lock(this->slotMutex);
+    this->storageBufferSlots.free(index);
+  }
+}  // namespace nugiEngine
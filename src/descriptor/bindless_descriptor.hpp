@@ -0,0 +1,77 @@
+#pragma once
+ 
+#include "../device/device.hpp"
+#include "descriptor.hpp"
+ 
+// std
+#include <memory>
+#include <mutex>
+#include <vector>
+ 
+namespace nugiEngine {
+ 
+/*
+ * One descriptor set holding partially bound arrays of sampled images, storage images and storage buffers.
+ * Shaders pick a resource by the index returned from add*(), so a new texture or material is a single
+ * descriptor write instead of a new descriptor set to allocate and bind.
+ * The set is update-after-bind, writes to unused slots are fine while frames using the set are in flight,
+ * but a removed slot must not be read by any frame still in flight when it gets reused
+ */
+class EngineBindlessDescriptor {
+ public:
+  static constexpr uint32_t SAMPLED_IMAGE_BINDING = 0;
+  static constexpr uint32_t STORAGE_IMAGE_BINDING = 1;
+  static constexpr uint32_t STORAGE_BUFFER_BINDING = 2;
+
+  static constexpr uint32_t INVALID_INDEX = ~0u;
+
+  EngineBindlessDescriptor(
+    EngineDevice &engineDevice, 
+    uint32_t maxSampledImages = 4096, 
+    uint32_t maxStorageImages = 256, 
+    uint32_t maxStorageBuffers = 1024,
+    VkShaderStageFlags stageFlags = VK_SHADER_STAGE_ALL
+  );
+
+  EngineBindlessDescriptor(const EngineBindlessDescriptor &) = delete;
+  EngineBindlessDescriptor &operator=(const EngineBindlessDescriptor &) = delete;
+
+  std::shared_ptr<EngineDescriptorSetLayout> getDescriptorSetLayout() const { return this->descSetLayout; }
+  VkDescriptorSet getDescriptorSet() const { return this->descriptorSet; }
+
+  uint32_t addSampledImage(VkDescriptorImageInfo imageInfo);
+  uint32_t addStorageImage(VkDescriptorImageInfo imageInfo);
+  uint32_t addStorageBuffer(VkDescriptorBufferInfo bufferInfo);
+
+  void updateSampledImage(uint32_t index, VkDescriptorImageInfo imageInfo);
+  void updateStorageImage(uint32_t index, VkDescriptorImageInfo imageInfo);
+  void updateStorageBuffer(uint32_t index, VkDescriptorBufferInfo bufferInfo);
+
+  void removeSampledImage(uint32_t index);
+  void removeStorageImage(uint32_t index);
+  void removeStorageBuffer(uint32_t index);
+
+ private:
+  struct SlotAllocator {
+    uint32_t capacity = 0;
+    uint32_t nextIndex = 0;
+    std::vector<uint32_t> freeIndices{};
+
+    uint32_t allocate();
+    void free(uint32_t index);
+  };
+
+  void writeImage(uint32_t binding, uint32_t index, VkDescriptorImageInfo imageInfo);
+  void writeBuffer(uint32_t binding, uint32_t index, VkDescriptorBufferInfo bufferInfo);
+
+  EngineDevice &engineDevice;
+
+  std::shared_ptr<EngineDescriptorPool> descriptorPool;
+  std::shared_ptr<EngineDescriptorSetLayout> descSetLayout;
+  VkDescriptorSet descriptorSet;
+
+  SlotAllocator sampledImageSlots, storageImageSlots, storageBufferSlots;
+  std::mutex slotMutex;
+};
+ 
+}  // namespace nugiEngine
@@ -1,4 +1,5 @@
 #include "descriptor.hpp"
+#include "../pipeline/layout_cache.hpp"
  
 // std
 #include <cassert>
@@ -11,7 +12,8 @@ namespace nugiEngine {
     uint32_t binding,
     VkDescriptorType descriptorType,
     VkShaderStageFlags stageFlags,
-    uint32_t count) 
+    uint32_t count,
+    VkDescriptorBindingFlags bindingFlags) 
   {
     assert(bindings.count(binding) == 0 && "Binding already in use");
     VkDescriptorSetLayoutBinding layoutBinding{};
@@ -20,25 +22,48 @@ namespace nugiEngine {
     layoutBinding.descriptorCount = count;
     layoutBinding.stageFlags = stageFlags;
     bindings[binding] = layoutBinding;
+
+    if (bindingFlags != 0) {
+      this->bindingFlags[binding] = bindingFlags;
+    }
+
     return *this;
   }
   
   std::shared_ptr<EngineDescriptorSetLayout> EngineDescriptorSetLayout::Builder::build() const {
-    return std::make_shared<EngineDescriptorSetLayout>(this->engineDevice, bindings);
+    return this->engineDevice.getLayoutCache()->getDescriptorSetLayout(this->bindings, this->bindingFlags);
   }
   
   // *************** Descriptor Set Layout *********************
   
   EngineDescriptorSetLayout::EngineDescriptorSetLayout(
-      EngineDevice &engineDevice, std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings)
+      EngineDevice &engineDevice, std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings, 
+      std::unordered_map<uint32_t, VkDescriptorBindingFlags> bindingFlags)
       : engineDevice{engineDevice}, bindings{bindings} {
     std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings{};
+    std::vector<VkDescriptorBindingFlags> setLayoutBindingFlags{};
+    VkDescriptorSetLayoutCreateFlags layoutFlags = 0;
+
     for (auto& kv : bindings) {
       setLayoutBindings.push_back(kv.second);
+
+      auto flags = bindingFlags.count(kv.first) == 1 ? bindingFlags[kv.first] : 0;
+      setLayoutBindingFlags.push_back(flags);
+
+      if (flags & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT) {
+        layoutFlags |= VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+      }
     }
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+    bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    bindingFlagsInfo.bindingCount = static_cast<uint32_t>(setLayoutBindingFlags.size());
+    bindingFlagsInfo.pBindingFlags = setLayoutBindingFlags.data();
   
     VkDescriptorSetLayoutCreateInfo descriptorSetLayoutInfo{};
     descriptorSetLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    descriptorSetLayoutInfo.pNext = bindingFlags.empty() ? nullptr : &bindingFlagsInfo;
+    descriptorSetLayoutInfo.flags = layoutFlags;
     descriptorSetLayoutInfo.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
     descriptorSetLayoutInfo.pBindings = setLayoutBindings.data();
   
@@ -135,7 +160,7 @@ namespace nugiEngine {
   
   EngineDescriptorWriter::EngineDescriptorWriter(EngineDescriptorSetLayout &setLayout, EngineDescriptorPool &pool) : setLayout{setLayout}, pool{pool} {}
   
-  EngineDescriptorWriter &EngineDescriptorWriter::writeBuffer(uint32_t binding, VkDescriptorBufferInfo *bufferInfo, uint32_t count) {
+  EngineDescriptorWriter &EngineDescriptorWriter::writeBuffer(uint32_t binding, VkDescriptorBufferInfo *bufferInfo, uint32_t count, uint32_t arrayElement) {
     assert(setLayout.bindings.count(binding) == 1 && "Layout does not contain specified binding");
   
     auto &bindingDescription = setLayout.bindings[binding];
@@ -144,6 +169,7 @@ namespace nugiEngine {
     write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
     write.descriptorType = bindingDescription.descriptorType;
     write.dstBinding = binding;
+    write.dstArrayElement = arrayElement;
     write.pBufferInfo = bufferInfo;
     write.descriptorCount = count;
   
@@ -151,7 +177,7 @@ namespace nugiEngine {
     return *this;
   }
   
-  EngineDescriptorWriter &EngineDescriptorWriter::writeImage(uint32_t binding, VkDescriptorImageInfo *imageInfo, uint32_t count) {
+  EngineDescriptorWriter &EngineDescriptorWriter::writeImage(uint32_t binding, VkDescriptorImageInfo *imageInfo, uint32_t count, uint32_t arrayElement) {
     assert(setLayout.bindings.count(binding) == 1 && "Layout does not contain specified binding");
   
     auto &bindingDescription = setLayout.bindings[binding];
@@ -160,6 +186,7 @@ namespace nugiEngine {
     write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
     write.descriptorType = bindingDescription.descriptorType;
     write.dstBinding = binding;
+    write.dstArrayElement = arrayElement;
     write.pImageInfo = imageInfo;
     write.descriptorCount = count;
   
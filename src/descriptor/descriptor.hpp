@@ -19,16 +19,20 @@ class EngineDescriptorSetLayout {
       uint32_t binding,
       VkDescriptorType descriptorType,
       VkShaderStageFlags stageFlags,
-      uint32_t count = 1
+      uint32_t count = 1,
+      VkDescriptorBindingFlags bindingFlags = 0
     );
+    // layouts with the same bindings are shared, see EngineLayoutCache
     std::shared_ptr<EngineDescriptorSetLayout> build() const;
  
    private:
     EngineDevice &engineDevice;
     std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings{};
+    std::unordered_map<uint32_t, VkDescriptorBindingFlags> bindingFlags{};
   };
  
-  EngineDescriptorSetLayout(EngineDevice &engineDevice, std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings);
+  EngineDescriptorSetLayout(EngineDevice &engineDevice, std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings, 
+    std::unordered_map<uint32_t, VkDescriptorBindingFlags> bindingFlags = {});
   ~EngineDescriptorSetLayout();
 
   EngineDescriptorSetLayout(const EngineDescriptorSetLayout &) = delete;
@@ -88,8 +92,8 @@ class EngineDescriptorWriter {
  public:
   EngineDescriptorWriter(EngineDescriptorSetLayout &setLayout, EngineDescriptorPool &pool);
  
-  EngineDescriptorWriter &writeBuffer(uint32_t binding, VkDescriptorBufferInfo *bufferInfo, uint32_t count = 1);
-  EngineDescriptorWriter &writeImage(uint32_t binding, VkDescriptorImageInfo *imageInfo, uint32_t count = 1);
+  EngineDescriptorWriter &writeBuffer(uint32_t binding, VkDescriptorBufferInfo *bufferInfo, uint32_t count = 1, uint32_t arrayElement = 0);
+  EngineDescriptorWriter &writeImage(uint32_t binding, VkDescriptorImageInfo *imageInfo, uint32_t count = 1, uint32_t arrayElement = 0);
  
   bool build(VkDescriptorSet *set);
   void overwrite(VkDescriptorSet *set);
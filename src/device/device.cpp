@@ -1,6 +1,11 @@
 #include "device.hpp"
+#include "../staging/staging_allocator.hpp"
+#include "../upload_service/upload_service.hpp"
+#include "../pipeline/pipeline_cache.hpp"
+#include "../pipeline/layout_cache.hpp"
 
 // std headers
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <set>
@@ -57,10 +62,22 @@ namespace nugiEngine {
     this->msaaSamples = this->getMaxUsableFlagsCount();
     this->createLogicalDevice();
     this->createCommandPool();
+    this->createMemoryAllocator();
+    this->createStagingAllocator();
+    this->createUploadService();
+    this->createPipelineCache();
+    this->createLayoutCache();
   }
 
   EngineDevice::~EngineDevice() {
+    this->layoutCache.reset();
+    this->pipelineCache.reset();
+    this->uploadService.reset();
+    this->stagingAllocator.reset();
+    this->memoryAllocator.reset();
+
     vkDestroyCommandPool(this->device, this->commandPool, nullptr);
+    vkDestroyCommandPool(this->device, this->computeCommandPool, nullptr);
     vkDestroyDevice(this->device, nullptr);
 
     if (enableValidationLayers) {
@@ -149,6 +166,12 @@ namespace nugiEngine {
       this->familyIndices.transferFamily
     };
 
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(this->physicalDevice, &queueFamilyCount, nullptr);
+
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(this->physicalDevice, &queueFamilyCount, queueFamilies.data());
+
     std::vector<float> queuePriority;
 
     for (int i = 0; i < EngineDevice::MAX_FRAMES_IN_FLIGHT; i++) {
@@ -163,7 +186,7 @@ namespace nugiEngine {
       VkDeviceQueueCreateInfo queueCreateInfo = {};
       queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
       queueCreateInfo.queueFamilyIndex = queueFamily;
-      queueCreateInfo.queueCount = static_cast<uint32_t>(queuePriority.size());
+      queueCreateInfo.queueCount = std::min(static_cast<uint32_t>(queuePriority.size()), queueFamilies[queueFamily].queueCount);
       queueCreateInfo.pQueuePriorities = queuePriority.data();
       queueCreateInfos.push_back(queueCreateInfo);
     }
@@ -173,8 +196,43 @@ namespace nugiEngine {
     deviceFeatures.sampleRateShading = VK_TRUE;
     deviceFeatures.fragmentStoresAndAtomics = VK_TRUE;
 
+    VkPhysicalDeviceVulkan12Features supportedVulkan12Features = {};
+    supportedVulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+    VkPhysicalDeviceFeatures2 supportedFeatures = {};
+    supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    supportedFeatures.pNext = &supportedVulkan12Features;
+    vkGetPhysicalDeviceFeatures2(this->physicalDevice, &supportedFeatures);
+
+    VkPhysicalDeviceVulkan12Features vulkan12Features = {};
+    vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    vulkan12Features.timelineSemaphore = VK_TRUE;
+
+    // descriptor indexing is only turned on as a whole, the bindless descriptor needs every part of it
+    this->bindlessSupported = supportedVulkan12Features.descriptorIndexing && supportedVulkan12Features.runtimeDescriptorArray 
+      && supportedVulkan12Features.descriptorBindingPartiallyBound && supportedVulkan12Features.descriptorBindingUpdateUnusedWhilePending
+      && supportedVulkan12Features.shaderSampledImageArrayNonUniformIndexing && supportedVulkan12Features.shaderStorageBufferArrayNonUniformIndexing
+      && supportedVulkan12Features.descriptorBindingSampledImageUpdateAfterBind && supportedVulkan12Features.descriptorBindingStorageImageUpdateAfterBind
+      && supportedVulkan12Features.descriptorBindingStorageBufferUpdateAfterBind;
+
+    this->bufferDeviceAddressSupported = supportedVulkan12Features.bufferDeviceAddress;
+    vulkan12Features.bufferDeviceAddress = supportedVulkan12Features.bufferDeviceAddress;
+
+    if (this->bindlessSupported) {
+      vulkan12Features.descriptorIndexing = VK_TRUE;
+      vulkan12Features.runtimeDescriptorArray = VK_TRUE;
+      vulkan12Features.descriptorBindingPartiallyBound = VK_TRUE;
+      vulkan12Features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+      vulkan12Features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+      vulkan12Features.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+      vulkan12Features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+      vulkan12Features.descriptorBindingStorageImageUpdateAfterBind = VK_TRUE;
+      vulkan12Features.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+    }
+
     VkDeviceCreateInfo createInfo = {};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    createInfo.pNext = &vulkan12Features;
 
     createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
     createInfo.pQueueCreateInfos = queueCreateInfos.data();
@@ -196,16 +254,21 @@ namespace nugiEngine {
       throw std::runtime_error("failed to create logical device!");
     }
 
-    this->graphicsQueue.resize(EngineDevice::MAX_FRAMES_IN_FLIGHT);
-    this->presentQueue.resize(EngineDevice::MAX_FRAMES_IN_FLIGHT);
-    this->computeQueue.resize(EngineDevice::MAX_FRAMES_IN_FLIGHT);
-    this->transferQueue.resize(EngineDevice::MAX_FRAMES_IN_FLIGHT);
+    this->getDeviceQueues(this->familyIndices.graphicsFamily, queueFamilies[this->familyIndices.graphicsFamily].queueCount, this->graphicsQueue);
+    this->getDeviceQueues(this->familyIndices.presentFamily, queueFamilies[this->familyIndices.presentFamily].queueCount, this->presentQueue);
+    this->getDeviceQueues(this->familyIndices.computeFamily, queueFamilies[this->familyIndices.computeFamily].queueCount, this->computeQueue);
+    this->getDeviceQueues(this->familyIndices.transferFamily, queueFamilies[this->familyIndices.transferFamily].queueCount, this->transferQueue);
+  }
 
-    for (int i = 0; i < EngineDevice::MAX_FRAMES_IN_FLIGHT; i++) {
-      vkGetDeviceQueue(this->device, this->familyIndices.graphicsFamily, i, &this->graphicsQueue[i]);
-      vkGetDeviceQueue(this->device, this->familyIndices.presentFamily, i, &this->presentQueue[i]);
-      vkGetDeviceQueue(this->device, this->familyIndices.computeFamily, i, &this->computeQueue[i]);
-      vkGetDeviceQueue(this->device, this->familyIndices.transferFamily, i, &this->transferQueue[i]);
+  void EngineDevice::getDeviceQueues(uint32_t queueFamily, uint32_t queueCount, std::vector<VkQueue> &queues) {
+    queues.resize(std::min(static_cast<uint32_t>(EngineDevice::MAX_FRAMES_IN_FLIGHT), queueCount));
+
+    for (uint32_t i = 0; i < queues.size(); i++) {
+      vkGetDeviceQueue(this->device, queueFamily, i, &queues[i]);
+
+      if (this->queueMutexes.find(queues[i]) == this->queueMutexes.end()) {
+        this->queueMutexes.emplace(queues[i], std::make_unique<std::mutex>());
+      }
     }
   }
 
@@ -221,6 +284,51 @@ namespace nugiEngine {
     if (vkCreateCommandPool(this->device, &poolInfo, nullptr, &this->commandPool) != VK_SUCCESS) {
       throw std::runtime_error("failed to create command pool!");
     }
+
+    poolInfo.queueFamilyIndex = queueFamilyIndices.computeFamily;
+
+    if (vkCreateCommandPool(this->device, &poolInfo, nullptr, &this->computeCommandPool) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create compute command pool!");
+    }
+  }
+
+  void EngineDevice::createMemoryAllocator() {
+    this->memoryAllocator = std::make_unique<EngineMemoryAllocator>(this->physicalDevice, this->device, 
+      EngineMemoryAllocator::DEFAULT_BLOCK_SIZE, this->bufferDeviceAddressSupported);
+  }
+
+  void EngineDevice::createStagingAllocator() {
+    this->stagingAllocator = std::make_unique<EngineStagingAllocator>(*this);
+  }
+
+  void EngineDevice::waitIdle() {
+    // vkDeviceWaitIdle synchronizes with every queue at once, they are always locked in the same order
+    std::vector<std::unique_lock<std::mutex>> locks;
+    for (auto &&queueMutex : this->queueMutexes) {
+      locks.emplace_back(*queueMutex.second);
+    }
+
+    vkDeviceWaitIdle(this->device);
+  }
+
+  void EngineDevice::createUploadService() {
+    this->uploadService = std::make_unique<EngineUploadService>(*this, *this->stagingAllocator);
+  }
+
+  void EngineDevice::createPipelineCache() {
+    this->pipelineCache = std::make_unique<EnginePipelineCache>(*this);
+  }
+
+  void EngineDevice::createLayoutCache() {
+    this->layoutCache = std::make_unique<EngineLayoutCache>(*this);
+  }
+
+  VkPipelineCache EngineDevice::getPipelineCache() {
+    return this->pipelineCache->getPipelineCache();
+  }
+
+  void EngineDevice::savePipelineCache() {
+    this->pipelineCache->save();
   }
 
   void EngineDevice::createSurface() { 
@@ -238,11 +346,16 @@ namespace nugiEngine {
       swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
     }
 
-    VkPhysicalDeviceFeatures supportedFeatures;
-    vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
+    VkPhysicalDeviceVulkan12Features supportedVulkan12Features = {};
+    supportedVulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+    VkPhysicalDeviceFeatures2 supportedFeatures = {};
+    supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    supportedFeatures.pNext = &supportedVulkan12Features;
+    vkGetPhysicalDeviceFeatures2(device, &supportedFeatures);
 
     return indices.isComplete() && extensionsSupported && swapChainAdequate && 
-      supportedFeatures.samplerAnisotropy;
+      supportedFeatures.features.samplerAnisotropy && supportedVulkan12Features.timelineSemaphore;
   }
 
   void EngineDevice::populateDebugMessengerCreateInfo(
@@ -352,6 +465,8 @@ namespace nugiEngine {
 
   QueueFamilyIndices EngineDevice::findQueueFamilies(VkPhysicalDevice device) {
     QueueFamilyIndices indices;
+    bool hasDedicatedCompute = false;
+    bool hasDedicatedTransfer = false;
 
     uint32_t queueFamilyCount = 0;
     vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
@@ -361,29 +476,41 @@ namespace nugiEngine {
 
     int i = 0;
     for (const auto &queueFamily : queueFamilies) {
-      if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+      if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT && !indices.graphicsFamilyHasValue) {
         indices.graphicsFamily = i;
         indices.graphicsFamilyHasValue = true;
       }
 
+      // prefer a compute family without graphics, so the trace dispatch can run asynchronously to the raster work
       if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT) {
-        indices.computeFamily = i;
-        indices.computeFamilyHasValue = true;
+        bool isDedicated = !(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT);
+
+        if (!indices.computeFamilyHasValue || (isDedicated && !hasDedicatedCompute)) {
+          indices.computeFamily = i;
+          indices.computeFamilyHasValue = true;
+          hasDedicatedCompute = isDedicated;
+        }
       }
 
+      // likewise a transfer-only family lets uploads run on the copy engine next to the rendering
       if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT) {
-        indices.transferFamily = i;
-        indices.transferFamilyHasValue = true;
+        bool isDedicated = !(queueFamily.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT));
+
+        if (!indices.transferFamilyHasValue || (isDedicated && !hasDedicatedTransfer)) {
+          indices.transferFamily = i;
+          indices.transferFamilyHasValue = true;
+          hasDedicatedTransfer = isDedicated;
+        }
       }
 
       VkBool32 presentSupport = false;
       vkGetPhysicalDeviceSurfaceSupportKHR(device, i, this->surface, &presentSupport);
-      if (queueFamily.queueCount > 0 && presentSupport) {
+      if (queueFamily.queueCount > 0 && presentSupport && !indices.presentFamilyHasValue) {
         indices.presentFamily = i;
         indices.presentFamilyHasValue = true;
       }
 
-      if (indices.isComplete()) {
+      if (indices.isComplete() && hasDedicatedCompute && hasDedicatedTransfer) {
         break;
       }
 
@@ -1,12 +1,21 @@
 #pragma once
 
 #include "../window/window.hpp"
+#include "../memory/memory_allocator.hpp"
 
 // std lib headers
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace nugiEngine {
+  class EngineStagingAllocator;
+  class EngineUploadService;
+  class EnginePipelineCache;
+  class EngineLayoutCache;
+
   struct SwapChainSupportDetails {
     VkSurfaceCapabilitiesKHR capabilities;
     std::vector<VkSurfaceFormatKHR> formats;
@@ -50,17 +59,31 @@ namespace nugiEngine {
       VkPhysicalDevice getPhysicalDevice() { return this->physicalDevice; }
 
       VkCommandPool getCommandPool() { return this->commandPool; }
+      VkCommandPool getComputeCommandPool() { return this->computeCommandPool; }
       VkSurfaceKHR getSurface() { return this->surface; }
-
-      VkQueue getGraphicsQueue(uint32_t index) { return this->graphicsQueue[index]; }
-      VkQueue getPresentQueue(uint32_t index) { return this->presentQueue[index]; }
-      VkQueue getComputeQueue(uint32_t index) { return this->computeQueue[index]; }
-      VkQueue getTransferQueue(uint32_t index) { return this->transferQueue[index]; }
+      EngineMemoryAllocator* getMemoryAllocator() { return this->memoryAllocator.get(); }
+      EngineStagingAllocator* getStagingAllocator() { return this->stagingAllocator.get(); }
+      EngineUploadService* getUploadService() { return this->uploadService.get(); }
+      VkPipelineCache getPipelineCache();
+      void savePipelineCache();
+      EngineLayoutCache* getLayoutCache() { return this->layoutCache.get(); }
+
+      VkQueue getGraphicsQueue(uint32_t index) { return this->graphicsQueue[index % this->graphicsQueue.size()]; }
+      VkQueue getPresentQueue(uint32_t index) { return this->presentQueue[index % this->presentQueue.size()]; }
+      VkQueue getComputeQueue(uint32_t index) { return this->computeQueue[index % this->computeQueue.size()]; }
+      VkQueue getTransferQueue(uint32_t index) { return this->transferQueue[index % this->transferQueue.size()]; }
 
       QueueFamilyIndices getFamilyIndices() { return this->familyIndices; }
+
+      // queues are shared between the render thread and the upload thread, every vkQueueSubmit, 
+      // vkQueueWaitIdle and vkQueuePresentKHR has to hold the mutex of the queue it uses
+      std::mutex& getQueueMutex(VkQueue queue) { return *this->queueMutexes.at(queue); }
+      void waitIdle();
       
       VkPhysicalDeviceProperties getProperties() { return this->properties; }
       VkSampleCountFlagBits getMSAASamples() { return this->msaaSamples; }
+      bool isBindlessSupported() { return this->bindlessSupported; }
+      bool isBufferDeviceAddressSupported() { return this->bufferDeviceAddressSupported; }
 
       SwapChainSupportDetails getSwapChainSupport() { return this->querySwapChainSupport(this->physicalDevice); }
       QueueFamilyIndices findPhysicalQueueFamilies() { return this->findQueueFamilies(this->physicalDevice); }
@@ -75,6 +98,12 @@ namespace nugiEngine {
       void pickPhysicalDevice();
       void createLogicalDevice();
       void createCommandPool();
+      void createMemoryAllocator();
+      void createStagingAllocator();
+      void createUploadService();
+      void createPipelineCache();
+      void createLayoutCache();
+      void getDeviceQueues(uint32_t queueFamily, uint32_t queueCount, std::vector<VkQueue> &queues);
 
       // helper creation functions
       bool isDeviceSuitable(VkPhysicalDevice device);
@@ -102,6 +131,16 @@ namespace nugiEngine {
 
       // command pool
       VkCommandPool commandPool;
+      VkCommandPool computeCommandPool;
+
+      // memory
+      std::unique_ptr<EngineMemoryAllocator> memoryAllocator;
+      std::unique_ptr<EngineStagingAllocator> stagingAllocator;
+      std::unique_ptr<EngineUploadService> uploadService;
+
+      // pipeline
+      std::unique_ptr<EnginePipelineCache> pipelineCache;
+      std::unique_ptr<EngineLayoutCache> layoutCache;
 
       // queue
       std::vector<VkQueue> graphicsQueue;
@@ -109,12 +148,21 @@ namespace nugiEngine {
       std::vector<VkQueue> computeQueue;
       std::vector<VkQueue> transferQueue;
 
+      // families may share queues, so the mutexes are keyed by the queue itself. Filled once on creation
+      std::unordered_map<VkQueue, std::unique_ptr<std::mutex>> queueMutexes;
+
       // Queue Family Index
       QueueFamilyIndices familyIndices;
 
       // Anti-aliasing
       VkSampleCountFlagBits msaaSamples = VK_SAMPLE_COUNT_1_BIT;
 
+      // descriptor indexing
+      bool bindlessSupported = false;
+
+      // buffer device address
+      bool bufferDeviceAddressSupported = false;
+
       const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
       const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
   };
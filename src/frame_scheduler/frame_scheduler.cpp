@@ -0,0 +1,150 @@
+#include "frame_scheduler.hpp"
+
+#include <limits>
+#include <stdexcept>
+
+namespace nugiEngine {
+	EngineFrameScheduler::EngineFrameScheduler(EngineDevice& device, uint32_t framesInFlight) : appDevice{device}, framesInFlight{framesInFlight} {
+		if (this->framesInFlight == 0) {
+			throw std::runtime_error("frame scheduler needs at least one frame in flight");
+		}
+
+		this->frameValues.resize(this->framesInFlight, TimelineValues{});
+		this->createTimelineSemaphores();
+	}
+
+	EngineFrameScheduler::~EngineFrameScheduler() {
+		this->waitIdle();
+		this->collectGarbage();
+
+		for (auto &&timeline : this->timelines) {
+			vkDestroySemaphore(this->appDevice.getLogicalDevice(), timeline.semaphore, nullptr);
+		}
+	}
+
+	void EngineFrameScheduler::createTimelineSemaphores() {
+		VkSemaphoreTypeCreateInfo typeInfo{};
+		typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		typeInfo.initialValue = 0;
+
+		VkSemaphoreCreateInfo semaphoreInfo{};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		semaphoreInfo.pNext = &typeInfo;
+
+		for (auto &&timeline : this->timelines) {
+			if (vkCreateSemaphore(this->appDevice.getLogicalDevice(), &semaphoreInfo, nullptr, &timeline.semaphore) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create timeline semaphore!");
+			}
+		}
+	}
+
+	uint64_t EngineFrameScheduler::getCompletedValue(EngineQueueTimeline timeline) {
+		auto &queueTimeline = this->timelines[static_cast<uint32_t>(timeline)];
+
+		uint64_t value = 0;
+		if (vkGetSemaphoreCounterValue(this->appDevice.getLogicalDevice(), queueTimeline.semaphore, &value) != VK_SUCCESS) {
+			throw std::runtime_error("failed to read timeline semaphore value!");
+		}
+
+		queueTimeline.completedValue = value;
+		return value;
+	}
+
+	uint64_t EngineFrameScheduler::nextValue(EngineQueueTimeline timeline) {
+		uint32_t timelineIndex = static_cast<uint32_t>(timeline);
+		uint64_t value = ++this->timelines[timelineIndex].currentValue;
+
+		this->frameValues[this->currentFrameIndex][timelineIndex] = value;
+		return value;
+	}
+
+	void EngineFrameScheduler::waitValue(EngineQueueTimeline timeline, uint64_t value) {
+		auto &queueTimeline = this->timelines[static_cast<uint32_t>(timeline)];
+
+		// the cached value avoids a driver call when the GPU is known to be ahead already
+		if (value <= queueTimeline.completedValue || value <= this->getCompletedValue(timeline)) {
+			return;
+		}
+
+		VkSemaphoreWaitInfo waitInfo{};
+		waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		waitInfo.semaphoreCount = 1;
+		waitInfo.pSemaphores = &queueTimeline.semaphore;
+		waitInfo.pValues = &value;
+
+		if (vkWaitSemaphores(this->appDevice.getLogicalDevice(), &waitInfo, std::numeric_limits<uint64_t>::max()) != VK_SUCCESS) {
+			throw std::runtime_error("failed to wait timeline semaphore!");
+		}
+
+		queueTimeline.completedValue = value;
+	}
+
+	void EngineFrameScheduler::waitIdle() {
+		for (uint32_t i = 0; i < TIMELINE_COUNT; i++) {
+			this->waitValue(static_cast<EngineQueueTimeline>(i), this->timelines[i].currentValue);
+		}
+	}
+
+	void EngineFrameScheduler::beginFrame() {
+		for (uint32_t i = 0; i < TIMELINE_COUNT; i++) {
+			this->waitValue(static_cast<EngineQueueTimeline>(i), this->frameValues[this->currentFrameIndex][i]);
+		}
+
+		this->collectGarbage();
+	}
+
+	void EngineFrameScheduler::endFrame() {
+		this->currentFrameIndex = (this->currentFrameIndex + 1) % this->framesInFlight;
+	}
+
+	bool EngineFrameScheduler::isReached(const TimelineValues &values) {
+		for (uint32_t i = 0; i < TIMELINE_COUNT; i++) {
+			if (values[i] > this->timelines[i].completedValue) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void EngineFrameScheduler::deferDestroy(std::function<void()> destroyFunction) {
+		// the resource may still be used by any queue, so it waits for everything reserved so far
+		TimelineValues values{};
+		for (uint32_t i = 0; i < TIMELINE_COUNT; i++) {
+			values[i] = this->timelines[i].currentValue;
+		}
+
+		std::lock_guard<std::mutex> lock(this->deferredMutex);
+		this->deferredDestroys.emplace_back(DeferredDestroy{ values, destroyFunction });
+	}
+
+	void EngineFrameScheduler::collectGarbage() {
+		std::vector<std::function<void()>> readyFunctions;
+
+		{
+			std::lock_guard<std::mutex> lock(this->deferredMutex);
+			if (this->deferredDestroys.empty()) {
+				return;
+			}
+
+			for (uint32_t i = 0; i < TIMELINE_COUNT; i++) {
+				this->getCompletedValue(static_cast<EngineQueueTimeline>(i));
+			}
+
+			for (auto iterator = this->deferredDestroys.begin(); iterator != this->deferredDestroys.end();) {
+				if (this->isReached(iterator->values)) {
+					readyFunctions.emplace_back(std::move(iterator->destroyFunction));
+					iterator = this->deferredDestroys.erase(iterator);
+				} else {
+					iterator++;
+				}
+			}
+		}
+
+		// run outside the lock, a destroy function may defer more work
+		for (auto &&destroyFunction : readyFunctions) {
+			destroyFunction();
+		}
+	}
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "../device/device.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace nugiEngine {
+	enum class EngineQueueTimeline : uint32_t {
+		Graphics = 0,
+		Compute,
+		Count
+	};
+
+	/*
+	 * Tracks GPU progress with one timeline semaphore per queue, each with its own monotonically increasing value.
+	 * Each submit reserves a new value of its queue with nextValue() and signals it, which also records it as the
+	 * current frame slot's last use of that queue. A frame slot can be reused once every queue reached the values its
+	 * last submits signaled, so submits only wait on the frame slot and resource dependencies they actually have
+	 */
+	class EngineFrameScheduler {
+		public:
+			EngineFrameScheduler(EngineDevice& device, uint32_t framesInFlight = EngineDevice::MAX_FRAMES_IN_FLIGHT);
+			~EngineFrameScheduler();
+
+			EngineFrameScheduler(const EngineFrameScheduler&) = delete;
+			EngineFrameScheduler& operator = (const EngineFrameScheduler&) = delete;
+
+			VkSemaphore getTimelineSemaphore(EngineQueueTimeline timeline) const { return this->timelines[static_cast<uint32_t>(timeline)].semaphore; }
+			uint32_t getFramesInFlight() const { return this->framesInFlight; }
+			uint32_t getFrameIndex() const { return this->currentFrameIndex; }
+			uint64_t getCurrentValue(EngineQueueTimeline timeline) const { return this->timelines[static_cast<uint32_t>(timeline)].currentValue; }
+
+			// the value signaled by the last submit of the current frame slot on the timeline, 0 when there was none
+			uint64_t getFrameValue(EngineQueueTimeline timeline) const { return this->frameValues[this->currentFrameIndex][static_cast<uint32_t>(timeline)]; }
+
+			uint64_t getCompletedValue(EngineQueueTimeline timeline);
+			uint64_t nextValue(EngineQueueTimeline timeline);
+
+			void beginFrame();
+			void endFrame();
+
+			void waitValue(EngineQueueTimeline timeline, uint64_t value);
+			void waitIdle();
+
+			void deferDestroy(std::function<void()> destroyFunction);
+			void collectGarbage();
+
+		private:
+			static constexpr uint32_t TIMELINE_COUNT = static_cast<uint32_t>(EngineQueueTimeline::Count);
+			using TimelineValues = std::array<uint64_t, TIMELINE_COUNT>;
+
+			struct QueueTimeline {
+				VkSemaphore semaphore = VK_NULL_HANDLE;
+				std::atomic<uint64_t> currentValue{0}, completedValue{0};
+			};
+
+			struct DeferredDestroy {
+				TimelineValues values;
+				std::function<void()> destroyFunction;
+			};
+
+			void createTimelineSemaphores();
+			bool isReached(const TimelineValues &values);
+
+			EngineDevice& appDevice;
+
+			std::array<QueueTimeline, TIMELINE_COUNT> timelines;
+
+			uint32_t framesInFlight, currentFrameIndex = 0;
+			std::vector<TimelineValues> frameValues;
+
+			std::deque<DeferredDestroy> deferredDestroys;
+			std::mutex deferredMutex;
+	};
+}
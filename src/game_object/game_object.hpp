@@ -25,6 +25,7 @@ namespace nugiEngine {
 	{
 	public:
 		using id_t = unsigned int;
+		static constexpr uint32_t NO_TEXTURE = ~0u;
 
 		static EngineGameObject createGameObject() {
 			static id_t currentId = 0;
@@ -53,7 +54,7 @@ namespace nugiEngine {
 
 		std::shared_ptr<EngineModel> model{};
 		std::shared_ptr<EngineTexture> texture{};
-		std::shared_ptr<VkDescriptorSet> textureDescSet{};
+		uint32_t textureIndex = NO_TEXTURE; // slot of the texture in the bindless descriptor
 		std::unique_ptr<PointLightComponent> pointLights = nullptr;
 	private:
 		id_t objectId;
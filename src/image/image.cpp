@@ -24,7 +24,7 @@ namespace nugiEngine {
 
     if (this->isImageCreatedByUs) {
       vkDestroyImage(this->appDevice.getLogicalDevice(), this->image, nullptr);
-      vkFreeMemory(this->appDevice.getLogicalDevice(), this->imageMemory, nullptr);
+      this->appDevice.getMemoryAllocator()->free(this->allocation);
     }
   }
 
@@ -51,16 +51,10 @@ namespace nugiEngine {
     VkMemoryRequirements memRequirements;
     vkGetImageMemoryRequirements(this->appDevice.getLogicalDevice(), this->image, &memRequirements);
 
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = this->appDevice.findMemoryType(memRequirements.memoryTypeBits, properties);
+    this->allocation = this->appDevice.getMemoryAllocator()->allocate(memRequirements, properties, 
+      tiling == VK_IMAGE_TILING_LINEAR, EngineMemoryCategory::Image);
 
-    if (vkAllocateMemory(this->appDevice.getLogicalDevice(), &allocInfo, nullptr, &this->imageMemory) != VK_SUCCESS) {
-      throw std::runtime_error("failed to allocate image memory!");
-    }
-
-    if (vkBindImageMemory(this->appDevice.getLogicalDevice(), this->image, this->imageMemory, 0) != VK_SUCCESS) {
+    if (vkBindImageMemory(this->appDevice.getLogicalDevice(), this->image, this->allocation.memory, this->allocation.offset) != VK_SUCCESS) {
       throw std::runtime_error("failed to bind image memory!");
     }
   }
@@ -86,19 +80,9 @@ namespace nugiEngine {
     }
   }
 
-  void EngineImage::transitionImageLayout(VkImageLayout oldLayout, VkImageLayout newLayout, VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage, 
-    VkAccessFlags srcAccess, VkAccessFlags dstAccess, uint32_t srcQueueFamilyIndex, uint32_t dstQueueFamilyIndex,
-    std::shared_ptr<EngineCommandBuffer> commandBuffer, EngineDevice *appDevice) 
+  VkImageMemoryBarrier EngineImage::createBarrier(VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlags srcAccess, 
+    VkAccessFlags dstAccess, uint32_t srcQueueFamilyIndex, uint32_t dstQueueFamilyIndex) const
   {
-    bool isCommandBufferCreatedHere = false;
-    
-    if (commandBuffer == nullptr) {
-      commandBuffer = std::make_shared<EngineCommandBuffer>(this->appDevice);
-      commandBuffer->beginSingleTimeCommand();
-
-      isCommandBufferCreatedHere = true;  
-    }
-
     VkImageMemoryBarrier barrier{};
     barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
     barrier.oldLayout = oldLayout;
@@ -116,22 +100,50 @@ namespace nugiEngine {
     barrier.srcAccessMask = srcAccess;
     barrier.dstAccessMask = dstAccess;
 
+    return barrier;
+  }
+
+  bool EngineImage::addTransition(std::shared_ptr<EngineCommandBuffer> commandBuffer, VkImageLayout oldLayout, VkImageLayout newLayout, 
+    VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage, VkAccessFlags srcAccess, VkAccessFlags dstAccess, 
+    uint32_t srcQueueFamilyIndex, uint32_t dstQueueFamilyIndex) 
+  {
+    // Without a layout change or an ownership transfer, a barrier that waits for nothing (bottom of pipe
+    // without access) is a no-op. Anything else is only dropped by the command buffer, which knows what was recorded
+    // into it before: the per image state seen at recording time can't be trusted, recorded command buffers are replayed
+    // in a different order than they were recorded
+    bool isEmptyDependency = oldLayout == newLayout && srcQueueFamilyIndex == dstQueueFamilyIndex
+      && dstStage == VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT && dstAccess == 0;
+
+    if (isEmptyDependency) {
+      return false;
+    }
+
+    VkImageMemoryBarrier barrier = this->createBarrier(oldLayout, newLayout, srcAccess, dstAccess, 
+      srcQueueFamilyIndex, dstQueueFamilyIndex);
     this->layout = newLayout;
+    return commandBuffer->addImageBarrier(barrier, srcStage, dstStage);
+  }
 
-    vkCmdPipelineBarrier(
-      commandBuffer->getCommandBuffer(), 
-      srcStage, 
-      dstStage,
-      0,
-      0, nullptr,
-      0, nullptr,
-      1, 
-      &barrier
-    );
+  void EngineImage::transitionImageLayout(VkImageLayout oldLayout, VkImageLayout newLayout, VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage, 
+    VkAccessFlags srcAccess, VkAccessFlags dstAccess, uint32_t srcQueueFamilyIndex, uint32_t dstQueueFamilyIndex,
+    std::shared_ptr<EngineCommandBuffer> commandBuffer, EngineDevice *appDevice) 
+  {
+    bool isCommandBufferCreatedHere = false;
+    
+    if (commandBuffer == nullptr) {
+      commandBuffer = std::make_shared<EngineCommandBuffer>(this->appDevice);
+      commandBuffer->beginSingleTimeCommand();
+
+      isCommandBufferCreatedHere = true;  
+    }
+
+    this->addTransition(commandBuffer, oldLayout, newLayout, srcStage, dstStage, srcAccess, dstAccess, 
+      srcQueueFamilyIndex, dstQueueFamilyIndex);
+    commandBuffer->flushBarriers();
 
     if (isCommandBufferCreatedHere) {
       commandBuffer->endCommand();
-      commandBuffer->submitCommand(this->appDevice.getTransferQueue(0));
+      commandBuffer->submitCommand(this->appDevice.getGraphicsQueue(0));
     }
   }
   
@@ -149,45 +161,16 @@ namespace nugiEngine {
       isCommandBufferCreatedHere = true;  
     }
 
-    std::vector<VkImageMemoryBarrier> barriers;
-
     for (auto &&image : images) {
-      VkImageMemoryBarrier barrier{};
-
-      barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-      barrier.oldLayout = oldLayout;
-      barrier.newLayout = newLayout;
-
-      barrier.srcQueueFamilyIndex = srcQueueFamilyIndex;
-      barrier.dstQueueFamilyIndex = dstQueueFamilyIndex;
-
-      barrier.image = image->getImage();
-      barrier.subresourceRange.aspectMask = image->getAspectFlag();
-      barrier.subresourceRange.baseMipLevel = 0;
-      barrier.subresourceRange.levelCount = image->getMipLevels();
-      barrier.subresourceRange.baseArrayLayer = 0;
-      barrier.subresourceRange.layerCount = 1;
-      barrier.srcAccessMask = srcAccess;
-      barrier.dstAccessMask = dstAccess;
-
-      image->layout = newLayout;
-      barriers.emplace_back(barrier);
+      image->addTransition(commandBuffer, oldLayout, newLayout, srcStage, dstStage, srcAccess, dstAccess, 
+        srcQueueFamilyIndex, dstQueueFamilyIndex);
     }
 
-    vkCmdPipelineBarrier(
-      commandBuffer->getCommandBuffer(), 
-      srcStage, 
-      dstStage,
-      0,
-      0, nullptr,
-      0, nullptr,
-      static_cast<uint32_t>(barriers.size()), 
-      barriers.data()
-    );
+    commandBuffer->flushBarriers();
 
     if (isCommandBufferCreatedHere) {
       commandBuffer->endCommand();
-      commandBuffer->submitCommand(appDevice->getTransferQueue(0));
+      commandBuffer->submitCommand(appDevice->getGraphicsQueue(0));
     }
   }
 
@@ -213,7 +196,7 @@ namespace nugiEngine {
 
     if (isCommandBufferCreatedHere) {
       commandBuffer->endCommand();
-      commandBuffer->submitCommand(this->appDevice.getTransferQueue(0));
+      commandBuffer->submitCommand(this->appDevice.getGraphicsQueue(0));
     }
   }
 
@@ -239,11 +222,33 @@ namespace nugiEngine {
 
     if (isCommandBufferCreatedHere) {
       commandBuffer->endCommand();
-      commandBuffer->submitCommand(this->appDevice.getTransferQueue(0));
+      commandBuffer->submitCommand(this->appDevice.getGraphicsQueue(0));
     }
   }
 
-  void EngineImage::generateMipMap() {
+  void EngineImage::generateMipMap(std::shared_ptr<EngineCommandBuffer> commandBuffer) {
+    bool isCommandBufferCreatedHere = false;
+    
+    if (commandBuffer == nullptr) {
+      commandBuffer = std::make_shared<EngineCommandBuffer>(this->appDevice);
+      commandBuffer->beginSingleTimeCommand();
+
+      isCommandBufferCreatedHere = true;  
+    }
+
+    // barriers batched before the mip chain was requested have to be recorded first
+    commandBuffer->flushBarriers();
+
+    this->recordMipMaps(commandBuffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    this->layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    if (isCommandBufferCreatedHere) {
+      commandBuffer->endCommand();
+      commandBuffer->submitCommand(this->appDevice.getGraphicsQueue(0));
+    }
+  }
+
+  void EngineImage::recordMipMaps(std::shared_ptr<EngineCommandBuffer> commandBuffer, VkPipelineStageFlags dstStage) const {
     if (!this->isImageCreatedByUs) {
       throw std::runtime_error("cannot generate mipmap if the image is not created by this class => image directly assigned to this class via second constructor");
     }
@@ -256,9 +261,6 @@ namespace nugiEngine {
       throw std::runtime_error("texture image format does not support linear blitting!");
     }
 
-    EngineCommandBuffer commandBuffer{this->appDevice};
-    commandBuffer.beginSingleTimeCommand();
-
     VkImageMemoryBarrier barrier{};
     barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
     barrier.image = this->image;
@@ -280,7 +282,7 @@ namespace nugiEngine {
       barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
 
       vkCmdPipelineBarrier(
-        commandBuffer.getCommandBuffer(),
+        commandBuffer->getCommandBuffer(),
         VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
         0, nullptr,
         0, nullptr,
@@ -303,7 +305,7 @@ namespace nugiEngine {
       blit.dstSubresource.layerCount = 1;
 
       vkCmdBlitImage(
-        commandBuffer.getCommandBuffer(),
+        commandBuffer->getCommandBuffer(),
         this->image, 
         VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
         this->image, 
@@ -319,9 +321,9 @@ namespace nugiEngine {
       barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 
       vkCmdPipelineBarrier(
-        commandBuffer.getCommandBuffer(),
+        commandBuffer->getCommandBuffer(),
         VK_PIPELINE_STAGE_TRANSFER_BIT, 
-        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 
+        dstStage, 
         0,
         0, nullptr,
         0, nullptr,
@@ -333,22 +335,19 @@ namespace nugiEngine {
       if (mipHeight > 1) mipHeight /= 2;
     }
 
-    barrier.subresourceRange.baseMipLevel = mipLevels - 1;
+    barrier.subresourceRange.baseMipLevel = this->mipLevels - 1;
     barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
     barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
     barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
     barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 
     vkCmdPipelineBarrier(
-      commandBuffer.getCommandBuffer(),
+      commandBuffer->getCommandBuffer(),
       VK_PIPELINE_STAGE_TRANSFER_BIT, 
-      VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+      dstStage, 0,
       0, nullptr,
       0, nullptr,
       1, &barrier);
-
-    commandBuffer.endCommand();
-    commandBuffer.submitCommand(this->appDevice.getTransferQueue(0));
   }
 
   VkDescriptorImageInfo EngineImage::getDescriptorInfo(VkImageLayout desiredImageLayout) {
@@ -19,8 +19,9 @@ namespace nugiEngine
 
       VkImage getImage() const { return this->image; }
       VkImageView getImageView() const { return this->imageView; }
-      VkDeviceMemory getImageMemory() const { return this->imageMemory; }
+      VkDeviceMemory getImageMemory() const { return this->allocation.memory; }
       VkImageLayout getLayout() const { return this->layout; }
+      void setLayout(VkImageLayout layout) { this->layout = layout; }
       
       VkImageAspectFlags getAspectFlag() { return this->aspectFlags; }
       uint32_t getMipLevels() { return this->mipLevels; }
@@ -32,10 +33,22 @@ namespace nugiEngine
         uint32_t dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED, std::shared_ptr<EngineCommandBuffer> commandBuffer = nullptr, 
         EngineDevice *appDevice = nullptr);
 
+      // describes a transition without recording it or touching the tracked layout, safe to call from any thread
+      VkImageMemoryBarrier createBarrier(VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlags srcAccess, VkAccessFlags dstAccess, 
+        uint32_t srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED, uint32_t dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED) const;
+
+      bool addTransition(std::shared_ptr<EngineCommandBuffer> commandBuffer, VkImageLayout oldLayout, VkImageLayout newLayout, 
+        VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage, VkAccessFlags srcAccess, VkAccessFlags dstAccess, 
+        uint32_t srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED, uint32_t dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED);
+
       void copyImageFromOther(std::shared_ptr<EngineImage> srcImage, VkImageLayout srcLayout, VkImageLayout dstLayout, std::shared_ptr<EngineCommandBuffer> commandBuffer = nullptr);
       void copyImageToOther(std::shared_ptr<EngineImage> dstImage, VkImageLayout srcLayout, VkImageLayout dstLayout, std::shared_ptr<EngineCommandBuffer> commandBuffer = nullptr);
 
-      void generateMipMap();
+      void generateMipMap(std::shared_ptr<EngineCommandBuffer> commandBuffer = nullptr);
+
+      // blits the base level down the mip chain without touching the tracked layout, safe to call from any thread.
+      // Every level has to be in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, they end up in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+      void recordMipMaps(std::shared_ptr<EngineCommandBuffer> commandBuffer, VkPipelineStageFlags dstStage) const;
 
       static void transitionImageLayout(std::vector<std::shared_ptr<EngineImage>> images, VkImageLayout oldLayout, VkImageLayout newLayout, 
         VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage, VkAccessFlags srcAccess, VkAccessFlags dstAccess,
@@ -47,7 +60,7 @@ namespace nugiEngine
 
       VkImage image;
       VkImageView imageView;
-      VkDeviceMemory imageMemory;
+      EngineMemoryAllocation allocation{};
       VkFormat format;
       VkImageAspectFlags aspectFlags;
       VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -0,0 +1,331 @@
+#include "memory_allocator.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace nugiEngine {
+  struct EngineMemoryBlock {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize size = 0;
+    VkDeviceSize usedBytes = 0;
+    uint32_t memoryTypeIndex = 0;
+
+    bool isLinear = true;
+    bool isDedicated = false;
+    bool isCoherent = false;
+    char* mapped = nullptr;
+
+    // offset -> size of every free range, sorted by offset so neighbours can be merged on free
+    std::map<VkDeviceSize, VkDeviceSize> freeRanges;
+  };
+
+  EngineMemoryAllocator::EngineMemoryAllocator(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize blockSize, bool isDeviceAddressEnabled)
+    : physicalDevice{physicalDevice}, device{device}, isDeviceAddressEnabled{isDeviceAddressEnabled}, blockSize{blockSize}
+  {
+    vkGetPhysicalDeviceMemoryProperties(this->physicalDevice, &this->memoryProperties);
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(this->physicalDevice, &properties);
+    this->nonCoherentAtomSize = std::max<VkDeviceSize>(properties.limits.nonCoherentAtomSize, 1);
+  }
+
+  EngineMemoryAllocator::~EngineMemoryAllocator() {
+    for (auto &&block : this->blocks) {
+      if (block->mapped != nullptr) {
+        vkUnmapMemory(this->device, block->memory);
+      }
+
+      vkFreeMemory(this->device, block->memory, nullptr);
+    }
+  }
+
+  uint32_t EngineMemoryAllocator::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
+    for (uint32_t i = 0; i < this->memoryProperties.memoryTypeCount; i++) {
+      if ((typeFilter & (1 << i)) && (this->memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+        return i;
+      }
+    }
+
+    throw std::runtime_error("failed to find suitable memory type!");
+  }
+
+  VkDeviceSize EngineMemoryAllocator::getBlockSize(uint32_t memoryTypeIndex) {
+    // small heaps (e.g. the 256 MB host visible device local window) must not be taken by a single block
+    uint32_t heapIndex = this->memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+    return std::min(this->blockSize, this->memoryProperties.memoryHeaps[heapIndex].size / 8);
+  }
+
+  EngineMemoryBlock* EngineMemoryAllocator::createBlock(uint32_t memoryTypeIndex, VkDeviceSize size, bool isLinear, bool isDedicated) {
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = size;
+    allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+    VkMemoryAllocateFlagsInfo allocFlagsInfo{};
+    allocFlagsInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
+    allocFlagsInfo.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT;
+
+    if (this->isDeviceAddressEnabled) {
+      allocInfo.pNext = &allocFlagsInfo;
+    }
+
+    auto block = std::make_unique<EngineMemoryBlock>();
+
+    if (vkAllocateMemory(this->device, &allocInfo, nullptr, &block->memory) != VK_SUCCESS) {
+      throw std::runtime_error("failed to allocate device memory block!");
+    }
+
+    VkMemoryPropertyFlags propertyFlags = this->memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags;
+
+    block->size = size;
+    block->memoryTypeIndex = memoryTypeIndex;
+    block->isLinear = isLinear;
+    block->isDedicated = isDedicated;
+    block->isCoherent = (propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+    block->freeRanges.emplace(0, size);
+
+    // host visible blocks are mapped once and stay mapped until the block is freed
+    if (propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+      void* mapped = nullptr;
+      if (vkMapMemory(this->device, block->memory, 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS) {
+        vkFreeMemory(this->device, block->memory, nullptr);
+        throw std::runtime_error("failed to map device memory block!");
+      }
+
+      block->mapped = static_cast<char*>(mapped);
+    }
+
+    this->statistics.blockCount++;
+    this->statistics.blockBytes += size;
+
+    if (isDedicated) {
+      this->statistics.dedicatedCount++;
+    }
+
+    this->blocks.emplace_back(std::move(block));
+    return this->blocks.back().get();
+  }
+
+  void EngineMemoryAllocator::destroyBlock(EngineMemoryBlock* block) {
+    if (block->mapped != nullptr) {
+      vkUnmapMemory(this->device, block->memory);
+    }
+
+    vkFreeMemory(this->device, block->memory, nullptr);
+
+    this->statistics.blockCount--;
+    this->statistics.blockBytes -= block->size;
+
+    if (block->isDedicated) {
+      this->statistics.dedicatedCount--;
+    }
+
+    auto iterator = std::find_if(this->blocks.begin(), this->blocks.end(),
+      [block](const std::unique_ptr<EngineMemoryBlock> &other) { return other.get() == block; });
+    this->blocks.erase(iterator);
+  }
+
+  bool EngineMemoryAllocator::allocateFromBlock(EngineMemoryBlock* block, VkMemoryRequirements requirements, EngineMemoryAllocation &allocation) {
+    VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+
+    // first fit, the free ranges are visited from the lowest offset
+    for (auto iterator = block->freeRanges.begin(); iterator != block->freeRanges.end(); iterator++) {
+      VkDeviceSize rangeOffset = iterator->first;
+      VkDeviceSize rangeEnd = iterator->first + iterator->second;
+      VkDeviceSize alignedOffset = (rangeOffset + alignment - 1) & ~(alignment - 1);
+
+      if (alignedOffset + requirements.size > rangeEnd) {
+        continue;
+      }
+
+      block->freeRanges.erase(iterator);
+
+      if (alignedOffset > rangeOffset) {
+        block->freeRanges.emplace(rangeOffset, alignedOffset - rangeOffset);
+      }
+
+      if (alignedOffset + requirements.size < rangeEnd) {
+        block->freeRanges.emplace(alignedOffset + requirements.size, rangeEnd - alignedOffset - requirements.size);
+      }
+
+      block->usedBytes += requirements.size;
+
+      allocation.memory = block->memory;
+      allocation.offset = alignedOffset;
+      allocation.size = requirements.size;
+      allocation.mapped = block->mapped != nullptr ? block->mapped + alignedOffset : nullptr;
+      allocation.block = block;
+      allocation.isCoherent = block->isCoherent;
+
+      return true;
+    }
+
+    return false;
+  }
+
+  EngineMemoryAllocation EngineMemoryAllocator::allocate(VkMemoryRequirements requirements, VkMemoryPropertyFlags properties,
+    bool isLinear, EngineMemoryCategory category)
+  {
+    std::lock_guard<std::mutex> lock(this->allocatorMutex);
+
+    uint32_t memoryTypeIndex = this->findMemoryType(requirements.memoryTypeBits, properties);
+    VkDeviceSize typeBlockSize = this->getBlockSize(memoryTypeIndex);
+
+    EngineMemoryAllocation allocation{};
+    allocation.category = category;
+
+    bool isAllocated = false;
+
+    // big resources get a block of their own instead of wasting most of a shared one
+    if (requirements.size > typeBlockSize / 2) {
+      auto block = this->createBlock(memoryTypeIndex, requirements.size, isLinear, true);
+      isAllocated = this->allocateFromBlock(block, requirements, allocation);
+    } else {
+      for (auto &&block : this->blocks) {
+        if (block->isDedicated || block->memoryTypeIndex != memoryTypeIndex || block->isLinear != isLinear) {
+          continue;
+        }
+
+        if (this->allocateFromBlock(block.get(), requirements, allocation)) {
+          isAllocated = true;
+          break;
+        }
+      }
+
+      if (!isAllocated) {
+        auto block = this->createBlock(memoryTypeIndex, typeBlockSize, isLinear, false);
+        isAllocated = this->allocateFromBlock(block, requirements, allocation);
+      }
+    }
+
+    if (!isAllocated) {
+      throw std::runtime_error("failed to sub-allocate device memory!");
+    }
+
+    this->statistics.usedBytes[static_cast<uint32_t>(category)] += allocation.size;
+    this->statistics.allocationCount[static_cast<uint32_t>(category)]++;
+
+    return allocation;
+  }
+
+  void EngineMemoryAllocator::free(EngineMemoryAllocation &allocation) {
+    if (allocation.block == nullptr) {
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(this->allocatorMutex);
+
+    EngineMemoryBlock* block = allocation.block;
+
+    this->statistics.usedBytes[static_cast<uint32_t>(allocation.category)] -= allocation.size;
+    this->statistics.allocationCount[static_cast<uint32_t>(allocation.category)]--;
+
+    if (block->isDedicated) {
+      this->destroyBlock(block);
+      allocation = EngineMemoryAllocation{};
+
+      return;
+    }
+
+    block->usedBytes -= allocation.size;
+    auto iterator = block->freeRanges.emplace(allocation.offset, allocation.size).first;
+
+    // merge with the following and the preceding free range
+    auto next = std::next(iterator);
+    if (next != block->freeRanges.end() && iterator->first + iterator->second == next->first) {
+      iterator->second += next->second;
+      block->freeRanges.erase(next);
+    }
+
+    if (iterator != block->freeRanges.begin()) {
+      auto previous = std::prev(iterator);
+      if (previous->first + previous->second == iterator->first) {
+        previous->second += iterator->second;
+        block->freeRanges.erase(iterator);
+      }
+    }
+
+    // keep one empty block per memory type around, so a single resource being recreated does not
+    // allocate and free a whole block every time
+    if (block->usedBytes == 0) {
+      bool hasOtherBlock = std::any_of(this->blocks.begin(), this->blocks.end(),
+        [block](const std::unique_ptr<EngineMemoryBlock> &other) {
+          return other.get() != block && !other->isDedicated && other->memoryTypeIndex == block->memoryTypeIndex
+            && other->isLinear == block->isLinear;
+        });
+
+      if (hasOtherBlock) {
+        this->destroyBlock(block);
+      }
+    }
+
+    allocation = EngineMemoryAllocation{};
+  }
+
+  VkMappedMemoryRange EngineMemoryAllocator::getMappedRange(const EngineMemoryAllocation &allocation, VkDeviceSize size, VkDeviceSize offset) {
+    if (size == VK_WHOLE_SIZE) {
+      size = allocation.size - offset;
+    }
+
+    // ranges of non coherent memory must start and end on a multiple of nonCoherentAtomSize
+    VkDeviceSize start = allocation.offset + offset;
+    VkDeviceSize end = start + size;
+
+    start = (start / this->nonCoherentAtomSize) * this->nonCoherentAtomSize;
+    end = std::min(((end + this->nonCoherentAtomSize - 1) / this->nonCoherentAtomSize) * this->nonCoherentAtomSize, allocation.block->size);
+
+    VkMappedMemoryRange mappedRange{};
+    mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    mappedRange.memory = allocation.memory;
+    mappedRange.offset = start;
+    mappedRange.size = end - start;
+
+    return mappedRange;
+  }
+
+  VkResult EngineMemoryAllocator::flush(const EngineMemoryAllocation &allocation, VkDeviceSize size, VkDeviceSize offset) {
+    if (allocation.isCoherent || allocation.mapped == nullptr) {
+      return VK_SUCCESS;
+    }
+
+    VkMappedMemoryRange mappedRange = this->getMappedRange(allocation, size, offset);
+    return vkFlushMappedMemoryRanges(this->device, 1, &mappedRange);
+  }
+
+  VkResult EngineMemoryAllocator::invalidate(const EngineMemoryAllocation &allocation, VkDeviceSize size, VkDeviceSize offset) {
+    if (allocation.isCoherent || allocation.mapped == nullptr) {
+      return VK_SUCCESS;
+    }
+
+    VkMappedMemoryRange mappedRange = this->getMappedRange(allocation, size, offset);
+    return vkInvalidateMappedMemoryRanges(this->device, 1, &mappedRange);
+  }
+
+  EngineMemoryStatistics EngineMemoryAllocator::getStatistics() {
+    std::lock_guard<std::mutex> lock(this->allocatorMutex);
+    return this->statistics;
+  }
+
+  void EngineMemoryAllocator::printStatistics(std::ostream &stream) {
+    EngineMemoryStatistics currentStatistics = this->getStatistics();
+
+    stream << "device memory: " << currentStatistics.blockCount << " blocks (" << currentStatistics.dedicatedCount
+      << " dedicated), " << (currentStatistics.blockBytes >> 10) << " KiB reserved" << '\n';
+
+    for (uint32_t i = 0; i < static_cast<uint32_t>(EngineMemoryCategory::Count); i++) {
+      stream << "  " << EngineMemoryAllocator::getCategoryName(static_cast<EngineMemoryCategory>(i)) << ": "
+        << currentStatistics.allocationCount[i] << " allocations, " << (currentStatistics.usedBytes[i] >> 10) << " KiB" << '\n';
+    }
+  }
+
+  const char* EngineMemoryAllocator::getCategoryName(EngineMemoryCategory category) {
+    switch (category) {
+      case EngineMemoryCategory::Vertex: return "vertex";
+      case EngineMemoryCategory::Uniform: return "uniform";
+      case EngineMemoryCategory::Storage: return "storage";
+      case EngineMemoryCategory::Staging: return "staging";
+      case EngineMemoryCategory::Image: return "image";
+      default: return "other";
+    }
+  }
+} // namespace nugiEngine
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace nugiEngine {
+  enum class EngineMemoryCategory : uint32_t {
+    Vertex = 0,
+    Uniform,
+    Storage,
+    Staging,
+    Image,
+    Other,
+    Count
+  };
+
+  struct EngineMemoryBlock;
+
+  // A sub-range of a device memory block. Host visible blocks stay mapped for their whole
+  // lifetime, so mapped already points at the start of this range
+  struct EngineMemoryAllocation {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    void* mapped = nullptr;
+
+    EngineMemoryBlock* block = nullptr;
+    EngineMemoryCategory category = EngineMemoryCategory::Other;
+    bool isCoherent = false;
+  };
+
+  struct EngineMemoryStatistics {
+    uint32_t blockCount = 0;
+    uint32_t dedicatedCount = 0;
+    VkDeviceSize blockBytes = 0;
+
+    std::array<VkDeviceSize, static_cast<uint32_t>(EngineMemoryCategory::Count)> usedBytes{};
+    std::array<uint32_t, static_cast<uint32_t>(EngineMemoryCategory::Count)> allocationCount{};
+  };
+
+  class EngineMemoryAllocator {
+    public:
+      static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+      // with isDeviceAddressEnabled every block is allocated so buffers placed in it can be used by their device address
+      EngineMemoryAllocator(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize blockSize = DEFAULT_BLOCK_SIZE, 
+        bool isDeviceAddressEnabled = false);
+      ~EngineMemoryAllocator();
+
+      EngineMemoryAllocator(const EngineMemoryAllocator&) = delete;
+      EngineMemoryAllocator& operator=(const EngineMemoryAllocator&) = delete;
+
+      // isLinear tells whether the resource is a buffer or linear image, those never share a block
+      // with optimal tiled images, so bufferImageGranularity never has to be checked between neighbours
+      EngineMemoryAllocation allocate(VkMemoryRequirements requirements, VkMemoryPropertyFlags properties,
+        bool isLinear, EngineMemoryCategory category);
+      void free(EngineMemoryAllocation &allocation);
+
+      VkResult flush(const EngineMemoryAllocation &allocation, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+      VkResult invalidate(const EngineMemoryAllocation &allocation, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+
+      EngineMemoryStatistics getStatistics();
+      void printStatistics(std::ostream &stream);
+
+      static const char* getCategoryName(EngineMemoryCategory category);
+
+    private:
+      uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+      VkDeviceSize getBlockSize(uint32_t memoryTypeIndex);
+      VkMappedMemoryRange getMappedRange(const EngineMemoryAllocation &allocation, VkDeviceSize size, VkDeviceSize offset);
+
+      EngineMemoryBlock* createBlock(uint32_t memoryTypeIndex, VkDeviceSize size, bool isLinear, bool isDedicated);
+      void destroyBlock(EngineMemoryBlock* block);
+
+      bool allocateFromBlock(EngineMemoryBlock* block, VkMemoryRequirements requirements, EngineMemoryAllocation &allocation);
+
+      VkPhysicalDevice physicalDevice;
+      VkDevice device;
+      bool isDeviceAddressEnabled;
+      VkPhysicalDeviceMemoryProperties memoryProperties;
+      VkDeviceSize blockSize, nonCoherentAtomSize;
+
+      std::vector<std::unique_ptr<EngineMemoryBlock>> blocks;
+      EngineMemoryStatistics statistics;
+      std::mutex allocatorMutex;
+  };
+} // namespace nugiEngine
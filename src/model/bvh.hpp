@@ -4,8 +4,11 @@
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 
+#include "../ray_ubo.hpp"
 #include "../utils/sort.hpp"
 
+#include <cfloat>
+#include <cmath>
 #include <vector>
 #include <algorithm>
 #include <stack>
@@ -87,22 +90,22 @@ namespace nugiEngine {
     }
   };
 
-  bool nodeCompare(BvhItemBuild &a, BvhItemBuild &b) {
+  inline bool nodeCompare(BvhItemBuild &a, BvhItemBuild &b) {
     return a.index < b.index;
   }
 
-  Aabb surroundingBox(Aabb box0, Aabb box1) {
+  inline Aabb surroundingBox(Aabb box0, Aabb box1) {
     return Aabb{ glm::min(box0.min, box1.min), glm::max(box0.max, box1.max) };
   }
 
-  Aabb objectBoundingBox(Object &o) {
+  inline Aabb objectBoundingBox(Object &o) {
     // Need to add eps to correctly construct an AABB for flat objects like planes.
     return Aabb{ glm::min(glm::min(o.triangle.point0, o.triangle.point1), o.triangle.point2) - eps, 
       glm::max(glm::max(o.triangle.point0, o.triangle.point1), o.triangle.point2) + eps };
     // return {t.center - t.radius, t.center + t.radius};
   }
 
-  Aabb objectListBoundingBox(std::vector<ObjectBoundBox> &objects) {
+  inline Aabb objectListBoundingBox(std::vector<ObjectBoundBox> &objects) {
     Aabb tempBox;
     Aabb outputBox;
     bool firstBox = true;
@@ -123,21 +126,21 @@ namespace nugiEngine {
     return boxA.min[axis] < boxB.min[axis];
   }
 
-  bool boxXCompare(ObjectBoundBox a, ObjectBoundBox b) {
+  inline bool boxXCompare(ObjectBoundBox a, ObjectBoundBox b) {
     return boxCompare(a.o, b.o, 0);
   }
 
-  bool boxYCompare(ObjectBoundBox a, ObjectBoundBox b) {
+  inline bool boxYCompare(ObjectBoundBox a, ObjectBoundBox b) {
     return boxCompare(a.o, b.o, 1);
   }
 
-  bool boxZCompare(ObjectBoundBox a, ObjectBoundBox b) {
+  inline bool boxZCompare(ObjectBoundBox a, ObjectBoundBox b) {
     return boxCompare(a.o, b.o, 2);
   }
 
   // Since GPU can't deal with tree structures we need to create a flattened BVH.
   // Stack is used instead of a tree.
-  std::vector<BvhNode> createBvh(const std::vector<ObjectBoundBox> &srcObjects) {
+  inline std::vector<BvhNode> createBvh(const std::vector<ObjectBoundBox> &srcObjects) {
     int nodeCounter = 0;
     std::vector<BvhItemBuild> intermediate;
     std::stack<BvhItemBuild> nodeStack;
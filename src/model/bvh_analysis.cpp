@@ -0,0 +1,363 @@
+#include "bvh_analysis.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+namespace nugiEngine {
+  namespace {
+    struct NodeRecord {
+      int index;
+      uint32_t depth;
+    };
+
+    float surfaceArea(glm::vec3 minimum, glm::vec3 maximum) {
+      glm::vec3 extent = glm::max(maximum - minimum, glm::vec3(0.0f));
+      return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+    }
+
+    float volume(glm::vec3 minimum, glm::vec3 maximum) {
+      glm::vec3 extent = glm::max(maximum - minimum, glm::vec3(0.0f));
+      return extent.x * extent.y * extent.z;
+    }
+
+    uint32_t objectCount(const BvhNode &node) {
+      return (node.leftObjIndex >= 0 ? 1u : 0u) + (node.rightObjIndex >= 0 ? 1u : 0u);
+    }
+
+    bool isLeaf(const BvhNode &node) {
+      return node.leftNode < 0 && node.rightNode < 0;
+    }
+
+    void checkNodeIndex(const std::vector<BvhNode> &bvhNodes, int index) {
+      if (index >= static_cast<int>(bvhNodes.size())) {
+        throw std::runtime_error("bvh node refers to child " + std::to_string(index) + " out of " + std::to_string(bvhNodes.size()) + " nodes!");
+      }
+    }
+
+    // worst case occupancy of the hitBvh stack while the subtree of nodeIndex is walked, counted from the entry below it:
+    // both children are pushed, the right one is popped first while the left one still waits on the stack
+    uint32_t stackDepth(const std::vector<BvhNode> &bvhNodes, std::vector<uint32_t> &depths, int nodeIndex) {
+      const BvhNode &node = bvhNodes[nodeIndex];
+      
+      if (node.leftNode >= 0 && node.rightNode >= 0) {
+        return std::max({ 2u, 1u + depths[node.rightNode], depths[node.leftNode] });
+      }
+
+      if (node.leftNode >= 0) {
+        return std::max(1u, depths[node.leftNode]);
+      }
+
+      if (node.rightNode >= 0) {
+        return std::max(1u, depths[node.rightNode]);
+      }
+
+      return 0u;
+    }
+
+    bool intersectAabb(const BvhAnalysisRay &ray, glm::vec3 invDirection, glm::vec3 minimum, glm::vec3 maximum) {
+      glm::vec3 tMin = (minimum - ray.origin) * invDirection;
+      glm::vec3 tMax = (maximum - ray.origin) * invDirection;
+      glm::vec3 t1 = glm::min(tMin, tMax);
+      glm::vec3 t2 = glm::max(tMin, tMax);
+
+      float tNear = std::max(std::max(t1.x, t1.y), t1.z);
+      float tFar = std::min(std::min(t2.x, t2.y), t2.z);
+
+      return tNear < tFar;
+    }
+
+    bool intersectTriangle(const BvhAnalysisRay &ray, const Triangle &triangle, float tMin, float &tMax) {
+      const float epsilon = 0.00001f;
+
+      glm::vec3 v0v1 = triangle.point1 - triangle.point0;
+      glm::vec3 v0v2 = triangle.point2 - triangle.point0;
+      glm::vec3 pvec = glm::cross(ray.direction, v0v2);
+      float det = glm::dot(v0v1, pvec);
+
+      if (std::abs(det) < epsilon) {
+        return false;
+      }
+
+      float invDet = 1.0f / det;
+
+      glm::vec3 tvec = ray.origin - triangle.point0;
+      float u = glm::dot(tvec, pvec) * invDet;
+      if (u < 0.0f || u > 1.0f) {
+        return false;
+      }
+
+      glm::vec3 qvec = glm::cross(tvec, v0v1);
+      float v = glm::dot(ray.direction, qvec) * invDet;
+      if (v < 0.0f || u + v > 1.0f) {
+        return false;
+      }
+
+      float t = glm::dot(v0v2, qvec) * invDet;
+      if (t <= epsilon || t < tMin || t > tMax) {
+        return false;
+      }
+
+      tMax = t;
+      return true;
+    }
+
+    std::vector<BvhAnalysisRay> sampleRays(const BvhNode &root, const BvhAnalysisConfigInfo &configInfo) {
+      std::mt19937 generator{configInfo.seed};
+      std::uniform_real_distribution<float> distribution{0.0f, 1.0f};
+
+      glm::vec3 center = (root.minimum + root.maximum) * 0.5f;
+      float radius = glm::length(root.maximum - root.minimum) * 0.5f * 1.5f + 1e-3f;
+
+      std::vector<BvhAnalysisRay> rays;
+      rays.reserve(configInfo.sampledRayCount);
+
+      for (uint32_t i = 0; i < configInfo.sampledRayCount; i++) {
+        // uniform origin on the bounding sphere, aimed at a uniform point inside the root box
+        float z = 1.0f - 2.0f * distribution(generator);
+        float phi = 2.0f * glm::pi<float>() * distribution(generator);
+        float r = std::sqrt(std::max(0.0f, 1.0f - z * z));
+
+        glm::vec3 origin = center + radius * glm::vec3(r * std::cos(phi), r * std::sin(phi), z);
+        glm::vec3 target = root.minimum + (root.maximum - root.minimum) * glm::vec3(distribution(generator), distribution(generator), distribution(generator));
+
+        rays.push_back({ origin, glm::normalize(target - origin) });
+      }
+
+      return rays;
+    }
+
+    // the same walk as hitBvh in ray_trace_pbrt.comp, without its stack limit
+    void traceRays(const std::vector<BvhNode> &bvhNodes, const std::vector<Object> &objects, const std::vector<BvhAnalysisRay> &rays, BvhStatistics &statistics) {
+      uint64_t nodeVisits = 0, triangleTests = 0, hitCount = 0;
+      std::vector<int> stack;
+
+      for (auto &&ray : rays) {
+        glm::vec3 invDirection = 1.0f / ray.direction;
+        float tMax = 1000000.0f;
+        bool isHit = false;
+        uint32_t rayNodeVisits = 0;
+
+        stack.clear();
+        stack.push_back(0);
+
+        while (!stack.empty()) {
+          int currentNode = stack.back();
+          stack.pop_back();
+
+          const BvhNode &node = bvhNodes[currentNode];
+          rayNodeVisits++;
+
+          if (!intersectAabb(ray, invDirection, node.minimum, node.maximum)) {
+            continue;
+          }
+
+          for (int objIndex : { node.leftObjIndex, node.rightObjIndex }) {
+            if (objIndex >= 0) {
+              isHit |= intersectTriangle(ray, objects[objIndex].triangle, 0.001f, tMax);
+              triangleTests++;
+            }
+          }
+
+          if (node.leftNode >= 0) {
+            stack.push_back(node.leftNode);
+          }
+
+          if (node.rightNode >= 0) {
+            stack.push_back(node.rightNode);
+          }
+        }
+
+        nodeVisits += rayNodeVisits;
+        hitCount += isHit ? 1 : 0;
+        statistics.maxNodeVisits = std::max(statistics.maxNodeVisits, rayNodeVisits);
+      }
+
+      statistics.rayCount = static_cast<uint32_t>(rays.size());
+      if (!rays.empty()) {
+        statistics.averageNodeVisits = static_cast<float>(static_cast<double>(nodeVisits) / rays.size());
+        statistics.averageTriangleTests = static_cast<float>(static_cast<double>(triangleTests) / rays.size());
+        statistics.hitRatio = static_cast<float>(static_cast<double>(hitCount) / rays.size());
+      }
+    }
+
+    BvhStatistics analyzeStructure(const std::vector<BvhNode> &bvhNodes, const std::vector<Object> &objects, const BvhAnalysisConfigInfo &configInfo) {
+      BvhStatistics statistics{};
+      statistics.nodeCount = static_cast<uint32_t>(bvhNodes.size());
+      statistics.objectCount = static_cast<uint32_t>(objects.size());
+
+      if (bvhNodes.empty()) {
+        return statistics;
+      }
+
+      float rootArea = std::max(surfaceArea(bvhNodes[0].minimum, bvhNodes[0].maximum), FLT_MIN);
+      double childArea = 0.0, overlapArea = 0.0, innerVolume = 0.0, emptyVolume = 0.0, leafDepthSum = 0.0;
+
+      // children always come after their parent in the flattened array, nodes are walked from the root
+      std::vector<NodeRecord> nodeStack = { { 0, 0 } };
+      std::vector<int> visitOrder;
+      std::vector<bool> isVisited(bvhNodes.size(), false);
+
+      while (!nodeStack.empty()) {
+        NodeRecord record = nodeStack.back();
+        nodeStack.pop_back();
+
+        if (isVisited[record.index]) {
+          throw std::runtime_error("bvh node " + std::to_string(record.index) + " is reachable twice!");
+        }
+
+        isVisited[record.index] = true;
+        visitOrder.push_back(record.index);
+
+        const BvhNode &node = bvhNodes[record.index];
+        float nodeArea = surfaceArea(node.minimum, node.maximum);
+
+        statistics.sahCost += configInfo.intersectionCost * objectCount(node) * nodeArea / rootArea;
+        statistics.maxDepth = std::max(statistics.maxDepth, record.depth);
+
+        if (isLeaf(node)) {
+          statistics.leafCount++;
+          leafDepthSum += record.depth;
+
+          if (statistics.depthHistogram.size() <= record.depth) {
+            statistics.depthHistogram.resize(record.depth + 1, 0);
+          }
+
+          uint32_t leafSize = objectCount(node);
+          if (statistics.leafSizeHistogram.size() <= leafSize) {
+            statistics.leafSizeHistogram.resize(leafSize + 1, 0);
+          }
+
+          statistics.depthHistogram[record.depth]++;
+          statistics.leafSizeHistogram[leafSize]++;
+          continue;
+        }
+
+        statistics.innerNodeCount++;
+        statistics.sahCost += configInfo.traversalCost * nodeArea / rootArea;
+
+        for (int child : { node.leftNode, node.rightNode }) {
+          if (child >= 0) {
+            checkNodeIndex(bvhNodes, child);
+            nodeStack.push_back({ child, record.depth + 1 });
+          }
+        }
+
+        double nodeVolume = volume(node.minimum, node.maximum);
+        double coveredVolume = 0.0;
+
+        if (node.leftNode >= 0 && node.rightNode >= 0) {
+          const BvhNode &left = bvhNodes[node.leftNode];
+          const BvhNode &right = bvhNodes[node.rightNode];
+
+          glm::vec3 overlapMinimum = glm::max(left.minimum, right.minimum);
+          glm::vec3 overlapMaximum = glm::min(left.maximum, right.maximum);
+
+          childArea += surfaceArea(left.minimum, left.maximum) + surfaceArea(right.minimum, right.maximum);
+          overlapArea += surfaceArea(overlapMinimum, overlapMaximum);
+
+          coveredVolume = volume(left.minimum, left.maximum) + volume(right.minimum, right.maximum) - volume(overlapMinimum, overlapMaximum);
+        } else {
+          const BvhNode &child = bvhNodes[std::max(node.leftNode, node.rightNode)];
+          coveredVolume = volume(child.minimum, child.maximum);
+        }
+
+        innerVolume += nodeVolume;
+        emptyVolume += std::max(0.0, nodeVolume - coveredVolume);
+      }
+
+      // every node is reachable from the root, so post order is the visit order reversed
+      std::vector<uint32_t> stackDepths(bvhNodes.size(), 0);
+      for (auto iterator = visitOrder.rbegin(); iterator != visitOrder.rend(); iterator++) {
+        stackDepths[*iterator] = stackDepth(bvhNodes, stackDepths, *iterator);
+      }
+
+      statistics.maxStackDepth = std::max(1u, stackDepths[0]);
+      statistics.averageLeafDepth = statistics.leafCount > 0 ? static_cast<float>(leafDepthSum / statistics.leafCount) : 0.0f;
+      statistics.siblingOverlapArea = static_cast<float>(overlapArea);
+      statistics.siblingOverlapRatio = childArea > 0.0 ? static_cast<float>(overlapArea / childArea) : 0.0f;
+      statistics.emptySpaceRatio = innerVolume > 0.0 ? static_cast<float>(emptyVolume / innerVolume) : 0.0f;
+
+      return statistics;
+    }
+  } // namespace
+
+  BvhStatistics analyzeBvh(const std::vector<BvhNode> &bvhNodes, const std::vector<Object> &objects, const BvhAnalysisConfigInfo &configInfo) {
+    auto statistics = analyzeStructure(bvhNodes, objects, configInfo);
+    
+    if (!bvhNodes.empty() && configInfo.sampledRayCount > 0) {
+      traceRays(bvhNodes, objects, sampleRays(bvhNodes[0], configInfo), statistics);
+    }
+
+    return statistics;
+  }
+
+  BvhStatistics analyzeBvh(const std::vector<BvhNode> &bvhNodes, const std::vector<Object> &objects, 
+    const std::vector<BvhAnalysisRay> &rays, const BvhAnalysisConfigInfo &configInfo) 
+  {
+    auto statistics = analyzeStructure(bvhNodes, objects, configInfo);
+
+    if (!bvhNodes.empty()) {
+      traceRays(bvhNodes, objects, rays, statistics);
+    }
+
+    return statistics;
+  }
+
+  void BvhStatistics::print(std::ostream &stream) const {
+    stream << "nodes:              " << this->nodeCount << " (" << this->innerNodeCount << " inner, " << this->leafCount << " leaves)\n"
+      << "objects:            " << this->objectCount << "\n"
+      << "sah cost:           " << this->sahCost << "\n"
+      << "depth:              max " << this->maxDepth << ", leaf average " << this->averageLeafDepth << "\n"
+      << "gpu stack:          " << this->maxStackDepth << " of " << GPU_BVH_STACK_SIZE
+      << (this->maxStackDepth > GPU_BVH_STACK_SIZE ? " (overflows hitBvh!)" : "") << "\n"
+      << "sibling overlap:    " << this->siblingOverlapArea << " area, " << this->siblingOverlapRatio * 100.0f << "% of the children\n"
+      << "empty space:        " << this->emptySpaceRatio * 100.0f << "% of the inner nodes\n";
+
+    stream << "leaf sizes:        ";
+    for (size_t i = 0; i < this->leafSizeHistogram.size(); i++) {
+      stream << " " << i << ":" << this->leafSizeHistogram[i];
+    }
+
+    stream << "\nleaves per depth:  ";
+    for (size_t i = 0; i < this->depthHistogram.size(); i++) {
+      if (this->depthHistogram[i] > 0) {
+        stream << " " << i << ":" << this->depthHistogram[i];
+      }
+    }
+
+    stream << "\n";
+
+    if (this->rayCount > 0) {
+      stream << "rays:               " << this->rayCount << ", " << this->hitRatio * 100.0f << "% hit\n"
+        << "node visits:        " << this->averageNodeVisits << " per ray, max " << this->maxNodeVisits << "\n"
+        << "triangle tests:     " << this->averageTriangleTests << " per ray\n";
+    }
+  }
+
+  void BvhStatistics::writeJson(std::ostream &stream) const {
+    stream << "{\"nodes\":" << this->nodeCount << ",\"inner_nodes\":" << this->innerNodeCount << ",\"leaves\":" << this->leafCount
+      << ",\"objects\":" << this->objectCount << ",\"sah_cost\":" << this->sahCost
+      << ",\"max_depth\":" << this->maxDepth << ",\"average_leaf_depth\":" << this->averageLeafDepth
+      << ",\"max_stack_depth\":" << this->maxStackDepth
+      << ",\"sibling_overlap_area\":" << this->siblingOverlapArea << ",\"sibling_overlap_ratio\":" << this->siblingOverlapRatio
+      << ",\"empty_space_ratio\":" << this->emptySpaceRatio;
+
+    stream << ",\"leaf_size_histogram\":[";
+    for (size_t i = 0; i < this->leafSizeHistogram.size(); i++) {
+      stream << (i > 0 ? "," : "") << this->leafSizeHistogram[i];
+    }
+
+    stream << "],\"depth_histogram\":[";
+    for (size_t i = 0; i < this->depthHistogram.size(); i++) {
+      stream << (i > 0 ? "," : "") << this->depthHistogram[i];
+    }
+
+    stream << "],\"rays\":" << this->rayCount << ",\"average_node_visits\":" << this->averageNodeVisits
+      << ",\"average_triangle_tests\":" << this->averageTriangleTests << ",\"max_node_visits\":" << this->maxNodeVisits
+      << ",\"hit_ratio\":" << this->hitRatio << "}";
+  }
+} // namespace nugiEngine
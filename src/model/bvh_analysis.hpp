@@ -0,0 +1,74 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include "../ray_ubo.hpp"
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace nugiEngine {
+  // hitBvh in ray_trace_pbrt.comp traverses with an int stack[BVH_STACK_SIZE] and skips the pushes that don't fit.
+  // CPU built trees are checked against it, the GPU built LBVH is not checked and may lose subtrees past this depth
+  constexpr uint32_t GPU_BVH_STACK_SIZE = 64;
+
+  struct BvhAnalysisRay {
+    glm::vec3 origin;
+    glm::vec3 direction;
+  };
+
+  struct BvhAnalysisConfigInfo {
+    // weights of the surface area heuristic
+    float traversalCost = 1.0f;
+    float intersectionCost = 1.0f;
+
+    // rays from a sphere around the scene towards random points inside it, 0 skips the traversal statistics
+    uint32_t sampledRayCount = 100000;
+    uint32_t seed = 1;
+  };
+
+  struct BvhStatistics {
+    uint32_t nodeCount = 0;
+    uint32_t innerNodeCount = 0;
+    uint32_t leafCount = 0;
+    uint32_t objectCount = 0;
+
+    float sahCost = 0.0f;
+
+    uint32_t maxDepth = 0;
+    float averageLeafDepth = 0.0f;
+
+    // entries the GPU traversal stack needs in the worst case, has to stay within GPU_BVH_STACK_SIZE
+    uint32_t maxStackDepth = 0;
+
+    std::vector<uint32_t> depthHistogram;     // leaves per depth
+    std::vector<uint32_t> leafSizeHistogram;  // leaves per object count
+
+    // surface area of the intersection of the two children, summed over inner nodes and relative to the children's area
+    float siblingOverlapArea = 0.0f;
+    float siblingOverlapRatio = 0.0f;
+
+    // volume of inner nodes not covered by either child, relative to the volume of the inner nodes
+    float emptySpaceRatio = 0.0f;
+
+    // per ray of the sampled set, counted the way hitBvh walks the tree
+    uint32_t rayCount = 0;
+    float averageNodeVisits = 0.0f;
+    float averageTriangleTests = 0.0f;
+    uint32_t maxNodeVisits = 0;
+    float hitRatio = 0.0f;
+
+    void print(std::ostream &stream) const;
+    void writeJson(std::ostream &stream) const;
+  };
+
+  BvhStatistics analyzeBvh(const std::vector<BvhNode> &bvhNodes, const std::vector<Object> &objects, 
+    const BvhAnalysisConfigInfo &configInfo = BvhAnalysisConfigInfo{});
+
+  // the traversal statistics measured over the caller's rays instead of sampled ones
+  BvhStatistics analyzeBvh(const std::vector<BvhNode> &bvhNodes, const std::vector<Object> &objects, 
+    const std::vector<BvhAnalysisRay> &rays, const BvhAnalysisConfigInfo &configInfo = BvhAnalysisConfigInfo{});
+} // namespace nugiEngine
@@ -0,0 +1,423 @@
+#include "gltf_importer.hpp"
+#include "../cpu_renderer/tile_scheduler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#define CGLTF_IMPLEMENTATION
+#include <cgltf.h>
+
+#include <stb_image.h>
+
+namespace nugiEngine {
+	namespace {
+		const char* resultName(cgltf_result result) {
+			switch (result) {
+				case cgltf_result_data_too_short: return "data too short";
+				case cgltf_result_unknown_format: return "unknown format";
+				case cgltf_result_invalid_json: return "invalid json";
+				case cgltf_result_invalid_gltf: return "invalid gltf";
+				case cgltf_result_invalid_options: return "invalid options";
+				case cgltf_result_file_not_found: return "file not found";
+				case cgltf_result_io_error: return "io error";
+				case cgltf_result_out_of_memory: return "out of memory";
+				case cgltf_result_legacy_gltf: return "legacy gltf";
+				default: return "unknown error";
+			}
+		}
+
+		// frees the parsed document on every way out of importGltf
+		struct GltfDocument {
+			cgltf_data *data = nullptr;
+			~GltfDocument() { cgltf_free(this->data); }
+		};
+
+		// Disney style reflectance, the F0 of 0.16 * fresnelReflect^2 the shaders use
+		float iorToFresnelReflect(float ior) {
+			float f0 = (ior - 1.0f) / (ior + 1.0f);
+			return std::min(std::sqrt(f0 * f0 / 0.16f), 1.0f);
+		}
+
+		Material convertMaterial(const cgltf_material &material) {
+			Material converted{ glm::vec3(1.0f), 1.0f, 1.0f, 0.5f };
+
+			if (material.has_pbr_metallic_roughness) {
+				auto &&pbr = material.pbr_metallic_roughness;
+
+				converted.baseColor = glm::vec3(pbr.base_color_factor[0], pbr.base_color_factor[1], pbr.base_color_factor[2]);
+				converted.metallicness = pbr.metallic_factor;
+				converted.roughness = pbr.roughness_factor;
+			}
+
+			if (material.has_ior) {
+				converted.fresnelReflect = iorToFresnelReflect(material.ior.ior);
+			}
+
+			return converted;
+		}
+
+		glm::vec3 emissiveColor(const cgltf_material &material) {
+			float strength = material.has_emissive_strength ? material.emissive_strength.emissive_strength : 1.0f;
+			return glm::vec3(material.emissive_factor[0], material.emissive_factor[1], material.emissive_factor[2]) * strength;
+		}
+
+		const cgltf_accessor* findAttribute(const cgltf_primitive &primitive, cgltf_attribute_type type) {
+			for (cgltf_size i = 0; i < primitive.attributes_count; i++) {
+				if (primitive.attributes[i].type == type && primitive.attributes[i].index == 0) {
+					return primitive.attributes[i].data;
+				}
+			}
+
+			return nullptr;
+		}
+
+		void decodePrimitive(const cgltf_data &data, const cgltf_primitive &primitive, GltfPrimitive &decoded) {
+			const cgltf_accessor *positions = findAttribute(primitive, cgltf_attribute_type_position);
+			if (positions == nullptr) {
+				throw std::runtime_error("primitive without positions!");
+			}
+
+			const cgltf_accessor *normals = findAttribute(primitive, cgltf_attribute_type_normal);
+			const cgltf_accessor *uvs = findAttribute(primitive, cgltf_attribute_type_texcoord);
+			const cgltf_accessor *colors = findAttribute(primitive, cgltf_attribute_type_color);
+
+			glm::vec4 baseColor{1.0f};
+			if (primitive.material != nullptr && primitive.material->has_pbr_metallic_roughness) {
+				const cgltf_float *factor = primitive.material->pbr_metallic_roughness.base_color_factor;
+				baseColor = glm::vec4(factor[0], factor[1], factor[2], factor[3]);
+			}
+
+			auto &&vertices = decoded.model.vertices;
+			vertices.resize(positions->count);
+
+			for (cgltf_size i = 0; i < positions->count; i++) {
+				float values[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+				Vertex &vertex = vertices[i];
+
+				cgltf_accessor_read_float(positions, i, values, 3);
+				vertex.position = glm::vec3(values[0], values[1], values[2]);
+
+				if (normals != nullptr && cgltf_accessor_read_float(normals, i, values, 3)) {
+					vertex.normal = glm::vec3(values[0], values[1], values[2]);
+				}
+
+				if (uvs != nullptr && cgltf_accessor_read_float(uvs, i, values, 2)) {
+					vertex.uv = glm::vec2(values[0], values[1]);
+				}
+
+				vertex.color = glm::vec3(baseColor.r, baseColor.g, baseColor.b);
+				if (colors != nullptr && cgltf_accessor_read_float(colors, i, values, cgltf_num_components(colors->type))) {
+					vertex.color *= glm::vec3(values[0], values[1], values[2]);
+				}
+			}
+
+			auto &&indices = decoded.model.indices;
+
+			if (primitive.indices != nullptr) {
+				indices.resize(primitive.indices->count);
+
+				for (cgltf_size i = 0; i < primitive.indices->count; i++) {
+					indices[i] = static_cast<uint32_t>(cgltf_accessor_read_index(primitive.indices, i));
+				}
+			} else {
+				indices.resize(positions->count);
+
+				for (cgltf_size i = 0; i < positions->count; i++) {
+					indices[i] = static_cast<uint32_t>(i);
+				}
+			}
+
+			// a trailing partial triangle would make the ray tracing flattening read past the end
+			indices.resize(indices.size() - indices.size() % 3);
+
+			for (auto &&index : indices) {
+				if (index >= vertices.size()) {
+					throw std::runtime_error("primitive index " + std::to_string(index) + " is out of its " + std::to_string(vertices.size()) + " vertices!");
+				}
+			}
+
+			if (primitive.material != nullptr) {
+				decoded.materialIndex = static_cast<uint32_t>(primitive.material - data.materials);
+
+				const cgltf_texture *texture = primitive.material->pbr_metallic_roughness.base_color_texture.texture;
+				if (primitive.material->has_pbr_metallic_roughness && texture != nullptr && texture->image != nullptr) {
+					decoded.baseColorImageIndex = static_cast<int32_t>(texture->image - data.images);
+				}
+			} else {
+				decoded.materialIndex = static_cast<uint32_t>(data.materials_count);
+			}
+		}
+
+		std::vector<unsigned char> readImageBytes(const cgltf_options &options, const cgltf_image &image, const std::string &directory) {
+			if (image.buffer_view != nullptr) {
+				const uint8_t *bytes = cgltf_buffer_view_data(image.buffer_view);
+				if (bytes == nullptr) {
+					throw std::runtime_error("image buffer is not loaded!");
+				}
+
+				return std::vector<unsigned char>(bytes, bytes + image.buffer_view->size);
+			}
+
+			if (image.uri == nullptr) {
+				throw std::runtime_error("image without data!");
+			}
+
+			std::string uri = image.uri;
+
+			if (uri.compare(0, 5, "data:") == 0) {
+				size_t dataStart = uri.find(";base64,");
+				if (dataStart == std::string::npos) {
+					throw std::runtime_error("image data uri is not base64!");
+				}
+
+				const char *base64 = image.uri + dataStart + 8;
+				size_t base64Size = std::strlen(base64);
+				size_t paddingSize = base64Size > 0 && base64[base64Size - 1] == '=' ? (base64Size > 1 && base64[base64Size - 2] == '=' ? 2 : 1) : 0;
+				cgltf_size size = base64Size / 4 * 3 - paddingSize;
+
+				void *decoded = nullptr;
+				if (cgltf_load_buffer_base64(&options, size, base64, &decoded) != cgltf_result_success) {
+					throw std::runtime_error("failed to decode image data uri!");
+				}
+
+				std::vector<unsigned char> bytes(static_cast<unsigned char*>(decoded), static_cast<unsigned char*>(decoded) + size);
+				free(decoded);
+
+				return bytes;
+			}
+
+			// uris are percent encoded and relative to the gltf file
+			std::vector<char> decodedUri(uri.begin(), uri.end());
+			decodedUri.push_back('\0');
+			cgltf_decode_uri(decodedUri.data());
+
+			std::string path = directory + decodedUri.data();
+			FILE *file = std::fopen(path.c_str(), "rb");
+
+			if (file == nullptr) {
+				throw std::runtime_error("failed to open image " + path + "!");
+			}
+
+			std::fseek(file, 0, SEEK_END);
+			long fileSize = std::ftell(file);
+			std::fseek(file, 0, SEEK_SET);
+
+			std::vector<unsigned char> bytes(fileSize > 0 ? static_cast<size_t>(fileSize) : 0);
+			size_t readSize = std::fread(bytes.data(), 1, bytes.size(), file);
+			std::fclose(file);
+
+			if (readSize != bytes.size()) {
+				throw std::runtime_error("failed to read image " + path + "!");
+			}
+
+			return bytes;
+		}
+
+		void decodeImage(const cgltf_options &options, const cgltf_image &image, const std::string &directory, GltfImage &decoded) {
+			auto bytes = readImageBytes(options, image, directory);
+
+			int width = 0, height = 0, channels = 0;
+			stbi_uc *pixels = stbi_load_from_memory(bytes.data(), static_cast<int>(bytes.size()), &width, &height, &channels, STBI_rgb_alpha);
+
+			if (pixels == nullptr) {
+				throw std::runtime_error(std::string("failed to decode image: ") + stbi_failure_reason());
+			}
+
+			decoded.width = static_cast<uint32_t>(width);
+			decoded.height = static_cast<uint32_t>(height);
+			decoded.pixels.assign(pixels, pixels + static_cast<size_t>(width) * height * 4);
+
+			stbi_image_free(pixels);
+		}
+
+		glm::mat4 nodeWorldTransform(const cgltf_node &node) {
+			cgltf_float matrix[16];
+			cgltf_node_transform_world(&node, matrix);
+
+			// both are column major
+			glm::mat4 transform{1.0f};
+			for (int column = 0; column < 4; column++) {
+				for (int row = 0; row < 4; row++) {
+					transform[column][row] = matrix[column * 4 + row];
+				}
+			}
+
+			return transform;
+		}
+
+		// one instance per primitive of every node with a mesh, in the default scene or else below every root node
+		void collectInstances(const cgltf_data &data, const std::vector<uint32_t> &primitiveOffsets, std::vector<GltfInstance> &instances) {
+			std::vector<const cgltf_node*> nodes;
+			const cgltf_scene *scene = data.scene != nullptr ? data.scene : (data.scenes_count > 0 ? &data.scenes[0] : nullptr);
+
+			if (scene != nullptr) {
+				for (cgltf_size i = 0; i < scene->nodes_count; i++) {
+					nodes.emplace_back(scene->nodes[i]);
+				}
+			} else {
+				for (cgltf_size i = 0; i < data.nodes_count; i++) {
+					if (data.nodes[i].parent == nullptr) {
+						nodes.emplace_back(&data.nodes[i]);
+					}
+				}
+			}
+
+			while (!nodes.empty()) {
+				const cgltf_node *node = nodes.back();
+				nodes.pop_back();
+
+				for (cgltf_size i = 0; i < node->children_count; i++) {
+					nodes.emplace_back(node->children[i]);
+				}
+
+				if (node->mesh == nullptr) {
+					continue;
+				}
+
+				glm::mat4 transform = nodeWorldTransform(*node);
+				uint32_t meshIndex = static_cast<uint32_t>(node->mesh - data.meshes);
+
+				for (uint32_t i = primitiveOffsets[meshIndex]; i < primitiveOffsets[meshIndex + 1]; i++) {
+					instances.emplace_back(GltfInstance{ i, transform });
+				}
+			}
+		}
+	} // namespace
+
+	GltfSceneData importGltf(const std::string &filePath, const GltfImportConfigInfo &configInfo) {
+		cgltf_options options{};
+		GltfDocument document;
+
+		cgltf_result result = cgltf_parse_file(&options, filePath.c_str(), &document.data);
+		if (result == cgltf_result_success) {
+			result = cgltf_load_buffers(&options, document.data, filePath.c_str());
+		}
+
+		if (result == cgltf_result_success) {
+			result = cgltf_validate(document.data);
+		}
+
+		if (result != cgltf_result_success) {
+			throw std::runtime_error("failed to load " + filePath + ": " + resultName(result) + "!");
+		}
+
+		const cgltf_data &data = *document.data;
+
+		size_t separator = filePath.find_last_of("/\\");
+		std::string directory = separator == std::string::npos ? std::string{} : filePath.substr(0, separator + 1);
+
+		// the primitives of mesh i are [primitiveOffsets[i], primitiveOffsets[i + 1]), only triangle lists are kept
+		std::vector<uint32_t> primitiveOffsets(data.meshes_count + 1, 0);
+		std::vector<const cgltf_primitive*> primitives;
+
+		for (cgltf_size i = 0; i < data.meshes_count; i++) {
+			for (cgltf_size j = 0; j < data.meshes[i].primitives_count; j++) {
+				const cgltf_primitive &primitive = data.meshes[i].primitives[j];
+
+				if (primitive.type == cgltf_primitive_type_triangles && !primitive.has_draco_mesh_compression) {
+					primitives.emplace_back(&primitive);
+				}
+			}
+
+			primitiveOffsets[i + 1] = static_cast<uint32_t>(primitives.size());
+		}
+
+		GltfSceneData scene{};
+		scene.primitives.resize(primitives.size());
+		scene.images.resize(configInfo.isDecodingImages ? data.images_count : 0);
+
+		EngineTileScheduler scheduler{configInfo.threadCount};
+
+		// the workers must not throw, the first error is raised once every task has run
+		uint32_t primitiveCount = static_cast<uint32_t>(scene.primitives.size());
+		std::vector<std::string> errors(primitiveCount + scene.images.size());
+
+		scheduler.run(static_cast<uint32_t>(errors.size()), [&](uint32_t taskIndex, uint32_t) {
+			try {
+				if (taskIndex < primitiveCount) {
+					decodePrimitive(data, *primitives[taskIndex], scene.primitives[taskIndex]);
+				} else {
+					uint32_t imageIndex = taskIndex - primitiveCount;
+					decodeImage(options, data.images[imageIndex], directory, scene.images[imageIndex]);
+				}
+			} catch (const std::exception &e) {
+				errors[taskIndex] = e.what();
+			}
+		});
+
+		for (auto &&error : errors) {
+			if (!error.empty()) {
+				throw std::runtime_error("failed to import " + filePath + ": " + error);
+			}
+		}
+
+		collectInstances(data, primitiveOffsets, scene.instances);
+
+		// materials keep the glTF order, the default material for primitives without one goes last
+		auto &&rayTraceData = scene.rayTraceData;
+		for (cgltf_size i = 0; i < data.materials_count; i++) {
+			rayTraceData.materials.emplace_back(convertMaterial(data.materials[i]));
+		}
+
+		rayTraceData.materials.emplace_back(Material{ glm::vec3(1.0f), 0.0f, 1.0f, 0.5f });
+
+		// every instance writes its triangles into its own range, so the flattening runs in parallel as well
+		std::vector<size_t> objectOffsets(scene.instances.size() + 1, 0);
+		for (size_t i = 0; i < scene.instances.size(); i++) {
+			objectOffsets[i + 1] = objectOffsets[i] + scene.primitives[scene.instances[i].primitiveIndex].model.indices.size() / 3;
+		}
+
+		rayTraceData.objects.resize(objectOffsets.back());
+
+		scheduler.run(static_cast<uint32_t>(scene.instances.size()), [&](uint32_t taskIndex, uint32_t) {
+			const GltfInstance &instance = scene.instances[taskIndex];
+			const GltfPrimitive &primitive = scene.primitives[instance.primitiveIndex];
+
+			auto &&vertices = primitive.model.vertices;
+			auto &&indices = primitive.model.indices;
+
+			for (size_t i = 0; i < indices.size() / 3; i++) {
+				glm::vec3 points[3];
+				for (int corner = 0; corner < 3; corner++) {
+					points[corner] = glm::vec3(instance.transform * glm::vec4(vertices[indices[i * 3 + corner]].position, 1.0f));
+				}
+
+				rayTraceData.objects[objectOffsets[taskIndex] + i] = Object{ Triangle{ points[0], points[1], points[2] }, 1, primitive.materialIndex };
+			}
+		});
+
+		// emissive triangles also become lights, so they are sampled directly
+		glm::vec3 sceneMinimum{ std::numeric_limits<float>::max() };
+		glm::vec3 sceneMaximum{ -std::numeric_limits<float>::max() };
+
+		for (auto &&object : rayTraceData.objects) {
+			sceneMinimum = glm::min(sceneMinimum, glm::min(glm::min(object.triangle.point0, object.triangle.point1), object.triangle.point2));
+			sceneMaximum = glm::max(sceneMaximum, glm::max(glm::max(object.triangle.point0, object.triangle.point1), object.triangle.point2));
+		}
+
+		float lightRadius = configInfo.lightRadius;
+		if (lightRadius <= 0.0f && !rayTraceData.objects.empty()) {
+			lightRadius = glm::length(sceneMaximum - sceneMinimum);
+		}
+
+		for (auto &&object : rayTraceData.objects) {
+			if (object.materialIndex >= data.materials_count) {
+				continue;
+			}
+
+			glm::vec3 color = emissiveColor(data.materials[object.materialIndex]);
+			if (color.r > 0.0f || color.g > 0.0f || color.b > 0.0f) {
+				rayTraceData.lights.emplace_back(Light{ object.triangle, color, lightRadius });
+			}
+		}
+
+		return scene;
+	}
+} // namespace nugiEngine
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "model.hpp"
+#include "ray_trace_model_data.hpp"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace nugiEngine {
+	struct GltfImportConfigInfo {
+		// 0 uses every hardware thread
+		uint32_t threadCount = 0;
+
+		// falloff distance of the lights made from emissive triangles, 0 takes the diagonal of the scene bounds
+		float lightRadius = 0.0f;
+
+		bool isDecodingImages = true;
+	};
+
+	// one glTF primitive in the space of its mesh, shared by every node that instances the mesh
+	struct GltfPrimitive {
+		ModelData model;
+
+		// index into RayTraceModelData::materials, primitives without a material use the default one at the end
+		uint32_t materialIndex = 0;
+
+		// index into GltfSceneData::images, -1 without a base color texture
+		int32_t baseColorImageIndex = -1;
+	};
+
+	struct GltfInstance {
+		uint32_t primitiveIndex;
+		glm::mat4 transform;
+	};
+
+	// decoded to 8-bit RGBA
+	struct GltfImage {
+		uint32_t width = 0;
+		uint32_t height = 0;
+		std::vector<unsigned char> pixels;
+	};
+
+	struct GltfSceneData {
+		std::vector<GltfPrimitive> primitives;
+		std::vector<GltfInstance> instances;
+		std::vector<GltfImage> images;
+
+		// every instance flattened into world space triangles, emissive materials also become lights
+		RayTraceModelData rayTraceData;
+	};
+
+	/*
+	 * Imports a .gltf or .glb file. Only triangle primitives are kept. The node hierarchy of the default scene
+	 * is resolved into one instance per primitive and node, so meshes are stored once for the raster path.
+	 * Primitives and images are decoded in parallel, then the instances are flattened in parallel
+	 */
+	GltfSceneData importGltf(const std::string &filePath, const GltfImportConfigInfo &configInfo = GltfImportConfigInfo{});
+} // namespace nugiEngine
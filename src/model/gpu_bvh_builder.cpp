@@ -0,0 +1,296 @@
+#include "gpu_bvh_builder.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace nugiEngine {
+	EngineGpuBvhBuilder::EngineGpuBvhBuilder(EngineDevice &device, std::shared_ptr<EngineBuffer> objectBuffer, 
+		std::shared_ptr<EngineBuffer> bvhBuffer, uint32_t maxObjectCount) 
+		: appDevice{device}, objectBuffer{objectBuffer}, bvhBuffer{bvhBuffer}, maxObjectCount{std::max(maxObjectCount, 1u)}
+	{
+		this->maxTileCount = (this->maxObjectCount + GROUP_SIZE - 1) / GROUP_SIZE;
+
+		this->createBuffers();
+		this->createDescriptor();
+		this->createPipelineLayout();
+		this->createPipelines();
+	}
+
+	EngineGpuBvhBuilder::~EngineGpuBvhBuilder() {}
+
+	void EngineGpuBvhBuilder::createBuffers() {
+		VkBufferUsageFlags usageFlags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+
+		this->boundsBuffer = std::make_shared<EngineBuffer>(
+			this->appDevice,
+			sizeof(uint32_t),
+			6,
+			usageFlags | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+		);
+
+		for (uint32_t i = 0; i < 2; i++) {
+			this->keyBuffers[i] = std::make_shared<EngineBuffer>(
+				this->appDevice,
+				sizeof(uint32_t),
+				this->maxObjectCount,
+				usageFlags,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+			);
+
+			this->valueBuffers[i] = std::make_shared<EngineBuffer>(
+				this->appDevice,
+				sizeof(uint32_t),
+				this->maxObjectCount,
+				usageFlags,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+			);
+		}
+
+		this->histogramBuffer = std::make_shared<EngineBuffer>(
+			this->appDevice,
+			sizeof(uint32_t),
+			(1u << RADIX_BITS) * this->maxTileCount,
+			usageFlags,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+		);
+
+		this->parentBuffer = std::make_shared<EngineBuffer>(
+			this->appDevice,
+			sizeof(int32_t),
+			2 * this->maxObjectCount - 1,
+			usageFlags,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+		);
+
+		this->arrivalBuffer = std::make_shared<EngineBuffer>(
+			this->appDevice,
+			sizeof(uint32_t),
+			this->maxObjectCount,
+			usageFlags,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+		);
+	}
+
+	void EngineGpuBvhBuilder::createDescriptor() {
+		this->descriptorPool = EngineDescriptorPool::Builder(this->appDevice)
+			.setMaxSets(2)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 20)
+			.build();
+
+		auto descSetLayoutBuilder = EngineDescriptorSetLayout::Builder(this->appDevice);
+		for (uint32_t binding = 0; binding < 10; binding++) {
+			descSetLayoutBuilder.addBinding(binding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+		}
+
+		this->descSetLayout = descSetLayoutBuilder.build();
+
+		auto objectInfo = this->objectBuffer->descriptorInfo();
+		auto bvhInfo = this->bvhBuffer->descriptorInfo();
+		auto boundsInfo = this->boundsBuffer->descriptorInfo();
+		auto histogramInfo = this->histogramBuffer->descriptorInfo();
+		auto parentInfo = this->parentBuffer->descriptorInfo();
+		auto arrivalInfo = this->arrivalBuffer->descriptorInfo();
+
+		// set 0 sorts from the first key / value pair into the second, set 1 back again
+		for (uint32_t i = 0; i < 2; i++) {
+			auto inputKeyInfo = this->keyBuffers[i]->descriptorInfo();
+			auto inputValueInfo = this->valueBuffers[i]->descriptorInfo();
+			auto outputKeyInfo = this->keyBuffers[1 - i]->descriptorInfo();
+			auto outputValueInfo = this->valueBuffers[1 - i]->descriptorInfo();
+
+			bool isBuilt = EngineDescriptorWriter(*this->descSetLayout, *this->descriptorPool)
+				.writeBuffer(0, &objectInfo)
+				.writeBuffer(1, &bvhInfo)
+				.writeBuffer(2, &boundsInfo)
+				.writeBuffer(3, &inputKeyInfo)
+				.writeBuffer(4, &inputValueInfo)
+				.writeBuffer(5, &outputKeyInfo)
+				.writeBuffer(6, &outputValueInfo)
+				.writeBuffer(7, &histogramInfo)
+				.writeBuffer(8, &parentInfo)
+				.writeBuffer(9, &arrivalInfo)
+				.build(&this->descriptorSets[i]);
+
+			if (!isBuilt) {
+				throw std::runtime_error("failed to allocate the gpu bvh builder descriptor set!");
+			}
+		}
+	}
+
+	void EngineGpuBvhBuilder::createPipelineLayout() {
+		this->pipelineLayout = EnginePipelineLayout::Builder(this->appDevice)
+			.addDescriptorSetLayout(this->descSetLayout)
+			.addPushConstantRange(VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(LbvhPushConstant))
+			.build();
+	}
+
+	void EngineGpuBvhBuilder::createPipelines() {
+		VkPipelineLayout layout = this->pipelineLayout->getPipelineLayout();
+
+		this->boundsPipeline = EngineComputePipeline::Builder(this->appDevice, layout).setDefault("shader/lbvh_bounds.comp.spv").build();
+		this->mortonPipeline = EngineComputePipeline::Builder(this->appDevice, layout).setDefault("shader/lbvh_morton.comp.spv").build();
+		this->radixCountPipeline = EngineComputePipeline::Builder(this->appDevice, layout).setDefault("shader/lbvh_radix_count.comp.spv").build();
+		this->radixScanPipeline = EngineComputePipeline::Builder(this->appDevice, layout).setDefault("shader/lbvh_radix_scan.comp.spv").build();
+		this->radixScatterPipeline = EngineComputePipeline::Builder(this->appDevice, layout).setDefault("shader/lbvh_radix_scatter.comp.spv").build();
+		this->hierarchyPipeline = EngineComputePipeline::Builder(this->appDevice, layout).setDefault("shader/lbvh_hierarchy.comp.spv").build();
+		this->fitPipeline = EngineComputePipeline::Builder(this->appDevice, layout).setDefault("shader/lbvh_fit.comp.spv").build();
+	}
+
+	void EngineGpuBvhBuilder::bindSet(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t setIndex) {
+		vkCmdBindDescriptorSets(
+			commandBuffer->getCommandBuffer(),
+			VK_PIPELINE_BIND_POINT_COMPUTE,
+			this->pipelineLayout->getPipelineLayout(),
+			0,
+			1,
+			&this->descriptorSets[setIndex],
+			0,
+			nullptr
+		);
+	}
+
+	void EngineGpuBvhBuilder::pushConstant(std::shared_ptr<EngineCommandBuffer> commandBuffer, LbvhPushConstant push) {
+		vkCmdPushConstants(
+			commandBuffer->getCommandBuffer(),
+			this->pipelineLayout->getPipelineLayout(),
+			VK_SHADER_STAGE_COMPUTE_BIT,
+			0,
+			sizeof(LbvhPushConstant),
+			&push
+		);
+	}
+
+	void EngineGpuBvhBuilder::addStepBarrier(std::shared_ptr<EngineCommandBuffer> commandBuffer, std::shared_ptr<EngineBuffer> buffer) {
+		VkBufferMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.buffer = buffer->getBuffer();
+		barrier.offset = 0;
+		barrier.size = VK_WHOLE_SIZE;
+
+		commandBuffer->addBufferBarrier(barrier, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+	}
+
+	void EngineGpuBvhBuilder::recordBuild(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t objectCount) {
+		if (objectCount == 0) {
+			return;
+		}
+
+		if (objectCount > this->maxObjectCount) {
+			throw std::runtime_error("gpu bvh builder got " + std::to_string(objectCount) + " objects, it was made for " + std::to_string(this->maxObjectCount) + "!");
+		}
+
+		uint32_t tileCount = (objectCount + GROUP_SIZE - 1) / GROUP_SIZE;
+		LbvhPushConstant push{ objectCount, 0, tileCount };
+
+		VkCommandBuffer vkCommandBuffer = commandBuffer->getCommandBuffer();
+
+		// min fields start at the largest ordered value, max fields at the smallest
+		vkCmdFillBuffer(vkCommandBuffer, this->boundsBuffer->getBuffer(), 0, 3 * sizeof(uint32_t), 0xFFFFFFFFu);
+		vkCmdFillBuffer(vkCommandBuffer, this->boundsBuffer->getBuffer(), 3 * sizeof(uint32_t), 3 * sizeof(uint32_t), 0u);
+
+		VkBufferMemoryBarrier fillBarrier{};
+		fillBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		fillBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		fillBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		fillBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		fillBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		fillBarrier.buffer = this->boundsBuffer->getBuffer();
+		fillBarrier.offset = 0;
+		fillBarrier.size = VK_WHOLE_SIZE;
+
+		commandBuffer->addBufferBarrier(fillBarrier, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+		commandBuffer->flushBarriers();
+
+		this->bindSet(commandBuffer, 0);
+		this->pushConstant(commandBuffer, push);
+
+		this->boundsPipeline->bind(vkCommandBuffer);
+		this->boundsPipeline->dispatch(vkCommandBuffer, tileCount, 1, 1);
+
+		this->addStepBarrier(commandBuffer, this->boundsBuffer);
+		commandBuffer->flushBarriers();
+
+		this->mortonPipeline->bind(vkCommandBuffer);
+		this->mortonPipeline->dispatch(vkCommandBuffer, tileCount, 1, 1);
+
+		this->addStepBarrier(commandBuffer, this->keyBuffers[0]);
+		this->addStepBarrier(commandBuffer, this->valueBuffers[0]);
+		commandBuffer->flushBarriers();
+
+		// a 256 way digit per pass, four passes cover the 30-bit codes
+		constexpr uint32_t passCount = (MORTON_BITS + RADIX_BITS - 1) / RADIX_BITS;
+		static_assert(passCount % 2 == 0, "the sorted codes have to end in the first key / value pair");
+
+		for (uint32_t pass = 0; pass < passCount; pass++) {
+			uint32_t setIndex = pass % 2;
+			push.shift = pass * RADIX_BITS;
+
+			this->bindSet(commandBuffer, setIndex);
+			this->pushConstant(commandBuffer, push);
+
+			this->radixCountPipeline->bind(vkCommandBuffer);
+			this->radixCountPipeline->dispatch(vkCommandBuffer, tileCount, 1, 1);
+
+			this->addStepBarrier(commandBuffer, this->histogramBuffer);
+			commandBuffer->flushBarriers();
+
+			this->radixScanPipeline->bind(vkCommandBuffer);
+			this->radixScanPipeline->dispatch(vkCommandBuffer, 1, 1, 1);
+
+			this->addStepBarrier(commandBuffer, this->histogramBuffer);
+			commandBuffer->flushBarriers();
+
+			this->radixScatterPipeline->bind(vkCommandBuffer);
+			this->radixScatterPipeline->dispatch(vkCommandBuffer, tileCount, 1, 1);
+
+			// the next pass rewrites the histogram and reads what was just scattered
+			this->addStepBarrier(commandBuffer, this->histogramBuffer);
+			this->addStepBarrier(commandBuffer, this->keyBuffers[1 - setIndex]);
+			this->addStepBarrier(commandBuffer, this->valueBuffers[1 - setIndex]);
+			commandBuffer->flushBarriers();
+		}
+
+		// the bvh buffer may still be read by an earlier trace dispatch
+		VkBufferMemoryBarrier bvhBarrier{};
+		bvhBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		bvhBarrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		bvhBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		bvhBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		bvhBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		bvhBarrier.buffer = this->bvhBuffer->getBuffer();
+		bvhBarrier.offset = 0;
+		bvhBarrier.size = VK_WHOLE_SIZE;
+
+		commandBuffer->addBufferBarrier(bvhBarrier, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+		commandBuffer->flushBarriers();
+
+		// passCount is even, so the sorted codes are back in the pair set 0 reads from
+		push.shift = 0;
+		this->bindSet(commandBuffer, 0);
+		this->pushConstant(commandBuffer, push);
+
+		this->hierarchyPipeline->bind(vkCommandBuffer);
+		this->hierarchyPipeline->dispatch(vkCommandBuffer, tileCount, 1, 1);
+
+		this->addStepBarrier(commandBuffer, this->bvhBuffer);
+		this->addStepBarrier(commandBuffer, this->parentBuffer);
+		this->addStepBarrier(commandBuffer, this->arrivalBuffer);
+		commandBuffer->flushBarriers();
+
+		this->fitPipeline->bind(vkCommandBuffer);
+		this->fitPipeline->dispatch(vkCommandBuffer, tileCount, 1, 1);
+
+		VkBufferMemoryBarrier readBarrier = bvhBarrier;
+		readBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		readBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+		commandBuffer->addBufferBarrier(readBarrier, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+		commandBuffer->flushBarriers();
+	}
+} // namespace nugiEngine
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "../device/device.hpp"
+#include "../buffer/buffer.hpp"
+#include "../command/command_buffer.hpp"
+#include "../descriptor/descriptor.hpp"
+#include "../pipeline/pipeline_layout.hpp"
+#include "../pipeline/compute_pipeline.hpp"
+
+#include <array>
+#include <memory>
+
+namespace nugiEngine {
+	struct LbvhPushConstant {
+		uint32_t objectCount;
+		uint32_t shift;
+		uint32_t tileCount;
+	};
+
+	/*
+	 * Builds a linear BVH on the compute queue straight into the BVH buffer the trace shader binds:
+	 * centroid bounds, 30-bit Morton codes, a four pass radix sort, the Karras hierarchy and a bottom-up box fit.
+	 * Every leaf holds a single object, so objectCount objects take 2 * objectCount - 1 nodes
+	 */
+	class EngineGpuBvhBuilder {
+		public:
+			static constexpr uint32_t GROUP_SIZE = 256;
+			static constexpr uint32_t RADIX_BITS = 8;
+			static constexpr uint32_t MORTON_BITS = 30;
+
+			EngineGpuBvhBuilder(EngineDevice &device, std::shared_ptr<EngineBuffer> objectBuffer, 
+				std::shared_ptr<EngineBuffer> bvhBuffer, uint32_t maxObjectCount);
+			~EngineGpuBvhBuilder();
+
+			EngineGpuBvhBuilder(const EngineGpuBvhBuilder&) = delete;
+			EngineGpuBvhBuilder& operator = (const EngineGpuBvhBuilder&) = delete;
+
+			// records the whole build, the object buffer has to be visible to compute shaders already.
+			// Ends with the bvh buffer ready for compute shader reads, also for later submits on the same queue
+			void recordBuild(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t objectCount);
+
+		private:
+			void createBuffers();
+			void createDescriptor();
+			void createPipelineLayout();
+			void createPipelines();
+
+			void bindSet(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t setIndex);
+			void pushConstant(std::shared_ptr<EngineCommandBuffer> commandBuffer, LbvhPushConstant push);
+			void addStepBarrier(std::shared_ptr<EngineCommandBuffer> commandBuffer, std::shared_ptr<EngineBuffer> buffer);
+
+			EngineDevice &appDevice;
+			uint32_t maxObjectCount, maxTileCount;
+
+			std::shared_ptr<EngineBuffer> objectBuffer;
+			std::shared_ptr<EngineBuffer> bvhBuffer;
+
+			// the sort ping-pongs between the two key / value pairs, an even pass count leaves the result in the first one
+			std::shared_ptr<EngineBuffer> boundsBuffer;
+			std::array<std::shared_ptr<EngineBuffer>, 2> keyBuffers;
+			std::array<std::shared_ptr<EngineBuffer>, 2> valueBuffers;
+			std::shared_ptr<EngineBuffer> histogramBuffer;
+			std::shared_ptr<EngineBuffer> parentBuffer;
+			std::shared_ptr<EngineBuffer> arrivalBuffer;
+
+			std::shared_ptr<EngineDescriptorPool> descriptorPool;
+			std::shared_ptr<EngineDescriptorSetLayout> descSetLayout;
+			std::array<VkDescriptorSet, 2> descriptorSets{};
+
+			std::shared_ptr<EnginePipelineLayout> pipelineLayout;
+			std::unique_ptr<EngineComputePipeline> boundsPipeline;
+			std::unique_ptr<EngineComputePipeline> mortonPipeline;
+			std::unique_ptr<EngineComputePipeline> radixCountPipeline;
+			std::unique_ptr<EngineComputePipeline> radixScanPipeline;
+			std::unique_ptr<EngineComputePipeline> radixScatterPipeline;
+			std::unique_ptr<EngineComputePipeline> hierarchyPipeline;
+			std::unique_ptr<EngineComputePipeline> fitPipeline;
+	};
+} // namespace nugiEngine
@@ -0,0 +1,523 @@
+#include "lbvh.hpp"
+#include "bvh.hpp"
+#include "../cpu_renderer/tile_scheduler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <functional>
+#include <memory>
+
+namespace nugiEngine {
+  namespace {
+    constexpr uint32_t TREELET_LEAF_COUNT = 7;
+    constexpr uint32_t MIN_OBJECTS_PER_TASK = 16384;
+    constexpr uint32_t INVALID_NODE = UINT32_MAX;
+
+    // the same weights the analyzer uses by default
+    constexpr float TRAVERSAL_COST = 1.0f;
+    constexpr float INTERSECTION_COST = 1.0f;
+
+    // internal nodes are [0, n - 1), the leaf of the i-th sorted object is n - 1 + i
+    struct LbvhNode {
+      Aabb box;
+      uint32_t leftNode = INVALID_NODE;
+      uint32_t rightNode = INVALID_NODE;
+      uint32_t parentNode = INVALID_NODE;
+      uint32_t objectCount = 1;
+      float cost = 0.0f;
+    };
+
+    class LbvhBuilder {
+      public:
+        LbvhBuilder(const std::vector<Object> &objects, const LbvhConfigInfo &configInfo)
+          : objects{objects}, configInfo{configInfo}, scheduler{configInfo.threadCount}, objectCount{static_cast<uint32_t>(objects.size())}
+        {
+          this->taskCount = std::clamp(this->objectCount / MIN_OBJECTS_PER_TASK, 1u, this->scheduler.getThreadCount() * 4);
+        }
+
+        std::vector<BvhNode> build() {
+          this->computeMortonCodes();
+          this->sortMortonCodes();
+          this->createHierarchy();
+
+          // the leaves hold their boxes now and the codes are not needed after the split search
+          std::vector<Aabb>().swap(this->objectBoxes);
+          std::vector<uint64_t>().swap(this->mortonCodes);
+
+          this->updateNodes(0);
+
+          for (uint32_t round = 0; round < this->configInfo.treeletRounds; round++) {
+            this->updateNodes(TREELET_LEAF_COUNT << round);
+          }
+
+          return this->flatten();
+        }
+
+      private:
+        const std::vector<Object> &objects;
+        LbvhConfigInfo configInfo;
+        EngineTileScheduler scheduler;
+
+        uint32_t objectCount;
+        uint32_t taskCount;
+
+        std::vector<uint64_t> mortonCodes;
+        std::vector<uint32_t> objectIndices;
+        std::vector<Aabb> objectBoxes;
+
+        std::vector<LbvhNode> nodes;
+        std::unique_ptr<std::atomic<uint32_t>[]> arrivals;
+
+        uint32_t getLeaf(uint32_t sortedIndex) const { return this->objectCount - 1 + sortedIndex; }
+        bool isLeaf(uint32_t node) const { return node >= this->objectCount - 1; }
+        uint32_t getRoot() const { return this->objectCount > 1 ? 0 : this->getLeaf(0); }
+
+        // splits [0, count) into taskCount contiguous ranges, the range only depends on the task index
+        void parallelFor(uint32_t count, const std::function<void(uint32_t taskIndex, uint32_t first, uint32_t last)> &body) {
+          this->scheduler.run(this->taskCount, [&](uint32_t taskIndex, uint32_t) {
+            uint32_t first = static_cast<uint32_t>(static_cast<uint64_t>(count) * taskIndex / this->taskCount);
+            uint32_t last = static_cast<uint32_t>(static_cast<uint64_t>(count) * (taskIndex + 1) / this->taskCount);
+
+            body(taskIndex, first, last);
+          });
+        }
+
+        static uint32_t expandBits10(uint32_t value) {
+          value = (value * 0x00010001u) & 0xFF0000FFu;
+          value = (value * 0x00000101u) & 0x0F00F00Fu;
+          value = (value * 0x00000011u) & 0xC30C30C3u;
+          value = (value * 0x00000005u) & 0x49249249u;
+
+          return value;
+        }
+
+        static uint64_t expandBits21(uint64_t value) {
+          value &= 0x1FFFFFull;
+          value = (value | value << 32) & 0x1F00000000FFFFull;
+          value = (value | value << 16) & 0x1F0000FF0000FFull;
+          value = (value | value << 8) & 0x100F00F00F00F00Full;
+          value = (value | value << 4) & 0x10C30C30C30C30C3ull;
+          value = (value | value << 2) & 0x1249249249249249ull;
+
+          return value;
+        }
+
+        static float surfaceArea(const Aabb &box) {
+          glm::vec3 extent = box.max - box.min;
+          return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+        }
+
+        void computeMortonCodes() {
+          bool isMorton63 = this->configInfo.mortonCodeWidth == MortonCodeWidth::Bits63
+            || (this->configInfo.mortonCodeWidth == MortonCodeWidth::Auto && this->objectCount > LBVH_MORTON30_MAX_OBJECTS);
+
+          this->objectBoxes.resize(this->objectCount);
+          std::vector<Aabb> centroidBoxes(this->taskCount);
+
+          this->parallelFor(this->objectCount, [&](uint32_t taskIndex, uint32_t first, uint32_t last) {
+            Aabb centroidBox;
+
+            for (uint32_t i = first; i < last; i++) {
+              const Triangle &triangle = this->objects[i].triangle;
+
+              // the same padding objectBoundingBox adds for flat triangles
+              this->objectBoxes[i].min = glm::min(glm::min(triangle.point0, triangle.point1), triangle.point2) - eps;
+              this->objectBoxes[i].max = glm::max(glm::max(triangle.point0, triangle.point1), triangle.point2) + eps;
+
+              glm::vec3 centroid = (this->objectBoxes[i].min + this->objectBoxes[i].max) * 0.5f;
+              centroidBox.min = glm::min(centroidBox.min, centroid);
+              centroidBox.max = glm::max(centroidBox.max, centroid);
+            }
+
+            centroidBoxes[taskIndex] = centroidBox;
+          });
+
+          Aabb centroidBox;
+          for (auto &&box : centroidBoxes) {
+            centroidBox.min = glm::min(centroidBox.min, box.min);
+            centroidBox.max = glm::max(centroidBox.max, box.max);
+          }
+
+          glm::vec3 extent = centroidBox.max - centroidBox.min;
+          glm::vec3 scale = glm::vec3(
+            extent.x > 0.0f ? 1.0f / extent.x : 0.0f,
+            extent.y > 0.0f ? 1.0f / extent.y : 0.0f,
+            extent.z > 0.0f ? 1.0f / extent.z : 0.0f
+          );
+
+          float cellCount = isMorton63 ? 2097152.0f : 1024.0f;
+
+          this->mortonCodes.resize(this->objectCount);
+          this->objectIndices.resize(this->objectCount);
+
+          this->parallelFor(this->objectCount, [&](uint32_t, uint32_t first, uint32_t last) {
+            for (uint32_t i = first; i < last; i++) {
+              glm::vec3 centroid = (this->objectBoxes[i].min + this->objectBoxes[i].max) * 0.5f;
+              glm::vec3 cell = glm::min(glm::max((centroid - centroidBox.min) * scale * cellCount, glm::vec3(0.0f)), glm::vec3(cellCount - 1.0f));
+
+              if (isMorton63) {
+                this->mortonCodes[i] = expandBits21(static_cast<uint64_t>(cell.x)) << 2 | expandBits21(static_cast<uint64_t>(cell.y)) << 1
+                  | expandBits21(static_cast<uint64_t>(cell.z));
+              } else {
+                this->mortonCodes[i] = expandBits10(static_cast<uint32_t>(cell.x)) << 2 | expandBits10(static_cast<uint32_t>(cell.y)) << 1
+                  | expandBits10(static_cast<uint32_t>(cell.z));
+              }
+
+              this->objectIndices[i] = i;
+            }
+          });
+        }
+
+        // least significant digit first, 8 bits per pass. Every task counts its own range, so the scatter stays stable
+        // and the result does not depend on the thread count. Digits that are equal in every code are skipped
+        void sortMortonCodes() {
+          std::vector<uint64_t> differentBits(this->taskCount, 0);
+
+          this->parallelFor(this->objectCount, [&](uint32_t taskIndex, uint32_t first, uint32_t last) {
+            for (uint32_t i = first; i < last; i++) {
+              differentBits[taskIndex] |= this->mortonCodes[i] ^ this->mortonCodes[0];
+            }
+          });
+
+          uint64_t differentMask = 0;
+          for (auto &&bits : differentBits) {
+            differentMask |= bits;
+          }
+
+          std::vector<uint64_t> sortedCodes(this->objectCount);
+          std::vector<uint32_t> sortedIndices(this->objectCount);
+          std::vector<uint32_t> offsets(static_cast<size_t>(this->taskCount) * 256);
+
+          for (uint32_t shift = 0; shift < 64; shift += 8) {
+            if (((differentMask >> shift) & 0xFF) == 0) {
+              continue;
+            }
+
+            std::fill(offsets.begin(), offsets.end(), 0);
+
+            this->parallelFor(this->objectCount, [&](uint32_t taskIndex, uint32_t first, uint32_t last) {
+              uint32_t *counts = &offsets[static_cast<size_t>(taskIndex) * 256];
+
+              for (uint32_t i = first; i < last; i++) {
+                counts[(this->mortonCodes[i] >> shift) & 0xFF]++;
+              }
+            });
+
+            // digit major, task minor: every task writes its part of a digit after the tasks before it
+            uint32_t offset = 0;
+            for (uint32_t digit = 0; digit < 256; digit++) {
+              for (uint32_t taskIndex = 0; taskIndex < this->taskCount; taskIndex++) {
+                uint32_t count = offsets[static_cast<size_t>(taskIndex) * 256 + digit];
+                offsets[static_cast<size_t>(taskIndex) * 256 + digit] = offset;
+                offset += count;
+              }
+            }
+
+            this->parallelFor(this->objectCount, [&](uint32_t taskIndex, uint32_t first, uint32_t last) {
+              uint32_t *digitOffsets = &offsets[static_cast<size_t>(taskIndex) * 256];
+
+              for (uint32_t i = first; i < last; i++) {
+                uint32_t target = digitOffsets[(this->mortonCodes[i] >> shift) & 0xFF]++;
+
+                sortedCodes[target] = this->mortonCodes[i];
+                sortedIndices[target] = this->objectIndices[i];
+              }
+            });
+
+            this->mortonCodes.swap(sortedCodes);
+            this->objectIndices.swap(sortedIndices);
+          }
+        }
+
+        // length of the common prefix of two sorted codes, equal codes are told apart by their position
+        int commonPrefix(int64_t i, int64_t j) const {
+          if (j < 0 || j >= this->objectCount) {
+            return -1;
+          }
+
+          uint64_t first = this->mortonCodes[i], second = this->mortonCodes[j];
+          if (first == second) {
+            return 64 + __builtin_clz(static_cast<uint32_t>(i ^ j));
+          }
+
+          return __builtin_clzll(first ^ second);
+        }
+
+        void createHierarchy() {
+          this->nodes.assign(2 * static_cast<size_t>(this->objectCount) - 1, LbvhNode{});
+
+          this->parallelFor(this->objectCount, [&](uint32_t, uint32_t first, uint32_t last) {
+            for (uint32_t i = first; i < last; i++) {
+              this->nodes[this->getLeaf(i)].box = this->objectBoxes[this->objectIndices[i]];
+            }
+          });
+
+          this->parallelFor(this->objectCount - 1, [&](uint32_t, uint32_t first, uint32_t last) {
+            for (int64_t i = first; i < last; i++) {
+              // the node covers the codes sharing a longer prefix with code i than its neighbour on the other side
+              int64_t direction = this->commonPrefix(i, i + 1) - this->commonPrefix(i, i - 1) >= 0 ? 1 : -1;
+              int minPrefix = this->commonPrefix(i, i - direction);
+
+              int64_t maxLength = 2;
+              while (this->commonPrefix(i, i + maxLength * direction) > minPrefix) {
+                maxLength *= 2;
+              }
+
+              int64_t length = 0;
+              for (int64_t step = maxLength / 2; step >= 1; step /= 2) {
+                if (this->commonPrefix(i, i + (length + step) * direction) > minPrefix) {
+                  length += step;
+                }
+              }
+
+              int64_t j = i + length * direction;
+              int nodePrefix = this->commonPrefix(i, j);
+
+              // the split is where the prefix of the range ends
+              int64_t split = 0;
+              int64_t step = length;
+
+              do {
+                step = (step + 1) / 2;
+                if (this->commonPrefix(i, i + (split + step) * direction) > nodePrefix) {
+                  split += step;
+                }
+              } while (step > 1);
+
+              int64_t gamma = i + split * direction + std::min<int64_t>(direction, 0);
+
+              uint32_t leftNode = std::min(i, j) == gamma ? this->getLeaf(static_cast<uint32_t>(gamma)) : static_cast<uint32_t>(gamma);
+              uint32_t rightNode = std::max(i, j) == gamma + 1 ? this->getLeaf(static_cast<uint32_t>(gamma + 1)) : static_cast<uint32_t>(gamma + 1);
+
+              this->nodes[i].leftNode = leftNode;
+              this->nodes[i].rightNode = rightNode;
+              this->nodes[leftNode].parentNode = static_cast<uint32_t>(i);
+              this->nodes[rightNode].parentNode = static_cast<uint32_t>(i);
+            }
+          });
+        }
+
+        void updateNode(uint32_t node) {
+          LbvhNode &current = this->nodes[node];
+          const LbvhNode &left = this->nodes[current.leftNode];
+          const LbvhNode &right = this->nodes[current.rightNode];
+
+          current.box = surroundingBox(left.box, right.box);
+          current.objectCount = left.objectCount + right.objectCount;
+          current.cost = TRAVERSAL_COST * surfaceArea(current.box) + left.cost + right.cost;
+        }
+
+        // walks from every leaf towards the root, the second thread to reach a node finds both children finished.
+        // Nodes with at least minTreeletObjects objects are restructured on the way, 0 only refits boxes and costs
+        void updateNodes(uint32_t minTreeletObjects) {
+          if (this->objectCount < 2) {
+            LbvhNode &leaf = this->nodes[this->getLeaf(0)];
+            leaf.cost = INTERSECTION_COST * surfaceArea(leaf.box);
+
+            return;
+          }
+
+          this->arrivals = std::make_unique<std::atomic<uint32_t>[]>(this->objectCount - 1);
+          for (uint32_t i = 0; i < this->objectCount - 1; i++) {
+            this->arrivals[i].store(0, std::memory_order_relaxed);
+          }
+
+          this->parallelFor(this->objectCount, [&](uint32_t, uint32_t first, uint32_t last) {
+            for (uint32_t i = first; i < last; i++) {
+              LbvhNode &leaf = this->nodes[this->getLeaf(i)];
+              leaf.cost = INTERSECTION_COST * surfaceArea(leaf.box);
+
+              uint32_t node = leaf.parentNode;
+
+              while (node != INVALID_NODE && this->arrivals[node].fetch_add(1, std::memory_order_acq_rel) == 1) {
+                this->updateNode(node);
+
+                if (minTreeletObjects > 0 && this->nodes[node].objectCount >= minTreeletObjects) {
+                  this->optimizeTreelet(node);
+                }
+
+                node = this->nodes[node].parentNode;
+              }
+            }
+          });
+        }
+
+        // Karras & Aila 2013: the treelet below root is grown to TREELET_LEAF_COUNT leaves by opening the largest node,
+        // then the topology with minimal SAH cost over those leaves is found by dynamic programming over leaf subsets
+        // and the treelet's internal nodes are rewired into it
+        void optimizeTreelet(uint32_t root) {
+          uint32_t treeletLeaves[TREELET_LEAF_COUNT];
+          uint32_t treeletNodes[TREELET_LEAF_COUNT - 1];
+
+          uint32_t leafCount = 2, nodeCount = 1;
+          treeletLeaves[0] = this->nodes[root].leftNode;
+          treeletLeaves[1] = this->nodes[root].rightNode;
+          treeletNodes[0] = root;
+
+          while (leafCount < TREELET_LEAF_COUNT) {
+            int largest = -1;
+            float largestArea = -1.0f;
+
+            for (uint32_t i = 0; i < leafCount; i++) {
+              float area = surfaceArea(this->nodes[treeletLeaves[i]].box);
+
+              if (!this->isLeaf(treeletLeaves[i]) && area > largestArea) {
+                largest = static_cast<int>(i);
+                largestArea = area;
+              }
+            }
+
+            if (largest < 0) {
+              break;
+            }
+
+            uint32_t opened = treeletLeaves[largest];
+            treeletNodes[nodeCount++] = opened;
+            treeletLeaves[largest] = this->nodes[opened].leftNode;
+            treeletLeaves[leafCount++] = this->nodes[opened].rightNode;
+          }
+
+          if (leafCount < 3) {
+            return;
+          }
+
+          uint32_t subsetCount = 1u << leafCount;
+          Aabb subsetBoxes[1u << TREELET_LEAF_COUNT];
+          float optimalCosts[1u << TREELET_LEAF_COUNT];
+          uint32_t optimalPartitions[1u << TREELET_LEAF_COUNT];
+
+          for (uint32_t subset = 1; subset < subsetCount; subset++) {
+            Aabb box;
+            for (uint32_t i = 0; i < leafCount; i++) {
+              if (subset & (1u << i)) {
+                box = surroundingBox(box, this->nodes[treeletLeaves[i]].box);
+              }
+            }
+
+            subsetBoxes[subset] = box;
+          }
+
+          for (uint32_t i = 0; i < leafCount; i++) {
+            optimalCosts[1u << i] = this->nodes[treeletLeaves[i]].cost;
+          }
+
+          for (uint32_t size = 2; size <= leafCount; size++) {
+            for (uint32_t subset = 1; subset < subsetCount; subset++) {
+              if (static_cast<uint32_t>(__builtin_popcount(subset)) != size) {
+                continue;
+              }
+
+              float bestCost = FLT_MAX;
+              uint32_t bestPartition = 0;
+
+              // every way to split the subset in two, each pair once
+              uint32_t lowest = (subset - 1) & subset;
+              uint32_t partition = (0u - lowest) & subset;
+
+              do {
+                float cost = optimalCosts[partition] + optimalCosts[subset ^ partition];
+                if (cost < bestCost) {
+                  bestCost = cost;
+                  bestPartition = partition;
+                }
+
+                partition = (partition - lowest) & subset;
+              } while (partition != 0);
+
+              optimalCosts[subset] = TRAVERSAL_COST * surfaceArea(subsetBoxes[subset]) + bestCost;
+              optimalPartitions[subset] = bestPartition;
+            }
+          }
+
+          // keep the current shape unless the new one is measurably better, rounding alone must not reshuffle it
+          if (optimalCosts[subsetCount - 1] >= this->nodes[root].cost * 0.9999f) {
+            return;
+          }
+
+          uint32_t freeNode = 1;
+          std::function<uint32_t(uint32_t, uint32_t)> rebuild = [&](uint32_t subset, uint32_t node) -> uint32_t {
+            uint32_t parts[2] = { optimalPartitions[subset], subset ^ optimalPartitions[subset] };
+            uint32_t children[2];
+
+            for (uint32_t i = 0; i < 2; i++) {
+              if (__builtin_popcount(parts[i]) == 1) {
+                children[i] = treeletLeaves[__builtin_ctz(parts[i])];
+              } else {
+                children[i] = rebuild(parts[i], treeletNodes[freeNode++]);
+              }
+
+              this->nodes[children[i]].parentNode = node;
+            }
+
+            this->nodes[node].leftNode = children[0];
+            this->nodes[node].rightNode = children[1];
+            this->updateNode(node);
+
+            return node;
+          };
+
+          rebuild(subsetCount - 1, root);
+        }
+
+        // depth first, so a node and its children stay close in memory. A node over two single object leaves
+        // becomes one leaf holding both, the same shape createBvh produces
+        std::vector<BvhNode> flatten() {
+          struct FlattenItem {
+            uint32_t node;
+            int parent;
+            bool isLeft;
+          };
+
+          std::vector<BvhNode> output;
+          output.reserve(this->objectCount);
+
+          std::vector<FlattenItem> stack;
+          stack.push_back({ this->getRoot(), -1, true });
+
+          while (!stack.empty()) {
+            FlattenItem item = stack.back();
+            stack.pop_back();
+
+            const LbvhNode &node = this->nodes[item.node];
+            int index = static_cast<int>(output.size());
+
+            BvhNode gpuNode{};
+            gpuNode.minimum = node.box.min;
+            gpuNode.maximum = node.box.max;
+
+            if (this->isLeaf(item.node)) {
+              gpuNode.leftObjIndex = static_cast<int>(this->objectIndices[item.node - (this->objectCount - 1)]);
+            } else if (this->isLeaf(node.leftNode) && this->isLeaf(node.rightNode)) {
+              gpuNode.leftObjIndex = static_cast<int>(this->objectIndices[node.leftNode - (this->objectCount - 1)]);
+              gpuNode.rightObjIndex = static_cast<int>(this->objectIndices[node.rightNode - (this->objectCount - 1)]);
+            } else {
+              stack.push_back({ node.rightNode, index, false });
+              stack.push_back({ node.leftNode, index, true });
+            }
+
+            if (item.parent >= 0) {
+              if (item.isLeft) {
+                output[item.parent].leftNode = index;
+              } else {
+                output[item.parent].rightNode = index;
+              }
+            }
+
+            output.emplace_back(gpuNode);
+          }
+
+          return output;
+        }
+    };
+  } // namespace
+
+  std::vector<BvhNode> createLbvh(const std::vector<Object> &objects, const LbvhConfigInfo &configInfo) {
+    if (objects.empty()) {
+      return {};
+    }
+
+    LbvhBuilder builder{objects, configInfo};
+    return builder.build();
+  }
+} // namespace nugiEngine
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "../ray_ubo.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace nugiEngine {
+  enum class MortonCodeWidth {
+    Auto,    // 30 bits up to LBVH_MORTON30_MAX_OBJECTS objects, 63 bits above
+    Bits30,  // 10 bits per axis
+    Bits63   // 21 bits per axis, for scenes where a 1024^3 grid puts many centroids into one cell
+  };
+
+  constexpr uint32_t LBVH_MORTON30_MAX_OBJECTS = 1u << 20;
+
+  struct LbvhConfigInfo {
+    MortonCodeWidth mortonCodeWidth = MortonCodeWidth::Auto;
+
+    // rounds of treelet restructuring after the build, each one rebuilds every 7 leaf treelet to its minimal SAH shape.
+    // 0 keeps the plain Karras hierarchy
+    uint32_t treeletRounds = 0;
+
+    // 0 uses every hardware thread
+    uint32_t threadCount = 0;
+  };
+
+  // Linear BVH (Karras 2012): centroids are sorted along a Morton curve with a parallel radix sort
+  // and every internal node is found independently from the sorted codes, so the build is O(n).
+  // The output has the same layout as createBvh: node 0 is the root, children come after their parent
+  // and a leaf holds one or two objects
+  std::vector<BvhNode> createLbvh(const std::vector<Object> &objects, const LbvhConfigInfo &configInfo = LbvhConfigInfo{});
+} // namespace nugiEngine
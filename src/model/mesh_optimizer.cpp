@@ -0,0 +1,379 @@
+#include "mesh_optimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace nugiEngine {
+  namespace {
+    constexpr uint32_t INVALID_TRIANGLE = UINT32_MAX;
+
+    // the cache Forsyth's scores are tuned for, larger than the simulated FIFO on purpose
+    constexpr uint32_t FORSYTH_CACHE_SIZE = 32;
+    constexpr uint32_t FORSYTH_VALENCE_TABLE_SIZE = 32;
+
+    // a FIFO cache through timestamps, flush() evicts everything without touching the vertices
+    class FifoCache {
+      public:
+        FifoCache(size_t vertexCount, uint32_t cacheSize) : timestamps(vertexCount, 0), cacheSize{cacheSize}, time{cacheSize + 1} {}
+
+        // returns 1 when the vertex had to be transformed
+        uint32_t access(uint32_t vertex) {
+          if (this->time - this->timestamps[vertex] > this->cacheSize) {
+            this->timestamps[vertex] = this->time++;
+            return 1;
+          }
+
+          return 0;
+        }
+
+        uint32_t accessTriangle(const std::vector<uint32_t> &indices, size_t triangle) {
+          return this->access(indices[triangle * 3 + 0]) + this->access(indices[triangle * 3 + 1]) + this->access(indices[triangle * 3 + 2]);
+        }
+
+        void flush() { this->time += this->cacheSize + 1; }
+
+      private:
+        std::vector<uint32_t> timestamps;
+        uint32_t cacheSize;
+        uint32_t time;
+    };
+
+    class ForsythOptimizer {
+      public:
+        ForsythOptimizer(const std::vector<uint32_t> &indices, size_t vertexCount) : indices{indices}, vertexCount{vertexCount} {
+          this->triangleCount = indices.size() / 3;
+
+          for (uint32_t i = 0; i < FORSYTH_CACHE_SIZE; i++) {
+            // the last triangle's vertices get a fixed score, so the next one does not simply reuse its edge
+            this->cacheScores[i] = i < 3 ? 0.75f : std::pow(1.0f - static_cast<float>(i - 3) / (FORSYTH_CACHE_SIZE - 3), 1.5f);
+          }
+
+          for (uint32_t i = 1; i < FORSYTH_VALENCE_TABLE_SIZE; i++) {
+            this->valenceScores[i] = 2.0f / std::sqrt(static_cast<float>(i));
+          }
+        }
+
+        std::vector<uint32_t> optimize() {
+          this->buildAdjacency();
+
+          std::vector<uint32_t> result;
+          result.reserve(this->triangleCount * 3);
+
+          uint32_t bestTriangle = this->findInitialTriangle();
+          size_t inputCursor = 0;
+
+          while (result.size() < this->triangleCount * 3) {
+            // dead end: nothing in the cache touches a remaining triangle, continue in input order
+            if (bestTriangle == INVALID_TRIANGLE) {
+              while (this->isEmitted[inputCursor]) {
+                inputCursor++;
+              }
+
+              bestTriangle = static_cast<uint32_t>(inputCursor);
+            }
+
+            for (uint32_t corner = 0; corner < 3; corner++) {
+              result.emplace_back(this->indices[bestTriangle * 3 + corner]);
+            }
+
+            this->emitTriangle(bestTriangle);
+            bestTriangle = this->findBestCachedTriangle();
+          }
+
+          return result;
+        }
+
+      private:
+        const std::vector<uint32_t> &indices;
+        size_t vertexCount, triangleCount;
+
+        float cacheScores[FORSYTH_CACHE_SIZE];
+        float valenceScores[FORSYTH_VALENCE_TABLE_SIZE] = { 0.0f };
+
+        // the remaining triangles of vertex v are adjacency[adjacencyOffsets[v], adjacencyOffsets[v] + remainingCounts[v])
+        std::vector<uint32_t> adjacencyOffsets, adjacency, remainingCounts;
+        std::vector<int32_t> cachePositions;
+        std::vector<float> vertexScores, triangleScores;
+        std::vector<bool> isEmitted;
+
+        std::vector<uint32_t> cache, nextCache;
+
+        float vertexScore(uint32_t vertex) const {
+          uint32_t remaining = this->remainingCounts[vertex];
+          if (remaining == 0) {
+            return -1.0f;
+          }
+
+          int32_t position = this->cachePositions[vertex];
+          float score = position >= 0 ? this->cacheScores[position] : 0.0f;
+
+          return score + (remaining < FORSYTH_VALENCE_TABLE_SIZE ? this->valenceScores[remaining] : 2.0f / std::sqrt(static_cast<float>(remaining)));
+        }
+
+        void buildAdjacency() {
+          this->remainingCounts.assign(this->vertexCount, 0);
+          for (auto &&index : this->indices) {
+            this->remainingCounts[index]++;
+          }
+
+          this->adjacencyOffsets.assign(this->vertexCount + 1, 0);
+          std::partial_sum(this->remainingCounts.begin(), this->remainingCounts.end(), this->adjacencyOffsets.begin() + 1);
+
+          std::vector<uint32_t> fillCounts(this->vertexCount, 0);
+          this->adjacency.resize(this->indices.size());
+
+          for (size_t i = 0; i < this->indices.size(); i++) {
+            uint32_t vertex = this->indices[i];
+            this->adjacency[this->adjacencyOffsets[vertex] + fillCounts[vertex]++] = static_cast<uint32_t>(i / 3);
+          }
+
+          this->cachePositions.assign(this->vertexCount, -1);
+          this->vertexScores.resize(this->vertexCount);
+
+          for (uint32_t vertex = 0; vertex < this->vertexCount; vertex++) {
+            this->vertexScores[vertex] = this->vertexScore(vertex);
+          }
+
+          this->triangleScores.resize(this->triangleCount);
+          for (size_t triangle = 0; triangle < this->triangleCount; triangle++) {
+            this->triangleScores[triangle] = this->vertexScores[this->indices[triangle * 3 + 0]] 
+              + this->vertexScores[this->indices[triangle * 3 + 1]] + this->vertexScores[this->indices[triangle * 3 + 2]];
+          }
+
+          this->isEmitted.assign(this->triangleCount, false);
+        }
+
+        uint32_t findInitialTriangle() const {
+          auto best = std::max_element(this->triangleScores.begin(), this->triangleScores.end());
+          return static_cast<uint32_t>(best - this->triangleScores.begin());
+        }
+
+        void updateVertexScore(uint32_t vertex) {
+          float score = this->vertexScore(vertex);
+          float delta = score - this->vertexScores[vertex];
+          this->vertexScores[vertex] = score;
+
+          uint32_t offset = this->adjacencyOffsets[vertex];
+          for (uint32_t i = 0; i < this->remainingCounts[vertex]; i++) {
+            this->triangleScores[this->adjacency[offset + i]] += delta;
+          }
+        }
+
+        void emitTriangle(uint32_t triangle) {
+          this->isEmitted[triangle] = true;
+          this->nextCache.clear();
+
+          for (uint32_t corner = 0; corner < 3; corner++) {
+            uint32_t vertex = this->indices[triangle * 3 + corner];
+
+            // every corner added one adjacency entry, so every corner removes one
+            uint32_t offset = this->adjacencyOffsets[vertex];
+            uint32_t &remaining = this->remainingCounts[vertex];
+
+            for (uint32_t i = 0; i < remaining; i++) {
+              if (this->adjacency[offset + i] == triangle) {
+                std::swap(this->adjacency[offset + i], this->adjacency[offset + remaining - 1]);
+                remaining--;
+                break;
+              }
+            }
+
+            if (std::find(this->nextCache.begin(), this->nextCache.end(), vertex) == this->nextCache.end()) {
+              this->nextCache.emplace_back(vertex);
+            }
+          }
+
+          // the triangle moves to the front, the rest of the cache keeps its order behind it
+          size_t triangleVertexCount = this->nextCache.size();
+          for (auto &&vertex : this->cache) {
+            auto triangleEnd = this->nextCache.begin() + triangleVertexCount;
+            if (std::find(this->nextCache.begin(), triangleEnd, vertex) == triangleEnd) {
+              this->nextCache.emplace_back(vertex);
+            }
+          }
+
+          for (size_t i = 0; i < this->nextCache.size(); i++) {
+            this->cachePositions[this->nextCache[i]] = i < FORSYTH_CACHE_SIZE ? static_cast<int32_t>(i) : -1;
+          }
+
+          // evicted vertices are rescored as well, they lost their cache bonus
+          for (auto &&vertex : this->nextCache) {
+            this->updateVertexScore(vertex);
+          }
+
+          if (this->nextCache.size() > FORSYTH_CACHE_SIZE) {
+            this->nextCache.resize(FORSYTH_CACHE_SIZE);
+          }
+
+          std::swap(this->cache, this->nextCache);
+        }
+
+        uint32_t findBestCachedTriangle() const {
+          uint32_t bestTriangle = INVALID_TRIANGLE;
+          float bestScore = -1.0f;
+
+          for (auto &&vertex : this->cache) {
+            uint32_t offset = this->adjacencyOffsets[vertex];
+
+            for (uint32_t i = 0; i < this->remainingCounts[vertex]; i++) {
+              uint32_t triangle = this->adjacency[offset + i];
+
+              if (this->triangleScores[triangle] > bestScore) {
+                bestScore = this->triangleScores[triangle];
+                bestTriangle = triangle;
+              }
+            }
+          }
+
+          return bestTriangle;
+        }
+    };
+  } // namespace
+
+  VertexCacheStatistics analyzeVertexCache(const std::vector<uint32_t> &indices, size_t vertexCount, uint32_t cacheSize) {
+    VertexCacheStatistics statistics{};
+    size_t triangleCount = indices.size() / 3;
+
+    if (triangleCount == 0) {
+      return statistics;
+    }
+
+    FifoCache cache{vertexCount, cacheSize};
+    std::vector<bool> isReferenced(vertexCount, false);
+
+    for (size_t triangle = 0; triangle < triangleCount; triangle++) {
+      statistics.transformedVertexCount += cache.accessTriangle(indices, triangle);
+    }
+
+    for (auto &&index : indices) {
+      isReferenced[index] = true;
+    }
+
+    size_t referencedCount = static_cast<size_t>(std::count(isReferenced.begin(), isReferenced.end(), true));
+
+    statistics.acmr = static_cast<float>(statistics.transformedVertexCount) / static_cast<float>(triangleCount);
+    statistics.atvr = static_cast<float>(statistics.transformedVertexCount) / static_cast<float>(referencedCount);
+
+    return statistics;
+  }
+
+  std::vector<uint32_t> optimizeVertexCache(const std::vector<uint32_t> &indices, size_t vertexCount) {
+    if (indices.size() < 6) {
+      return indices;
+    }
+
+    ForsythOptimizer optimizer{indices, vertexCount};
+    return optimizer.optimize();
+  }
+
+  std::vector<uint32_t> optimizeOverdraw(const std::vector<uint32_t> &indices, const std::vector<glm::vec3> &positions, float threshold) {
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2) {
+      return indices;
+    }
+
+    FifoCache cache{positions.size(), MESH_VERTEX_CACHE_SIZE};
+
+    // hard boundaries: the cache optimizer started over, every vertex of the triangle missed
+    std::vector<size_t> hardBoundaries;
+    for (size_t triangle = 0; triangle < triangleCount; triangle++) {
+      if (cache.accessTriangle(indices, triangle) == 3 || triangle == 0) {
+        hardBoundaries.emplace_back(triangle);
+      }
+    }
+
+    hardBoundaries.emplace_back(triangleCount);
+
+    // soft boundaries: a cluster ends as soon as its own ACMR, with a cold cache, is within the threshold
+    std::vector<size_t> boundaries;
+    for (size_t i = 0; i + 1 < hardBoundaries.size(); i++) {
+      size_t start = hardBoundaries[i], end = hardBoundaries[i + 1];
+
+      cache.flush();
+      uint32_t clusterMisses = 0;
+
+      for (size_t triangle = start; triangle < end; triangle++) {
+        clusterMisses += cache.accessTriangle(indices, triangle);
+      }
+
+      float clusterThreshold = threshold * static_cast<float>(clusterMisses) / static_cast<float>(end - start);
+
+      cache.flush();
+      boundaries.emplace_back(start);
+
+      uint32_t runningMisses = 0, runningTriangles = 0;
+
+      for (size_t triangle = start; triangle < end; triangle++) {
+        runningMisses += cache.accessTriangle(indices, triangle);
+        runningTriangles++;
+
+        if (triangle + 1 < end && static_cast<float>(runningMisses) / static_cast<float>(runningTriangles) <= clusterThreshold) {
+          boundaries.emplace_back(triangle + 1);
+          cache.flush();
+
+          runningMisses = 0;
+          runningTriangles = 0;
+        }
+      }
+
+      // the rest after the last split rarely reaches the threshold on its own, it joins the cluster before it
+      if (runningTriangles != 0 && boundaries.back() != start) {
+        boundaries.pop_back();
+      }
+    }
+
+    boundaries.emplace_back(triangleCount);
+    size_t clusterCount = boundaries.size() - 1;
+
+    glm::vec3 meshCentroid{0.0f};
+    for (auto &&index : indices) {
+      meshCentroid += positions[index];
+    }
+
+    meshCentroid /= static_cast<float>(indices.size());
+
+    // clusters whose area weighted normal points away from the center occlude the others from most viewpoints
+    std::vector<float> sortKeys(clusterCount);
+    for (size_t cluster = 0; cluster < clusterCount; cluster++) {
+      glm::vec3 centroid{0.0f}, normal{0.0f};
+      float area = 0.0f;
+
+      for (size_t triangle = boundaries[cluster]; triangle < boundaries[cluster + 1]; triangle++) {
+        const glm::vec3 &point0 = positions[indices[triangle * 3 + 0]];
+        const glm::vec3 &point1 = positions[indices[triangle * 3 + 1]];
+        const glm::vec3 &point2 = positions[indices[triangle * 3 + 2]];
+
+        glm::vec3 triangleNormal = glm::cross(point1 - point0, point2 - point0);
+        float triangleArea = glm::length(triangleNormal);
+
+        centroid += (point0 + point1 + point2) * (triangleArea / 3.0f);
+        normal += triangleNormal;
+        area += triangleArea;
+      }
+
+      float normalLength = glm::length(normal);
+      if (area <= 0.0f || normalLength <= 0.0f) {
+        sortKeys[cluster] = 0.0f;
+        continue;
+      }
+
+      sortKeys[cluster] = glm::dot(centroid / area - meshCentroid, normal / normalLength);
+    }
+
+    std::vector<uint32_t> clusterOrder(clusterCount);
+    std::iota(clusterOrder.begin(), clusterOrder.end(), 0);
+    std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&sortKeys](uint32_t first, uint32_t second) {
+      return sortKeys[first] > sortKeys[second];
+    });
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+
+    for (auto &&cluster : clusterOrder) {
+      result.insert(result.end(), indices.begin() + boundaries[cluster] * 3, indices.begin() + boundaries[cluster + 1] * 3);
+    }
+
+    return result;
+  }
+} // namespace nugiEngine
@@ -1,26 +1,71 @@
 #include "model.hpp"
 #include "../utils/utils.hpp"
+#include "../upload_service/upload_service.hpp"
+#include "../cpu_renderer/tile_scheduler.hpp"
+#include "mesh_optimizer.hpp"
+#include "obj_vertex_table.hpp"
 
 #include <cstring>
 #include <iostream>
-#include <unordered_map>
+#include <utility>
 
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tiny_obj_loader.h>
 
-#define GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtx/hash.hpp>
+namespace nugiEngine {
+	namespace {
+		void loadObjShape(const tinyobj::attrib_t &attrib, const tinyobj::shape_t &shape, ModelData &shapeData) {
+			ObjVertexTable<tinyobj::index_t> vertexTable{shape.mesh.indices.size()};
+
+			shapeData.vertices.reserve(shape.mesh.indices.size());
+			shapeData.indices.reserve(shape.mesh.indices.size());
+
+			for (const auto &index: shape.mesh.indices) {
+				auto [vertexIndex, isNew] = vertexTable.insert(index);
+				shapeData.indices.emplace_back(vertexIndex);
+
+				if (!isNew) {
+					continue;
+				}
+
+				Vertex vertex{};
+
+				if (index.vertex_index >= 0) {
+					vertex.position = {
+						attrib.vertices[3 * index.vertex_index + 0],
+						attrib.vertices[3 * index.vertex_index + 1],
+						attrib.vertices[3 * index.vertex_index + 2]
+					};
+
+					vertex.color = {
+						attrib.colors[3 * index.vertex_index + 0],
+						attrib.colors[3 * index.vertex_index + 1],
+						attrib.colors[3 * index.vertex_index + 2]
+					};
+				}
 
-namespace std {
-	template<>
-	struct hash<nugiEngine::Vertex> {
-		size_t operator () (nugiEngine::Vertex const &vertex) const {
-			size_t seed = 0;
-			nugiEngine::hashCombine(seed, vertex.position, vertex.color, vertex.normal, vertex.uv);
-			return seed;
+				if (index.normal_index >= 0) {
+					vertex.normal = {
+						attrib.normals[3 * index.normal_index + 0],
+						attrib.normals[3 * index.normal_index + 1],
+						attrib.normals[3 * index.normal_index + 2]
+					};
+				}
+
+				if (index.texcoord_index >= 0) {
+					vertex.uv = { // temoirary. for OBJ object only
+						attrib.texcoords[2 * index.texcoord_index + 0],
+						1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
+					};
+				}
+
+				shapeData.vertices.emplace_back(vertex);
+			}
+
+			shapeData.vertices.shrink_to_fit();
 		}
-	};
-} // namespace std
+	} // namespace
+} // namespace nugiEngine
 
 namespace nugiEngine {
 	EngineModel::EngineModel(EngineDevice &device, const ModelData &datas) : engineDevice{device} {
@@ -44,18 +89,7 @@ namespace nugiEngine {
 		VkDeviceSize bufferSize = sizeof(vertices[0]) * vertextCount;
 		uint32_t vertexSize = sizeof(vertices[0]);
 
-		EngineBuffer stagingBuffer {
-			this->engineDevice,
-			vertexSize,
-			this->vertextCount,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-		};
-
-		stagingBuffer.map();
-		stagingBuffer.writeToBuffer((void *) vertices.data());
-
-		this->vertexBuffer = std::make_unique<EngineBuffer>(
+		this->vertexBuffer = std::make_shared<EngineBuffer>(
 			this->engineDevice,
 			vertexSize,
 			this->vertextCount,
@@ -63,7 +97,9 @@ namespace nugiEngine {
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
 		);
 
-		this->vertexBuffer->copyBuffer(stagingBuffer.getBuffer(), bufferSize);
+		// copied on the transfer queue and handed over to the graphics queue, the app waits for every upload before drawing
+		this->engineDevice.getUploadService()->uploadBuffer(this->vertexBuffer, vertices.data(), bufferSize, 
+			this->engineDevice.getFamilyIndices().graphicsFamily, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
 	}
 
 	void EngineModel::createIndexBuffer(const std::vector<uint32_t> &indices) { 
@@ -77,18 +113,7 @@ namespace nugiEngine {
 		VkDeviceSize bufferSize = sizeof(indices[0]) * this->indexCount;
 		uint32_t indexSize = sizeof(indices[0]);
 
-		EngineBuffer stagingBuffer {
-			this->engineDevice,
-			indexSize,
-			this->indexCount,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-		};
-
-		stagingBuffer.map();
-		stagingBuffer.writeToBuffer((void *) indices.data());
-
-		this->indexBuffer = std::make_unique<EngineBuffer>(
+		this->indexBuffer = std::make_shared<EngineBuffer>(
 			this->engineDevice,
 			indexSize,
 			this->indexCount,
@@ -96,7 +121,8 @@ namespace nugiEngine {
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
 		);
 
-		this->indexBuffer->copyBuffer(stagingBuffer.getBuffer(), bufferSize);
+		this->engineDevice.getUploadService()->uploadBuffer(this->indexBuffer, indices.data(), bufferSize, 
+			this->engineDevice.getFamilyIndices().graphicsFamily, VK_ACCESS_INDEX_READ_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
 	}
 
 	void EngineModel::bind(std::shared_ptr<EngineCommandBuffer> commandBuffer) {
@@ -159,49 +185,41 @@ namespace nugiEngine {
 			throw std::runtime_error(warn + err);
 		}
 
-		this->vertices.clear();
-		this->indices.clear();
+		// every shape is deduplicated and optimized on its own, then the shapes are appended in order
+		std::vector<ModelData> shapeDatas(shapes.size());
+		EngineTileScheduler scheduler{};
 
-		std::unordered_map<Vertex, uint32_t> uniqueVertices{};
-		for (const auto &shape: shapes) {
-			for (const auto &index: shape.mesh.indices) {
-				Vertex vertex{};
+		scheduler.run(static_cast<uint32_t>(shapes.size()), [&](uint32_t shapeIndex, uint32_t) {
+			ModelData &shapeData = shapeDatas[shapeIndex];
+			loadObjShape(attrib, shapes[shapeIndex], shapeData);
 
-				if (index.vertex_index >= 0) {
-					vertex.position = {
-						attrib.vertices[3 * index.vertex_index + 0],
-						attrib.vertices[3 * index.vertex_index + 1],
-						attrib.vertices[3 * index.vertex_index + 2]
-					};
+			std::vector<glm::vec3> positions(shapeData.vertices.size());
+			for (size_t i = 0; i < shapeData.vertices.size(); i++) {
+				positions[i] = shapeData.vertices[i].position;
+			}
 
-					vertex.color = {
-						attrib.colors[3 * index.vertex_index + 0],
-						attrib.colors[3 * index.vertex_index + 1],
-						attrib.colors[3 * index.vertex_index + 2]
-					};
-				}
+			shapeData.indices = optimizeVertexCache(shapeData.indices, shapeData.vertices.size());
+			shapeData.indices = optimizeOverdraw(shapeData.indices, positions);
+		});
 
-				if (index.normal_index >= 0) {
-					vertex.normal = {
-						attrib.normals[3 * index.normal_index + 0],
-						attrib.normals[3 * index.normal_index + 1],
-						attrib.normals[3 * index.normal_index + 2]
-					};
-				}
+		size_t vertexCount = 0, indexCount = 0;
+		for (auto &&shapeData : shapeDatas) {
+			vertexCount += shapeData.vertices.size();
+			indexCount += shapeData.indices.size();
+		}
 
-				if (index.texcoord_index >= 0) {
-					vertex.uv = { // temoirary. for OBJ object only
-						attrib.texcoords[2 * index.texcoord_index + 0],
-    				1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
-					};
-				}
+		this->vertices.clear();
+		this->indices.clear();
 
-				if (uniqueVertices.count(vertex) == 0) {
-					uniqueVertices[vertex] = static_cast<uint32_t>(this->vertices.size());
-					this->vertices.push_back(vertex);
-				}
+		this->vertices.reserve(vertexCount);
+		this->indices.reserve(indexCount);
+
+		for (auto &&shapeData : shapeDatas) {
+			uint32_t vertexOffset = static_cast<uint32_t>(this->vertices.size());
+			this->vertices.insert(this->vertices.end(), shapeData.vertices.begin(), shapeData.vertices.end());
 
-				this->indices.push_back(uniqueVertices[vertex]);
+			for (auto &&index : shapeData.indices) {
+				this->indices.emplace_back(index + vertexOffset);
 			}
 		}
 	}
@@ -53,10 +53,10 @@ namespace nugiEngine
 	private:
 		EngineDevice &engineDevice;
 		
-		std::unique_ptr<EngineBuffer> vertexBuffer;
+		std::shared_ptr<EngineBuffer> vertexBuffer;
 		uint32_t vertextCount;
 
-		std::unique_ptr<EngineBuffer> indexBuffer;
+		std::shared_ptr<EngineBuffer> indexBuffer;
 		uint32_t indexCount;
 
 		bool hasIndexBuffer = false;
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace nugiEngine {
+  // open addressing table from an OBJ index triple to the vertex it became. The vertex data is a function
+  // of the triple, so comparing the three indices is enough and the floats are never hashed.
+  // IndexTriple is tinyobj::index_t in the loader, anything with vertex_index, normal_index and texcoord_index works
+  template <typename IndexTriple>
+  class ObjVertexTable {
+    public:
+      ObjVertexTable(size_t maxVertexCount) {
+        size_t capacity = 16;
+        while (capacity < maxVertexCount * 2) {
+          capacity *= 2;
+        }
+
+        this->slots.assign(capacity, EMPTY_SLOT);
+        this->keys.reserve(maxVertexCount);
+      }
+
+      // returns the vertex of the triple and whether it was added by this call
+      std::pair<uint32_t, bool> insert(const IndexTriple &key) {
+        size_t mask = this->slots.size() - 1;
+        size_t slot = hashKey(key) & mask;
+
+        while (this->slots[slot] != EMPTY_SLOT) {
+          const IndexTriple &other = this->keys[this->slots[slot]];
+          if (other.vertex_index == key.vertex_index && other.normal_index == key.normal_index && other.texcoord_index == key.texcoord_index) {
+            return { this->slots[slot], false };
+          }
+
+          slot = (slot + 1) & mask;
+        }
+
+        uint32_t vertex = static_cast<uint32_t>(this->keys.size());
+        this->slots[slot] = vertex;
+        this->keys.emplace_back(key);
+
+        return { vertex, true };
+      }
+
+    private:
+      static constexpr uint32_t EMPTY_SLOT = UINT32_MAX;
+
+      std::vector<uint32_t> slots;
+      std::vector<IndexTriple> keys;
+
+      static size_t hashKey(const IndexTriple &key) {
+        uint64_t hash = static_cast<uint32_t>(key.vertex_index) * 0x9E3779B97F4A7C15ull;
+        hash ^= static_cast<uint32_t>(key.normal_index) * 0xC2B2AE3D27D4EB4Full;
+        hash ^= static_cast<uint32_t>(key.texcoord_index) * 0x165667B19E3779F9ull;
+
+        return static_cast<size_t>(hash ^ (hash >> 29));
+      }
+  };
+} // namespace nugiEngine
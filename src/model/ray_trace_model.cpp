@@ -1,155 +1,173 @@
 #include "ray_trace_model.hpp"
 #include "../utils/utils.hpp"
+#include "../upload_service/upload_service.hpp"
 
+#include <algorithm>
+#include <array>
 #include <cstring>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
 #include <unordered_map>
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/hash.hpp>
 
 #include "bvh.hpp"
+#include "bvh_analysis.hpp"
+#include "gltf_importer.hpp"
 
 namespace nugiEngine {
-	EngineRayTraceModel::EngineRayTraceModel(EngineDevice &device, RayTraceModelData &datas) : engineDevice{device} {
-		auto bvhData = this->createBvhData(datas);
-		auto triangleData = this->createObjectData(datas);
-		auto materialData = this->createMaterialData(datas);
-		auto lightData = this->createLightData(datas);
+	EngineRayTraceModel::EngineRayTraceModel(EngineDevice &device, RayTraceModelData &datas, bool isBuildingBvhOnGpu) 
+		: engineDevice{device}, objectCount{static_cast<uint32_t>(datas.objects.size())}, materialCount{static_cast<uint32_t>(datas.materials.size())}, 
+			lightCount{static_cast<uint32_t>(datas.lights.size())}, isBuildingBvhOnGpu{isBuildingBvhOnGpu} 
+	{
+		auto bvhNodes = this->isBuildingBvhOnGpu ? std::vector<BvhNode>{} : this->createBvhData(datas);
 
-		this->createBuffers(triangleData, bvhData, materialData, lightData);
-	}
+		// the gpu builder puts one object in every leaf, n objects take 2n - 1 nodes
+		this->bvhNodeCount = this->isBuildingBvhOnGpu ? std::max(2 * this->objectCount, 1u) - 1 : static_cast<uint32_t>(bvhNodes.size());
 
-	EngineRayTraceModel::~EngineRayTraceModel() {}
+		this->createBuffers();
+		this->uploadBuffers(datas.objects.data(), this->isBuildingBvhOnGpu ? nullptr : bvhNodes.data(), datas.materials.data(), datas.lights.data());
 
-	ObjectData EngineRayTraceModel::createObjectData(const RayTraceModelData &data) {
-		ObjectData object;
-		for (int i = 0; i < data.objects.size(); i++) {
-			object.objects[i] = data.objects[i];
+		if (this->isBuildingBvhOnGpu) {
+			this->createGpuBvhBuilder();
 		}
-
-		return object;
 	}
 
-	MaterialData EngineRayTraceModel::createMaterialData(const RayTraceModelData &data) {
-		MaterialData materials;
-		for (int i = 0; i < data.materials.size(); i++) {
-			materials.materials[i] = data.materials[i];
-		}
-
-		return materials;
-	}
+	EngineRayTraceModel::EngineRayTraceModel(EngineDevice &device, const SceneCacheFile &cacheFile) : engineDevice{device} {
+		auto objects = cacheFile.getSection(SceneCacheSection::Objects, sizeof(Object));
+		auto bvhNodes = cacheFile.getSection(SceneCacheSection::BvhNodes, sizeof(BvhNode));
+		auto materials = cacheFile.getSection(SceneCacheSection::Materials, sizeof(Material));
+		auto lights = cacheFile.getSection(SceneCacheSection::Lights, sizeof(Light));
 
-	LightData EngineRayTraceModel::createLightData(const RayTraceModelData &data) {
-		LightData lights;
-		for (int i = 0; i < data.lights.size(); i++) {
-			lights.lights[i] = data.lights[i];
-		}
+		this->objectCount = objects.count;
+		this->bvhNodeCount = bvhNodes.count;
+		this->materialCount = materials.count;
+		this->lightCount = lights.count;
 
-		return lights;
+		this->createBuffers();
+		this->uploadBuffers(objects.data, bvhNodes.data, materials.data, lights.data);
 	}
 
-	BvhData EngineRayTraceModel::createBvhData(const RayTraceModelData &data) {
+	EngineRayTraceModel::~EngineRayTraceModel() {}
+
+	std::vector<BvhNode> EngineRayTraceModel::createBvhData(const RayTraceModelData &data) {
 		std::vector<ObjectBoundBox> objects;
-		for (int i = 0; i < data.objects.size(); i++) {
-			Object o = data.objects[i];
-			objects.push_back({i, o});
+		for (size_t i = 0; i < data.objects.size(); i++) {
+			objects.push_back({static_cast<int>(i), data.objects[i]});
 		}
 
 		auto bvhNodes = createBvh(objects);
-		BvhData bvh{};
 
-		for (int i = 0; i < bvhNodes.size(); i++) {
-			bvh.bvhNodes[i] = bvhNodes[i];
+		// a deeper tree would silently overrun the traversal stack in the shader
+		BvhAnalysisConfigInfo analysisInfo{};
+		analysisInfo.sampledRayCount = 0;
+
+		auto statistics = analyzeBvh(bvhNodes, data.objects, analysisInfo);
+		if (statistics.maxStackDepth > GPU_BVH_STACK_SIZE) {
+			throw std::runtime_error("bvh needs " + std::to_string(statistics.maxStackDepth) + " traversal stack entries, hitBvh has " + std::to_string(GPU_BVH_STACK_SIZE) + "!");
 		}
 
-		return bvh;
+		return bvhNodes;
 	}
 
-	void EngineRayTraceModel::createBuffers(ObjectData &data, BvhData &bvh, MaterialData &material, LightData &light) {
-		EngineBuffer objectStagingBuffer {
-			this->engineDevice,
-			sizeof(ObjectData),
-			1,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-		};
+	void EngineRayTraceModel::createGpuBvhBuilder() {
+		// the scratch buffers stay with the model, so the tree can be rebuilt in any frame
+		this->gpuBvhBuilder = std::make_unique<EngineGpuBvhBuilder>(this->engineDevice, this->objectBuffer, this->bvhBuffer, this->objectCount);
+		this->isBuildPending = true;
+	}
+
+	void EngineRayTraceModel::recordBvhBuild(std::shared_ptr<EngineCommandBuffer> commandBuffer) {
+		if (this->gpuBvhBuilder == nullptr) {
+			throw std::runtime_error("the bvh can only be rebuilt in gpu bvh mode!");
+		}
 
-		objectStagingBuffer.map();
-		objectStagingBuffer.writeToBuffer(&data);
+		this->gpuBvhBuilder->recordBuild(commandBuffer, this->objectCount);
+		this->isBuildPending = false;
+	}
+
+	RayTraceSceneAddress EngineRayTraceModel::getSceneAddress() {
+		RayTraceSceneAddress sceneAddress{};
+		sceneAddress.objects = this->objectBuffer->getDeviceAddress();
+		sceneAddress.bvhNodes = this->bvhBuffer->getDeviceAddress();
+		sceneAddress.materials = this->materialBuffer->getDeviceAddress();
+		sceneAddress.lights = this->lightBuffer->getDeviceAddress();
+
+		sceneAddress.objectCount = this->objectCount;
+		sceneAddress.bvhNodeCount = this->bvhNodeCount;
+		sceneAddress.materialCount = this->materialCount;
+		sceneAddress.lightCount = this->lightCount;
+
+		return sceneAddress;
+	}
+
+	void EngineRayTraceModel::createBuffers() {
+		VkBufferUsageFlags usageFlags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		if (this->engineDevice.isBufferDeviceAddressSupported()) {
+			usageFlags |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+		}
 
+		// a scene without lights still binds a buffer, vulkan has no zero sized ones
 		this->objectBuffer = std::make_shared<EngineBuffer>(
 			this->engineDevice,
-			sizeof(ObjectData),
-			1,
-			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			sizeof(Object),
+			std::max(this->objectCount, 1u),
+			usageFlags,
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
 		);
 
-		this->objectBuffer->copyBuffer(objectStagingBuffer.getBuffer(), sizeof(ObjectData));
-
-		EngineBuffer bvhStagingBuffer {
-			this->engineDevice,
-			sizeof(BvhData),
-			1,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-		};
-
-		bvhStagingBuffer.map();
-		bvhStagingBuffer.writeToBuffer(&bvh);
-
 		this->bvhBuffer = std::make_shared<EngineBuffer>(
 			this->engineDevice,
-			sizeof(BvhData),
-			1,
-			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			sizeof(BvhNode),
+			std::max(this->bvhNodeCount, 1u),
+			usageFlags,
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
 		);
 
-		this->bvhBuffer->copyBuffer(bvhStagingBuffer.getBuffer(), sizeof(BvhData));
-
-		EngineBuffer materialStagingBuffer {
+		this->materialBuffer = std::make_shared<EngineBuffer>(
 			this->engineDevice,
-			sizeof(MaterialData),
-			1,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-		};
-
-		materialStagingBuffer.map();
-		materialStagingBuffer.writeToBuffer(&material);
+			sizeof(Material),
+			std::max(this->materialCount, 1u),
+			usageFlags,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+		);
 
-		this->materialBuffer = std::make_shared<EngineBuffer>(
+		this->lightBuffer = std::make_shared<EngineBuffer>(
 			this->engineDevice,
-			sizeof(MaterialData),
-			1,
-			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			sizeof(Light),
+			std::max(this->lightCount, 1u),
+			usageFlags,
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
 		);
+	}
 
-		this->materialBuffer->copyBuffer(materialStagingBuffer.getBuffer(), sizeof(MaterialData));
+	void EngineRayTraceModel::uploadBuffers(const void *objects, const void *bvh, const void *materials, const void *lights) {
+		// the scene is copied on the transfer queue and handed over to the compute queue, which runs the trace dispatch
+		auto uploadService = this->engineDevice.getUploadService();
+		uint32_t computeFamily = this->engineDevice.getFamilyIndices().computeFamily;
 
-		EngineBuffer lightStagingBuffer {
-			this->engineDevice,
-			sizeof(LightData),
-			1,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+		std::vector<std::future<void>> uploads;
+		auto enqueueUpload = [&](std::shared_ptr<EngineBuffer> buffer, const void *data, VkDeviceSize size) {
+			if (size > 0) {
+				uploads.emplace_back(uploadService->uploadBuffer(buffer, data, size, computeFamily, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT));
+			}
 		};
 
-		lightStagingBuffer.map();
-		lightStagingBuffer.writeToBuffer(&light);
+		enqueueUpload(this->objectBuffer, objects, sizeof(Object) * this->objectCount);
+		enqueueUpload(this->materialBuffer, materials, sizeof(Material) * this->materialCount);
+		enqueueUpload(this->lightBuffer, lights, sizeof(Light) * this->lightCount);
 
-		this->lightBuffer = std::make_shared<EngineBuffer>(
-			this->engineDevice,
-			sizeof(LightData),
-			1,
-			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-		);
+		// the gpu builder writes the tree on the compute queue itself
+		if (bvh != nullptr) {
+			enqueueUpload(this->bvhBuffer, bvh, sizeof(BvhNode) * this->bvhNodeCount);
+		}
 
-		this->lightBuffer->copyBuffer(lightStagingBuffer.getBuffer(), sizeof(LightData));
+		for (auto &&upload : uploads) {
+			upload.get();
+		}
 	}
 
 	std::unique_ptr<EngineRayTraceModel> EngineRayTraceModel::createModelFromFile(EngineDevice &device, const std::string &filePath) {
@@ -159,8 +177,52 @@ namespace nugiEngine {
 		return std::make_unique<EngineRayTraceModel>(device, modelData);
 	}
 
+	std::unique_ptr<EngineRayTraceModel> EngineRayTraceModel::createModelFromCache(EngineDevice &device, const std::string &cachePath) {
+		SceneCacheFile cacheFile{cachePath};
+		return std::make_unique<EngineRayTraceModel>(device, cacheFile);
+	}
+
+	std::unique_ptr<EngineRayTraceModel> EngineRayTraceModel::createModelWithCache(EngineDevice &device, RayTraceModelData &data, const std::string &cachePath) {
+		auto cacheFile = SceneCacheFile::openIfValid(cachePath, hashSceneData(data));
+		if (cacheFile != nullptr) {
+			return std::make_unique<EngineRayTraceModel>(device, *cacheFile);
+		}
+
+		try {
+			EngineRayTraceModel::writeCache(cachePath, data);
+		} catch (const std::exception &e) {
+			// a read only cache location only costs the startup time
+			std::cerr << "failed to write scene cache: " << e.what() << std::endl;
+			return std::make_unique<EngineRayTraceModel>(device, data);
+		}
+
+		return EngineRayTraceModel::createModelFromCache(device, cachePath);
+	}
+
+	void EngineRayTraceModel::writeCache(const std::string &cachePath, const RayTraceModelData &data) {
+		auto bvhNodes = EngineRayTraceModel::createBvhData(data);
+
+		std::array<SceneCacheBlob, static_cast<size_t>(SceneCacheSection::Count)> blobs{};
+		blobs[static_cast<size_t>(SceneCacheSection::Objects)] = { data.objects.data(), sizeof(Object) * data.objects.size(), static_cast<uint32_t>(data.objects.size()) };
+		blobs[static_cast<size_t>(SceneCacheSection::Materials)] = { data.materials.data(), sizeof(Material) * data.materials.size(), static_cast<uint32_t>(data.materials.size()) };
+		blobs[static_cast<size_t>(SceneCacheSection::Lights)] = { data.lights.data(), sizeof(Light) * data.lights.size(), static_cast<uint32_t>(data.lights.size()) };
+		blobs[static_cast<size_t>(SceneCacheSection::BvhNodes)] = { bvhNodes.data(), sizeof(BvhNode) * bvhNodes.size(), static_cast<uint32_t>(bvhNodes.size()) };
+
+		writeSceneCache(cachePath, hashSceneData(data), blobs);
+	}
+
 	void RayTraceModelData::loadModel(const std::string &filePath) {
-		
+		size_t extensionStart = filePath.find_last_of('.');
+		std::string extension = extensionStart == std::string::npos ? std::string{} : filePath.substr(extensionStart);
+
+		if (extension != ".gltf" && extension != ".glb") {
+			throw std::runtime_error("ray tracing models are loaded from .gltf or .glb, not " + filePath + "!");
+		}
+
+		GltfImportConfigInfo importInfo{};
+		importInfo.isDecodingImages = false;
+
+		*this = std::move(importGltf(filePath, importInfo).rayTraceData);
 	}
     
 } // namespace nugiEngine
@@ -4,6 +4,9 @@
 #include "../buffer/buffer.hpp"
 #include "../command/command_buffer.hpp"
 #include "../ray_ubo.hpp"
+#include "ray_trace_model_data.hpp"
+#include "gpu_bvh_builder.hpp"
+#include "scene_cache.hpp"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -13,33 +16,14 @@
 #include <memory>
 
 namespace nugiEngine {
-	struct RayTraceModelData {
-    std::vector<Object> objects;
-    std::vector<Material> materials;
-    std::vector<Light> lights;
-
-		void loadModel(const std::string &filePath);
-	};
-
-  struct ObjectData {
-    Object objects[100];
-  };
-
-  struct BvhData {
-    BvhNode bvhNodes[100];
-	};
-
-  struct MaterialData {
-    Material materials[100];
-  };
-
-  struct LightData {
-    Light lights[100];
-  };
-
+	// every scene buffer holds exactly the entries of the scene, the shader reads them as runtime sized arrays
 	class EngineRayTraceModel {
 	public:
-		EngineRayTraceModel(EngineDevice &device, RayTraceModelData &data);
+		// with isBuildingBvhOnGpu the tree is built by EngineGpuBvhBuilder into the bvh buffer instead of uploaded.
+		// Nothing is built here, the first recordBvhBuild has to come before the first trace dispatch
+		EngineRayTraceModel(EngineDevice &device, RayTraceModelData &data, bool isBuildingBvhOnGpu = false);
+		// uploads the sections of the mapped cache as they are, nothing is built
+		EngineRayTraceModel(EngineDevice &device, const SceneCacheFile &cacheFile);
 		~EngineRayTraceModel();
 
 		EngineRayTraceModel(const EngineRayTraceModel&) = delete;
@@ -50,7 +34,24 @@ namespace nugiEngine {
     VkDescriptorBufferInfo getMaterialInfo() { return this->materialBuffer->descriptorInfo();  }
     VkDescriptorBufferInfo getLightInfo() { return this->lightBuffer->descriptorInfo(); }
 
+    // all zero when the device has no buffer device address support
+    RayTraceSceneAddress getSceneAddress();
+
+    // true in gpu bvh mode until the first build was recorded
+    bool isBvhBuildPending() const { return this->isBuildPending; }
+
+    // rebuilds the tree of the current object buffer on the compute queue, e.g. every frame after the geometry
+    // was changed on the device. Only in gpu bvh mode
+    void recordBvhBuild(std::shared_ptr<EngineCommandBuffer> commandBuffer);
+
     static std::unique_ptr<EngineRayTraceModel> createModelFromFile(EngineDevice &device, const std::string &filePath);
+    static std::unique_ptr<EngineRayTraceModel> createModelFromCache(EngineDevice &device, const std::string &cachePath);
+
+    // loads the cache when it was written for the same scene, otherwise builds the scene and writes the cache first
+    static std::unique_ptr<EngineRayTraceModel> createModelWithCache(EngineDevice &device, RayTraceModelData &data, const std::string &cachePath);
+
+    // builds every GPU table of the scene, including its BVH, and writes them as a scene cache
+    static void writeCache(const std::string &cachePath, const RayTraceModelData &data);
 		
 	private:
 		EngineDevice &engineDevice;
@@ -60,11 +61,15 @@ namespace nugiEngine {
     std::shared_ptr<EngineBuffer> materialBuffer;
     std::shared_ptr<EngineBuffer> lightBuffer;
 
-	  ObjectData createObjectData(const RayTraceModelData &data);
-    BvhData createBvhData(const RayTraceModelData &data);
-    MaterialData createMaterialData(const RayTraceModelData &data);
-    LightData createLightData(const RayTraceModelData &data);
+    std::unique_ptr<EngineGpuBvhBuilder> gpuBvhBuilder;
+    uint32_t objectCount = 0, bvhNodeCount = 0, materialCount = 0, lightCount = 0;
+    bool isBuildingBvhOnGpu = false, isBuildPending = false;
+
+    static std::vector<BvhNode> createBvhData(const RayTraceModelData &data);
 
-    void createBuffers(ObjectData &data, BvhData &bvh, MaterialData &material, LightData &light);
+    void createBuffers();
+    // the sources only have to live until this returns, they are copied into staging buffers. A null bvh is not uploaded
+    void uploadBuffers(const void *objects, const void *bvh, const void *materials, const void *lights);
+    void createGpuBvhBuilder();
 	};
 } // namespace nugiEngine
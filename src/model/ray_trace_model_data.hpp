@@ -0,0 +1,17 @@
+#pragma once
+
+#include "../ray_ubo.hpp"
+
+#include <string>
+#include <vector>
+
+namespace nugiEngine {
+	// the scene as both the GPU and the CPU ray tracers consume it, kept free of any Vulkan type
+	struct RayTraceModelData {
+    std::vector<Object> objects;
+    std::vector<Material> materials;
+    std::vector<Light> lights;
+
+		void loadModel(const std::string &filePath);
+	};
+} // namespace nugiEngine
@@ -0,0 +1,230 @@
+#include "scene_cache.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace nugiEngine {
+  namespace {
+    class SceneHasher {
+      public:
+        void add(const void *data, size_t size) {
+          auto bytes = static_cast<const unsigned char*>(data);
+          for (size_t i = 0; i < size; i++) {
+            this->hash = (this->hash ^ bytes[i]) * 1099511628211ull;
+          }
+        }
+
+        void add(uint32_t value) { this->add(&value, sizeof(value)); }
+        void add(float value) { this->add(&value, sizeof(value)); }
+        void add(const glm::vec3 &value) { this->add(value.x); this->add(value.y); this->add(value.z); }
+
+        void add(const Triangle &triangle) {
+          this->add(triangle.point0);
+          this->add(triangle.point1);
+          this->add(triangle.point2);
+        }
+
+        uint64_t getHash() const { return this->hash; }
+
+      private:
+        uint64_t hash = 14695981039346656037ull;
+    };
+
+    uint64_t alignSectionOffset(uint64_t offset) {
+      return (offset + SCENE_CACHE_SECTION_ALIGNMENT - 1) / SCENE_CACHE_SECTION_ALIGNMENT * SCENE_CACHE_SECTION_ALIGNMENT;
+    }
+
+    const char* sectionName(SceneCacheSection section) {
+      switch (section) {
+        case SceneCacheSection::Objects: return "objects";
+        case SceneCacheSection::Materials: return "materials";
+        case SceneCacheSection::Lights: return "lights";
+        case SceneCacheSection::BvhNodes: return "bvh nodes";
+        default: return "unknown";
+      }
+    }
+  } // namespace
+
+  uint64_t hashSceneData(const RayTraceModelData &data) {
+    SceneHasher hasher;
+    hasher.add(SCENE_CACHE_VERSION);
+
+    hasher.add(static_cast<uint32_t>(data.objects.size()));
+    for (auto &&object : data.objects) {
+      hasher.add(object.triangle);
+      hasher.add(object.materialType);
+      hasher.add(object.materialIndex);
+    }
+
+    hasher.add(static_cast<uint32_t>(data.materials.size()));
+    for (auto &&material : data.materials) {
+      hasher.add(material.baseColor);
+      hasher.add(material.metallicness);
+      hasher.add(material.roughness);
+      hasher.add(material.fresnelReflect);
+    }
+
+    hasher.add(static_cast<uint32_t>(data.lights.size()));
+    for (auto &&light : data.lights) {
+      hasher.add(light.triangle);
+      hasher.add(light.color);
+      hasher.add(light.radius);
+    }
+
+    return hasher.getHash();
+  }
+
+  void writeSceneCache(const std::string &filePath, uint64_t contentHash,
+    const std::array<SceneCacheBlob, static_cast<size_t>(SceneCacheSection::Count)> &blobs) 
+  {
+    SceneCacheHeader header{};
+    std::memcpy(header.magic, SCENE_CACHE_MAGIC, sizeof(header.magic));
+    header.version = SCENE_CACHE_VERSION;
+    header.sectionCount = static_cast<uint32_t>(blobs.size());
+    header.contentHash = contentHash;
+
+    uint64_t offset = alignSectionOffset(sizeof(SceneCacheHeader));
+    for (size_t i = 0; i < blobs.size(); i++) {
+      header.sections[i].offset = offset;
+      header.sections[i].size = blobs[i].size;
+      header.sections[i].count = blobs[i].count;
+
+      offset = alignSectionOffset(offset + blobs[i].size);
+    }
+
+    header.fileSize = offset;
+
+    // written next to the target and renamed, a reader never maps a half written file
+    std::string tempPath = filePath + ".tmp";
+    std::ofstream file{tempPath, std::ios::binary | std::ios::trunc};
+
+    if (!file.is_open()) {
+      throw std::runtime_error("failed to open scene cache " + tempPath + " for writing!");
+    }
+
+    std::vector<char> padding(SCENE_CACHE_SECTION_ALIGNMENT, 0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(SceneCacheHeader));
+    uint64_t position = sizeof(SceneCacheHeader);
+
+    for (size_t i = 0; i < blobs.size(); i++) {
+      file.write(padding.data(), static_cast<std::streamsize>(header.sections[i].offset - position));
+      file.write(static_cast<const char*>(blobs[i].data), static_cast<std::streamsize>(blobs[i].size));
+
+      position = header.sections[i].offset + blobs[i].size;
+    }
+
+    file.write(padding.data(), static_cast<std::streamsize>(header.fileSize - position));
+    file.close();
+
+    if (file.fail()) {
+      std::remove(tempPath.c_str());
+      throw std::runtime_error("failed to write scene cache " + tempPath + "!");
+    }
+
+    if (std::rename(tempPath.c_str(), filePath.c_str()) != 0) {
+      std::remove(tempPath.c_str());
+      throw std::runtime_error("failed to move scene cache to " + filePath + ": " + std::strerror(errno));
+    }
+  }
+
+  SceneCacheFile::SceneCacheFile(const std::string &filePath) : filePath{filePath} {
+    int fileDescriptor = open(filePath.c_str(), O_RDONLY);
+    if (fileDescriptor < 0) {
+      throw std::runtime_error("failed to open scene cache " + filePath + ": " + std::strerror(errno));
+    }
+
+    struct stat fileStat{};
+    if (fstat(fileDescriptor, &fileStat) != 0 || fileStat.st_size < static_cast<off_t>(sizeof(SceneCacheHeader))) {
+      close(fileDescriptor);
+      throw std::runtime_error("scene cache " + filePath + " is too small!");
+    }
+
+    this->mappedSize = static_cast<size_t>(fileStat.st_size);
+    this->mappedData = mmap(nullptr, this->mappedSize, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+
+    // the mapping keeps the file alive on its own
+    close(fileDescriptor);
+
+    if (this->mappedData == MAP_FAILED) {
+      this->mappedData = nullptr;
+      throw std::runtime_error("failed to map scene cache " + filePath + ": " + std::strerror(errno));
+    }
+
+    // the sections are read front to back exactly once, on their way into the staging buffers
+    madvise(this->mappedData, this->mappedSize, MADV_SEQUENTIAL);
+    madvise(this->mappedData, this->mappedSize, MADV_WILLNEED);
+    this->header = static_cast<const SceneCacheHeader*>(this->mappedData);
+
+    try {
+      this->validateHeader();
+    } catch (...) {
+      munmap(this->mappedData, this->mappedSize);
+      throw;
+    }
+  }
+
+  SceneCacheFile::~SceneCacheFile() {
+    if (this->mappedData != nullptr) {
+      munmap(this->mappedData, this->mappedSize);
+    }
+  }
+
+  void SceneCacheFile::validateHeader() const {
+    if (std::memcmp(this->header->magic, SCENE_CACHE_MAGIC, sizeof(SCENE_CACHE_MAGIC)) != 0) {
+      throw std::runtime_error(this->filePath + " is not a scene cache!");
+    }
+
+    if (this->header->version != SCENE_CACHE_VERSION) {
+      throw std::runtime_error("scene cache " + this->filePath + " has version " + std::to_string(this->header->version) 
+        + ", expected " + std::to_string(SCENE_CACHE_VERSION) + "!");
+    }
+
+    if (this->header->fileSize != this->mappedSize || this->header->sectionCount != this->header->sections.size()) {
+      throw std::runtime_error("scene cache " + this->filePath + " is truncated or damaged!");
+    }
+
+    for (auto &&section : this->header->sections) {
+      if (section.offset > this->mappedSize || section.size > this->mappedSize - section.offset) {
+        throw std::runtime_error("scene cache " + this->filePath + " has a section outside of the file!");
+      }
+    }
+  }
+
+  SceneCacheBlob SceneCacheFile::getSection(SceneCacheSection section, uint64_t elementSize) const {
+    auto &&sectionInfo = this->header->sections[static_cast<size_t>(section)];
+
+    if (sectionInfo.size != sectionInfo.count * elementSize) {
+      throw std::runtime_error("scene cache " + this->filePath + " has " + std::to_string(sectionInfo.size) + " bytes for " 
+        + std::to_string(sectionInfo.count) + " " + sectionName(section) + ", each takes " + std::to_string(elementSize) + "!");
+    }
+
+    SceneCacheBlob blob{};
+    blob.data = static_cast<const char*>(this->mappedData) + sectionInfo.offset;
+    blob.size = sectionInfo.size;
+    blob.count = sectionInfo.count;
+
+    return blob;
+  }
+
+  std::unique_ptr<SceneCacheFile> SceneCacheFile::openIfValid(const std::string &filePath, uint64_t contentHash) {
+    try {
+      auto cacheFile = std::make_unique<SceneCacheFile>(filePath);
+      if (cacheFile->getContentHash() != contentHash) {
+        return nullptr;
+      }
+
+      return cacheFile;
+    } catch (const std::exception&) {
+      return nullptr;
+    }
+  }
+} // namespace nugiEngine
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "ray_trace_model_data.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace nugiEngine {
+  // bump whenever a section or one of the GPU structs in ray_ubo.hpp changes its layout
+  constexpr uint32_t SCENE_CACHE_VERSION = 2;
+  constexpr char SCENE_CACHE_MAGIC[8] = { 'N', 'U', 'G', 'I', 'S', 'C', 'N', '\0' };
+
+  // sections start on this boundary, so they can be copied with aligned loads
+  constexpr uint64_t SCENE_CACHE_SECTION_ALIGNMENT = 256;
+
+  enum class SceneCacheSection : uint32_t {
+    Objects,
+    Materials,
+    Lights,
+    BvhNodes,
+    Count
+  };
+
+  struct SceneCacheSectionInfo {
+    uint64_t offset;
+    uint64_t size;
+
+    // entries of the section, the section holds exactly count of them
+    uint32_t count;
+    uint32_t padding;
+  };
+
+  // written in host byte order, a file from a machine with a different order fails the magic check
+  struct SceneCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t sectionCount;
+
+    // hashSceneData of the source scene, tells a stale cache apart
+    uint64_t contentHash;
+    uint64_t fileSize;
+
+    std::array<SceneCacheSectionInfo, static_cast<size_t>(SceneCacheSection::Count)> sections;
+  };
+
+  struct SceneCacheBlob {
+    const void *data = nullptr;
+    uint64_t size = 0;
+    uint32_t count = 0;
+  };
+
+  // FNV-1a over every field value of the objects, materials and lights, padding bytes are skipped
+  uint64_t hashSceneData(const RayTraceModelData &data);
+
+  // every blob is written as it is, laid out like the buffer it will be uploaded into
+  void writeSceneCache(const std::string &filePath, uint64_t contentHash,
+    const std::array<SceneCacheBlob, static_cast<size_t>(SceneCacheSection::Count)> &blobs);
+
+  /*
+   * A scene cache mapped read-only into memory. Nothing is parsed, the header is validated
+   * and the sections are handed out as pointers into the mapping, ready to be copied into a staging buffer
+   */
+  class SceneCacheFile {
+    public:
+      SceneCacheFile(const std::string &filePath);
+      ~SceneCacheFile();
+
+      SceneCacheFile(const SceneCacheFile&) = delete;
+      SceneCacheFile& operator=(const SceneCacheFile&) = delete;
+
+      const SceneCacheHeader& getHeader() const { return *this->header; }
+      uint64_t getContentHash() const { return this->header->contentHash; }
+
+      // throws when the section is not count entries of elementSize bytes, e.g. after a GPU struct changed its size
+      SceneCacheBlob getSection(SceneCacheSection section, uint64_t elementSize) const;
+
+      // the mapped cache, or null when the file is missing, damaged, written by another version or for another scene.
+      // The returned file is the one that gets uploaded, so the cache is mapped only once
+      static std::unique_ptr<SceneCacheFile> openIfValid(const std::string &filePath, uint64_t contentHash);
+
+    private:
+      std::string filePath;
+
+      void *mappedData = nullptr;
+      size_t mappedSize = 0;
+      const SceneCacheHeader *header = nullptr;
+
+      void validateHeader() const;
+  };
+} // namespace nugiEngine
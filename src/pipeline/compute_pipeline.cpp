@@ -2,7 +2,6 @@
 
 #include "../model/model.hpp"
 
-#include <fstream>
 #include <iostream>
 #include <stdexcept>
 
@@ -14,7 +13,7 @@ namespace nugiEngine {
 	EngineComputePipeline::Builder EngineComputePipeline::Builder::setDefault(const std::string& compFilePath) {
 		VkShaderModule compShaderModule;
 
-		auto compCode = EngineComputePipeline::readFile(compFilePath);
+		auto compCode = EngineShaderLibrary::getShaderCode(compFilePath);
 
 		EngineComputePipeline::createShaderModule(this->appDevice, compCode, &compShaderModule);
 
@@ -46,6 +45,17 @@ namespace nugiEngine {
 		return *this;
   }
 
+  EngineComputePipeline::Builder EngineComputePipeline::Builder::setSpecializationConstant(uint32_t constantId, uint32_t value) {
+    VkSpecializationMapEntry entry{};
+    entry.constantID = constantId;
+    entry.offset = static_cast<uint32_t>(this->configInfo.specializationData.size() * sizeof(uint32_t));
+    entry.size = sizeof(uint32_t);
+
+    this->configInfo.specializationEntries.emplace_back(entry);
+    this->configInfo.specializationData.emplace_back(value);
+		return *this;
+  }
+
 	std::unique_ptr<EngineComputePipeline> EngineComputePipeline::Builder::build() {
 		return std::make_unique<EngineComputePipeline>(
 			this->appDevice,
@@ -62,23 +72,6 @@ namespace nugiEngine {
 		vkDestroyPipeline(this->engineDevice.getLogicalDevice(), this->computePipeline, nullptr);
 	}
 
-	std::vector<char> EngineComputePipeline::readFile(const std::string& filepath) {
-		std::ifstream file{filepath, std::ios::ate | std::ios::binary};
-
-		if (!file.is_open()) {
-			throw std::runtime_error("failed to open file");
-		}
-
-		size_t fileSize = static_cast<size_t>(file.tellg());
-		std::vector<char> buffer(fileSize);
-
-		file.seekg(0);
-		file.read(buffer.data(), fileSize);
-
-		file.close();
-		return buffer;
-	}
-
 	void EngineComputePipeline::createGraphicPipeline(const ComputePipelineConfigInfo& configInfo) {
     VkComputePipelineCreateInfo pipelineInfo{};
 
@@ -88,18 +81,28 @@ namespace nugiEngine {
 		pipelineInfo.basePipelineHandle = configInfo.basePipelineHandleInfo;
 		pipelineInfo.stage = configInfo.shaderStageInfo;
 
-		if (vkCreateComputePipelines(this->engineDevice.getLogicalDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &this->computePipeline) != VK_SUCCESS) {
+    VkSpecializationInfo specializationInfo{};
+    if (!configInfo.specializationEntries.empty()) {
+      specializationInfo.mapEntryCount = static_cast<uint32_t>(configInfo.specializationEntries.size());
+      specializationInfo.pMapEntries = configInfo.specializationEntries.data();
+      specializationInfo.dataSize = configInfo.specializationData.size() * sizeof(uint32_t);
+      specializationInfo.pData = configInfo.specializationData.data();
+
+      pipelineInfo.stage.pSpecializationInfo = &specializationInfo;
+    }
+
+		if (vkCreateComputePipelines(this->engineDevice.getLogicalDevice(), this->engineDevice.getPipelineCache(), 1, &pipelineInfo, nullptr, &this->computePipeline) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create compute pipelines");
 		}
 
     this->shaderModule = configInfo.shaderStageInfo.module;
 	}
 
-	void EngineComputePipeline::createShaderModule(EngineDevice& appDevice, const std::vector<char>& code, VkShaderModule* shaderModule) {
+	void EngineComputePipeline::createShaderModule(EngineDevice& appDevice, const EngineShaderLibrary::ShaderCode& shaderCode, VkShaderModule* shaderModule) {
 		VkShaderModuleCreateInfo createInfo{};
 		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-		createInfo.codeSize = code.size();
-		createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+		createInfo.codeSize = shaderCode.codeSize;
+		createInfo.pCode = shaderCode.code;
 
 		if (vkCreateShaderModule(appDevice.getLogicalDevice(), &createInfo, nullptr, shaderModule) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create shader module");
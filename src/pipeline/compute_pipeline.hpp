@@ -5,6 +5,7 @@
 #include <memory>
 
 #include "../device/device.hpp"
+#include "../shader_library/shader_library.hpp"
 
 namespace nugiEngine {
 	struct ComputePipelineConfigInfo {
@@ -13,6 +14,9 @@ namespace nugiEngine {
     VkPipelineShaderStageCreateInfo shaderStageInfo{};
     VkPipeline basePipelineHandleInfo{};
     int32_t basePipelineIndex;
+
+    std::vector<VkSpecializationMapEntry> specializationEntries{};
+    std::vector<uint32_t> specializationData{};
 	};
 	
 	class EngineComputePipeline {
@@ -25,6 +29,7 @@ namespace nugiEngine {
 					Builder setShaderStageInfo(VkPipelineShaderStageCreateInfo shaderStagesInfo);
           Builder setBasePipelineHandleInfo(VkPipeline basePipeline);
           Builder setBasePipelineIndex(int32_t basePipelineIndex);
+          Builder setSpecializationConstant(uint32_t constantId, uint32_t value);
 
 					std::unique_ptr<EngineComputePipeline> build();
 
@@ -47,8 +52,7 @@ namespace nugiEngine {
 			VkPipeline computePipeline;
       VkShaderModule shaderModule{};
 			
-			static std::vector<char> readFile(const std::string& filepath);
-			static void createShaderModule(EngineDevice& appDevice, const std::vector<char>& code, VkShaderModule* shaderModule);
+			static void createShaderModule(EngineDevice& appDevice, const EngineShaderLibrary::ShaderCode& shaderCode, VkShaderModule* shaderModule);
 			void createGraphicPipeline(const ComputePipelineConfigInfo& configInfo);
 	};
 }
\ No newline at end of file
@@ -2,7 +2,6 @@
 
 #include "../model/model.hpp"
 
-#include <fstream>
 #include <iostream>
 #include <stdexcept>
 
@@ -83,8 +82,8 @@ namespace nugiEngine {
 		VkShaderModule vertShaderModule;
 		VkShaderModule fragShaderModule;
 
-		auto vertCode = EngineGraphicPipeline::readFile(vertFilePath);
-		auto fragCode = EngineGraphicPipeline::readFile(fragFilePath);
+		auto vertCode = EngineShaderLibrary::getShaderCode(vertFilePath);
+		auto fragCode = EngineShaderLibrary::getShaderCode(fragFilePath);
 
 		EngineGraphicPipeline::createShaderModule(this->appDevice, vertCode, &vertShaderModule);
 		EngineGraphicPipeline::createShaderModule(this->appDevice, fragCode, &fragShaderModule);
@@ -187,23 +186,6 @@ namespace nugiEngine {
 		vkDestroyPipeline(this->engineDevice.getLogicalDevice(), this->graphicPipeline, nullptr);
 	}
 
-	std::vector<char> EngineGraphicPipeline::readFile(const std::string& filepath) {
-		std::ifstream file{filepath, std::ios::ate | std::ios::binary};
-
-		if (!file.is_open()) {
-			throw std::runtime_error("failed to open file");
-		}
-
-		size_t fileSize = static_cast<size_t>(file.tellg());
-		std::vector<char> buffer(fileSize);
-
-		file.seekg(0);
-		file.read(buffer.data(), fileSize);
-
-		file.close();
-		return buffer;
-	}
-
 	void EngineGraphicPipeline::createGraphicPipeline(const GraphicPipelineConfigInfo& configInfo) {
 		auto bindingDescriptions = configInfo.bindingDescriptions;
 		auto attributeDescriptions = configInfo.attributeDescriptions;
@@ -242,7 +224,7 @@ namespace nugiEngine {
 		pipelineInfo.basePipelineIndex = -1;
 		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-		if (vkCreateGraphicsPipelines(this->engineDevice.getLogicalDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &this->graphicPipeline) != VK_SUCCESS) {
+		if (vkCreateGraphicsPipelines(this->engineDevice.getLogicalDevice(), this->engineDevice.getPipelineCache(), 1, &pipelineInfo, nullptr, &this->graphicPipeline) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create graphic pipelines");
 		}
 		
@@ -252,11 +234,11 @@ namespace nugiEngine {
 		}
 	}
 
-	void EngineGraphicPipeline::createShaderModule(EngineDevice& appDevice, const std::vector<char>& code, VkShaderModule* shaderModule) {
+	void EngineGraphicPipeline::createShaderModule(EngineDevice& appDevice, const EngineShaderLibrary::ShaderCode& shaderCode, VkShaderModule* shaderModule) {
 		VkShaderModuleCreateInfo createInfo{};
 		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-		createInfo.codeSize = code.size();
-		createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+		createInfo.codeSize = shaderCode.codeSize;
+		createInfo.pCode = shaderCode.code;
 
 		if (vkCreateShaderModule(appDevice.getLogicalDevice(), &createInfo, nullptr, shaderModule) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create shader module");
@@ -5,6 +5,7 @@
 #include <memory>
 
 #include "../device/device.hpp"
+#include "../shader_library/shader_library.hpp"
 
 namespace nugiEngine {
 	struct GraphicPipelineConfigInfo {
@@ -65,8 +66,7 @@ namespace nugiEngine {
 			EngineGraphicPipeline(const EngineGraphicPipeline&) = delete;
 			EngineGraphicPipeline& operator =(const EngineDevice&) = delete;
 
-			static std::vector<char> readFile(const std::string& filepath);
-			static void createShaderModule(EngineDevice& appDevice, const std::vector<char>& code, VkShaderModule* shaderModule);
+			static void createShaderModule(EngineDevice& appDevice, const EngineShaderLibrary::ShaderCode& shaderCode, VkShaderModule* shaderModule);
 
 			void bind(VkCommandBuffer commandBuffer);
 
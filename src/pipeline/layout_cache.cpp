@@ -0,0 +1,118 @@
+#include "layout_cache.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace nugiEngine {
+	size_t EngineLayoutCache::SignatureHash::operator()(const Signature& signature) const {
+		// FNV-1a over every word of the signature
+		uint64_t hash = 14695981039346656037ull;
+
+		for (auto&& word : signature) {
+			hash ^= word;
+			hash *= 1099511628211ull;
+		}
+
+		return static_cast<size_t>(hash);
+	}
+
+	template<typename Map>
+	void EngineLayoutCache::removeExpired(Map& layouts) {
+		for (auto iterator = layouts.begin(); iterator != layouts.end();) {
+			if (iterator->second.expired()) {
+				iterator = layouts.erase(iterator);
+			} else {
+				iterator++;
+			}
+		}
+	}
+
+	std::shared_ptr<EngineDescriptorSetLayout> EngineLayoutCache::getDescriptorSetLayout(const std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding>& bindings,
+		const std::unordered_map<uint32_t, VkDescriptorBindingFlags>& bindingFlags) 
+	{
+		std::vector<VkDescriptorSetLayoutBinding> sortedBindings{};
+		for (auto&& kv : bindings) {
+			assert(kv.second.pImmutableSamplers == nullptr && "Immutable samplers can not be part of a cached layout");
+			sortedBindings.emplace_back(kv.second);
+		}
+
+		std::sort(sortedBindings.begin(), sortedBindings.end(), [](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) { 
+			return a.binding < b.binding; 
+		});
+
+		Signature signature{};
+		for (auto&& binding : sortedBindings) {
+			signature.emplace_back(binding.binding);
+			signature.emplace_back(static_cast<uint64_t>(binding.descriptorType));
+			signature.emplace_back(binding.descriptorCount);
+			signature.emplace_back(binding.stageFlags);
+
+			auto flags = bindingFlags.find(binding.binding);
+			signature.emplace_back(flags != bindingFlags.end() ? flags->second : 0);
+		}
+
+		std::lock_guard<std::mutex> lock(this->cacheMutex);
+
+		auto iterator = this->descSetLayouts.find(signature);
+		if (iterator != this->descSetLayouts.end()) {
+			auto cachedLayout = iterator->second.lock();
+			if (cachedLayout != nullptr) {
+				return cachedLayout;
+			}
+		}
+
+		this->removeExpired(this->descSetLayouts);
+		this->removeExpired(this->setLayoutEntries);
+
+		auto descSetLayout = std::make_shared<EngineDescriptorSetLayout>(this->appDevice, bindings, bindingFlags);
+		this->descSetLayouts[signature] = descSetLayout;
+		this->setLayoutEntries[descSetLayout->getDescriptorSetLayout()] = SetLayoutEntry{ signature, descSetLayout };
+
+		return descSetLayout;
+	}
+
+	std::shared_ptr<EnginePipelineLayout> EngineLayoutCache::getPipelineLayout(const std::vector<VkDescriptorSetLayout>& descSetLayouts, 
+		const std::vector<VkPushConstantRange>& pushConstantRanges, const std::vector<std::shared_ptr<EngineDescriptorSetLayout>>& ownedDescSetLayouts) 
+	{
+		std::lock_guard<std::mutex> lock(this->cacheMutex);
+
+		// every set layout is held by the pipeline layout, so none of their handles can be reused while it is cached
+		std::vector<std::shared_ptr<EngineDescriptorSetLayout>> usedDescSetLayouts{};
+		Signature signature{ static_cast<uint64_t>(descSetLayouts.size()) };
+
+		for (auto&& descSetLayout : descSetLayouts) {
+			auto entry = this->setLayoutEntries.find(descSetLayout);
+			auto usedDescSetLayout = entry != this->setLayoutEntries.end() ? entry->second.layout.lock() : nullptr;
+
+			if (usedDescSetLayout == nullptr) {
+				return std::make_shared<EnginePipelineLayout>(this->appDevice, descSetLayouts, pushConstantRanges, ownedDescSetLayouts);
+			}
+
+			signature.emplace_back(static_cast<uint64_t>(entry->second.signature.size()));
+			signature.insert(signature.end(), entry->second.signature.begin(), entry->second.signature.end());
+
+			usedDescSetLayouts.emplace_back(usedDescSetLayout);
+		}
+
+		for (auto&& pushConstantRange : pushConstantRanges) {
+			signature.emplace_back(pushConstantRange.stageFlags);
+			signature.emplace_back(pushConstantRange.offset);
+			signature.emplace_back(pushConstantRange.size);
+		}
+
+		auto iterator = this->pipelineLayouts.find(signature);
+		if (iterator != this->pipelineLayouts.end()) {
+			auto cachedLayout = iterator->second.lock();
+			if (cachedLayout != nullptr) {
+				return cachedLayout;
+			}
+		}
+
+		this->removeExpired(this->pipelineLayouts);
+
+		auto pipelineLayout = std::make_shared<EnginePipelineLayout>(this->appDevice, descSetLayouts, pushConstantRanges, usedDescSetLayouts);
+		this->pipelineLayouts[signature] = pipelineLayout;
+
+		return pipelineLayout;
+	}
+} // namespace nugiEngine
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "../device/device.hpp"
+#include "../descriptor/descriptor.hpp"
+#include "pipeline_layout.hpp"
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace nugiEngine {
+	/*
+	 * Hands out descriptor set layouts and pipeline layouts shared between every render system with the same signature.
+	 * The cache only keeps weak references, a layout is destroyed as soon as the last render system using it is gone.
+	 * Pipeline layouts are keyed on the bindings of their set layouts rather than on the handles, since a handle can be
+	 * reused once its layout is destroyed. Set layouts the cache did not make have unknown bindings, so pipeline layouts
+	 * using them are never shared
+	 */
+	class EngineLayoutCache {
+		public:
+			EngineLayoutCache(EngineDevice& device) : appDevice{device} {}
+
+			EngineLayoutCache(const EngineLayoutCache&) = delete;
+			EngineLayoutCache& operator = (const EngineLayoutCache&) = delete;
+
+			std::shared_ptr<EngineDescriptorSetLayout> getDescriptorSetLayout(const std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding>& bindings,
+				const std::unordered_map<uint32_t, VkDescriptorBindingFlags>& bindingFlags = {});
+
+			std::shared_ptr<EnginePipelineLayout> getPipelineLayout(const std::vector<VkDescriptorSetLayout>& descSetLayouts, 
+				const std::vector<VkPushConstantRange>& pushConstantRanges, const std::vector<std::shared_ptr<EngineDescriptorSetLayout>>& ownedDescSetLayouts);
+
+		private:
+			using Signature = std::vector<uint64_t>;
+
+			struct SignatureHash {
+				size_t operator()(const Signature& signature) const;
+			};
+
+			template<typename T>
+			using LayoutMap = std::unordered_map<Signature, std::weak_ptr<T>, SignatureHash>;
+
+			struct SetLayoutEntry {
+				Signature signature;
+				std::weak_ptr<EngineDescriptorSetLayout> layout;
+
+				bool expired() const { return this->layout.expired(); }
+			};
+
+			template<typename Map>
+			static void removeExpired(Map& layouts);
+
+			EngineDevice& appDevice;
+
+			LayoutMap<EngineDescriptorSetLayout> descSetLayouts;
+			LayoutMap<EnginePipelineLayout> pipelineLayouts;
+
+			// the bindings of every set layout made here, to build the signature of pipeline layouts using them
+			std::unordered_map<VkDescriptorSetLayout, SetLayoutEntry> setLayoutEntries;
+
+			std::mutex cacheMutex;
+	};
+} // namespace nugiEngine
@@ -0,0 +1,135 @@
+#include "pipeline_cache.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+namespace nugiEngine {
+	EnginePipelineCache::EnginePipelineCache(EngineDevice& device, const std::string& filePath) : appDevice{device}, filePath{filePath} {
+		auto cacheData = this->loadCacheData();
+
+		VkPipelineCacheCreateInfo cacheInfo{};
+		cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		cacheInfo.initialDataSize = cacheData.size();
+		cacheInfo.pInitialData = cacheData.empty() ? nullptr : cacheData.data();
+
+		if (vkCreatePipelineCache(this->appDevice.getLogicalDevice(), &cacheInfo, nullptr, &this->pipelineCache) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create pipeline cache");
+		}
+	}
+
+	EnginePipelineCache::~EnginePipelineCache() {
+		try {
+			this->save();
+		} catch (const std::exception& e) {
+			std::cerr << "failed to save pipeline cache: " << e.what() << std::endl;
+		}
+
+		vkDestroyPipelineCache(this->appDevice.getLogicalDevice(), this->pipelineCache, nullptr);
+	}
+
+	std::vector<char> EnginePipelineCache::loadCacheData() {
+		std::ifstream file{this->filePath, std::ios::ate | std::ios::binary};
+		if (!file.is_open()) {
+			return {};
+		}
+
+		size_t fileSize = static_cast<size_t>(file.tellg());
+		if (fileSize < sizeof(CacheFileHeader)) {
+			return {};
+		}
+
+		CacheFileHeader fileHeader{};
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(&fileHeader), sizeof(CacheFileHeader));
+
+		auto properties = this->appDevice.getProperties();
+
+		if (fileHeader.magic != CACHE_FILE_MAGIC || fileHeader.fileVersion != CACHE_FILE_VERSION
+			|| fileHeader.driverVersion != properties.driverVersion || fileHeader.vendorID != properties.vendorID 
+			|| fileHeader.deviceID != properties.deviceID
+			|| std::memcmp(fileHeader.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0
+			|| fileHeader.dataSize != fileSize - sizeof(CacheFileHeader)) 
+		{
+			return {};
+		}
+
+		std::vector<char> cacheData(static_cast<size_t>(fileHeader.dataSize));
+		file.read(cacheData.data(), cacheData.size());
+
+		if (!file || !this->isCacheDataValid(cacheData)) {
+			return {};
+		}
+
+		return cacheData;
+	}
+
+	bool EnginePipelineCache::isCacheDataValid(const std::vector<char>& data) {
+		// VkPipelineCacheHeaderVersionOne written by the driver in front of its own data
+		if (data.size() < sizeof(VkPipelineCacheHeaderVersionOne)) {
+			return false;
+		}
+
+		VkPipelineCacheHeaderVersionOne cacheHeader{};
+		std::memcpy(&cacheHeader, data.data(), sizeof(VkPipelineCacheHeaderVersionOne));
+
+		auto properties = this->appDevice.getProperties();
+
+		return cacheHeader.headerSize >= sizeof(VkPipelineCacheHeaderVersionOne)
+			&& cacheHeader.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+			&& cacheHeader.vendorID == properties.vendorID
+			&& cacheHeader.deviceID == properties.deviceID
+			&& std::memcmp(cacheHeader.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+	}
+
+	void EnginePipelineCache::save() {
+		size_t dataSize = 0;
+		if (vkGetPipelineCacheData(this->appDevice.getLogicalDevice(), this->pipelineCache, &dataSize, nullptr) != VK_SUCCESS) {
+			throw std::runtime_error("failed to get pipeline cache size");
+		}
+
+		std::vector<char> cacheData(dataSize);
+		if (vkGetPipelineCacheData(this->appDevice.getLogicalDevice(), this->pipelineCache, &dataSize, cacheData.data()) != VK_SUCCESS) {
+			throw std::runtime_error("failed to get pipeline cache data");
+		}
+
+		auto properties = this->appDevice.getProperties();
+
+		CacheFileHeader fileHeader{};
+		fileHeader.magic = CACHE_FILE_MAGIC;
+		fileHeader.fileVersion = CACHE_FILE_VERSION;
+		fileHeader.driverVersion = properties.driverVersion;
+		fileHeader.vendorID = properties.vendorID;
+		fileHeader.deviceID = properties.deviceID;
+		fileHeader.dataSize = static_cast<uint64_t>(dataSize);
+		std::memcpy(fileHeader.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+		// write next to the old file first, a crash halfway through must not leave a truncated cache behind
+		std::string tempPath = this->filePath + ".tmp";
+
+		std::ofstream file{tempPath, std::ios::binary | std::ios::trunc};
+		if (!file.is_open()) {
+			throw std::runtime_error("failed to open pipeline cache file");
+		}
+
+		file.write(reinterpret_cast<const char*>(&fileHeader), sizeof(CacheFileHeader));
+		file.write(cacheData.data(), dataSize);
+		file.close();
+
+		if (!file) {
+			std::remove(tempPath.c_str());
+			throw std::runtime_error("failed to write pipeline cache file");
+		}
+
+		// rename does not replace an existing file on every platform
+		if (std::rename(tempPath.c_str(), this->filePath.c_str()) != 0) {
+			std::remove(this->filePath.c_str());
+
+			if (std::rename(tempPath.c_str(), this->filePath.c_str()) != 0) {
+				throw std::runtime_error("failed to replace pipeline cache file");
+			}
+		}
+	}
+} // namespace nugiEngine
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "../device/device.hpp"
+
+#include <string>
+#include <vector>
+
+namespace nugiEngine {
+	/*
+	 * A VkPipelineCache shared by every pipeline builder and persisted between runs.
+	 * The blob on disk starts with a small header of our own holding the driver version, followed by
+	 * the data returned by vkGetPipelineCacheData. Both headers are checked against the current device
+	 * on load, a blob written by another GPU or driver is thrown away instead of handed to the driver
+	 */
+	class EnginePipelineCache {
+		public:
+			EnginePipelineCache(EngineDevice& device, const std::string& filePath = "pipeline_cache.bin");
+			~EnginePipelineCache();
+
+			EnginePipelineCache(const EnginePipelineCache&) = delete;
+			EnginePipelineCache& operator = (const EnginePipelineCache&) = delete;
+
+			VkPipelineCache getPipelineCache() { return this->pipelineCache; }
+
+			// writes the cache to disk, also called on destruction
+			void save();
+
+		private:
+			struct CacheFileHeader {
+				uint32_t magic;
+				uint32_t fileVersion;
+				uint32_t driverVersion;
+				uint32_t vendorID;
+				uint32_t deviceID;
+				uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+				uint64_t dataSize;
+			};
+
+			static constexpr uint32_t CACHE_FILE_MAGIC = 0x4e504343; // "NPCC"
+			static constexpr uint32_t CACHE_FILE_VERSION = 1;
+
+			EngineDevice& appDevice;
+			VkPipelineCache pipelineCache;
+			std::string filePath;
+
+			std::vector<char> loadCacheData();
+			bool isCacheDataValid(const std::vector<char>& data);
+	};
+} // namespace nugiEngine
@@ -0,0 +1,51 @@
+#include "pipeline_layout.hpp"
+#include "layout_cache.hpp"
+
+#include <stdexcept>
+
+namespace nugiEngine {
+	EnginePipelineLayout::Builder& EnginePipelineLayout::Builder::addDescriptorSetLayout(std::shared_ptr<EngineDescriptorSetLayout> descSetLayout) {
+		this->descSetLayouts.emplace_back(descSetLayout->getDescriptorSetLayout());
+		this->ownedDescSetLayouts.emplace_back(descSetLayout);
+		return *this;
+	}
+
+	EnginePipelineLayout::Builder& EnginePipelineLayout::Builder::addDescriptorSetLayout(VkDescriptorSetLayout descSetLayout) {
+		this->descSetLayouts.emplace_back(descSetLayout);
+		return *this;
+	}
+
+	EnginePipelineLayout::Builder& EnginePipelineLayout::Builder::addPushConstantRange(VkShaderStageFlags stageFlags, uint32_t offset, uint32_t size) {
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = stageFlags;
+		pushConstantRange.offset = offset;
+		pushConstantRange.size = size;
+
+		this->pushConstantRanges.emplace_back(pushConstantRange);
+		return *this;
+	}
+
+	std::shared_ptr<EnginePipelineLayout> EnginePipelineLayout::Builder::build() const {
+		return this->appDevice.getLayoutCache()->getPipelineLayout(this->descSetLayouts, this->pushConstantRanges, this->ownedDescSetLayouts);
+	}
+
+	EnginePipelineLayout::EnginePipelineLayout(EngineDevice& device, const std::vector<VkDescriptorSetLayout>& descSetLayouts, 
+		const std::vector<VkPushConstantRange>& pushConstantRanges, std::vector<std::shared_ptr<EngineDescriptorSetLayout>> ownedDescSetLayouts) 
+		: appDevice{device}, ownedDescSetLayouts{ownedDescSetLayouts}
+	{
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descSetLayouts.size());
+		pipelineLayoutInfo.pSetLayouts = descSetLayouts.data();
+		pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstantRanges.size());
+		pipelineLayoutInfo.pPushConstantRanges = pushConstantRanges.data();
+
+		if (vkCreatePipelineLayout(this->appDevice.getLogicalDevice(), &pipelineLayoutInfo, nullptr, &this->pipelineLayout) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create pipeline layout!");
+		}
+	}
+
+	EnginePipelineLayout::~EnginePipelineLayout() {
+		vkDestroyPipelineLayout(this->appDevice.getLogicalDevice(), this->pipelineLayout, nullptr);
+	}
+} // namespace nugiEngine
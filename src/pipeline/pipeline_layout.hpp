@@ -0,0 +1,47 @@
+#pragma once
+
+#include "../device/device.hpp"
+#include "../descriptor/descriptor.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace nugiEngine {
+	class EnginePipelineLayout {
+		public:
+			class Builder {
+				public:
+					Builder(EngineDevice& appDevice) : appDevice{appDevice} {}
+
+					Builder& addDescriptorSetLayout(std::shared_ptr<EngineDescriptorSetLayout> descSetLayout);
+					Builder& addDescriptorSetLayout(VkDescriptorSetLayout descSetLayout);
+					Builder& addPushConstantRange(VkShaderStageFlags stageFlags, uint32_t offset, uint32_t size);
+
+					// returns the layout already made for the same set layouts and push constant ranges, if it is still alive
+					std::shared_ptr<EnginePipelineLayout> build() const;
+
+				private:
+					EngineDevice& appDevice;
+
+					std::vector<VkDescriptorSetLayout> descSetLayouts{};
+					std::vector<std::shared_ptr<EngineDescriptorSetLayout>> ownedDescSetLayouts{};
+					std::vector<VkPushConstantRange> pushConstantRanges{};
+			};
+
+			EnginePipelineLayout(EngineDevice& device, const std::vector<VkDescriptorSetLayout>& descSetLayouts, 
+				const std::vector<VkPushConstantRange>& pushConstantRanges, std::vector<std::shared_ptr<EngineDescriptorSetLayout>> ownedDescSetLayouts = {});
+			~EnginePipelineLayout();
+
+			EnginePipelineLayout(const EnginePipelineLayout&) = delete;
+			EnginePipelineLayout& operator = (const EnginePipelineLayout&) = delete;
+
+			VkPipelineLayout getPipelineLayout() const { return this->pipelineLayout; }
+
+		private:
+			EngineDevice& appDevice;
+			VkPipelineLayout pipelineLayout;
+
+			// the set layouts have to outlive every pipeline layout made from them
+			std::vector<std::shared_ptr<EngineDescriptorSetLayout>> ownedDescSetLayouts;
+	};
+} // namespace nugiEngine
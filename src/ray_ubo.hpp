@@ -56,7 +56,25 @@ namespace nugiEngine {
     alignas(16) glm::vec3 background;
   };
 
+  // device addresses of the scene buffers, read through buffer_reference by ray_trace_pbrt_bda.comp
+  struct RayTraceSceneAddress {
+    alignas(8) uint64_t objects = 0;
+    alignas(8) uint64_t bvhNodes = 0;
+    alignas(8) uint64_t materials = 0;
+    alignas(8) uint64_t lights = 0;
+
+    // entries behind each address, the shader declares the arrays without a size
+    alignas(4) uint32_t objectCount = 0;
+    alignas(4) uint32_t bvhNodeCount = 0;
+    alignas(4) uint32_t materialCount = 0;
+    alignas(4) uint32_t lightCount = 0;
+  };
+
   struct RayTracePushConstant {
     alignas(4) uint32_t randomSeed;
   };
+
+  struct RayTraceSeedUbo {
+    alignas(4) uint32_t randomSeed;
+  };
 }
\ No newline at end of file
@@ -8,19 +8,22 @@
 namespace nugiEngine {
 	EngineHybridRenderer::EngineHybridRenderer(EngineWindow& window, EngineDevice& device) : appDevice{device}, appWindow{window} {
 		this->recreateSwapChain();
+
+		this->frameScheduler = std::make_shared<EngineFrameScheduler>(device, EngineDevice::MAX_FRAMES_IN_FLIGHT);
 		this->createSyncObjects(static_cast<uint32_t>(this->swapChain->imageCount()));
 
 		this->commandBuffers = EngineCommandBuffer::createCommandBuffers(device, EngineDevice::MAX_FRAMES_IN_FLIGHT);
+		this->computeCommandBuffers = EngineCommandBuffer::createCommandBuffers(device, EngineDevice::MAX_FRAMES_IN_FLIGHT, device.getComputeCommandPool());
 		this->createDescriptorPool();
 	}
 
 	EngineHybridRenderer::~EngineHybridRenderer() {
 		this->descriptorPool->resetPool();
+		this->frameScheduler->waitIdle();
 		
     for (size_t i = 0; i < EngineDevice::MAX_FRAMES_IN_FLIGHT; i++) {
 			vkDestroySemaphore(this->appDevice.getLogicalDevice(), this->renderFinishedSemaphores[i], nullptr);
 			vkDestroySemaphore(this->appDevice.getLogicalDevice(), this->imageAvailableSemaphores[i], nullptr);
-			vkDestroyFence(this->appDevice.getLogicalDevice(), this->inFlightFences[i], nullptr);
 		}
 	}
 
@@ -31,7 +34,7 @@ namespace nugiEngine {
 			glfwWaitEvents();
 		}
 
-		vkDeviceWaitIdle(this->appDevice.getLogicalDevice());
+		this->appDevice.waitIdle();
 
 		if (this->swapChain == nullptr) {
 			this->swapChain = std::make_unique<EngineSwapChain>(this->appDevice, extent);
@@ -60,19 +63,14 @@ namespace nugiEngine {
 	void EngineHybridRenderer::createSyncObjects(uint32_t imageCount) {
 		imageAvailableSemaphores.resize(EngineDevice::MAX_FRAMES_IN_FLIGHT);
 		renderFinishedSemaphores.resize(EngineDevice::MAX_FRAMES_IN_FLIGHT);
-		inFlightFences.resize(EngineDevice::MAX_FRAMES_IN_FLIGHT);
 
 		VkSemaphoreCreateInfo semaphoreInfo = {};
 		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-		VkFenceCreateInfo fenceInfo = {};
-		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-		fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
+		// the swap chain still needs binary semaphores, every other dependency goes through the frame scheduler timeline
 		for (size_t i = 0; i < EngineDevice::MAX_FRAMES_IN_FLIGHT; i++) {
 		  if (vkCreateSemaphore(this->appDevice.getLogicalDevice(), &semaphoreInfo, nullptr, &this->imageAvailableSemaphores[i]) != VK_SUCCESS ||
-			vkCreateSemaphore(this->appDevice.getLogicalDevice(), &semaphoreInfo, nullptr, &this->renderFinishedSemaphores[i]) != VK_SUCCESS ||
-			vkCreateFence(this->appDevice.getLogicalDevice(), &fenceInfo, nullptr, &this->inFlightFences[i]) != VK_SUCCESS) 
+			vkCreateSemaphore(this->appDevice.getLogicalDevice(), &semaphoreInfo, nullptr, &this->renderFinishedSemaphores[i]) != VK_SUCCESS) 
 		  {
 			throw std::runtime_error("failed to create synchronization objects for a frame!");
 		  }
@@ -82,8 +80,10 @@ namespace nugiEngine {
 	bool EngineHybridRenderer::acquireFrame() {
 		assert(!this->isFrameStarted && "can't acquire frame while frame still in progress");
 
-		std::vector<VkFence> acquireFrameFences = { this->inFlightFences[this->currentFrameIndex] };
-		auto result = this->swapChain->acquireNextImage(&this->currentImageIndex, acquireFrameFences, this->imageAvailableSemaphores[this->currentFrameIndex]);
+		this->frameScheduler->beginFrame();
+		this->currentFrameIndex = this->frameScheduler->getFrameIndex();
+
+		auto result = this->swapChain->acquireNextImage(&this->currentImageIndex, this->imageAvailableSemaphores[this->currentFrameIndex]);
 		
 		if (result == VK_ERROR_OUT_OF_DATE_KHR) {
 			this->recreateSwapChain();
@@ -105,48 +105,86 @@ namespace nugiEngine {
 		return this->commandBuffers[this->currentFrameIndex];
 	}
 
+	std::shared_ptr<EngineCommandBuffer> EngineHybridRenderer::beginComputeCommand() {
+		assert(this->isFrameStarted && "can't start command while frame still in progress");
+
+		this->computeCommandBuffers[this->currentFrameIndex]->beginReccuringCommand();
+		return this->computeCommandBuffers[this->currentFrameIndex];
+	}
+
 	void EngineHybridRenderer::endCommand(std::shared_ptr<EngineCommandBuffer> commandBuffer) {
 		assert(this->isFrameStarted && "can't start command while frame still in progress");
 		commandBuffer->endCommand();
 	}
 
-	void EngineHybridRenderer::submitCommands(std::vector<std::shared_ptr<EngineCommandBuffer>> commandBuffer) {
+	void EngineHybridRenderer::submitFrame(uint32_t commandBufferCount, const VkCommandBuffer* commandBuffers) {
+		VkSemaphore graphicsTimeline = this->frameScheduler->getTimelineSemaphore(EngineQueueTimeline::Graphics);
+		VkSemaphore computeTimeline = this->frameScheduler->getTimelineSemaphore(EngineQueueTimeline::Compute);
+
+		// the only cross queue dependency of this frame is the storage image written by its compute submit
+		VkSemaphore waitSemaphores[] = { this->imageAvailableSemaphores[this->currentFrameIndex], computeTimeline };
+		VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT };
+		uint64_t waitValues[] = { 0, this->computeFinishedValue };
+
+		uint64_t frameValue = this->frameScheduler->nextValue(EngineQueueTimeline::Graphics);
+
+		VkSemaphore signalSemaphores[] = { this->renderFinishedSemaphores[this->currentFrameIndex], graphicsTimeline };
+		uint64_t signalValues[] = { 0, frameValue };
+
+		uint32_t waitSemaphoreCount = this->computeFinishedValue > 0 ? 2 : 1;
+
+		EngineCommandBuffer::submitCommands(this->appDevice, commandBufferCount, commandBuffers, this->appDevice.getGraphicsQueue(this->currentFrameIndex), 
+			waitSemaphoreCount, waitSemaphores, waitStages, waitValues, 2, signalSemaphores, signalValues);
+
+		this->computeFinishedValue = 0;
+		this->frameScheduler->endFrame();
+	}
+
+	void EngineHybridRenderer::submitCommands(std::vector<std::shared_ptr<EngineCommandBuffer>> commandBuffers) {
 		assert(this->isFrameStarted && "can't submit command if frame is not in progress");
-		vkResetFences(this->appDevice.getLogicalDevice(), 1, &this->inFlightFences[this->currentFrameIndex]);
 
-		std::vector<VkSemaphore> waitSemaphores = {this->imageAvailableSemaphores[this->currentFrameIndex]};
-		std::vector<VkSemaphore> signalSemaphores = {this->renderFinishedSemaphores[this->currentFrameIndex]};
-		std::vector<VkPipelineStageFlags> waitStages = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+		std::vector<VkCommandBuffer> buffers{};
+		for (auto& commandBuffer : commandBuffers) {
+			buffers.push_back(commandBuffer->getCommandBuffer());
+		}
 
-		EngineCommandBuffer::submitCommands(commandBuffers, this->appDevice.getGraphicsQueue(this->currentFrameIndex), waitSemaphores, waitStages, signalSemaphores, this->inFlightFences[this->currentFrameIndex]);
+		this->submitFrame(static_cast<uint32_t>(buffers.size()), buffers.data());
 	}
 
 	void EngineHybridRenderer::submitCommand(std::shared_ptr<EngineCommandBuffer> commandBuffer) {
 		assert(this->isFrameStarted && "can't submit command if frame is not in progress");
-		vkResetFences(this->appDevice.getLogicalDevice(), 1, &this->inFlightFences[this->currentFrameIndex]);
 
-		std::vector<VkSemaphore> waitSemaphores = {this->imageAvailableSemaphores[this->currentFrameIndex]};
-		std::vector<VkSemaphore> signalSemaphores = {this->renderFinishedSemaphores[this->currentFrameIndex]};
-		std::vector<VkPipelineStageFlags> waitStages = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+		VkCommandBuffer buffer = commandBuffer->getCommandBuffer();
+		this->submitFrame(1, &buffer);
+	}
 
-		commandBuffer->submitCommand(this->appDevice.getGraphicsQueue(this->currentFrameIndex), waitSemaphores, waitStages, signalSemaphores, this->inFlightFences[this->currentFrameIndex]);
+	void EngineHybridRenderer::submitComputeCommand(std::shared_ptr<EngineCommandBuffer> commandBuffer) {
+		assert(this->isFrameStarted && "can't submit command if frame is not in progress");
+
+		VkSemaphore graphicsTimeline = this->frameScheduler->getTimelineSemaphore(EngineQueueTimeline::Graphics);
+		VkSemaphore computeTimeline = this->frameScheduler->getTimelineSemaphore(EngineQueueTimeline::Compute);
+		VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+		// the storage image of this slot is released by the graphics submit that last used the slot,
+		// later graphics submits of other slots can still run next to this one
+		uint64_t releasedValue = this->frameScheduler->getFrameValue(EngineQueueTimeline::Graphics);
+		this->computeFinishedValue = this->frameScheduler->nextValue(EngineQueueTimeline::Compute);
+
+		commandBuffer->submitCommand(this->appDevice.getComputeQueue(this->currentFrameIndex), releasedValue > 0 ? 1 : 0, &graphicsTimeline, &waitStage, &releasedValue, 
+			1, &computeTimeline, &this->computeFinishedValue);
 	}
 
 	bool EngineHybridRenderer::presentFrame() {
 		assert(this->isFrameStarted && "can't present frame if frame is not in progress");
 
-		std::vector<VkSemaphore> waitSemaphores = {this->renderFinishedSemaphores[this->currentFrameIndex]};
-		auto result = this->swapChain->presentRenders(this->appDevice.getPresentQueue(this->currentFrameIndex), &this->currentImageIndex, waitSemaphores);
-
-		this->currentFrameIndex = (this->currentFrameIndex + 1) % EngineDevice::MAX_FRAMES_IN_FLIGHT;
+		VkSemaphore waitSemaphore = this->renderFinishedSemaphores[this->currentFrameIndex];
+		auto result = this->swapChain->presentRenders(this->appDevice.getPresentQueue(this->currentFrameIndex), &this->currentImageIndex, 1, &waitSemaphore);
 
 		this->isFrameStarted = false;
 
 		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || this->appWindow.wasResized()) {
 			this->appWindow.resetResizedFlag();
 			this->recreateSwapChain();
-			this->descriptorPool->resetPool();
-
 			return false;
 		} else if (result != VK_SUCCESS) {
 			throw std::runtime_error("failed to present swap chain image");
@@ -6,6 +6,7 @@
 #include "../buffer/buffer.hpp"
 #include "../descriptor/descriptor.hpp"
 #include "../command/command_buffer.hpp"
+#include "../frame_scheduler/frame_scheduler.hpp"
 
 #include <memory>
 #include <vector>
@@ -23,6 +24,7 @@ namespace nugiEngine {
 
 			std::shared_ptr<EngineSwapChain> getSwapChain() const { return this->swapChain; }
 			std::shared_ptr<EngineDescriptorPool> getDescriptorPool() const { return this->descriptorPool; }
+			std::shared_ptr<EngineFrameScheduler> getFrameScheduler() const { return this->frameScheduler; }
 			bool isFrameInProgress() const { return this->isFrameStarted; }
 
 			VkCommandBuffer getCommandBuffer() const { 
@@ -41,10 +43,12 @@ namespace nugiEngine {
 			}
 
 			std::shared_ptr<EngineCommandBuffer> beginCommand();
+			std::shared_ptr<EngineCommandBuffer> beginComputeCommand();
 			void endCommand(std::shared_ptr<EngineCommandBuffer>);
 
 			void submitCommands(std::vector<std::shared_ptr<EngineCommandBuffer>> commandBuffer);
 			void submitCommand(std::shared_ptr<EngineCommandBuffer> commandBuffer);
+			void submitComputeCommand(std::shared_ptr<EngineCommandBuffer> commandBuffer);
 
 			bool acquireFrame();
 			bool presentFrame();
@@ -52,6 +56,7 @@ namespace nugiEngine {
 		private:
 			void recreateSwapChain();
 			void createSyncObjects(uint32_t imageCount);
+			void submitFrame(uint32_t commandBufferCount, const VkCommandBuffer* commandBuffers);
 			void createDescriptorPool();
 
 			EngineWindow& appWindow;
@@ -59,14 +64,16 @@ namespace nugiEngine {
 
 			std::shared_ptr<EngineSwapChain> swapChain;
 			std::vector<std::shared_ptr<EngineCommandBuffer>> commandBuffers;
+			std::vector<std::shared_ptr<EngineCommandBuffer>> computeCommandBuffers;
 
 			std::shared_ptr<EngineDescriptorPool> descriptorPool;
+			std::shared_ptr<EngineFrameScheduler> frameScheduler;
 
 			std::vector<VkSemaphore> imageAvailableSemaphores;
 			std::vector<VkSemaphore> renderFinishedSemaphores;
-			std::vector<VkFence> inFlightFences;
 
 			uint32_t currentImageIndex = 0, currentFrameIndex = 0;
 			bool isFrameStarted = false;
+			uint64_t computeFinishedValue = 0;
 	};
 }
\ No newline at end of file
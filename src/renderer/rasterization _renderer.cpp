@@ -4,6 +4,7 @@
 #include <stdexcept>
 #include <array>
 #include <string>
+#include <limits>
 
 namespace nugiEngine {
 	EngineRasterRenderer::EngineRasterRenderer(EngineWindow& window, EngineDevice& device) : appDevice{device}, appWindow{window} {
@@ -14,6 +15,7 @@ namespace nugiEngine {
 
 		this->createGlobalBuffers(sizeof(GlobalUBO), sizeof(GlobalLight));
 		this->createGlobalUboDescriptor();
+		this->createBindlessDescriptor();
 	}
 
 	EngineRasterRenderer::~EngineRasterRenderer() {
@@ -32,7 +34,7 @@ namespace nugiEngine {
 			glfwWaitEvents();
 		}
 
-		vkDeviceWaitIdle(this->appDevice.getLogicalDevice());
+		this->appDevice.waitIdle();
 
 		if (this->swapChain == nullptr) {
 			this->swapChain = std::make_unique<EngineSwapChain>(this->appDevice, extent);
@@ -101,6 +103,12 @@ namespace nugiEngine {
 		}
 	}
 
+	void EngineRasterRenderer::createBindlessDescriptor() {
+		if (this->appDevice.isBindlessSupported()) {
+			this->bindlessDescriptor = std::make_shared<EngineBindlessDescriptor>(this->appDevice);
+		}
+	}
+
 	void EngineRasterRenderer::createSyncObjects(uint32_t imageCount) {
     imageAvailableSemaphores.resize(EngineDevice::MAX_FRAMES_IN_FLIGHT);
     renderFinishedSemaphores.resize(EngineDevice::MAX_FRAMES_IN_FLIGHT);
@@ -136,8 +144,8 @@ namespace nugiEngine {
 	bool EngineRasterRenderer::acquireFrame() {
 		assert(!this->isFrameStarted && "can't acquire frame while frame still in progress");
 
-		std::vector<VkFence> acquireFrameFences = { this->inFlightFences[this->currentFrameIndex] };
-		auto result = this->swapChain->acquireNextImage(&this->currentImageIndex, acquireFrameFences, this->imageAvailableSemaphores[this->currentFrameIndex]);
+		vkWaitForFences(this->appDevice.getLogicalDevice(), 1, &this->inFlightFences[this->currentFrameIndex], VK_TRUE, std::numeric_limits<uint64_t>::max());
+		auto result = this->swapChain->acquireNextImage(&this->currentImageIndex, this->imageAvailableSemaphores[this->currentFrameIndex]);
 
 		if (result == VK_ERROR_OUT_OF_DATE_KHR) {
 			this->recreateSwapChain();
@@ -189,8 +197,8 @@ namespace nugiEngine {
 	bool EngineRasterRenderer::presentFrame() {
 		assert(this->isFrameStarted && "can't present frame if frame is not in progress");
 
-		std::vector<VkSemaphore> waitSemaphores = {this->renderFinishedSemaphores[this->currentFrameIndex]};
-		auto result = this->swapChain->presentRenders(this->appDevice.getPresentQueue(0), &this->currentImageIndex, waitSemaphores);
+		VkSemaphore waitSemaphore = this->renderFinishedSemaphores[this->currentFrameIndex];
+		auto result = this->swapChain->presentRenders(this->appDevice.getPresentQueue(0), &this->currentImageIndex, 1, &waitSemaphore);
 
 		this->currentFrameIndex = (this->currentFrameIndex + 1) % EngineDevice::MAX_FRAMES_IN_FLIGHT;
 		this->isFrameStarted = false;
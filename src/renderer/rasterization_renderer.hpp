@@ -5,6 +5,7 @@
 #include "../swap_chain/swap_chain.hpp"
 #include "../buffer/buffer.hpp"
 #include "../descriptor/descriptor.hpp"
+#include "../descriptor/bindless_descriptor.hpp"
 #include "../command/command_buffer.hpp"
 
 #include <memory>
@@ -28,6 +29,9 @@ namespace nugiEngine {
 			std::shared_ptr<EngineDescriptorSetLayout> getGlobalDescSetLayout() const { return this->globalDescSetLayout; }
 			std::shared_ptr<VkDescriptorSet> getGlobalDescriptorSets(int index) const { return this->globalDescriptorSets[index]; }
 
+			// null when the device has no descriptor indexing, render systems then fall back to a set per resource
+			std::shared_ptr<EngineBindlessDescriptor> getBindlessDescriptor() const { return this->bindlessDescriptor; }
+
 			VkCommandBuffer getCommandBuffer() const { 
 				assert(this->isFrameStarted && "cannot get command buffer when frame is not in progress");
 				return this->commandBuffers[this->currentFrameIndex]->getCommandBuffer();
@@ -59,6 +63,7 @@ namespace nugiEngine {
 			void recreateSwapChain();
 			void createGlobalBuffers(unsigned long sizeUBO, unsigned long sizeLightBuffer);
 			void createGlobalUboDescriptor();
+			void createBindlessDescriptor();
 			void createSyncObjects(uint32_t imageCount);
 
 			EngineWindow& appWindow;
@@ -70,6 +75,7 @@ namespace nugiEngine {
 			std::shared_ptr<EngineDescriptorPool> descriptorPool{};
 			std::shared_ptr<EngineDescriptorSetLayout> globalDescSetLayout{};
 			std::vector<std::shared_ptr<VkDescriptorSet>> globalDescriptorSets;
+			std::shared_ptr<EngineBindlessDescriptor> bindlessDescriptor{};
 
 			std::vector<std::shared_ptr<EngineBuffer>> globalLightBuffers;
 			std::vector<std::shared_ptr<EngineBuffer>> globalUniformBuffers;
@@ -4,6 +4,7 @@
 #include <stdexcept>
 #include <array>
 #include <string>
+#include <limits>
 
 namespace nugiEngine {
 	EngineRayTraceRenderer::EngineRayTraceRenderer(EngineWindow& window, EngineDevice& device) : appDevice{device}, appWindow{window} {
@@ -31,7 +32,7 @@ namespace nugiEngine {
 			glfwWaitEvents();
 		}
 
-		vkDeviceWaitIdle(this->appDevice.getLogicalDevice());
+		this->appDevice.waitIdle();
 
 		if (this->swapChain == nullptr) {
 			this->swapChain = std::make_unique<EngineSwapChain>(this->appDevice, extent);
@@ -82,8 +83,8 @@ namespace nugiEngine {
 	bool EngineRayTraceRenderer::acquireFrame() {
 		assert(!this->isFrameStarted && "can't acquire frame while frame still in progress");
 
-		std::vector<VkFence> acquireFrameFences = { this->inFlightFences[this->currentFrameIndex] };
-		auto result = this->swapChain->acquireNextImage(&this->currentImageIndex, acquireFrameFences, this->imageAvailableSemaphores[this->currentFrameIndex]);
+		vkWaitForFences(this->appDevice.getLogicalDevice(), 1, &this->inFlightFences[this->currentFrameIndex], VK_TRUE, std::numeric_limits<uint64_t>::max());
+		auto result = this->swapChain->acquireNextImage(&this->currentImageIndex, this->imageAvailableSemaphores[this->currentFrameIndex]);
 
 		if (result == VK_ERROR_OUT_OF_DATE_KHR) {
 			this->recreateSwapChain();
@@ -135,8 +136,8 @@ namespace nugiEngine {
 	bool EngineRayTraceRenderer::presentFrame() {
 		assert(this->isFrameStarted && "can't present frame if frame is not in progress");
 
-		std::vector<VkSemaphore> waitSemaphores = {this->renderFinishedSemaphores[this->currentFrameIndex]};
-		auto result = this->swapChain->presentRenders(this->appDevice.getPresentQueue(this->currentFrameIndex) , &this->currentImageIndex, waitSemaphores);
+		VkSemaphore waitSemaphore = this->renderFinishedSemaphores[this->currentFrameIndex];
+		auto result = this->swapChain->presentRenders(this->appDevice.getPresentQueue(this->currentFrameIndex) , &this->currentImageIndex, 1, &waitSemaphore);
 
 		this->currentFrameIndex = (this->currentFrameIndex + 1) % EngineDevice::MAX_FRAMES_IN_FLIGHT;
 		this->isFrameStarted = false;
@@ -23,34 +23,20 @@ namespace nugiEngine {
 		this->createPipeline(renderPass);
 	}
 
-	EnginePointLightRenderSystem::~EnginePointLightRenderSystem() {
-		vkDestroyPipelineLayout(this->appDevice.getLogicalDevice(), this->pipelineLayout, nullptr);
-	}
+	EnginePointLightRenderSystem::~EnginePointLightRenderSystem() {}
 
 	void EnginePointLightRenderSystem::createPipelineLayout(VkDescriptorSetLayout globalDescSetLayout) {
-		VkPushConstantRange pushConstantRange{};
-		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-		pushConstantRange.offset = 0;
-		pushConstantRange.size = sizeof(PointLightPushConstant);
-
-		std::vector<VkDescriptorSetLayout> descriptorSetLayouts = { globalDescSetLayout };
-
-		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
-		pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
-		pipelineLayoutInfo.pushConstantRangeCount = 1;
-		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
-
-		if (vkCreatePipelineLayout(this->appDevice.getLogicalDevice(), &pipelineLayoutInfo, nullptr, &this->pipelineLayout) != VK_SUCCESS) {
-			throw std::runtime_error("failed to create pipeline layout!");
-		}
+		this->pipelineLayout = 
+			EnginePipelineLayout::Builder(this->appDevice)
+				.addDescriptorSetLayout(globalDescSetLayout)
+				.addPushConstantRange(VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PointLightPushConstant))
+				.build();
 	}
 
 	void EnginePointLightRenderSystem::createPipeline(VkRenderPass renderPass) {
 		assert(this->pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
 
-		this->pipeline = EngineGraphicPipeline::Builder(this->appDevice, this->pipelineLayout, renderPass)
+		this->pipeline = EngineGraphicPipeline::Builder(this->appDevice, this->pipelineLayout->getPipelineLayout(), renderPass)
 			.setDefault("shader/point_light.vert.spv", "shader/point_light.frag.spv")
 			.setBindingDescriptions({})
 			.setAttributeDescriptions({})
@@ -83,7 +69,7 @@ namespace nugiEngine {
 		vkCmdBindDescriptorSets(
 			commandBuffer->getCommandBuffer(),
 			VK_PIPELINE_BIND_POINT_GRAPHICS,
-			this->pipelineLayout,
+			this->pipelineLayout->getPipelineLayout(),
 			0,
 			1,
 			&UBODescSet,
@@ -101,7 +87,7 @@ namespace nugiEngine {
 
 			vkCmdPushConstants(
 				commandBuffer->getCommandBuffer(),
-				this->pipelineLayout,
+				this->pipelineLayout->getPipelineLayout(),
 				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
 				0,
 				sizeof(PointLightPushConstant),
@@ -23,34 +23,21 @@ namespace nugiEngine {
 		this->createPipeline();
 	}
 
-	EngineSamplingRayCompRenderSystem::~EngineSamplingRayCompRenderSystem() {
-		vkDestroyPipelineLayout(this->appDevice.getLogicalDevice(), this->pipelineLayout, nullptr);
-	}
+	EngineSamplingRayCompRenderSystem::~EngineSamplingRayCompRenderSystem() {}
 
 	void EngineSamplingRayCompRenderSystem::createPipelineLayout(std::shared_ptr<EngineDescriptorSetLayout> traceRayDescLayout) {
-		VkPushConstantRange pushConstantRange{};
-		pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-		pushConstantRange.offset = 0;
-		pushConstantRange.size = sizeof(RayTracePushConstant);
-
-		std::vector<VkDescriptorSetLayout> descSetLayouts = { traceRayDescLayout->getDescriptorSetLayout(), this->descSetLayout->getDescriptorSetLayout() };
-
-		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descSetLayouts.size());
-		pipelineLayoutInfo.pSetLayouts = descSetLayouts.data();
-		pipelineLayoutInfo.pushConstantRangeCount = 1;
-		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
-
-		if (vkCreatePipelineLayout(this->appDevice.getLogicalDevice(), &pipelineLayoutInfo, nullptr, &this->pipelineLayout) != VK_SUCCESS) {
-			throw std::runtime_error("failed to create pipeline layout!");
-		}
+		this->pipelineLayout = 
+			EnginePipelineLayout::Builder(this->appDevice)
+				.addDescriptorSetLayout(traceRayDescLayout)
+				.addDescriptorSetLayout(this->descSetLayout)
+				.addPushConstantRange(VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(RayTracePushConstant))
+				.build();
 	}
 
 	void EngineSamplingRayCompRenderSystem::createPipeline() {
 		assert(this->pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
 
-		this->pipeline = EngineComputePipeline::Builder(this->appDevice, this->pipelineLayout)
+		this->pipeline = EngineComputePipeline::Builder(this->appDevice, this->pipelineLayout->getPipelineLayout())
 			.setDefault("shader/ray_trace_sampling.comp.spv")
 			.build();
 	}
@@ -101,7 +88,7 @@ namespace nugiEngine {
 		vkCmdBindDescriptorSets(
 			commandBuffer->getCommandBuffer(),
 			VK_PIPELINE_BIND_POINT_COMPUTE,
-			this->pipelineLayout,
+			this->pipelineLayout->getPipelineLayout(),
 			0,
 			2,
 			descpSet,
@@ -114,7 +101,7 @@ namespace nugiEngine {
 
 		vkCmdPushConstants(
 			commandBuffer->getCommandBuffer(), 
-			this->pipelineLayout, 
+			this->pipelineLayout->getPipelineLayout(), 
 			VK_SHADER_STAGE_COMPUTE_BIT,
 			0,
 			sizeof(RayTracePushConstant),
@@ -8,50 +8,37 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 
+#include <iostream>
 #include <stdexcept>
 #include <array>
 #include <string>
 
 namespace nugiEngine {
 	EngineSamplingRayRasterRenderSystem::EngineSamplingRayRasterRenderSystem(EngineDevice& device, std::shared_ptr<EngineDescriptorPool> descriptorPool, 
-		uint32_t width, uint32_t height, std::vector<std::shared_ptr<EngineImage>> computeStoreImages, uint32_t nSample, VkRenderPass renderPass) 
-		: appDevice{device}
+		uint32_t width, uint32_t height, std::vector<std::shared_ptr<EngineImage>> computeStoreImages, 
+		std::vector<VkDescriptorBufferInfo> seedBuffersInfo, VkRenderPass renderPass) 
+		: appDevice{device}, descriptorPool{descriptorPool}
 	{
 		this->createAccumulateImages(width, height);
-		this->createDescriptor(descriptorPool, computeStoreImages, nSample);
+		this->createDescriptor(descriptorPool, computeStoreImages, seedBuffersInfo);
 
 		this->createPipelineLayout();
 		this->createPipeline(renderPass);
 	}
 
-	EngineSamplingRayRasterRenderSystem::~EngineSamplingRayRasterRenderSystem() {
-		vkDestroyPipelineLayout(this->appDevice.getLogicalDevice(), this->pipelineLayout, nullptr);
-	}
+	EngineSamplingRayRasterRenderSystem::~EngineSamplingRayRasterRenderSystem() {}
 
 	void EngineSamplingRayRasterRenderSystem::createPipelineLayout() {
-		VkPushConstantRange pushConstantRange{};
-		pushConstantRange.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-		pushConstantRange.offset = 0;
-		pushConstantRange.size = sizeof(RayTracePushConstant);
-
-		std::vector<VkDescriptorSetLayout> descSetLayouts = { this->descSetLayout->getDescriptorSetLayout() };
-
-		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descSetLayouts.size());
-		pipelineLayoutInfo.pSetLayouts = descSetLayouts.data();
-		pipelineLayoutInfo.pushConstantRangeCount = 1;
-		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
-
-		if (vkCreatePipelineLayout(this->appDevice.getLogicalDevice(), &pipelineLayoutInfo, nullptr, &this->pipelineLayout) != VK_SUCCESS) {
-			throw std::runtime_error("failed to create pipeline layout!");
-		}
+		this->pipelineLayout = 
+			EnginePipelineLayout::Builder(this->appDevice)
+				.addDescriptorSetLayout(this->descSetLayout)
+				.build();
 	}
 
 	void EngineSamplingRayRasterRenderSystem::createPipeline(VkRenderPass renderPass) {
 		assert(this->pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
 
-		this->pipeline = EngineGraphicPipeline::Builder(this->appDevice, this->pipelineLayout, renderPass)
+		this->pipeline = EngineGraphicPipeline::Builder(this->appDevice, this->pipelineLayout->getPipelineLayout(), renderPass)
 			.setDefault("shader/ray_trace_sampling.vert.spv", "shader/ray_trace_sampling.frag.spv")
 			.build();
 	}
@@ -75,11 +62,14 @@ namespace nugiEngine {
 		}
 	}
 
-	void EngineSamplingRayRasterRenderSystem::createDescriptor(std::shared_ptr<EngineDescriptorPool> descriptorPool, std::vector<std::shared_ptr<EngineImage>> computeStoreImages, uint32_t nSample) {
+	void EngineSamplingRayRasterRenderSystem::createDescriptor(std::shared_ptr<EngineDescriptorPool> descriptorPool, std::vector<std::shared_ptr<EngineImage>> computeStoreImages, 
+		std::vector<VkDescriptorBufferInfo> seedBuffersInfo) 
+	{
 		this->descSetLayout = 
 			EngineDescriptorSetLayout::Builder(this->appDevice)
 				.addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT)
-				.addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT, nSample)
+				.addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT)
+				.addBinding(2, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
 				.build();
 				
 		this->descriptorSets.clear();
@@ -90,22 +80,51 @@ namespace nugiEngine {
 			auto accumulateImage = this->accumulateImages[i];
 			auto accumulateImageInfo = accumulateImage->getDescriptorInfo(VK_IMAGE_LAYOUT_GENERAL);
 
-			std::vector<VkDescriptorImageInfo> computeStoreImageInfos;
-			for (uint32_t j = 0; j < nSample; j++) {
-				auto imageInfo = computeStoreImages[j + nSample * i]->getDescriptorInfo(VK_IMAGE_LAYOUT_GENERAL); 
-				computeStoreImageInfos.emplace_back(imageInfo);
-			}
+			auto computeStoreImageInfo = computeStoreImages[i]->getDescriptorInfo(VK_IMAGE_LAYOUT_GENERAL);
 
 			EngineDescriptorWriter(*this->descSetLayout, *descriptorPool)
 				.writeImage(0, &accumulateImageInfo)
-				.writeImage(1, computeStoreImageInfos.data(), nSample) 
+				.writeImage(1, &computeStoreImageInfo)
+				.writeBuffer(2, &seedBuffersInfo[i])
 				.build(descSet.get());
 
 			this->descriptorSets.emplace_back(descSet);
 		}
 	}
 
-	void EngineSamplingRayRasterRenderSystem::render(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex, std::shared_ptr<EngineModel> model, uint32_t randomSeed) {
+	void EngineSamplingRayRasterRenderSystem::resize(uint32_t width, uint32_t height, std::vector<std::shared_ptr<EngineImage>> computeStoreImages) {
+		this->createAccumulateImages(width, height);
+		this->writeImageDescriptors(computeStoreImages);
+	}
+
+	void EngineSamplingRayRasterRenderSystem::writeImageDescriptors(std::vector<std::shared_ptr<EngineImage>> computeStoreImages) {
+		for (uint32_t i = 0; i < EngineDevice::MAX_FRAMES_IN_FLIGHT; i++) {
+			auto accumulateImageInfo = this->accumulateImages[i]->getDescriptorInfo(VK_IMAGE_LAYOUT_GENERAL);
+			auto computeStoreImageInfo = computeStoreImages[i]->getDescriptorInfo(VK_IMAGE_LAYOUT_GENERAL);
+
+			EngineDescriptorWriter(*this->descSetLayout, *this->descriptorPool)
+				.writeImage(0, &accumulateImageInfo)
+				.writeImage(1, &computeStoreImageInfo)
+				.overwrite(this->descriptorSets[i].get());
+		}
+	}
+
+	void EngineSamplingRayRasterRenderSystem::reloadPipeline(std::shared_ptr<EngineFrameScheduler> frameScheduler, VkRenderPass renderPass) {
+		std::unique_ptr<EngineGraphicPipeline> oldPipeline = std::move(this->pipeline);
+
+		try {
+			this->createPipeline(renderPass);
+		} catch (const std::exception& e) {
+			std::cerr << "failed to reload pipeline: " << e.what() << std::endl;
+			this->pipeline = std::move(oldPipeline);
+			return;
+		}
+
+		std::shared_ptr<EngineGraphicPipeline> retiredPipeline = std::move(oldPipeline);
+		frameScheduler->deferDestroy([retiredPipeline]() mutable { retiredPipeline.reset(); });
+	}
+
+	void EngineSamplingRayRasterRenderSystem::render(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex, std::shared_ptr<EngineModel> model) {
 		this->pipeline->bind(commandBuffer->getCommandBuffer());
 
 		std::vector<VkDescriptorSet> descpSet = { *this->descriptorSets[frameIndex] };
@@ -113,7 +132,7 @@ namespace nugiEngine {
 		vkCmdBindDescriptorSets(
 			commandBuffer->getCommandBuffer(),
 			VK_PIPELINE_BIND_POINT_GRAPHICS,
-			this->pipelineLayout,
+			this->pipelineLayout->getPipelineLayout(),
 			0,
 			static_cast<uint32_t>(descpSet.size()),
 			descpSet.data(),
@@ -121,18 +140,6 @@ namespace nugiEngine {
 			nullptr
 		);
 
-		RayTracePushConstant pushConstant{};
-		pushConstant.randomSeed = randomSeed;
-
-		vkCmdPushConstants(
-			commandBuffer->getCommandBuffer(), 
-			this->pipelineLayout, 
-			VK_SHADER_STAGE_FRAGMENT_BIT,
-			0,
-			sizeof(RayTracePushConstant),
-			&pushConstant
-		);
-
 		model->bind(commandBuffer);
 		model->draw(commandBuffer);
 	}
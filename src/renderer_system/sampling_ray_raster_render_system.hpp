@@ -3,11 +3,13 @@
 #include "../command/command_buffer.hpp"
 #include "../camera/camera.hpp"
 #include "../device/device.hpp"
+#include "../pipeline/pipeline_layout.hpp"
 #include "../pipeline/graphic_pipeline.hpp"
 #include "../game_object/game_object.hpp"
 #include "../frame_info.hpp"
 #include "../buffer/buffer.hpp"
 #include "../descriptor/descriptor.hpp"
+#include "../frame_scheduler/frame_scheduler.hpp"
 #include "../globalUbo.hpp"
 
 #include <memory>
@@ -17,25 +19,36 @@ namespace nugiEngine {
 	class EngineSamplingRayRasterRenderSystem {
 		public:
 			EngineSamplingRayRasterRenderSystem(EngineDevice& device, std::shared_ptr<EngineDescriptorPool> descriptorPool,
-				uint32_t width, uint32_t height, std::vector<std::shared_ptr<EngineImage>> computeStoreImages, uint32_t nSample,
-				VkRenderPass renderPass);
+				uint32_t width, uint32_t height, std::vector<std::shared_ptr<EngineImage>> computeStoreImages,
+				std::vector<VkDescriptorBufferInfo> seedBuffersInfo, VkRenderPass renderPass);
 			~EngineSamplingRayRasterRenderSystem();
 
 			EngineSamplingRayRasterRenderSystem(const EngineSamplingRayRasterRenderSystem&) = delete;
 			EngineSamplingRayRasterRenderSystem& operator = (const EngineSamplingRayRasterRenderSystem&) = delete;
 
-			void render(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex, std::shared_ptr<EngineModel> model, uint32_t randomSeed = 1);
+			// recreates the accumulate images and points the descriptors to the new (resized) images,
+			// the pipeline stays valid as long as the new render pass is compatible with the old one
+			void resize(uint32_t width, uint32_t height, std::vector<std::shared_ptr<EngineImage>> computeStoreImages);
+
+			// builds the pipeline again from the (recompiled) shader, the old one is destroyed once no frame in flight uses it.
+			// If the new pipeline can not be created the old one is kept
+			void reloadPipeline(std::shared_ptr<EngineFrameScheduler> frameScheduler, VkRenderPass renderPass);
+
+			void render(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex, std::shared_ptr<EngineModel> model);
 		
 		private:
 			void createPipelineLayout();
 			void createPipeline(VkRenderPass renderPass);
 
 			void createAccumulateImages(uint32_t width, uint32_t height);
-			void createDescriptor(std::shared_ptr<EngineDescriptorPool> descriptorPool, std::vector<std::shared_ptr<EngineImage>> computeStoreImages, uint32_t nSample);
+			void createDescriptor(std::shared_ptr<EngineDescriptorPool> descriptorPool, std::vector<std::shared_ptr<EngineImage>> computeStoreImages, 
+				std::vector<VkDescriptorBufferInfo> seedBuffersInfo);
+			void writeImageDescriptors(std::vector<std::shared_ptr<EngineImage>> computeStoreImages);
 
 			EngineDevice& appDevice;
+			std::shared_ptr<EngineDescriptorPool> descriptorPool;
 			
-			VkPipelineLayout pipelineLayout;
+			std::shared_ptr<EnginePipelineLayout> pipelineLayout;
 			std::unique_ptr<EngineGraphicPipeline> pipeline;
 
 			std::shared_ptr<EngineDescriptorSetLayout> descSetLayout;
@@ -23,34 +23,20 @@ namespace nugiEngine {
 		this->createPipeline(renderPass);
 	}
 
-	EngineSimpleRenderSystem::~EngineSimpleRenderSystem() {
-		vkDestroyPipelineLayout(this->appDevice.getLogicalDevice(), this->pipelineLayout, nullptr);
-	}
+	EngineSimpleRenderSystem::~EngineSimpleRenderSystem() {}
 
 	void EngineSimpleRenderSystem::createPipelineLayout(VkDescriptorSetLayout globalDescSetLayout) {
-		VkPushConstantRange pushConstantRange{};
-		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-		pushConstantRange.offset = 0;
-		pushConstantRange.size = sizeof(SimplePushConstantData);
-
-		std::vector<VkDescriptorSetLayout> descriptorSetLayouts = { globalDescSetLayout };
-
-		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
-		pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
-		pipelineLayoutInfo.pushConstantRangeCount = 1;
-		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
-
-		if (vkCreatePipelineLayout(this->appDevice.getLogicalDevice(), &pipelineLayoutInfo, nullptr, &this->pipelineLayout) != VK_SUCCESS) {
-			throw std::runtime_error("failed to create pipeline layout!");
-		}
+		this->pipelineLayout = 
+			EnginePipelineLayout::Builder(this->appDevice)
+				.addDescriptorSetLayout(globalDescSetLayout)
+				.addPushConstantRange(VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(SimplePushConstantData))
+				.build();
 	}
 
 	void EngineSimpleRenderSystem::createPipeline(VkRenderPass renderPass) {
 		assert(this->pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
 
-		this->pipeline = EngineGraphicPipeline::Builder(this->appDevice, this->pipelineLayout, renderPass)
+		this->pipeline = EngineGraphicPipeline::Builder(this->appDevice, this->pipelineLayout->getPipelineLayout(), renderPass)
 			.setDefault("shader/simple_shader.vert.spv", "shader/simple_shader.frag.spv")
 			.build();
 	}
@@ -61,7 +47,7 @@ namespace nugiEngine {
 		vkCmdBindDescriptorSets(
 			commandBuffer->getCommandBuffer(),
 			VK_PIPELINE_BIND_POINT_GRAPHICS,
-			this->pipelineLayout,
+			this->pipelineLayout->getPipelineLayout(),
 			0,
 			1,
 			&UBODescSet,
@@ -70,7 +56,7 @@ namespace nugiEngine {
 		);
 
 		for (auto& obj : gameObjects) {
-			if (obj->textureDescSet != nullptr || obj->pointLights != nullptr) continue;
+			if (obj->textureIndex != EngineGameObject::NO_TEXTURE || obj->pointLights != nullptr) continue;
 			
 			SimplePushConstantData pushConstant{};
 
@@ -79,7 +65,7 @@ namespace nugiEngine {
 
 			vkCmdPushConstants(
 				commandBuffer->getCommandBuffer(), 
-				pipelineLayout, 
+				this->pipelineLayout->getPipelineLayout(), 
 				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
 				0,
 				sizeof(SimplePushConstantData),
@@ -3,6 +3,7 @@
 #include "../command/command_buffer.hpp"
 #include "../camera/camera.hpp"
 #include "../device/device.hpp"
+#include "../pipeline/pipeline_layout.hpp"
 #include "../pipeline/graphic_pipeline.hpp"
 #include "../game_object/game_object.hpp"
 #include "../frame_info.hpp"
@@ -30,7 +31,7 @@ namespace nugiEngine {
 
 			EngineDevice& appDevice;
 			
-			VkPipelineLayout pipelineLayout;
+			std::shared_ptr<EnginePipelineLayout> pipelineLayout;
 			std::unique_ptr<EngineGraphicPipeline> pipeline;
 	};
 }
\ No newline at end of file
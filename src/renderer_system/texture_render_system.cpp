@@ -13,98 +13,122 @@
 
 namespace nugiEngine {
 
-	struct SimplePushConstantData {
+	struct TexturePushConstantData {
 		glm::mat4 modelMatrix{1.0f};
-		glm::mat4 normalMatrix{1.0f};
+		glm::mat3x4 normalMatrix{1.0f};
+		uint32_t textureIndex = 0;
 	};
 
-	EngineTextureRenderSystem::EngineTextureRenderSystem(EngineDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalDescSetLayout) 
-		: appDevice{device} 
+	EngineTextureRenderSystem::EngineTextureRenderSystem(EngineDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalDescSetLayout, 
+		std::shared_ptr<EngineBindlessDescriptor> bindlessDescriptor, std::shared_ptr<EngineDescriptorPool> descriptorPool) 
+		: appDevice{device}, bindlessDescriptor{bindlessDescriptor}, descriptorPool{descriptorPool}
 	{
-		this->createDescriptor();
+		this->createDescriptorSetLayout();
 		this->createPipelineLayout(globalDescSetLayout);
 		this->createPipeline(renderPass);
 	}
 
-	EngineTextureRenderSystem::~EngineTextureRenderSystem() {
-		vkDestroyPipelineLayout(this->appDevice.getLogicalDevice(), this->pipelineLayout, nullptr);
-	}
+	EngineTextureRenderSystem::~EngineTextureRenderSystem() {}
+
+	void EngineTextureRenderSystem::createDescriptorSetLayout() {
+		if (this->bindlessDescriptor != nullptr) {
+			this->textureDescSetLayout = this->bindlessDescriptor->getDescriptorSetLayout();
+			return;
+		}
 
-	void EngineTextureRenderSystem::createDescriptor() {
 		this->textureDescSetLayout = 
 			EngineDescriptorSetLayout::Builder(this->appDevice)
-        .addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
+				.addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
 				.build();
 	}
 
 	void EngineTextureRenderSystem::createPipelineLayout(VkDescriptorSetLayout globalDescSetLayout) {
-		VkPushConstantRange pushConstantRange{};
-		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-		pushConstantRange.offset = 0;
-		pushConstantRange.size = sizeof(SimplePushConstantData);
-
-		std::vector<VkDescriptorSetLayout> descriptorSetLayouts = { globalDescSetLayout, this->textureDescSetLayout->getDescriptorSetLayout() };
-
-		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
-		pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
-		pipelineLayoutInfo.pushConstantRangeCount = 1;
-		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
-
-		if (vkCreatePipelineLayout(this->appDevice.getLogicalDevice(), &pipelineLayoutInfo, nullptr, &this->pipelineLayout) != VK_SUCCESS) {
-			throw std::runtime_error("failed to create pipeline layout!");
-		}
+		this->pipelineLayout = 
+			EnginePipelineLayout::Builder(this->appDevice)
+				.addDescriptorSetLayout(globalDescSetLayout)
+				.addDescriptorSetLayout(this->textureDescSetLayout)
+				.addPushConstantRange(VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(TexturePushConstantData))
+				.build();
 	}
 
 	void EngineTextureRenderSystem::createPipeline(VkRenderPass renderPass) {
 		assert(this->pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
 
-		this->pipeline = EngineGraphicPipeline::Builder(this->appDevice, this->pipelineLayout, renderPass)
-			.setDefault("shader/simple_texture_shader.vert.spv", "shader/simple_texture_shader.frag.spv")
+		// the single texture variant reads set 1 as one sampler instead of the bindless array
+		const char* fragmentShader = this->bindlessDescriptor != nullptr 
+			? "shader/simple_texture_shader.frag.spv" 
+			: "shader/simple_texture_shader_single.frag.spv";
+
+		this->pipeline = EngineGraphicPipeline::Builder(this->appDevice, this->pipelineLayout->getPipelineLayout(), renderPass)
+			.setDefault("shader/simple_texture_shader.vert.spv", fragmentShader)
 			.build();
 	}
 
-	std::shared_ptr<VkDescriptorSet> EngineTextureRenderSystem::setupTextureDescriptorSet(EngineDescriptorPool &descriptorPool, VkDescriptorImageInfo descImageInfo) {
-		std::shared_ptr<VkDescriptorSet> descSet = std::make_shared<VkDescriptorSet>();
+	uint32_t EngineTextureRenderSystem::registerTexture(VkDescriptorImageInfo descImageInfo) {
+		if (this->bindlessDescriptor != nullptr) {
+			return this->bindlessDescriptor->addSampledImage(descImageInfo);
+		}
 
-		EngineDescriptorWriter(*this->textureDescSetLayout, descriptorPool)
+		VkDescriptorSet descSet{};
+		bool isBuilt = EngineDescriptorWriter(*this->textureDescSetLayout, *this->descriptorPool)
 			.writeImage(0, &descImageInfo)
-			.build(descSet.get());
+			.build(&descSet);
 
-		return descSet;
+		if (!isBuilt) {
+			throw std::runtime_error("failed to allocate texture descriptor set!");
+		}
+
+		this->textureDescSets.emplace_back(descSet);
+		return static_cast<uint32_t>(this->textureDescSets.size() - 1);
 	}
 
 	void EngineTextureRenderSystem::render(std::shared_ptr<EngineCommandBuffer> commandBuffer, VkDescriptorSet &UBODescSet, FrameInfo &frameInfo, std::vector<std::shared_ptr<EngineGameObject>> &gameObjects) {
 		this->pipeline->bind(commandBuffer->getCommandBuffer());
 
+		// every texture lives in the one bindless set, it is bound once and the objects only differ by push constant.
+		// Without it the global set is bound here and the texture set per object
+		VkDescriptorSet descpSet[2] = { UBODescSet, this->bindlessDescriptor != nullptr ? this->bindlessDescriptor->getDescriptorSet() : VK_NULL_HANDLE };
+		uint32_t descSetCount = this->bindlessDescriptor != nullptr ? 2 : 1;
+
+		vkCmdBindDescriptorSets(
+			commandBuffer->getCommandBuffer(),
+			VK_PIPELINE_BIND_POINT_GRAPHICS,
+			this->pipelineLayout->getPipelineLayout(),
+			0,
+			descSetCount,
+			descpSet,
+			0,
+			nullptr
+		);
+
 		for (auto& obj : gameObjects) {
-			if (obj->textureDescSet == nullptr) continue;
-			
-			VkDescriptorSet descpSet[2] = { UBODescSet, *obj->textureDescSet };
-
-			vkCmdBindDescriptorSets(
-				commandBuffer->getCommandBuffer(),
-				VK_PIPELINE_BIND_POINT_GRAPHICS,
-				this->pipelineLayout,
-				0,
-				2,
-				descpSet,
-				0,
-				nullptr
-			);
+			if (obj->textureIndex == EngineGameObject::NO_TEXTURE) continue;
 
-			SimplePushConstantData pushConstant{};
+			TexturePushConstantData pushConstant{};
 
 			pushConstant.modelMatrix = obj->transform.mat4();
-			pushConstant.normalMatrix = obj->transform.normalMatrix();
+			pushConstant.normalMatrix = glm::mat3x4(obj->transform.normalMatrix());
+			pushConstant.textureIndex = obj->textureIndex;
+
+			if (this->bindlessDescriptor == nullptr) {
+				vkCmdBindDescriptorSets(
+					commandBuffer->getCommandBuffer(),
+					VK_PIPELINE_BIND_POINT_GRAPHICS,
+					this->pipelineLayout->getPipelineLayout(),
+					1,
+					1,
+					&this->textureDescSets[obj->textureIndex],
+					0,
+					nullptr
+				);
+			}
 
 			vkCmdPushConstants(
 				commandBuffer->getCommandBuffer(), 
-				this->pipelineLayout, 
+				this->pipelineLayout->getPipelineLayout(), 
 				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
 				0,
-				sizeof(SimplePushConstantData),
+				sizeof(TexturePushConstantData),
 				&pushConstant
 			);
 
@@ -3,11 +3,13 @@
 #include "../command/command_buffer.hpp"
 #include "../camera/camera.hpp"
 #include "../device/device.hpp"
+#include "../pipeline/pipeline_layout.hpp"
 #include "../pipeline/graphic_pipeline.hpp"
 #include "../game_object/game_object.hpp"
 #include "../frame_info.hpp"
 #include "../buffer/buffer.hpp"
 #include "../descriptor/descriptor.hpp"
+#include "../descriptor/bindless_descriptor.hpp"
 #include "../texture/texture.hpp"
 #include "../globalUbo.hpp"
 
@@ -15,27 +17,39 @@
 #include <vector>
 
 namespace nugiEngine {
+	/*
+	 * Draws textured game objects. With a bindless descriptor every texture is a slot of the one bindless set,
+	 * bound once per pass. Without one (no descriptor indexing on the device) each texture gets a descriptor set
+	 * of its own from the given pool, bound per object
+	 */
 	class EngineTextureRenderSystem {
 		public:
-			EngineTextureRenderSystem(EngineDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalDescSetLayout);
+			EngineTextureRenderSystem(EngineDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalDescSetLayout, 
+				std::shared_ptr<EngineBindlessDescriptor> bindlessDescriptor, std::shared_ptr<EngineDescriptorPool> descriptorPool);
 			~EngineTextureRenderSystem();
 
 			EngineTextureRenderSystem(const EngineTextureRenderSystem&) = delete;
 			EngineTextureRenderSystem& operator = (const EngineTextureRenderSystem&) = delete;
 			
-			std::shared_ptr<VkDescriptorSet> setupTextureDescriptorSet(EngineDescriptorPool &descriptorPool, VkDescriptorImageInfo descImageInfo);
+			// returns the index to be put into EngineGameObject::textureIndex
+			uint32_t registerTexture(VkDescriptorImageInfo descImageInfo);
 			void render(std::shared_ptr<EngineCommandBuffer> commandBuffer, VkDescriptorSet &UBODescSet, FrameInfo &frameInfo, std::vector<std::shared_ptr<EngineGameObject>> &gameObjects);
 
 		private:
-			void createDescriptor();
+			void createDescriptorSetLayout();
 			void createPipelineLayout(VkDescriptorSetLayout globalDescSetLayout);
 			void createPipeline(VkRenderPass renderPass);
 
 			EngineDevice& appDevice;
 			
-			VkPipelineLayout pipelineLayout;
+			std::shared_ptr<EnginePipelineLayout> pipelineLayout;
 			std::unique_ptr<EngineGraphicPipeline> pipeline;
 
+			std::shared_ptr<EngineBindlessDescriptor> bindlessDescriptor{};
+
+			// only used without a bindless descriptor
+			std::shared_ptr<EngineDescriptorPool> descriptorPool{};
 			std::shared_ptr<EngineDescriptorSetLayout> textureDescSetLayout{};
+			std::vector<VkDescriptorSet> textureDescSets{};
 	};
 }
\ No newline at end of file
@@ -8,15 +8,28 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 
+#include <iostream>
 #include <stdexcept>
 #include <array>
 #include <string>
 
 namespace nugiEngine {
 	EngineTraceRayRenderSystem::EngineTraceRayRenderSystem(EngineDevice& device, std::shared_ptr<EngineDescriptorPool> descriptorPool, 
-		uint32_t width, uint32_t height, uint32_t nSample, std::vector<VkDescriptorBufferInfo> buffersInfo) : appDevice{device}, width{width}, height{height}, nSample{nSample}
+		uint32_t width, uint32_t height, uint32_t nSample, std::vector<VkDescriptorBufferInfo> buffersInfo, RayTraceSceneAddress sceneAddress) 
+		: appDevice{device}, descriptorPool{descriptorPool}, width{width}, height{height}, nSample{nSample}, sceneAddress{sceneAddress}
 	{
+		this->usingDeviceAddress = this->appDevice.isBufferDeviceAddressSupported() && sceneAddress.objects != 0;
+
+		auto familyIndices = this->appDevice.getFamilyIndices();
+
+		// ownership transfers are only needed when the trace and the raster run on different queue families
+		if (familyIndices.computeFamily != familyIndices.graphicsFamily) {
+			this->computeFamily = familyIndices.computeFamily;
+			this->graphicsFamily = familyIndices.graphicsFamily;
+		}
+
 		this->createImageStorages();
+		this->initImageStorages();
 		this->createUniformBuffer();
 
 		this->createDescriptor(descriptorPool, buffersInfo);
@@ -25,35 +38,25 @@ namespace nugiEngine {
 		this->createPipeline();
 	}
 
-	EngineTraceRayRenderSystem::~EngineTraceRayRenderSystem() {
-		vkDestroyPipelineLayout(this->appDevice.getLogicalDevice(), this->pipelineLayout, nullptr);
-	}
+	EngineTraceRayRenderSystem::~EngineTraceRayRenderSystem() {}
 
 	void EngineTraceRayRenderSystem::createPipelineLayout() {
-		VkPushConstantRange pushConstantRange{};
-		pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-		pushConstantRange.offset = 0;
-		pushConstantRange.size = sizeof(RayTracePushConstant);
-
-		VkDescriptorSetLayout descriptorSetLayout = this->descSetLayout->getDescriptorSetLayout();
-
-		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		pipelineLayoutInfo.setLayoutCount = 1;
-		pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
-		pipelineLayoutInfo.pushConstantRangeCount = 1;
-		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
-
-		if (vkCreatePipelineLayout(this->appDevice.getLogicalDevice(), &pipelineLayoutInfo, nullptr, &this->pipelineLayout) != VK_SUCCESS) {
-			throw std::runtime_error("failed to create pipeline layout!");
+		auto pipelineLayoutBuilder = EnginePipelineLayout::Builder(this->appDevice);
+		pipelineLayoutBuilder.addDescriptorSetLayout(this->descSetLayout);
+
+		if (this->usingDeviceAddress) {
+			pipelineLayoutBuilder.addPushConstantRange(VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(RayTraceSceneAddress));
 		}
+
+		this->pipelineLayout = pipelineLayoutBuilder.build();
 	}
 
 	void EngineTraceRayRenderSystem::createPipeline() {
 		assert(this->pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
 
-		this->pipeline = EngineComputePipeline::Builder(this->appDevice, this->pipelineLayout)
-			.setDefault("shader/ray_trace_pbrt.comp.spv")
+		this->pipeline = EngineComputePipeline::Builder(this->appDevice, this->pipelineLayout->getPipelineLayout())
+			.setDefault(this->usingDeviceAddress ? "shader/ray_trace_pbrt_bda.comp.spv" : "shader/ray_trace_pbrt.comp.spv")
+			.setSpecializationConstant(0, this->nSample)
 			.build();
 	}
 
@@ -61,17 +64,39 @@ namespace nugiEngine {
 		this->storageImages.clear();
 
 		for (uint32_t i = 0; i < EngineDevice::MAX_FRAMES_IN_FLIGHT; i++) {
-			for (uint32_t j = 0; j < this->nSample; j++) {
-				auto storageImage = std::make_shared<EngineImage>(
-					this->appDevice, this->width, this->height, 
-					1, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_B8G8R8A8_UNORM, 
-					VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT, 
-					VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_ASPECT_COLOR_BIT
-				);
-
-				this->storageImages.emplace_back(storageImage);
-			}
+			auto storageImage = std::make_shared<EngineImage>(
+				this->appDevice, this->width, this->height, 
+				1, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_B8G8R8A8_UNORM, 
+				VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT, 
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_ASPECT_COLOR_BIT
+			);
+
+			this->storageImages.emplace_back(storageImage);
+		}
+	}
+
+	void EngineTraceRayRenderSystem::initImageStorages() {
+		// recorded command buffers always start by acquiring the image from the graphics queue, 
+		// so the first frame needs the image to be released by the graphics queue as well
+		auto commandBuffer = std::make_shared<EngineCommandBuffer>(this->appDevice);
+		commandBuffer->beginSingleTimeCommand();
+
+		for (auto &&storageImage : this->storageImages) {
+			storageImage->addTransition(commandBuffer, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL,
+				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+				0, VK_ACCESS_SHADER_READ_BIT);
 		}
+
+		commandBuffer->flushBarriers();
+
+		for (auto &&storageImage : this->storageImages) {
+			storageImage->addTransition(commandBuffer, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
+				VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 
+				VK_ACCESS_SHADER_READ_BIT, 0, this->graphicsFamily, this->computeFamily);
+		}
+
+		commandBuffer->endCommand();
+		commandBuffer->submitCommand(this->appDevice.getGraphicsQueue(0));
 	}
 
 	void EngineTraceRayRenderSystem::createUniformBuffer() {
@@ -89,60 +114,144 @@ namespace nugiEngine {
 			uniformBuffer->map();
 			this->uniformBuffers.emplace_back(uniformBuffer);
 		}
+
+		this->seedBuffers.clear();
+
+		for (uint32_t i = 0; i < EngineDevice::MAX_FRAMES_IN_FLIGHT; i++) {
+			auto seedBuffer = std::make_shared<EngineBuffer>(
+				this->appDevice,
+				sizeof(RayTraceSeedUbo),
+				1,
+				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+			);
+
+			seedBuffer->map();
+			this->seedBuffers.emplace_back(seedBuffer);
+		}
+	}
+
+	std::vector<VkDescriptorBufferInfo> EngineTraceRayRenderSystem::getSeedBuffersInfo() {
+		std::vector<VkDescriptorBufferInfo> buffersInfo{};
+		for (auto &&seedBuffer : this->seedBuffers) {
+			buffersInfo.emplace_back(seedBuffer->descriptorInfo());
+		}
+
+		return buffersInfo;
 	}
 
 	void EngineTraceRayRenderSystem::createDescriptor(std::shared_ptr<EngineDescriptorPool> descriptorPool, std::vector<VkDescriptorBufferInfo> buffersInfo) {
-		this->descSetLayout = 
-			EngineDescriptorSetLayout::Builder(this->appDevice)
-				.addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT, this->nSample)
-				.addBinding(1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+		auto descSetLayoutBuilder = EngineDescriptorSetLayout::Builder(this->appDevice);
+		descSetLayoutBuilder
+			.addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT)
+			.addBinding(1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+			.addBinding(6, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+
+		// the scene buffers are reached by their address instead
+		if (!this->usingDeviceAddress) {
+			descSetLayoutBuilder
 				.addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
 				.addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
 				.addBinding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
-				.addBinding(5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
-				.build();
+				.addBinding(5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+		}
+
+		this->descSetLayout = descSetLayoutBuilder.build();
 
 		this->descriptorSets.clear();
 		this->isFrameUpdated.clear();
 
 		for (uint32_t i = 0; i < EngineDevice::MAX_FRAMES_IN_FLIGHT; i++) {
 			auto descSet = std::make_shared<VkDescriptorSet>();
-			std::vector<VkDescriptorImageInfo> imageInfos{};
-
-			for (uint32_t j = 0; j < this->nSample; j++) {
-				auto imageInfo = this->storageImages[j + this->nSample * i]->getDescriptorInfo(VK_IMAGE_LAYOUT_GENERAL); 
-				imageInfos.emplace_back(imageInfo);
-			}
+			auto imageInfo = this->storageImages[i]->getDescriptorInfo(VK_IMAGE_LAYOUT_GENERAL);
 
 			auto uniformBuffer = this->uniformBuffers[i];
 			auto uniformBufferInfo = uniformBuffer->descriptorInfo();
+			auto seedBufferInfo = this->seedBuffers[i]->descriptorInfo();
 
-			EngineDescriptorWriter(*this->descSetLayout, *descriptorPool)
-				.writeImage(0, imageInfos.data(), this->nSample) 
+			auto descWriter = EngineDescriptorWriter(*this->descSetLayout, *descriptorPool);
+			descWriter
+				.writeImage(0, &imageInfo)
 				.writeBuffer(1, &uniformBufferInfo)
-				.writeBuffer(2, &buffersInfo[0])
-				.writeBuffer(3, &buffersInfo[1])
-				.writeBuffer(4, &buffersInfo[2])
-				.writeBuffer(5, &buffersInfo[3])
-				.build(descSet.get());
+				.writeBuffer(6, &seedBufferInfo);
+
+			if (!this->usingDeviceAddress) {
+				descWriter
+					.writeBuffer(2, &buffersInfo[0])
+					.writeBuffer(3, &buffersInfo[1])
+					.writeBuffer(4, &buffersInfo[2])
+					.writeBuffer(5, &buffersInfo[3]);
+			}
+
+			descWriter.build(descSet.get());
 
 			this->descriptorSets.emplace_back(descSet);
 			this->isFrameUpdated.emplace_back(false);
 		}
 	}
 
+	void EngineTraceRayRenderSystem::resize(uint32_t width, uint32_t height) {
+		this->width = width;
+		this->height = height;
+
+		this->createImageStorages();
+		this->initImageStorages();
+		this->writeImageDescriptors();
+
+		for (uint32_t i = 0; i < EngineDevice::MAX_FRAMES_IN_FLIGHT; i++) {
+			this->isFrameUpdated[i] = false;
+		}
+	}
+
+	void EngineTraceRayRenderSystem::writeImageDescriptors() {
+		for (uint32_t i = 0; i < EngineDevice::MAX_FRAMES_IN_FLIGHT; i++) {
+			auto imageInfo = this->storageImages[i]->getDescriptorInfo(VK_IMAGE_LAYOUT_GENERAL);
+
+			EngineDescriptorWriter(*this->descSetLayout, *this->descriptorPool)
+				.writeImage(0, &imageInfo)
+				.overwrite(this->descriptorSets[i].get());
+		}
+	}
+
+	void EngineTraceRayRenderSystem::setSceneAddress(RayTraceSceneAddress sceneAddress) {
+		assert(this->usingDeviceAddress && "Scene address can only be swapped in device address mode");
+		this->sceneAddress = sceneAddress;
+	}
+
 	void EngineTraceRayRenderSystem::writeGlobalData(uint32_t frameIndex, RayTraceUbo ubo) {
 		this->uniformBuffers[frameIndex]->writeToBuffer(&ubo);
 		this->uniformBuffers[frameIndex]->flush();
 	}
 
-	void EngineTraceRayRenderSystem::render(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t imageIndex, uint32_t randomSeed) {
+	void EngineTraceRayRenderSystem::writeRandomSeed(uint32_t frameIndex, uint32_t randomSeed) {
+		RayTraceSeedUbo seedUbo{};
+		seedUbo.randomSeed = randomSeed;
+
+		this->seedBuffers[frameIndex]->writeToBuffer(&seedUbo);
+	}
+
+	void EngineTraceRayRenderSystem::reloadPipeline(std::shared_ptr<EngineFrameScheduler> frameScheduler) {
+		std::unique_ptr<EngineComputePipeline> oldPipeline = std::move(this->pipeline);
+
+		try {
+			this->createPipeline();
+		} catch (const std::exception& e) {
+			std::cerr << "failed to reload pipeline: " << e.what() << std::endl;
+			this->pipeline = std::move(oldPipeline);
+			return;
+		}
+
+		std::shared_ptr<EngineComputePipeline> retiredPipeline = std::move(oldPipeline);
+		frameScheduler->deferDestroy([retiredPipeline]() mutable { retiredPipeline.reset(); });
+	}
+
+	void EngineTraceRayRenderSystem::render(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t imageIndex) {
 		this->pipeline->bind(commandBuffer->getCommandBuffer());
 
 		vkCmdBindDescriptorSets(
 			commandBuffer->getCommandBuffer(),
 			VK_PIPELINE_BIND_POINT_COMPUTE,
-			this->pipelineLayout,
+			this->pipelineLayout->getPipelineLayout(),
 			0,
 			1,
 			this->descriptorSets[imageIndex].get(),
@@ -150,67 +259,54 @@ namespace nugiEngine {
 			nullptr
 		);
 
-		RayTracePushConstant pushConstant{};
-		pushConstant.randomSeed = randomSeed;
-
-		vkCmdPushConstants(
-			commandBuffer->getCommandBuffer(), 
-			this->pipelineLayout, 
-			VK_SHADER_STAGE_COMPUTE_BIT,
-			0,
-			sizeof(RayTracePushConstant),
-			&pushConstant
-		);
+		if (this->usingDeviceAddress) {
+			vkCmdPushConstants(
+				commandBuffer->getCommandBuffer(),
+				this->pipelineLayout->getPipelineLayout(),
+				VK_SHADER_STAGE_COMPUTE_BIT,
+				0,
+				sizeof(RayTraceSceneAddress),
+				&this->sceneAddress
+			);
+		}
 
-		this->pipeline->dispatch(commandBuffer->getCommandBuffer(), this->width / 8, this->height / 8, this->nSample / 2);
+		this->pipeline->dispatch(commandBuffer->getCommandBuffer(), this->width / 8, this->height / 8, 1);
 	}
 
 	bool EngineTraceRayRenderSystem::prepareFrame(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex) {
-		std::vector<std::shared_ptr<EngineImage>> selectedImages;
-		for (uint32_t i = this->nSample * frameIndex; i < (this->nSample * frameIndex) + this->nSample; i++) {
-			selectedImages.emplace_back(this->storageImages[i]);
-		}
+		// acquire the image back from the graphics queue which released it in finishFrame (or in initImageStorages)
+		bool isRecorded = this->storageImages[frameIndex]->addTransition(commandBuffer, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0, VK_ACCESS_SHADER_WRITE_BIT, this->graphicsFamily, this->computeFamily);
 
-		if (selectedImages[0]->getLayout() == VK_IMAGE_LAYOUT_UNDEFINED) {
-			EngineImage::transitionImageLayout(selectedImages, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL,
-				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-				0, VK_ACCESS_SHADER_WRITE_BIT, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
-				commandBuffer);
-		} else {
-			EngineImage::transitionImageLayout(selectedImages, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
-				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-				0, VK_ACCESS_SHADER_WRITE_BIT, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
-				commandBuffer);
-		}
-
-		return true;
+		commandBuffer->flushBarriers();
+		return isRecorded;
 	}
 
 	bool EngineTraceRayRenderSystem::transferFrame(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex) {
-		std::vector<std::shared_ptr<EngineImage>> selectedImages;
-		for (uint32_t i = this->nSample * frameIndex; i < (this->nSample * frameIndex) + this->nSample; i++) {
-			selectedImages.emplace_back(this->storageImages[i]);
-		}
+		bool isRecorded = this->storageImages[frameIndex]->addTransition(commandBuffer, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 
+			VK_ACCESS_SHADER_WRITE_BIT, 0, this->computeFamily, this->graphicsFamily);
 
-		EngineImage::transitionImageLayout(selectedImages, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
-			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 
-			VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
-			commandBuffer);
+		commandBuffer->flushBarriers();
+		return isRecorded;
+	}
+
+	bool EngineTraceRayRenderSystem::receiveFrame(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex) {
+		bool isRecorded = this->storageImages[frameIndex]->addTransition(commandBuffer, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
+			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 
+			0, VK_ACCESS_SHADER_READ_BIT, this->computeFamily, this->graphicsFamily);
 
-		return true;
+		commandBuffer->flushBarriers();
+		return isRecorded;
 	}
 
 	bool EngineTraceRayRenderSystem::finishFrame(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex) {
-		std::vector<std::shared_ptr<EngineImage>> selectedImages;
-		for (uint32_t i = this->nSample * frameIndex; i < (this->nSample * frameIndex) + this->nSample; i++) {
-			selectedImages.emplace_back(this->storageImages[i]);
-		}
-
-		EngineImage::transitionImageLayout(selectedImages, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
+		bool isRecorded = this->storageImages[frameIndex]->addTransition(commandBuffer, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
 			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 
-			VK_ACCESS_SHADER_READ_BIT, 0, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
-			commandBuffer);
+			VK_ACCESS_SHADER_READ_BIT, 0, this->graphicsFamily, this->computeFamily);
 
-		return true;
+		commandBuffer->flushBarriers();
+		return isRecorded;
 	}
 }
\ No newline at end of file
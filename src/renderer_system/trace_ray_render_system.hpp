@@ -3,11 +3,13 @@
 #include "../command/command_buffer.hpp"
 #include "../camera/camera.hpp"
 #include "../device/device.hpp"
+#include "../pipeline/pipeline_layout.hpp"
 #include "../pipeline/compute_pipeline.hpp"
 #include "../game_object/game_object.hpp"
 #include "../frame_info.hpp"
 #include "../buffer/buffer.hpp"
 #include "../descriptor/descriptor.hpp"
+#include "../frame_scheduler/frame_scheduler.hpp"
 #include "../frame_info.hpp"
 #include "../ray_ubo.hpp"
 
@@ -17,8 +19,10 @@
 namespace nugiEngine {
 	class EngineTraceRayRenderSystem {
 		public:
+			// with a non-zero sceneAddress the scene is read through buffer device addresses and buffersInfo is not used
 			EngineTraceRayRenderSystem(EngineDevice& device, std::shared_ptr<EngineDescriptorPool> descriptorPool, 
-				uint32_t width, uint32_t height, uint32_t nSample, std::vector<VkDescriptorBufferInfo> buffersInfo);
+				uint32_t width, uint32_t height, uint32_t nSample, std::vector<VkDescriptorBufferInfo> buffersInfo, 
+				RayTraceSceneAddress sceneAddress = {});
 			~EngineTraceRayRenderSystem();
 
 			EngineTraceRayRenderSystem(const EngineTraceRayRenderSystem&) = delete;
@@ -27,13 +31,29 @@ namespace nugiEngine {
 			std::shared_ptr<EngineDescriptorSetLayout> getDescSetLayout() { return this->descSetLayout; }
 			std::shared_ptr<VkDescriptorSet> getDescriptorSets(uint32_t index) { return this->descriptorSets[index]; }
 			std::vector<std::shared_ptr<EngineImage>> getStorageImages() { return this->storageImages; }
+			std::vector<VkDescriptorBufferInfo> getSeedBuffersInfo();
 			bool getFramesUpdated(uint32_t index) const { return this->isFrameUpdated[index]; }
 
+			// only the storage images and the descriptors pointing to them depend on the size,
+			// the pipeline, its layout and the descriptor sets themselves are kept
+			void resize(uint32_t width, uint32_t height);
+
+			// swaps the scene buffers without touching any descriptor, only in device address mode.
+			// Takes effect on the next recorded command buffer
+			void setSceneAddress(RayTraceSceneAddress sceneAddress);
+			bool isUsingDeviceAddress() const { return this->usingDeviceAddress; }
+
 			void writeGlobalData(uint32_t frameIndex, RayTraceUbo ubo);
-			void render(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex, uint32_t randomSeed = 1);
+			void writeRandomSeed(uint32_t frameIndex, uint32_t randomSeed);
+			// builds the pipeline again from the (recompiled) shader, the old one is destroyed once no frame in flight uses it.
+			// If the new pipeline can not be created the old one is kept
+			void reloadPipeline(std::shared_ptr<EngineFrameScheduler> frameScheduler);
+
+			void render(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex);
 
 			bool prepareFrame(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex);
 			bool transferFrame(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex);
+			bool receiveFrame(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex);
 			bool finishFrame(std::shared_ptr<EngineCommandBuffer> commandBuffer, uint32_t frameIndex);
 
 			std::vector<bool> isFrameUpdated;
@@ -44,20 +64,28 @@ namespace nugiEngine {
 
 			void createUniformBuffer();
 			void createImageStorages();
+			void initImageStorages();
 
 			void createDescriptor(std::shared_ptr<EngineDescriptorPool> descriptorPool, std::vector<VkDescriptorBufferInfo> buffersInfo);
+			void writeImageDescriptors();
 
 			EngineDevice& appDevice;
 
+			std::shared_ptr<EngineDescriptorPool> descriptorPool;
 			std::shared_ptr<EngineDescriptorSetLayout> descSetLayout;
 			std::vector<std::shared_ptr<VkDescriptorSet>> descriptorSets;
 
 			std::vector<std::shared_ptr<EngineBuffer>> uniformBuffers;
+			std::vector<std::shared_ptr<EngineBuffer>> seedBuffers;
 			std::vector<std::shared_ptr<EngineImage>> storageImages;
 			
-			VkPipelineLayout pipelineLayout;
+			std::shared_ptr<EnginePipelineLayout> pipelineLayout;
 			std::unique_ptr<EngineComputePipeline> pipeline;
 
 			uint32_t width, height, nSample;
+
+			bool usingDeviceAddress = false;
+			RayTraceSceneAddress sceneAddress{};
+			uint32_t computeFamily = VK_QUEUE_FAMILY_IGNORED, graphicsFamily = VK_QUEUE_FAMILY_IGNORED;
 	};
 }
\ No newline at end of file
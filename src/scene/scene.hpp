@@ -0,0 +1,15 @@
+#pragma once
+
+#include "../model/ray_trace_model_data.hpp"
+#include "../ray_ubo.hpp"
+
+#include <cstdint>
+
+namespace nugiEngine {
+	// the Cornell box rendered by the app, shared by the Vulkan and the CPU renderers
+	RayTraceModelData createCornellBoxScene();
+	RayTraceUbo createCornellBoxCamera(uint32_t width, uint32_t height);
+
+	// pinhole camera in the layout the trace shader reads, vfov in degrees
+	RayTraceUbo createCamera(glm::vec3 lookFrom, glm::vec3 lookAt, glm::vec3 vup, float vfov, uint32_t width, uint32_t height);
+} // namespace nugiEngine
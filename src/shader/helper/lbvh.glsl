@@ -0,0 +1,104 @@
+// shared by the lbvh_*.comp kernels of EngineGpuBvhBuilder. Every kernel sees the same set layout:
+// set 0 reads its codes from binding 3 - 4 and writes to binding 5 - 6, set 1 has the two pairs swapped,
+// so the radix sort passes alternate between the sets
+
+#define LBVH_GROUP_SIZE 256
+#define LBVH_RADIX 256
+
+struct Triangle {
+  vec3 point0;
+  vec3 point1;
+  vec3 point2;
+};
+
+struct Object {
+  Triangle triangle;
+  uint materialType;
+  uint materialIndex;
+};
+
+struct BvhNode {
+  int leftNode;
+  int rightNode;
+  int leftObjIndex;
+  int rightObjIndex;
+
+  vec3 maximum;
+  vec3 minimum;
+};
+
+layout(set = 0, binding = 0) buffer readonly ObjectSsbo {
+  Object objects[];
+};
+
+// the buffer the trace shader binds, written in place
+layout(set = 0, binding = 1) coherent buffer BvhSsbo {
+  BvhNode bvhNodes[];
+};
+
+// centroid bounds as order preserving uints: min xyz, then max xyz
+layout(set = 0, binding = 2) buffer BoundsSsbo {
+  uint bounds[6];
+};
+
+layout(set = 0, binding = 3) buffer InputKeySsbo {
+  uint inputKeys[];
+};
+
+layout(set = 0, binding = 4) buffer InputValueSsbo {
+  uint inputValues[];
+};
+
+layout(set = 0, binding = 5) buffer OutputKeySsbo {
+  uint outputKeys[];
+};
+
+layout(set = 0, binding = 6) buffer OutputValueSsbo {
+  uint outputValues[];
+};
+
+// digit major: the count of digit d in tile t is at d * tileCount + t
+layout(set = 0, binding = 7) buffer HistogramSsbo {
+  uint histogram[];
+};
+
+layout(set = 0, binding = 8) buffer ParentSsbo {
+  int parents[];
+};
+
+layout(set = 0, binding = 9) coherent buffer ArrivalSsbo {
+  uint arrivals[];
+};
+
+layout(push_constant) uniform LbvhPush {
+  uint objectCount;
+  uint shift;
+  uint tileCount;
+} push;
+
+// the same padding objectBoundingBox adds on the CPU, so flat triangles get a volume
+const vec3 LBVH_EPS = vec3(0.0001);
+
+vec3 objectMinimum(uint objIndex) {
+  Triangle triangle = objects[objIndex].triangle;
+  return min(min(triangle.point0, triangle.point1), triangle.point2) - LBVH_EPS;
+}
+
+vec3 objectMaximum(uint objIndex) {
+  Triangle triangle = objects[objIndex].triangle;
+  return max(max(triangle.point0, triangle.point1), triangle.point2) + LBVH_EPS;
+}
+
+vec3 objectCentroid(uint objIndex) {
+  return (objectMinimum(objIndex) + objectMaximum(objIndex)) * 0.5;
+}
+
+// flips the float bits so unsigned comparison matches float comparison, for atomicMin / atomicMax
+uint floatToOrderedUint(float value) {
+  uint bits = floatBitsToUint(value);
+  return (bits & 0x80000000u) != 0u ? ~bits : bits | 0x80000000u;
+}
+
+float orderedUintToFloat(uint value) {
+  return uintBitsToFloat((value & 0x80000000u) != 0u ? value & 0x7FFFFFFFu : ~value);
+}
@@ -12,11 +12,15 @@ float stepAndOutputRNGFloat(inout uint rngState) {
   return float(word) / 4294967295.0;
 }
 
-uvec2 imgSize = uvec2(imageSize(targetImage[0]));
+#ifndef RANDOM_SEED
+#define RANDOM_SEED push.randomSeed
+#endif
 
-uint rngStateXY =  (imgSize.x * gl_GlobalInvocationID.x + gl_GlobalInvocationID.y) * (push.randomSeed + 1);
-uint rngStateXZ =  (imgSize.x * gl_GlobalInvocationID.x + gl_GlobalInvocationID.z) * (push.randomSeed + 1);
-uint rngStateYZ =  (imgSize.y * gl_GlobalInvocationID.y + gl_GlobalInvocationID.z) * (push.randomSeed + 1);
+uvec2 imgSize = gl_NumWorkGroups.xy * gl_WorkGroupSize.xy;
+
+uint rngStateXY =  (imgSize.x * gl_GlobalInvocationID.x + gl_GlobalInvocationID.y) * (RANDOM_SEED + 1);
+uint rngStateXZ =  (imgSize.x * gl_GlobalInvocationID.x + gl_GlobalInvocationID.z) * (RANDOM_SEED + 1);
+uint rngStateYZ =  (imgSize.y * gl_GlobalInvocationID.y + gl_GlobalInvocationID.z) * (RANDOM_SEED + 1);
 
 float randomFloat(uint index) {
   float randNum = 0.0;
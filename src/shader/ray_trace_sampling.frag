@@ -2,29 +2,22 @@
 
 // ------------- layout ------------- 
 
-#define NSAMPLE 4
-
 layout(origin_upper_left) in vec4 gl_FragCoord;
 layout(location = 0) out vec4 outColor;
 
 layout(set = 0, binding = 0, rgba8) uniform image2D accumulateImage;
-layout(set = 0, binding = 1, rgba8) uniform readonly image2D inputImage[NSAMPLE];
+layout(set = 0, binding = 1, rgba8) uniform readonly image2D inputImage;
 
-layout(push_constant) uniform Push {
+layout(set = 0, binding = 2) uniform readonly SeedUbo {
   uint randomSeed;
-} push;
+} seed;
 
 void main() {
   vec4 accColor = imageLoad(accumulateImage, ivec2(gl_FragCoord.xy));
-  vec4 totalColor = vec4(0.0, 0.0, 0.0, 0.0);
-
-  for (uint i = 0; i < NSAMPLE; i++) {
-    vec4 imgColor = imageLoad(inputImage[i], ivec2(gl_FragCoord.xy));
-    totalColor += clamp(imgColor, 0.0, 1.0);
-  }
+  vec4 totalColor = imageLoad(inputImage, ivec2(gl_FragCoord.xy));
 
-  totalColor = totalColor / NSAMPLE; // sqrt(totalColor / NSAMPLE);
-  totalColor = (totalColor + accColor * push.randomSeed) / (push.randomSeed + 1.0);
+  // samples are already averaged by the trace pass
+  totalColor = (totalColor + accColor * seed.randomSeed) / (seed.randomSeed + 1.0);
 
   imageStore(accumulateImage, ivec2(gl_FragCoord.xy), totalColor);
   outColor = totalColor;
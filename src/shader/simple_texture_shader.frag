@@ -1,5 +1,9 @@
 #version 450
 
+#ifndef NO_BINDLESS
+#extension GL_EXT_nonuniform_qualifier : require
+#endif
+
 layout(location = 0) in vec3 fragColor;
 layout(location = 1) in vec3 fragPosWorld;
 layout(location = 2) in vec3 fragNormalWorld;
@@ -24,11 +28,18 @@ layout(set = 0, binding = 1) uniform GlobalLight {
     int numLights;
 } globalLight;
 
-layout(set = 1, binding = 0) uniform sampler2D texSampler;
+#ifdef NO_BINDLESS
+// one descriptor set per texture, for devices without descriptor indexing
+layout(set = 1, binding = 0) uniform sampler2D textureSampler;
+#else
+// bindless descriptor, see EngineBindlessDescriptor
+layout(set = 1, binding = 0) uniform sampler2D textures[];
+#endif
 
 layout(push_constant) uniform Push {
     mat4 modelMatrix;
-    mat4 normalMatrix;
+    mat3x4 normalMatrix;
+    uint textureIndex;
 } push;
 
 void main() {
@@ -61,5 +72,9 @@ void main() {
 
     vec4 finalLightColor = vec4(diffuseLight * fragColor + specularLight * fragColor, 1.0);
 
-    outColor = finalLightColor * texture(texSampler, fragTexCoord);
+#ifdef NO_BINDLESS
+    outColor = finalLightColor * texture(textureSampler, fragTexCoord);
+#else
+    outColor = finalLightColor * texture(textures[push.textureIndex], fragTexCoord);
+#endif
 }
\ No newline at end of file
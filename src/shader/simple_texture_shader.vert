@@ -29,7 +29,8 @@ layout(set = 0, binding = 1) uniform GlobalLight {
 
 layout(push_constant) uniform Push {
     mat4 modelMatrix;
-    mat4 normalMatrix;
+    mat3x4 normalMatrix;
+    uint textureIndex;
 } push;
 
 void main() {
@@ -0,0 +1,89 @@
+#include "shader_library.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace nugiEngine {
+	namespace {
+		// generated by tools/embed_shaders.py. Every build that compiles this file generates it first,
+		// a tree without it must not quietly go back to reading every .spv from disk. It is looked up on the include
+		// path only (the CMake build directory or src/shader_library for make), so a stale copy next to this file can't win
+#if !__has_include(<embedded_shaders.inc>)
+#error "embedded_shaders.inc is missing, run tools/embed_shaders.py (make shaders) or build through CMake"
+#endif
+#include <embedded_shaders.inc>
+
+		std::unordered_set<std::string> overriddenPaths;
+		std::mutex overrideMutex;
+	}
+
+	EngineShaderLibrary::ShaderCode EngineShaderLibrary::getShaderCode(const std::string& spirvPath) {
+		ShaderCode shaderCode{};
+
+		if (!EngineShaderLibrary::isOverridden(spirvPath)) {
+			if (auto embeddedShader = EngineShaderLibrary::findEmbeddedShader(spirvPath)) {
+				shaderCode.code = embeddedShader->code;
+				shaderCode.codeSize = embeddedShader->codeSize;
+
+				return shaderCode;
+			}
+		}
+
+		shaderCode.fileData = EngineShaderLibrary::readFile(spirvPath);
+		shaderCode.code = shaderCode.fileData.data();
+		shaderCode.codeSize = shaderCode.fileData.size() * sizeof(uint32_t);
+
+		return shaderCode;
+	}
+
+	const EmbeddedShader* EngineShaderLibrary::findEmbeddedShader(const std::string& spirvPath) {
+		auto first = std::begin(embeddedShaders);
+		auto last = std::end(embeddedShaders);
+
+		auto shader = std::lower_bound(first, last, spirvPath, [](const EmbeddedShader& embeddedShader, const std::string& path) {
+			return std::strcmp(embeddedShader.path, path.c_str()) < 0;
+		});
+
+		if (shader == last || shader->code == nullptr || spirvPath != shader->path) {
+			return nullptr;
+		}
+
+		return shader;
+	}
+
+	void EngineShaderLibrary::overrideWithFile(const std::string& spirvPath) {
+		std::lock_guard<std::mutex> lock{overrideMutex};
+		overriddenPaths.emplace(spirvPath);
+	}
+
+	bool EngineShaderLibrary::isOverridden(const std::string& spirvPath) {
+		std::lock_guard<std::mutex> lock{overrideMutex};
+		return overriddenPaths.find(spirvPath) != overriddenPaths.end();
+	}
+
+	std::vector<uint32_t> EngineShaderLibrary::readFile(const std::string& spirvPath) {
+		std::ifstream file{spirvPath, std::ios::ate | std::ios::binary};
+
+		if (!file.is_open()) {
+			throw std::runtime_error("failed to open file: " + spirvPath);
+		}
+
+		size_t fileSize = static_cast<size_t>(file.tellg());
+		if (fileSize % sizeof(uint32_t) != 0) {
+			throw std::runtime_error("invalid SPIR-V module: " + spirvPath);
+		}
+
+		std::vector<uint32_t> buffer(fileSize / sizeof(uint32_t));
+
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(buffer.data()), fileSize);
+
+		file.close();
+		return buffer;
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace nugiEngine {
+	struct EmbeddedShader {
+		const char* path;
+		const uint32_t* code;
+		size_t codeSize;
+	};
+
+	/*
+	 * Looks up SPIR-V modules by the path they would be loaded from (e.g. "shader/ray_trace_pbrt.comp.spv").
+	 * The modules are compiled into the binary by tools/embed_shaders.py, so no file is read at startup.
+	 * A path is only read from disk when it is not embedded or when the hot reloader has replaced it
+	 */
+	class EngineShaderLibrary {
+		public:
+			struct ShaderCode {
+				const uint32_t* code = nullptr;
+				size_t codeSize = 0;
+
+				// owns the module when it was read from disk
+				std::vector<uint32_t> fileData;
+			};
+
+			static ShaderCode getShaderCode(const std::string& spirvPath);
+			static const EmbeddedShader* findEmbeddedShader(const std::string& spirvPath);
+
+			// called once a newer module has been written to spirvPath, later loads read it instead of the embedded copy
+			static void overrideWithFile(const std::string& spirvPath);
+
+		private:
+			static bool isOverridden(const std::string& spirvPath);
+			static std::vector<uint32_t> readFile(const std::string& spirvPath);
+	};
+}
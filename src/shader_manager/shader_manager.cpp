@@ -0,0 +1,302 @@
+#include "shader_manager.hpp"
+
+#include "../shader_library/shader_library.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unordered_set>
+
+#ifdef NUGI_WITH_SHADERC
+#include <shaderc/shaderc.hpp>
+#endif
+
+namespace nugiEngine {
+	namespace {
+		// the file named by an #include "..." line, or an empty string for any other line
+		std::string parseInclude(const std::string& line) {
+			auto start = line.find_first_not_of(" \t");
+			if (start == std::string::npos || line.compare(start, 8, "#include") != 0) {
+				return "";
+			}
+
+			auto openQuote = line.find('"', start + 8);
+			auto closeQuote = openQuote == std::string::npos ? std::string::npos : line.find('"', openQuote + 1);
+
+			if (closeQuote == std::string::npos) {
+				return "";
+			}
+
+			return line.substr(openQuote + 1, closeQuote - openQuote - 1);
+		}
+
+		std::string resolveInclude(const std::string& requestedPath, const std::string& requestingPath) {
+			return (std::filesystem::path(requestingPath).parent_path() / requestedPath).lexically_normal().string();
+		}
+
+	#ifdef NUGI_WITH_SHADERC
+		// resolves #include "..." relative to the file containing it, the same way glslc does
+		class FileIncluder : public shaderc::CompileOptions::IncluderInterface {
+			public:
+				shaderc_include_result* GetInclude(const char* requestedSource, shaderc_include_type type, 
+					const char* requestingSource, size_t includeDepth) override 
+				{
+					auto includedFile = new IncludedFile{};
+					includedFile->path = resolveInclude(requestedSource, requestingSource);
+
+					std::ifstream file{includedFile->path};
+					if (file.is_open()) {
+						std::stringstream contentStream;
+						contentStream << file.rdbuf();
+
+						includedFile->content = contentStream.str();
+						includedFile->result.source_name = includedFile->path.c_str();
+						includedFile->result.source_name_length = includedFile->path.size();
+					} else {
+						// an empty source name tells shaderc the include failed, the content is the error message
+						includedFile->content = "can not open " + includedFile->path;
+						includedFile->result.source_name = "";
+						includedFile->result.source_name_length = 0;
+					}
+
+					includedFile->result.content = includedFile->content.c_str();
+					includedFile->result.content_length = includedFile->content.size();
+					includedFile->result.user_data = includedFile;
+
+					return &includedFile->result;
+				}
+
+				void ReleaseInclude(shaderc_include_result* includeResult) override {
+					delete static_cast<IncludedFile*>(includeResult->user_data);
+				}
+
+			private:
+				struct IncludedFile {
+					std::string path;
+					std::string content;
+					shaderc_include_result result;
+				};
+		};
+	#endif
+	}
+
+	EngineShaderManager::EngineShaderManager(std::chrono::milliseconds pollInterval) : pollInterval{pollInterval} {
+		this->watchThread = std::thread(&EngineShaderManager::run, this);
+	}
+
+	EngineShaderManager::~EngineShaderManager() {
+		{
+			std::lock_guard<std::mutex> lock(this->shaderMutex);
+			this->isRunning = false;
+		}
+
+		this->stopCondition.notify_all();
+		this->watchThread.join();
+	}
+
+	bool EngineShaderManager::getLastWriteTime(const std::string& path, std::filesystem::file_time_type& lastWriteTime) {
+		std::error_code errorCode;
+		lastWriteTime = std::filesystem::last_write_time(path, errorCode);
+
+		return !errorCode;
+	}
+
+	std::vector<std::string> EngineShaderManager::collectDependencies(const std::string& sourcePath) {
+		std::vector<std::string> dependencyPaths{ sourcePath };
+		std::unordered_set<std::string> visitedPaths{ sourcePath };
+
+		// the list grows while it is walked, every newly found include is scanned for includes of its own
+		for (size_t i = 0; i < dependencyPaths.size(); i++) {
+			std::ifstream file{dependencyPaths[i]};
+			std::string line;
+
+			while (std::getline(file, line)) {
+				auto includePath = parseInclude(line);
+				if (includePath.empty()) {
+					continue;
+				}
+
+				auto resolvedPath = resolveInclude(includePath, dependencyPaths[i]);
+				if (visitedPaths.insert(resolvedPath).second) {
+					dependencyPaths.emplace_back(resolvedPath);
+				}
+			}
+		}
+
+		return dependencyPaths;
+	}
+
+	std::vector<std::filesystem::file_time_type> EngineShaderManager::getLastWriteTimes(const std::vector<std::string>& paths) {
+		// a missing file keeps the default time, it shows up as a change once it exists again
+		std::vector<std::filesystem::file_time_type> lastWriteTimes(paths.size());
+		for (size_t i = 0; i < paths.size(); i++) {
+			EngineShaderManager::getLastWriteTime(paths[i], lastWriteTimes[i]);
+		}
+
+		return lastWriteTimes;
+	}
+
+	void EngineShaderManager::watch(const std::string& sourcePath, const std::string& spirvPath, std::vector<std::string> defines, 
+		std::function<void()> onReload) 
+	{
+		WatchedShader shader{};
+		shader.sourcePath = sourcePath;
+		shader.spirvPath = spirvPath;
+		shader.defines = defines;
+		shader.onReload = onReload;
+
+		std::filesystem::file_time_type lastWriteTime;
+		if (!EngineShaderManager::getLastWriteTime(sourcePath, lastWriteTime)) {
+			std::cerr << "shader manager: can not watch " << sourcePath << std::endl;
+			return;
+		}
+
+		shader.dependencyPaths = EngineShaderManager::collectDependencies(sourcePath);
+		shader.lastWriteTimes = EngineShaderManager::getLastWriteTimes(shader.dependencyPaths);
+
+		std::lock_guard<std::mutex> lock(this->shaderMutex);
+		this->shaders.emplace_back(shader);
+	}
+
+	bool EngineShaderManager::applyReloads() {
+		std::vector<std::function<void()>> reloadFunctions;
+
+		{
+			std::lock_guard<std::mutex> lock(this->shaderMutex);
+
+			for (auto&& shader : this->shaders) {
+				if (shader.isReady) {
+					reloadFunctions.emplace_back(shader.onReload);
+					shader.isReady = false;
+				}
+			}
+		}
+
+		for (auto&& reloadFunction : reloadFunctions) {
+			reloadFunction();
+		}
+
+		return !reloadFunctions.empty();
+	}
+
+	void EngineShaderManager::run() {
+		std::unique_lock<std::mutex> lock(this->shaderMutex);
+
+		while (this->isRunning) {
+			this->stopCondition.wait_for(lock, this->pollInterval, [this]() { return !this->isRunning; });
+
+			for (size_t i = 0; i < this->shaders.size() && this->isRunning; i++) {
+				auto lastWriteTimes = EngineShaderManager::getLastWriteTimes(this->shaders[i].dependencyPaths);
+				if (lastWriteTimes == this->shaders[i].lastWriteTimes) {
+					continue;
+				}
+
+				// an edit may add or remove includes, so the dependencies are collected again
+				this->shaders[i].dependencyPaths = EngineShaderManager::collectDependencies(this->shaders[i].sourcePath);
+				this->shaders[i].lastWriteTimes = EngineShaderManager::getLastWriteTimes(this->shaders[i].dependencyPaths);
+
+				auto sourcePath = this->shaders[i].sourcePath;
+				auto spirvPath = this->shaders[i].spirvPath;
+				auto defines = this->shaders[i].defines;
+
+				// compiling takes a while, watch() and applyReloads() must not wait for it
+				lock.unlock();
+				bool isCompiled = this->compile(sourcePath, spirvPath, defines);
+				lock.lock();
+
+				if (isCompiled) {
+					this->shaders[i].isReady = true;
+				}
+			}
+		}
+	}
+
+	bool EngineShaderManager::compile(const std::string& sourcePath, const std::string& spirvPath, const std::vector<std::string>& defines) {
+		// the new module is written next to the old one first, a failed compile must leave the old .spv intact
+		std::string tempPath = spirvPath + ".tmp";
+
+	#ifdef NUGI_WITH_SHADERC
+		std::ifstream sourceFile{sourcePath};
+		if (!sourceFile.is_open()) {
+			std::cerr << "shader manager: failed to open " << sourcePath << std::endl;
+			return false;
+		}
+
+		std::stringstream sourceStream;
+		sourceStream << sourceFile.rdbuf();
+
+		auto extension = std::filesystem::path(sourcePath).extension().string();
+		shaderc_shader_kind shaderKind = shaderc_glsl_infer_from_source;
+
+		if (extension == ".comp") {
+			shaderKind = shaderc_glsl_compute_shader;
+		} else if (extension == ".vert") {
+			shaderKind = shaderc_glsl_vertex_shader;
+		} else if (extension == ".frag") {
+			shaderKind = shaderc_glsl_fragment_shader;
+		}
+
+		shaderc::CompileOptions options;
+		options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_2);
+		options.SetOptimizationLevel(shaderc_optimization_level_performance);
+
+		for (auto&& define : defines) {
+			options.AddMacroDefinition(define);
+		}
+
+		options.SetIncluder(std::make_unique<FileIncluder>());
+
+		shaderc::Compiler compiler;
+		auto result = compiler.CompileGlslToSpv(sourceStream.str(), shaderKind, sourcePath.c_str(), options);
+
+		if (result.GetCompilationStatus() != shaderc_compilation_status_success) {
+			std::cerr << "shader manager: " << result.GetErrorMessage() << std::endl;
+			return false;
+		}
+
+		std::vector<uint32_t> spirv(result.cbegin(), result.cend());
+
+		std::ofstream spirvFile{tempPath, std::ios::binary | std::ios::trunc};
+		spirvFile.write(reinterpret_cast<const char*>(spirv.data()), spirv.size() * sizeof(uint32_t));
+		spirvFile.close();
+
+		if (!spirvFile) {
+			std::cerr << "shader manager: failed to write " << tempPath << std::endl;
+			std::remove(tempPath.c_str());
+
+			return false;
+		}
+	#else
+		std::string command = "glslc --target-env=vulkan1.2 -O";
+		for (auto&& define : defines) {
+			command += " -D" + define;
+		}
+
+		command += " \"" + sourcePath + "\" -o \"" + tempPath + "\"";
+
+		// glslc prints its own errors
+		if (std::system(command.c_str()) != 0) {
+			std::cerr << "shader manager: failed to compile " << sourcePath << std::endl;
+			std::remove(tempPath.c_str());
+
+			return false;
+		}
+	#endif
+
+		std::error_code errorCode;
+		std::filesystem::rename(tempPath, spirvPath, errorCode);
+
+		if (errorCode) {
+			std::cerr << "shader manager: failed to replace " << spirvPath << ": " << errorCode.message() << std::endl;
+			return false;
+		}
+
+		// the embedded copy of this module is out of date now
+		EngineShaderLibrary::overrideWithFile(spirvPath);
+
+		std::cout << "shader manager: reloaded " << sourcePath << std::endl;
+		return true;
+	}
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace nugiEngine {
+	/*
+	 * Watches GLSL sources and compiles them to SPIR-V on a background thread whenever they change.
+	 * The compiled module replaces the .spv file and takes precedence over the embedded copy, then the reload callback
+	 * runs on the render thread in applyReloads(), which has to be called at a frame boundary.
+	 * A source that fails to compile is reported and its .spv is left alone, so the old pipeline stays in use.
+	 * Files pulled in with #include "..." (the sources under helper/) are watched too, relative to the including file.
+	 * With NUGI_WITH_SHADERC the shaders are compiled in-process by shaderc, otherwise glslc is invoked
+	 */
+	class EngineShaderManager {
+		public:
+			EngineShaderManager(std::chrono::milliseconds pollInterval = std::chrono::milliseconds(500));
+			~EngineShaderManager();
+
+			EngineShaderManager(const EngineShaderManager&) = delete;
+			EngineShaderManager& operator = (const EngineShaderManager&) = delete;
+
+			void watch(const std::string& sourcePath, const std::string& spirvPath, std::vector<std::string> defines, 
+				std::function<void()> onReload);
+
+			// returns true if any reload callback was run
+			bool applyReloads();
+
+		private:
+			struct WatchedShader {
+				std::string sourcePath;
+				std::string spirvPath;
+				std::vector<std::string> defines;
+
+				std::function<void()> onReload;
+
+				// the source itself first, then every file it includes
+				std::vector<std::string> dependencyPaths;
+				std::vector<std::filesystem::file_time_type> lastWriteTimes;
+
+				bool isReady = false;
+			};
+
+			void run();
+			bool compile(const std::string& sourcePath, const std::string& spirvPath, const std::vector<std::string>& defines);
+
+			static bool getLastWriteTime(const std::string& path, std::filesystem::file_time_type& lastWriteTime);
+			static std::vector<std::string> collectDependencies(const std::string& sourcePath);
+			static std::vector<std::filesystem::file_time_type> getLastWriteTimes(const std::vector<std::string>& paths);
+
+			std::vector<WatchedShader> shaders;
+			std::mutex shaderMutex;
+
+			std::chrono::milliseconds pollInterval;
+			std::condition_variable stopCondition;
+
+			bool isRunning = true;
+			std::thread watchThread;
+	};
+}
@@ -0,0 +1,118 @@
+#include "staging_allocator.hpp"
+
+namespace nugiEngine {
+  EngineStagingAllocator::EngineStagingAllocator(EngineDevice &device, VkDeviceSize ringSize) : appDevice{device}, ringSize{ringSize} {
+    this->ringBuffer = std::make_unique<EngineBuffer>(
+      this->appDevice,
+      this->ringSize,
+      1,
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+    );
+
+    this->ringBuffer->map();
+  }
+
+  bool EngineStagingAllocator::tryAllocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset) {
+    if (this->usedBytes == 0) {
+      this->head = 0;
+      this->tail = 0;
+    }
+
+    VkDeviceSize alignedHead = ((this->head + alignment - 1) / alignment) * alignment;
+    VkDeviceSize consumedBytes = 0;
+
+    if (this->usedBytes == 0 || this->head > this->tail) {
+      // free space is [head, ringSize) followed by [0, tail), the end of the ring is skipped when wrapping
+      if (alignedHead + size <= this->ringSize) {
+        offset = alignedHead;
+        consumedBytes = alignedHead + size - this->head;
+      } else if (size <= this->tail) {
+        offset = 0;
+        consumedBytes = this->ringSize - this->head + size;
+      } else {
+        return false;
+      }
+    } else if (this->head < this->tail && alignedHead + size <= this->tail) {
+      offset = alignedHead;
+      consumedBytes = alignedHead + size - this->head;
+    } else {
+      return false;
+    }
+
+    this->head = offset + size;
+    this->usedBytes += consumedBytes;
+    this->stagingRanges.emplace_back(StagingRange{ consumedBytes, false });
+
+    return true;
+  }
+
+  EngineStagingAllocation EngineStagingAllocator::allocate(const void* data, VkDeviceSize size, VkDeviceSize alignment) {
+    EngineStagingAllocation allocation{};
+
+    if (size > this->ringSize) {
+      allocation.oversizedBuffer = std::make_shared<EngineBuffer>(
+        this->appDevice,
+        size,
+        1,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+      );
+
+      allocation.oversizedBuffer->map();
+      allocation.oversizedBuffer->writeToBuffer(const_cast<void*>(data), size);
+
+      allocation.buffer = allocation.oversizedBuffer->getBuffer();
+      return allocation;
+    }
+
+    {
+      // whoever submitted the earlier ranges gives them back once the GPU is done with them
+      std::unique_lock<std::mutex> lock(this->stagingMutex);
+      this->stagingCondition.wait(lock, [this, &allocation, size, alignment] { 
+        return this->tryAllocate(size, alignment, allocation.offset); 
+      });
+
+      allocation.sequence = this->firstSequence + this->stagingRanges.size() - 1;
+    }
+
+    // the reserved range belongs to this allocation only, so the copy needs no lock
+    this->ringBuffer->writeToBuffer(const_cast<void*>(data), size, allocation.offset);
+
+    allocation.buffer = this->ringBuffer->getBuffer();
+    return allocation;
+  }
+
+  void EngineStagingAllocator::release(EngineStagingAllocation &allocation) {
+    if (allocation.buffer == VK_NULL_HANDLE) {
+      return;
+    }
+
+    allocation.buffer = VK_NULL_HANDLE;
+
+    if (allocation.oversizedBuffer != nullptr) {
+      allocation.oversizedBuffer = nullptr;
+      return;
+    }
+
+    bool isReleased = false;
+
+    {
+      std::lock_guard<std::mutex> lock(this->stagingMutex);
+      this->stagingRanges[allocation.sequence - this->firstSequence].isReleased = true;
+
+      while (!this->stagingRanges.empty() && this->stagingRanges.front().isReleased) {
+        this->tail = (this->tail + this->stagingRanges.front().consumedBytes) % this->ringSize;
+        this->usedBytes -= this->stagingRanges.front().consumedBytes;
+
+        this->stagingRanges.pop_front();
+        this->firstSequence++;
+        isReleased = true;
+      }
+    }
+
+    if (isReleased) {
+      this->stagingCondition.notify_all();
+    }
+  }
+} // namespace nugiEngine
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "../device/device.hpp"
+#include "../buffer/buffer.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+namespace nugiEngine {
+  // a copy of uploaded data the GPU can read from, until it is given back with release()
+  struct EngineStagingAllocation {
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+
+    // uploads bigger than the whole ring get a buffer of their own instead of a range of it
+    std::shared_ptr<EngineBuffer> oversizedBuffer;
+    uint64_t sequence = 0;
+  };
+
+  /*
+   * One persistently mapped host buffer used as a ring by every upload of the device.
+   * allocate() copies the data in on the calling thread and blocks while the ring is full, release() gives the range
+   * back once the GPU is done reading it. Ranges may be released out of allocation order, the ring only moves past
+   * the oldest ranges once all of them are released
+   */
+  class EngineStagingAllocator {
+    public:
+      static constexpr VkDeviceSize DEFAULT_RING_SIZE = 32ull * 1024 * 1024;
+
+      EngineStagingAllocator(EngineDevice &device, VkDeviceSize ringSize = DEFAULT_RING_SIZE);
+
+      EngineStagingAllocator(const EngineStagingAllocator&) = delete;
+      EngineStagingAllocator& operator=(const EngineStagingAllocator&) = delete;
+
+      EngineStagingAllocation allocate(const void* data, VkDeviceSize size, VkDeviceSize alignment = 16);
+      void release(EngineStagingAllocation &allocation);
+
+    private:
+      struct StagingRange {
+        VkDeviceSize consumedBytes;
+        bool isReleased;
+      };
+
+      bool tryAllocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset);
+
+      EngineDevice &appDevice;
+
+      std::unique_ptr<EngineBuffer> ringBuffer;
+      VkDeviceSize ringSize, head = 0, tail = 0, usedBytes = 0;
+
+      std::deque<StagingRange> stagingRanges;
+      uint64_t firstSequence = 0;
+
+      std::mutex stagingMutex;
+      std::condition_variable stagingCondition;
+  };
+} // namespace nugiEngine
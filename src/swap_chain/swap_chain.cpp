@@ -30,15 +30,7 @@ namespace nugiEngine {
     }
   }
 
-  VkResult EngineSwapChain::acquireNextImage(uint32_t *imageIndex, std::vector<VkFence> inFlightFences, VkSemaphore imageAvailableSemaphore) {
-    vkWaitForFences(
-      this->device.getLogicalDevice(),
-      static_cast<uint32_t>(inFlightFences.size()),
-      inFlightFences.data(),
-      VK_TRUE,
-      std::numeric_limits<uint64_t>::max()
-    );
-
+  VkResult EngineSwapChain::acquireNextImage(uint32_t *imageIndex, VkSemaphore imageAvailableSemaphore) {
     VkResult result = vkAcquireNextImageKHR(
       this->device.getLogicalDevice(),
       this->swapChain,
@@ -51,12 +43,12 @@ namespace nugiEngine {
     return result;
   }
 
-  VkResult EngineSwapChain::presentRenders(VkQueue queue, uint32_t *imageIndex, std::vector<VkSemaphore> waitSemaphores) {
+  VkResult EngineSwapChain::presentRenders(VkQueue queue, uint32_t *imageIndex, uint32_t waitSemaphoreCount, const VkSemaphore* waitSemaphores) {
     VkPresentInfoKHR presentInfo = {};
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
-    presentInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
-    presentInfo.pWaitSemaphores = waitSemaphores.data();
+    presentInfo.waitSemaphoreCount = waitSemaphoreCount;
+    presentInfo.pWaitSemaphores = waitSemaphores;
 
     VkSwapchainKHR swapChains[] = { this->swapChain };
     presentInfo.swapchainCount = 1;
@@ -64,6 +56,8 @@ namespace nugiEngine {
 
     presentInfo.pImageIndices = imageIndex;
 
+    std::lock_guard<std::mutex> lock(this->device.getQueueMutex(queue));
+
     auto result = vkQueuePresentKHR(queue, &presentInfo);
     return result;
   }
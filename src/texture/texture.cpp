@@ -9,6 +9,7 @@
 
 #include "../buffer/buffer.hpp"
 #include "../command/command_buffer.hpp"
+#include "../upload_service/upload_service.hpp"
 
 namespace nugiEngine {
   EngineTexture::EngineTexture(EngineDevice &appDevice, const char* textureFileName) : appDevice{appDevice} {
@@ -31,34 +32,14 @@ namespace nugiEngine {
 
     this->mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(texWidth, texHeight)))) + 1;
 
-    unsigned long pixelSize = 4;
-    uint32_t pixelCount = texWidth * texHeight;
-
-    EngineBuffer stagingBuffer {
-			this->appDevice,
-			pixelSize,
-			pixelCount,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-		};
-
-    stagingBuffer.map();
-    stagingBuffer.writeToBuffer(pixels);
-    stagingBuffer.unmap();
-
-    stbi_image_free(pixels);
-
-    this->image = std::make_unique<EngineImage>(this->appDevice, texWidth, texHeight, this->mipLevels, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R8G8B8A8_SRGB, 
+    this->image = std::make_shared<EngineImage>(this->appDevice, texWidth, texHeight, this->mipLevels, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R8G8B8A8_SRGB, 
       VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, 
       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_ASPECT_COLOR_BIT);
 
-    this->image->transitionImageLayout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 
-      VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 
-      0, VK_ACCESS_TRANSFER_WRITE_BIT);
-      
-    stagingBuffer.copyBufferToImage(this->image->getImage(), static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), 1);
-    this->image->generateMipMap();
-    // this->image->transitionImageLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    // the pixels are staged before this returns, the mip chain is built on the graphics queue after the copy
+    this->appDevice.getUploadService()->uploadTexture(this->image, pixels, imageSize, static_cast<uint32_t>(texWidth), 
+      static_cast<uint32_t>(texHeight), VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    stbi_image_free(pixels);
   }
 
   void EngineTexture::createTextureSampler() {
@@ -23,7 +23,7 @@ namespace nugiEngine
 
     private:
       EngineDevice &appDevice;
-      std::unique_ptr<EngineImage> image;
+      std::shared_ptr<EngineImage> image;
 
       VkSampler sampler;
       uint32_t mipLevels;
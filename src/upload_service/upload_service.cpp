@@ -0,0 +1,447 @@
+#include "upload_service.hpp"
+
+#include <limits>
+#include <stdexcept>
+
+namespace nugiEngine {
+  EngineUploadService::EngineUploadService(EngineDevice &device, EngineStagingAllocator &stagingAllocator) 
+    : appDevice{device}, stagingAllocator{stagingAllocator} 
+  {
+    this->transferFamily = this->appDevice.getFamilyIndices().transferFamily;
+
+    VkSemaphoreTypeCreateInfo typeInfo{};
+    typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    typeInfo.initialValue = 0;
+
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreInfo.pNext = &typeInfo;
+
+    if (vkCreateSemaphore(this->appDevice.getLogicalDevice(), &semaphoreInfo, nullptr, &this->timelineSemaphore) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create upload timeline semaphore!");
+    }
+
+    this->uploadThread = std::thread(&EngineUploadService::run, this);
+  }
+
+  EngineUploadService::~EngineUploadService() {
+    {
+      std::lock_guard<std::mutex> lock(this->requestMutex);
+      this->isRunning = false;
+    }
+
+    this->requestCondition.notify_all();
+    this->uploadThread.join();
+
+    for (auto &&commandPool : this->commandPools) {
+      vkDestroyCommandPool(this->appDevice.getLogicalDevice(), commandPool.second, nullptr);
+    }
+
+    vkDestroySemaphore(this->appDevice.getLogicalDevice(), this->timelineSemaphore, nullptr);
+  }
+
+  void EngineUploadService::releaseStaging(std::vector<UploadRequest> &requests) {
+    for (auto &&request : requests) {
+      this->stagingAllocator.release(request.staging);
+    }
+  }
+
+  void EngineUploadService::completeRequests(size_t requestCount) {
+    {
+      std::lock_guard<std::mutex> lock(this->requestMutex);
+      this->completedCount += requestCount;
+    }
+
+    this->idleCondition.notify_all();
+  }
+
+  VkImageLayout EngineUploadService::getTransferLayout(const UploadRequest &request) const {
+    // the mip chain is blitted from the base level, so the image has to stay a transfer destination until then
+    return request.isGeneratingMipMaps ? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL : request.dstLayout;
+  }
+
+  std::future<void> EngineUploadService::uploadBuffer(std::shared_ptr<EngineBuffer> dstBuffer, const void* data, VkDeviceSize size,
+    uint32_t dstQueueFamilyIndex, VkAccessFlags dstAccess, VkPipelineStageFlags dstStage, std::function<void()> onComplete)
+  {
+    UploadRequest request{};
+    request.staging = this->stagingAllocator.allocate(data, size);
+    request.dstBuffer = dstBuffer;
+    request.size = size;
+    request.dstQueueFamilyIndex = dstQueueFamilyIndex;
+    request.dstAccess = dstAccess;
+    request.dstStage = dstStage;
+    request.onComplete = onComplete;
+
+    return this->enqueue(std::move(request));
+  }
+
+  std::future<void> EngineUploadService::uploadImage(std::shared_ptr<EngineImage> dstImage, const void* data, VkDeviceSize size,
+    uint32_t width, uint32_t height, VkImageLayout dstLayout, uint32_t dstQueueFamilyIndex, VkAccessFlags dstAccess,
+    VkPipelineStageFlags dstStage, std::function<void()> onComplete)
+  {
+    UploadRequest request{};
+    request.dstLayout = dstLayout;
+    request.dstQueueFamilyIndex = dstQueueFamilyIndex;
+    request.dstAccess = dstAccess;
+    request.dstStage = dstStage;
+
+    return this->enqueueImage(std::move(request), dstImage, data, size, width, height, onComplete);
+  }
+
+  std::future<void> EngineUploadService::uploadTexture(std::shared_ptr<EngineImage> dstImage, const void* data, VkDeviceSize size,
+    uint32_t width, uint32_t height, VkPipelineStageFlags dstStage, std::function<void()> onComplete)
+  {
+    // blits are only allowed on a graphics queue
+    UploadRequest request{};
+    request.dstLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    request.dstQueueFamilyIndex = this->appDevice.getFamilyIndices().graphicsFamily;
+    request.dstAccess = VK_ACCESS_SHADER_READ_BIT;
+    request.dstStage = dstStage;
+    request.isGeneratingMipMaps = dstImage->getMipLevels() > 1;
+
+    return this->enqueueImage(std::move(request), dstImage, data, size, width, height, onComplete);
+  }
+
+  std::future<void> EngineUploadService::enqueueImage(UploadRequest request, std::shared_ptr<EngineImage> dstImage, const void* data, 
+    VkDeviceSize size, uint32_t width, uint32_t height, std::function<void()> onComplete)
+  {
+    request.staging = this->stagingAllocator.allocate(data, size);
+    request.dstImage = dstImage;
+    request.size = size;
+    request.width = width;
+    request.height = height;
+    request.onComplete = onComplete;
+
+    // the image belongs to the calling thread, the upload thread only records barriers for it
+    dstImage->setLayout(request.dstLayout);
+
+    return this->enqueue(std::move(request));
+  }
+
+  void EngineUploadService::waitIdle() {
+    std::unique_lock<std::mutex> lock(this->requestMutex);
+
+    uint64_t enqueuedCount = this->enqueuedCount;
+    this->idleCondition.wait(lock, [this, enqueuedCount] { return this->completedCount >= enqueuedCount; });
+
+    // callers without a future of their own still have to hear about a failed upload
+    if (this->failedUpload != nullptr) {
+      std::exception_ptr failedUpload = this->failedUpload;
+      this->failedUpload = nullptr;
+
+      std::rethrow_exception(failedUpload);
+    }
+  }
+
+  std::future<void> EngineUploadService::enqueue(UploadRequest request) {
+    if (request.dstQueueFamilyIndex == VK_QUEUE_FAMILY_IGNORED) {
+      request.dstQueueFamilyIndex = this->transferFamily;
+    }
+
+    auto future = request.promise.get_future();
+
+    {
+      std::lock_guard<std::mutex> lock(this->requestMutex);
+      this->requests.emplace_back(std::move(request));
+      this->enqueuedCount++;
+    }
+
+    this->requestCondition.notify_one();
+    return future;
+  }
+
+  void EngineUploadService::run() {
+    while (true) {
+      std::vector<UploadRequest> pendingRequests;
+
+      {
+        std::unique_lock<std::mutex> lock(this->requestMutex);
+        this->requestCondition.wait(lock, [this] { 
+          return !this->isRunning || !this->requests.empty() || !this->inFlightBatches.empty(); 
+        });
+
+        if (!this->isRunning && this->requests.empty() && this->inFlightBatches.empty()) {
+          return;
+        }
+
+        // everything queued so far goes out in the same submission
+        while (!this->requests.empty()) {
+          pendingRequests.emplace_back(std::move(this->requests.front()));
+          this->requests.pop_front();
+        }
+      }
+
+      if (!pendingRequests.empty()) {
+        try {
+          this->submitBatch(pendingRequests);
+        } catch (...) {
+          this->releaseStaging(pendingRequests);
+
+          for (auto &&request : pendingRequests) {
+            request.promise.set_exception(std::current_exception());
+          }
+
+          {
+            std::lock_guard<std::mutex> lock(this->requestMutex);
+            this->failedUpload = std::current_exception();
+          }
+
+          this->completeRequests(pendingRequests.size());
+        }
+      }
+
+      // with nothing new to record the oldest batch is waited on, requests arriving meanwhile go out together
+      this->retireBatches(pendingRequests.empty());
+    }
+  }
+
+  void EngineUploadService::submitBatch(std::vector<UploadRequest> &requests) {
+    UploadBatch batch{};
+
+    try {
+      auto copyCommandBuffer = std::make_shared<EngineCommandBuffer>(this->appDevice, this->getCommandPool(this->transferFamily));
+      batch.commandBuffers.emplace_back(copyCommandBuffer);
+
+      copyCommandBuffer->beginSingleTimeCommand();
+
+      for (auto &&request : requests) {
+        this->recordCopy(copyCommandBuffer, request);
+      }
+
+      for (auto &&request : requests) {
+        this->recordRelease(copyCommandBuffer, request);
+      }
+
+      copyCommandBuffer->endCommand();
+      this->submitChained(copyCommandBuffer, this->getQueue(this->transferFamily));
+
+      // the acquire half of every ownership transfer runs on a queue of the receiving family
+      std::unordered_map<uint32_t, std::shared_ptr<EngineCommandBuffer>> acquireCommandBuffers;
+
+      for (auto &&request : requests) {
+        if (request.dstQueueFamilyIndex == this->transferFamily) {
+          continue;
+        }
+
+        auto &acquireCommandBuffer = acquireCommandBuffers[request.dstQueueFamilyIndex];
+        if (acquireCommandBuffer == nullptr) {
+          acquireCommandBuffer = std::make_shared<EngineCommandBuffer>(this->appDevice, this->getCommandPool(request.dstQueueFamilyIndex));
+          acquireCommandBuffer->beginSingleTimeCommand();
+
+          batch.commandBuffers.emplace_back(acquireCommandBuffer);
+        }
+
+        this->recordAcquire(acquireCommandBuffer, request);
+      }
+
+      for (auto &&acquireCommandBuffer : acquireCommandBuffers) {
+        acquireCommandBuffer.second->endCommand();
+        this->submitChained(acquireCommandBuffer.second, this->getQueue(acquireCommandBuffer.first));
+      }
+    } catch (...) {
+      // a part of the batch may already be on the GPU, its command buffers are freed when leaving here
+      this->waitValue(this->timelineValue);
+      throw;
+    }
+
+    batch.requests = std::move(requests);
+    batch.completeValue = this->timelineValue;
+
+    this->inFlightBatches.emplace_back(std::move(batch));
+  }
+
+  void EngineUploadService::retireBatches(bool isWaiting) {
+    if (this->inFlightBatches.empty()) {
+      return;
+    }
+
+    if (isWaiting) {
+      this->waitValue(this->inFlightBatches.front().completeValue);
+    }
+
+    uint64_t completedValue = 0;
+    if (vkGetSemaphoreCounterValue(this->appDevice.getLogicalDevice(), this->timelineSemaphore, &completedValue) != VK_SUCCESS) {
+      throw std::runtime_error("failed to read upload timeline semaphore value!");
+    }
+
+    while (!this->inFlightBatches.empty() && this->inFlightBatches.front().completeValue <= completedValue) {
+      auto batch = std::move(this->inFlightBatches.front());
+      this->inFlightBatches.pop_front();
+
+      this->releaseStaging(batch.requests);
+
+      for (auto &&request : batch.requests) {
+        request.promise.set_value();
+
+        if (request.onComplete) {
+          request.onComplete();
+        }
+      }
+
+      this->completeRequests(batch.requests.size());
+    }
+  }
+
+  void EngineUploadService::recordCopy(std::shared_ptr<EngineCommandBuffer> commandBuffer, UploadRequest &request) {
+    if (request.dstBuffer != nullptr) {
+      VkBufferCopy copyRegion{};
+      copyRegion.srcOffset = request.staging.offset;
+      copyRegion.dstOffset = 0;
+      copyRegion.size = request.size;
+
+      vkCmdCopyBuffer(commandBuffer->getCommandBuffer(), request.staging.buffer, request.dstBuffer->getBuffer(), 1, &copyRegion);
+      return;
+    }
+
+    // barriers are built without addTransition, the image state belongs to the thread which owns the image
+    VkImageMemoryBarrier barrier = request.dstImage->createBarrier(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+      0, VK_ACCESS_TRANSFER_WRITE_BIT);
+    commandBuffer->addImageBarrier(barrier, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+    commandBuffer->flushBarriers();
+
+    VkBufferImageCopy region{};
+    region.bufferOffset = request.staging.offset;
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+
+    region.imageSubresource.aspectMask = request.dstImage->getAspectFlag();
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+
+    region.imageOffset = {0, 0, 0};
+    region.imageExtent = {request.width, request.height, 1};
+
+    vkCmdCopyBufferToImage(commandBuffer->getCommandBuffer(), request.staging.buffer, request.dstImage->getImage(),
+      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+  }
+
+  void EngineUploadService::recordRelease(std::shared_ptr<EngineCommandBuffer> commandBuffer, UploadRequest &request) {
+    bool isSameFamily = request.dstQueueFamilyIndex == this->transferFamily;
+
+    // a transfer family taking graphics work as well builds the mip chain right after the copy
+    if (isSameFamily && request.isGeneratingMipMaps) {
+      commandBuffer->flushBarriers();
+      request.dstImage->recordMipMaps(commandBuffer, request.dstStage);
+      return;
+    }
+
+    // without a family change this is a plain barrier to the first use, otherwise the release half of the transfer
+    uint32_t srcQueueFamilyIndex = isSameFamily ? VK_QUEUE_FAMILY_IGNORED : this->transferFamily;
+    uint32_t dstQueueFamilyIndex = isSameFamily ? VK_QUEUE_FAMILY_IGNORED : request.dstQueueFamilyIndex;
+    VkAccessFlags dstAccess = isSameFamily ? request.dstAccess : 0;
+    VkPipelineStageFlags dstStage = isSameFamily ? request.dstStage : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+    if (request.dstBuffer != nullptr) {
+      VkBufferMemoryBarrier barrier{};
+      barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+      barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+      barrier.dstAccessMask = dstAccess;
+      barrier.srcQueueFamilyIndex = srcQueueFamilyIndex;
+      barrier.dstQueueFamilyIndex = dstQueueFamilyIndex;
+      barrier.buffer = request.dstBuffer->getBuffer();
+      barrier.offset = 0;
+      barrier.size = VK_WHOLE_SIZE;
+
+      commandBuffer->addBufferBarrier(barrier, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStage);
+    } else {
+      VkImageMemoryBarrier barrier = request.dstImage->createBarrier(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, this->getTransferLayout(request),
+        VK_ACCESS_TRANSFER_WRITE_BIT, dstAccess, srcQueueFamilyIndex, dstQueueFamilyIndex);
+      commandBuffer->addImageBarrier(barrier, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStage);
+    }
+  }
+
+  void EngineUploadService::recordAcquire(std::shared_ptr<EngineCommandBuffer> commandBuffer, UploadRequest &request) {
+    if (request.dstBuffer != nullptr) {
+      VkBufferMemoryBarrier barrier{};
+      barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+      barrier.srcAccessMask = 0;
+      barrier.dstAccessMask = request.dstAccess;
+      barrier.srcQueueFamilyIndex = this->transferFamily;
+      barrier.dstQueueFamilyIndex = request.dstQueueFamilyIndex;
+      barrier.buffer = request.dstBuffer->getBuffer();
+      barrier.offset = 0;
+      barrier.size = VK_WHOLE_SIZE;
+
+      commandBuffer->addBufferBarrier(barrier, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, request.dstStage);
+    } else {
+      // the layout transition is repeated on the acquire side, as the spec requires
+      VkAccessFlags dstAccess = request.isGeneratingMipMaps ? VK_ACCESS_TRANSFER_WRITE_BIT : request.dstAccess;
+      VkPipelineStageFlags dstStage = request.isGeneratingMipMaps ? VK_PIPELINE_STAGE_TRANSFER_BIT : request.dstStage;
+
+      VkImageMemoryBarrier barrier = request.dstImage->createBarrier(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, this->getTransferLayout(request),
+        0, dstAccess, this->transferFamily, request.dstQueueFamilyIndex);
+      commandBuffer->addImageBarrier(barrier, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dstStage);
+
+      if (request.isGeneratingMipMaps) {
+        commandBuffer->flushBarriers();
+        request.dstImage->recordMipMaps(commandBuffer, request.dstStage);
+      }
+    }
+  }
+
+  void EngineUploadService::submitChained(std::shared_ptr<EngineCommandBuffer> commandBuffer, VkQueue queue) {
+    // every submit waits on the one before it, so the timeline is signaled in order even across queues
+    VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    uint64_t waitValue = this->timelineValue;
+    uint64_t signalValue = ++this->timelineValue;
+
+    commandBuffer->submitCommand(queue, waitValue > 0 ? 1 : 0, &this->timelineSemaphore, &waitStage, &waitValue, 
+      1, &this->timelineSemaphore, &signalValue);
+  }
+
+  void EngineUploadService::waitValue(uint64_t value) {
+    if (value == 0) {
+      return;
+    }
+
+    VkSemaphoreWaitInfo waitInfo{};
+    waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores = &this->timelineSemaphore;
+    waitInfo.pValues = &value;
+
+    if (vkWaitSemaphores(this->appDevice.getLogicalDevice(), &waitInfo, std::numeric_limits<uint64_t>::max()) != VK_SUCCESS) {
+      throw std::runtime_error("failed to wait upload timeline semaphore!");
+    }
+  }
+
+  VkCommandPool EngineUploadService::getCommandPool(uint32_t queueFamilyIndex) {
+    auto iterator = this->commandPools.find(queueFamilyIndex);
+    if (iterator != this->commandPools.end()) {
+      return iterator->second;
+    }
+
+    VkCommandPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = queueFamilyIndex;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+    VkCommandPool commandPool;
+    if (vkCreateCommandPool(this->appDevice.getLogicalDevice(), &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create upload command pool!");
+    }
+
+    this->commandPools.emplace(queueFamilyIndex, commandPool);
+    return commandPool;
+  }
+
+  VkQueue EngineUploadService::getQueue(uint32_t queueFamilyIndex) {
+    auto familyIndices = this->appDevice.getFamilyIndices();
+
+    if (queueFamilyIndex == familyIndices.transferFamily) {
+      return this->appDevice.getTransferQueue(0);
+    }
+
+    if (queueFamilyIndex == familyIndices.computeFamily) {
+      return this->appDevice.getComputeQueue(0);
+    }
+
+    if (queueFamilyIndex == familyIndices.graphicsFamily) {
+      return this->appDevice.getGraphicsQueue(0);
+    }
+
+    throw std::runtime_error("upload destination is not a queue family of this device!");
+  }
+} // namespace nugiEngine
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "../device/device.hpp"
+#include "../buffer/buffer.hpp"
+#include "../command/command_buffer.hpp"
+#include "../image/image.hpp"
+#include "../staging/staging_allocator.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace nugiEngine {
+  /*
+   * Uploads data on the transfer queue from a thread of its own, every upload of the device goes through here.
+   * The data is copied into the staging allocator of the device on the calling thread, so it can be freed as soon as
+   * the call returns. The worker records every pending request into one transfer submission, then hands each resource
+   * over to the queue family that will use it. Submissions of a batch are chained on a timeline semaphore and the worker
+   * only blocks on it when it has nothing else to record. The returned future becomes ready (and onComplete
+   * runs on the worker thread) once the resource can be used on that family
+   */
+  class EngineUploadService {
+    public:
+      EngineUploadService(EngineDevice &device, EngineStagingAllocator &stagingAllocator);
+      ~EngineUploadService();
+
+      EngineUploadService(const EngineUploadService&) = delete;
+      EngineUploadService& operator=(const EngineUploadService&) = delete;
+
+      std::future<void> uploadBuffer(std::shared_ptr<EngineBuffer> dstBuffer, const void* data, VkDeviceSize size,
+        uint32_t dstQueueFamilyIndex, VkAccessFlags dstAccess, VkPipelineStageFlags dstStage,
+        std::function<void()> onComplete = nullptr);
+
+      std::future<void> uploadImage(std::shared_ptr<EngineImage> dstImage, const void* data, VkDeviceSize size,
+        uint32_t width, uint32_t height, VkImageLayout dstLayout, uint32_t dstQueueFamilyIndex, VkAccessFlags dstAccess,
+        VkPipelineStageFlags dstStage, std::function<void()> onComplete = nullptr);
+
+      // uploads the base level and fills the rest of the mip chain with blits on the graphics queue,
+      // the image ends up in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+      std::future<void> uploadTexture(std::shared_ptr<EngineImage> dstImage, const void* data, VkDeviceSize size,
+        uint32_t width, uint32_t height, VkPipelineStageFlags dstStage, std::function<void()> onComplete = nullptr);
+
+      // blocks until every upload enqueued so far is complete
+      void waitIdle();
+
+    private:
+      struct UploadRequest {
+        EngineStagingAllocation staging;
+
+        std::shared_ptr<EngineBuffer> dstBuffer;
+        std::shared_ptr<EngineImage> dstImage;
+
+        VkDeviceSize size = 0;
+        uint32_t width = 0, height = 0;
+        VkImageLayout dstLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        bool isGeneratingMipMaps = false;
+
+        uint32_t dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        VkAccessFlags dstAccess = 0;
+        VkPipelineStageFlags dstStage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+        std::promise<void> promise;
+        std::function<void()> onComplete;
+      };
+
+      struct UploadBatch {
+        std::vector<UploadRequest> requests;
+        std::vector<std::shared_ptr<EngineCommandBuffer>> commandBuffers;
+        uint64_t completeValue = 0;
+      };
+
+      void releaseStaging(std::vector<UploadRequest> &requests);
+      void completeRequests(size_t requestCount);
+
+      std::future<void> enqueue(UploadRequest request);
+      std::future<void> enqueueImage(UploadRequest request, std::shared_ptr<EngineImage> dstImage, const void* data, VkDeviceSize size,
+        uint32_t width, uint32_t height, std::function<void()> onComplete);
+
+      void run();
+      void submitBatch(std::vector<UploadRequest> &requests);
+      void retireBatches(bool isWaiting);
+
+      void recordCopy(std::shared_ptr<EngineCommandBuffer> commandBuffer, UploadRequest &request);
+      void recordRelease(std::shared_ptr<EngineCommandBuffer> commandBuffer, UploadRequest &request);
+      void recordAcquire(std::shared_ptr<EngineCommandBuffer> commandBuffer, UploadRequest &request);
+      void submitChained(std::shared_ptr<EngineCommandBuffer> commandBuffer, VkQueue queue);
+      void waitValue(uint64_t value);
+
+      VkImageLayout getTransferLayout(const UploadRequest &request) const;
+      VkCommandPool getCommandPool(uint32_t queueFamilyIndex);
+      VkQueue getQueue(uint32_t queueFamilyIndex);
+
+      EngineDevice &appDevice;
+      uint32_t transferFamily;
+
+      // filled on the calling threads, given back by the upload thread once the batch using it is complete
+      EngineStagingAllocator &stagingAllocator;
+
+      // only touched by the upload thread, command pools must not be shared with the render thread
+      std::unordered_map<uint32_t, VkCommandPool> commandPools;
+      std::deque<UploadBatch> inFlightBatches;
+      VkSemaphore timelineSemaphore;
+      uint64_t timelineValue = 0;
+
+      std::deque<UploadRequest> requests;
+      uint64_t enqueuedCount = 0, completedCount = 0;
+      std::exception_ptr failedUpload;
+      std::mutex requestMutex;
+      std::condition_variable requestCondition, idleCondition;
+
+      bool isRunning = true;
+      std::thread uploadThread;
+  };
+} // namespace nugiEngine
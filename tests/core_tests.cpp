@@ -0,0 +1,462 @@
+// Checks of the CPU side builders and mesh passes against simple reference implementations:
+// LBVH hits against the median split tree, the Karras hierarchy on duplicate Morton codes,
+// the OBJ vertex dedupe table against std::map, the mesh optimizers against the input triangles
+// and the SIMD kernels of the CPU BVH against its scalar one.
+//
+// core_tests.out, prints every failed check and exits with 1 if there was one
+
+#include "../src/cpu_renderer/cpu_bvh.hpp"
+#include "../src/model/bvh.hpp"
+#include "../src/model/lbvh.hpp"
+#include "../src/model/mesh_optimizer.hpp"
+#include "../src/model/obj_vertex_table.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace nugiEngine {
+	namespace {
+		struct TestRay {
+			glm::vec3 origin;
+			glm::vec3 direction;
+		};
+
+		struct TestIndex {
+			int vertex_index;
+			int normal_index;
+			int texcoord_index;
+		};
+
+		void check(bool condition, const std::string &message) {
+			if (!condition) {
+				throw std::runtime_error(message);
+			}
+		}
+
+		std::vector<Object> createRandomObjects(uint32_t count, float extent, float triangleSize, uint32_t seed) {
+			std::mt19937 generator{seed};
+			std::uniform_real_distribution<float> position{-extent, extent};
+			std::uniform_real_distribution<float> offset{-triangleSize, triangleSize};
+
+			std::vector<Object> objects;
+			objects.reserve(count);
+
+			for (uint32_t i = 0; i < count; i++) {
+				glm::vec3 center{position(generator), position(generator), position(generator)};
+
+				Object object{};
+				object.triangle.point0 = center + glm::vec3{offset(generator), offset(generator), offset(generator)};
+				object.triangle.point1 = center + glm::vec3{offset(generator), offset(generator), offset(generator)};
+				object.triangle.point2 = center + glm::vec3{offset(generator), offset(generator), offset(generator)};
+
+				objects.emplace_back(object);
+			}
+
+			return objects;
+		}
+
+		std::vector<BvhNode> createMedianSplitBvh(const std::vector<Object> &objects) {
+			std::vector<ObjectBoundBox> boundBoxes;
+			boundBoxes.reserve(objects.size());
+
+			for (int i = 0; i < static_cast<int>(objects.size()); i++) {
+				boundBoxes.push_back({ i, objects[i] });
+			}
+
+			return createBvh(boundBoxes);
+		}
+
+		bool intersectAabb(const TestRay &ray, glm::vec3 invDirection, glm::vec3 minimum, glm::vec3 maximum, float tMax) {
+			glm::vec3 t0 = (minimum - ray.origin) * invDirection;
+			glm::vec3 t1 = (maximum - ray.origin) * invDirection;
+			glm::vec3 tNear = glm::min(t0, t1);
+			glm::vec3 tFar = glm::max(t0, t1);
+
+			float nearest = std::max(std::max(tNear.x, tNear.y), tNear.z);
+			float farthest = std::min(std::min(tFar.x, tFar.y), tFar.z);
+
+			return nearest <= farthest && farthest >= 0.0f && nearest <= tMax;
+		}
+
+		bool intersectTriangle(const TestRay &ray, const Triangle &triangle, float &tMax) {
+			const float epsilon = 0.00001f;
+
+			glm::vec3 v0v1 = triangle.point1 - triangle.point0;
+			glm::vec3 v0v2 = triangle.point2 - triangle.point0;
+			glm::vec3 pvec = glm::cross(ray.direction, v0v2);
+			float det = glm::dot(v0v1, pvec);
+
+			if (std::abs(det) < epsilon) {
+				return false;
+			}
+
+			float invDet = 1.0f / det;
+
+			glm::vec3 tvec = ray.origin - triangle.point0;
+			float u = glm::dot(tvec, pvec) * invDet;
+			if (u < 0.0f || u > 1.0f) {
+				return false;
+			}
+
+			glm::vec3 qvec = glm::cross(tvec, v0v1);
+			float v = glm::dot(ray.direction, qvec) * invDet;
+			if (v < 0.0f || u + v > 1.0f) {
+				return false;
+			}
+
+			float t = glm::dot(v0v2, qvec) * invDet;
+			if (t <= epsilon || t > tMax) {
+				return false;
+			}
+
+			tMax = t;
+			return true;
+		}
+
+		// closest hit distance, or a negative value on a miss
+		float traceBruteForce(const std::vector<Object> &objects, const TestRay &ray) {
+			float tMax = 1000000.0f;
+			bool isHit = false;
+
+			for (auto &&object : objects) {
+				isHit |= intersectTriangle(ray, object.triangle, tMax);
+			}
+
+			return isHit ? tMax : -1.0f;
+		}
+
+		float traceBvh(const std::vector<BvhNode> &nodes, const std::vector<Object> &objects, const TestRay &ray) {
+			glm::vec3 invDirection = 1.0f / ray.direction;
+			float tMax = 1000000.0f;
+			bool isHit = false;
+
+			std::vector<int> stack{0};
+
+			while (!stack.empty()) {
+				const BvhNode &node = nodes[stack.back()];
+				stack.pop_back();
+
+				if (!intersectAabb(ray, invDirection, node.minimum, node.maximum, tMax)) {
+					continue;
+				}
+
+				for (int objIndex : { node.leftObjIndex, node.rightObjIndex }) {
+					if (objIndex >= 0) {
+						isHit |= intersectTriangle(ray, objects[objIndex].triangle, tMax);
+					}
+				}
+
+				for (int childNode : { node.leftNode, node.rightNode }) {
+					if (childNode >= 0) {
+						stack.push_back(childNode);
+					}
+				}
+			}
+
+			return isHit ? tMax : -1.0f;
+		}
+
+		// walks the whole tree once: every node has to be reached exactly once and every object has to sit in exactly one leaf
+		void checkTreeShape(const std::vector<BvhNode> &nodes, size_t objectCount, const std::string &name) {
+			check(!nodes.empty(), name + ": empty tree");
+
+			std::vector<uint32_t> nodeVisits(nodes.size(), 0);
+			std::vector<uint32_t> objectVisits(objectCount, 0);
+			std::vector<int> stack{0};
+
+			while (!stack.empty()) {
+				int currentNode = stack.back();
+				stack.pop_back();
+
+				check(currentNode >= 0 && currentNode < static_cast<int>(nodes.size()), name + ": child index out of range");
+				check(++nodeVisits[currentNode] == 1, name + ": node " + std::to_string(currentNode) + " is reached twice");
+
+				const BvhNode &node = nodes[currentNode];
+
+				for (int objIndex : { node.leftObjIndex, node.rightObjIndex }) {
+					if (objIndex >= 0) {
+						check(objIndex < static_cast<int>(objectCount), name + ": object index out of range");
+						objectVisits[objIndex]++;
+					}
+				}
+
+				for (int childNode : { node.leftNode, node.rightNode }) {
+					if (childNode >= 0) {
+						check(childNode > currentNode, name + ": child " + std::to_string(childNode) + " is stored before its parent");
+						stack.push_back(childNode);
+					}
+				}
+			}
+
+			for (size_t i = 0; i < nodes.size(); i++) {
+				check(nodeVisits[i] == 1, name + ": node " + std::to_string(i) + " is not reachable from the root");
+			}
+
+			for (size_t i = 0; i < objectCount; i++) {
+				check(objectVisits[i] == 1, name + ": object " + std::to_string(i) + " is in " + std::to_string(objectVisits[i]) + " leaves");
+			}
+		}
+
+		void testLbvhHitsMatchMedianSplit() {
+			std::vector<Object> objects = createRandomObjects(3000, 10.0f, 0.6f, 7);
+			std::vector<BvhNode> medianSplitNodes = createMedianSplitBvh(objects);
+
+			std::mt19937 generator{11};
+			std::uniform_real_distribution<float> distribution{-1.0f, 1.0f};
+
+			for (auto width : { MortonCodeWidth::Bits30, MortonCodeWidth::Bits63 }) {
+				for (uint32_t treeletRounds : { 0u, 2u }) {
+					LbvhConfigInfo configInfo{};
+					configInfo.mortonCodeWidth = width;
+					configInfo.treeletRounds = treeletRounds;
+
+					std::string name = std::string{"lbvh "} + (width == MortonCodeWidth::Bits30 ? "30" : "63") + " bit, " + std::to_string(treeletRounds) + " treelet rounds";
+					std::vector<BvhNode> lbvhNodes = createLbvh(objects, configInfo);
+					checkTreeShape(lbvhNodes, objects.size(), name);
+
+					for (uint32_t i = 0; i < 2000; i++) {
+						glm::vec3 origin = 20.0f * glm::vec3{distribution(generator), distribution(generator), distribution(generator)};
+						glm::vec3 target = 8.0f * glm::vec3{distribution(generator), distribution(generator), distribution(generator)};
+						TestRay ray{ origin, glm::normalize(target - origin) };
+
+						float bruteForceHit = traceBruteForce(objects, ray);
+						float medianSplitHit = traceBvh(medianSplitNodes, objects, ray);
+						float lbvhHit = traceBvh(lbvhNodes, objects, ray);
+
+						check(medianSplitHit == bruteForceHit, "median split: ray " + std::to_string(i) + " misses the closest hit");
+						check(lbvhHit == medianSplitHit, name + ": ray " + std::to_string(i) + " hits at " + std::to_string(lbvhHit) + " instead of " + std::to_string(medianSplitHit));
+					}
+				}
+			}
+		}
+
+		void testLbvhDuplicateMortonCodes() {
+			// a few cells hold hundreds of centroids each, so long runs of equal codes have to be split by index
+			std::vector<Object> objects = createRandomObjects(4, 1.0f, 0.2f, 3);
+			std::vector<Object> duplicated;
+
+			for (uint32_t i = 0; i < 1001; i++) {
+				duplicated.emplace_back(objects[i % objects.size()]);
+			}
+
+			for (uint32_t count : { 1u, 2u, 3u, 1001u }) {
+				std::vector<Object> subset{duplicated.begin(), duplicated.begin() + count};
+
+				for (auto width : { MortonCodeWidth::Bits30, MortonCodeWidth::Bits63 }) {
+					LbvhConfigInfo configInfo{};
+					configInfo.mortonCodeWidth = width;
+
+					checkTreeShape(createLbvh(subset, configInfo), subset.size(), "lbvh duplicates, " + std::to_string(count) + " objects");
+				}
+			}
+		}
+
+		void testObjVertexTable() {
+			std::mt19937 generator{5};
+			std::uniform_int_distribution<int> distribution{-1, 40};
+
+			std::vector<TestIndex> triples;
+			for (uint32_t i = 0; i < 50000; i++) {
+				triples.push_back({ distribution(generator), distribution(generator) / 8, distribution(generator) / 4 });
+			}
+
+			ObjVertexTable<TestIndex> vertexTable{triples.size()};
+			std::map<std::tuple<int, int, int>, uint32_t> reference;
+
+			for (auto &&triple : triples) {
+				auto key = std::make_tuple(triple.vertex_index, triple.normal_index, triple.texcoord_index);
+				auto [referenceIterator, isReferenceNew] = reference.emplace(key, static_cast<uint32_t>(reference.size()));
+				auto [vertex, isNew] = vertexTable.insert(triple);
+
+				check(isNew == isReferenceNew, "obj vertex table: wrong new flag");
+				check(vertex == referenceIterator->second, "obj vertex table: vertex " + std::to_string(vertex) + " instead of " + std::to_string(referenceIterator->second));
+			}
+		}
+
+		// triangles rotated so the smallest index comes first, the winding stays
+		std::vector<std::tuple<uint32_t, uint32_t, uint32_t>> getSortedTriangles(const std::vector<uint32_t> &indices) {
+			std::vector<std::tuple<uint32_t, uint32_t, uint32_t>> triangles;
+
+			for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+				uint32_t a = indices[i], b = indices[i + 1], c = indices[i + 2];
+
+				if (b < a && b <= c) {
+					triangles.emplace_back(b, c, a);
+				} else if (c < a && c < b) {
+					triangles.emplace_back(c, a, b);
+				} else {
+					triangles.emplace_back(a, b, c);
+				}
+			}
+
+			std::sort(triangles.begin(), triangles.end());
+			return triangles;
+		}
+
+		void testMeshOptimizers() {
+			const uint32_t gridSize = 64;
+
+			std::vector<glm::vec3> positions;
+			for (uint32_t y = 0; y <= gridSize; y++) {
+				for (uint32_t x = 0; x <= gridSize; x++) {
+					float angle = static_cast<float>(x) / gridSize * 6.2831853f;
+					positions.emplace_back(std::cos(angle), static_cast<float>(y) / gridSize, std::sin(angle));
+				}
+			}
+
+			std::vector<uint32_t> indices;
+			for (uint32_t y = 0; y < gridSize; y++) {
+				for (uint32_t x = 0; x < gridSize; x++) {
+					uint32_t corner = y * (gridSize + 1) + x;
+					indices.insert(indices.end(), { corner, corner + 1, corner + gridSize + 1, corner + 1, corner + gridSize + 2, corner + gridSize + 1 });
+				}
+			}
+
+			// shuffle the triangles so the optimizer has something to do
+			std::vector<uint32_t> triangleOrder(indices.size() / 3);
+			for (uint32_t i = 0; i < triangleOrder.size(); i++) {
+				triangleOrder[i] = i;
+			}
+
+			std::shuffle(triangleOrder.begin(), triangleOrder.end(), std::mt19937{9});
+
+			std::vector<uint32_t> shuffled;
+			for (uint32_t triangle : triangleOrder) {
+				shuffled.insert(shuffled.end(), { indices[3 * triangle], indices[3 * triangle + 1], indices[3 * triangle + 2] });
+			}
+
+			auto expected = getSortedTriangles(shuffled);
+
+			std::vector<uint32_t> cacheOptimized = optimizeVertexCache(shuffled, positions.size());
+			check(cacheOptimized.size() == shuffled.size(), "optimizeVertexCache: index count changed");
+			check(getSortedTriangles(cacheOptimized) == expected, "optimizeVertexCache: output is not a permutation of the input triangles");
+
+			float shuffledAcmr = analyzeVertexCache(shuffled, positions.size()).acmr;
+			float optimizedAcmr = analyzeVertexCache(cacheOptimized, positions.size()).acmr;
+			check(optimizedAcmr < shuffledAcmr, "optimizeVertexCache: ACMR " + std::to_string(optimizedAcmr) + " is not below " + std::to_string(shuffledAcmr));
+
+			std::vector<uint32_t> overdrawOptimized = optimizeOverdraw(cacheOptimized, positions);
+			check(overdrawOptimized.size() == shuffled.size(), "optimizeOverdraw: index count changed");
+			check(getSortedTriangles(overdrawOptimized) == expected, "optimizeOverdraw: output is not a permutation of the input triangles");
+		}
+
+		void checkSameHit(const CpuHit &hit, const CpuHit &expected, const std::string &name) {
+			check(hit.objIndex == expected.objIndex, name + " hits object " + std::to_string(hit.objIndex) + " instead of " + std::to_string(expected.objIndex));
+
+			// the SIMD kernels may contract the triangle test into FMAs
+			if (expected.isHit()) {
+				check(std::abs(hit.t - expected.t) <= 1e-4f * std::max(1.0f, expected.t), name + " hits at " + std::to_string(hit.t) + " instead of " + std::to_string(expected.t));
+			}
+		}
+
+		void testCpuBvhIsasMatchScalar() {
+			std::vector<Object> objects = createRandomObjects(3000, 10.0f, 0.6f, 13);
+			EngineCpuBvh bvh{objects, createMedianSplitBvh(objects)};
+
+			std::mt19937 generator{17};
+			std::uniform_real_distribution<float> distribution{-1.0f, 1.0f};
+			std::uniform_real_distribution<float> distance{1.0f, 40.0f};
+
+			// packets share an origin and aim at nearby targets, like the primary rays of a tile. A random tMax
+			// ends some rays in front of their hit, so occluded sees both outcomes
+			constexpr uint32_t packetCount = 256;
+			std::vector<CpuRay> rays(packetCount * 8);
+
+			for (uint32_t packet = 0; packet < packetCount; packet++) {
+				glm::vec3 origin = 20.0f * glm::vec3{distribution(generator), distribution(generator), distribution(generator)};
+				glm::vec3 target = 8.0f * glm::vec3{distribution(generator), distribution(generator), distribution(generator)};
+
+				for (uint32_t i = 0; i < 8; i++) {
+					glm::vec3 jitter = 0.5f * glm::vec3{distribution(generator), distribution(generator), distribution(generator)};
+
+					CpuRay &ray = rays[packet * 8 + i];
+					ray.origin = origin;
+					ray.direction = glm::normalize(target + jitter - origin);
+					ray.tMax = distance(generator);
+				}
+			}
+
+			bvh.setIsa(CpuIsa::Scalar);
+
+			std::vector<CpuHit> expectedHits(rays.size()), expectedHits4(rays.size()), expectedHits8(rays.size());
+			std::vector<bool> expectedOccluded(rays.size());
+
+			for (size_t i = 0; i < rays.size(); i++) {
+				expectedHits[i] = bvh.intersect(rays[i]);
+				expectedOccluded[i] = bvh.occluded(rays[i]);
+			}
+
+			for (size_t i = 0; i < rays.size(); i += 4) {
+				bvh.intersect4(&rays[i], &expectedHits4[i]);
+			}
+
+			for (size_t i = 0; i < rays.size(); i += 8) {
+				bvh.intersect8(&rays[i], &expectedHits8[i]);
+			}
+
+			for (auto isa : { CpuIsa::SSE, CpuIsa::AVX2, CpuIsa::AVX512 }) {
+				// nothing to compare on a CPU without the ISA, setIsa would fall back to a narrower kernel
+				if (!EngineCpuBvh::isIsaSupported(isa)) {
+					continue;
+				}
+
+				bvh.setIsa(isa);
+				std::string name = EngineCpuBvh::getIsaName(isa);
+				check(bvh.getIsa() == isa, name + ": setIsa picked " + EngineCpuBvh::getIsaName(bvh.getIsa()));
+
+				std::vector<CpuHit> hits4(rays.size()), hits8(rays.size());
+
+				for (size_t i = 0; i < rays.size(); i += 4) {
+					bvh.intersect4(&rays[i], &hits4[i]);
+				}
+
+				for (size_t i = 0; i < rays.size(); i += 8) {
+					bvh.intersect8(&rays[i], &hits8[i]);
+				}
+
+				for (size_t i = 0; i < rays.size(); i++) {
+					std::string rayName = name + ": ray " + std::to_string(i);
+
+					checkSameHit(bvh.intersect(rays[i]), expectedHits[i], rayName);
+					checkSameHit(hits4[i], expectedHits4[i], rayName + " in a packet of 4");
+					checkSameHit(hits8[i], expectedHits8[i], rayName + " in a packet of 8");
+					check(bvh.occluded(rays[i]) == expectedOccluded[i], rayName + " occlusion differs");
+				}
+			}
+		}
+	} // namespace
+} // namespace nugiEngine
+
+int main() {
+	const std::vector<std::pair<const char*, std::function<void()>>> tests = {
+		{ "lbvh_hits_match_median_split", nugiEngine::testLbvhHitsMatchMedianSplit },
+		{ "lbvh_duplicate_morton_codes", nugiEngine::testLbvhDuplicateMortonCodes },
+		{ "obj_vertex_table", nugiEngine::testObjVertexTable },
+		{ "mesh_optimizers", nugiEngine::testMeshOptimizers },
+		{ "cpu_bvh_isas_match_scalar", nugiEngine::testCpuBvhIsasMatchScalar }
+	};
+
+	int failedCount = 0;
+
+	for (auto &&[name, test] : tests) {
+		try {
+			test();
+			std::cout << "[ok]   " << name << '\n';
+		} catch (const std::exception &e) {
+			std::cerr << "[fail] " << name << ": " << e.what() << '\n';
+			failedCount++;
+		}
+	}
+
+	return failedCount == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
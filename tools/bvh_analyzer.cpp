@@ -0,0 +1,137 @@
+// Reports the quality of the BVH the engine builds for a scene: SAH cost, depth, leaf sizes, overlap, empty space
+// and the node visits of sampled rays, counted the way the compute shader walks the tree.
+//
+// bvh_analyzer.out [--scene app|random|sphere|cornell] [--size 10000] [--mesh file.obj] [--builder median_split|lbvh|lbvh_treelet]
+//                  [--rays 100000] [--json 1]
+
+#include "../bench/mesh_generator.hpp"
+
+#include "../src/model/bvh.hpp"
+#include "../src/model/bvh_analysis.hpp"
+#include "../src/model/lbvh.hpp"
+#include "../src/scene/scene.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace nugiEngine {
+	namespace {
+		struct AnalyzerConfigInfo {
+			std::string scene = "app";
+			uint32_t size = 10000;
+			std::string meshPath;
+			std::string builder = "median_split";
+			uint32_t rayCount = 100000;
+			bool isJson = false;
+		};
+
+		AnalyzerConfigInfo parseArguments(int argc, char const *argv[]) {
+			AnalyzerConfigInfo configInfo{};
+
+			for (int i = 1; i < argc; i++) {
+				std::string argument = argv[i];
+				if (i + 1 >= argc) {
+					throw std::invalid_argument("missing value for " + argument);
+				}
+
+				std::string value = argv[++i];
+
+				if (argument == "--scene") {
+					configInfo.scene = value;
+				} else if (argument == "--size") {
+					configInfo.size = static_cast<uint32_t>(std::stoul(value));
+				} else if (argument == "--mesh") {
+					configInfo.meshPath = value;
+				} else if (argument == "--builder") {
+					configInfo.builder = value;
+				} else if (argument == "--rays") {
+					configInfo.rayCount = static_cast<uint32_t>(std::stoul(value));
+				} else if (argument == "--json") {
+					configInfo.isJson = value != "0";
+				} else {
+					throw std::invalid_argument("unknown argument: " + argument);
+				}
+			}
+
+			return configInfo;
+		}
+
+		RayTraceModelData loadScene(const AnalyzerConfigInfo &configInfo) {
+			if (!configInfo.meshPath.empty()) {
+				return loadObjMesh(configInfo.meshPath);
+			}
+
+			if (configInfo.scene == "app") {
+				return createCornellBoxScene();
+			} else if (configInfo.scene == "random") {
+				return generateRandomTriangles(configInfo.size);
+			} else if (configInfo.scene == "sphere") {
+				return generateSphere(configInfo.size);
+			} else if (configInfo.scene == "cornell") {
+				return generateCornellBox(configInfo.size);
+			}
+
+			throw std::invalid_argument("unknown scene: " + configInfo.scene);
+		}
+
+		std::vector<BvhNode> buildBvh(const AnalyzerConfigInfo &configInfo, const RayTraceModelData &data) {
+			if (configInfo.builder == "median_split") {
+				std::vector<ObjectBoundBox> objects;
+				objects.reserve(data.objects.size());
+
+				for (int i = 0; i < static_cast<int>(data.objects.size()); i++) {
+					objects.push_back({i, data.objects[i]});
+				}
+
+				return createBvh(objects);
+			}
+
+			LbvhConfigInfo lbvhInfo{};
+			if (configInfo.builder == "lbvh_treelet") {
+				lbvhInfo.treeletRounds = 3;
+			} else if (configInfo.builder != "lbvh") {
+				throw std::invalid_argument("unknown builder: " + configInfo.builder);
+			}
+
+			return createLbvh(data.objects, lbvhInfo);
+		}
+	}
+} // namespace nugiEngine
+
+int main(int argc, char const *argv[])
+{
+	using namespace nugiEngine;
+
+	try {
+		AnalyzerConfigInfo configInfo = parseArguments(argc, argv);
+		RayTraceModelData data = loadScene(configInfo);
+
+		auto bvhNodes = buildBvh(configInfo, data);
+
+		BvhAnalysisConfigInfo analysisInfo{};
+		analysisInfo.sampledRayCount = configInfo.rayCount;
+
+		auto statistics = analyzeBvh(bvhNodes, data.objects, analysisInfo);
+
+		if (configInfo.isJson) {
+			statistics.writeJson(std::cout);
+			std::cout << "\n";
+		} else {
+			statistics.print(std::cout);
+		}
+
+		// a tree the compute shader can't traverse completely is an error for scripts checking builder changes
+		if (statistics.maxStackDepth > GPU_BVH_STACK_SIZE) {
+			return EXIT_FAILURE;
+		}
+	} catch (const std::exception &e) {
+		std::cerr << e.what() << "\n";
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,126 @@
+#!/usr/bin/env python3
+"""
+Compiles every shader under src/shader/ to SPIR-V and embeds the modules into
+src/shader_library/embedded_shaders.inc, so the engine never has to read a .spv at startup.
+
+The modules are also written to bin/shader/ (or --spirv-dir), which is where the hot reloader keeps them.
+Specialization constants are resolved when the pipeline is created, so only the
+preprocessor variants listed in VARIANTS need a module of their own.
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+
+ROOT_DIR = os.path.normpath(os.path.join(os.path.dirname(os.path.abspath(__file__)), ".."))
+SHADER_DIR = os.path.join(ROOT_DIR, "src", "shader")
+SPIRV_DIR = os.path.join(ROOT_DIR, "bin", "shader")
+OUTPUT_PATH = os.path.join(ROOT_DIR, "src", "shader_library", "embedded_shaders.inc")
+
+STAGES = (".vert", ".frag", ".comp")
+
+# source file -> extra modules compiled from it, as (module name, defines)
+VARIANTS = {
+    "ray_trace_pbrt.comp": [("ray_trace_pbrt_bda.comp", ["USE_BUFFER_REFERENCE"])],
+    "simple_texture_shader.frag": [("simple_texture_shader_single.frag", ["NO_BINDLESS"])],
+}
+
+
+def collect_modules():
+    modules = []
+
+    for fileName in sorted(os.listdir(SHADER_DIR)):
+        if not fileName.endswith(STAGES):
+            continue
+
+        modules.append((fileName, fileName, []))
+        for variantName, defines in VARIANTS.get(fileName, []):
+            modules.append((fileName, variantName, defines))
+
+    return modules
+
+
+def compile_module(glslc, spirvDir, sourceName, moduleName, defines):
+    spirvPath = os.path.join(spirvDir, moduleName + ".spv")
+    command = [glslc, "--target-env=vulkan1.2", "-O"]
+    command += ["-D" + define for define in defines]
+    command += [os.path.join(SHADER_DIR, sourceName), "-o", spirvPath]
+
+    if subprocess.call(command) != 0:
+        return None
+
+    with open(spirvPath, "rb") as spirvFile:
+        return spirvFile.read()
+
+
+def to_identifier(moduleName):
+    return "spirv_" + moduleName.replace(".", "_")
+
+
+def write_table(entries, outputPath):
+    lines = [
+        "// generated by tools/embed_shaders.py, do not edit",
+        "",
+    ]
+
+    for moduleName, code in entries:
+        words = [int.from_bytes(code[i:i + 4], "little") for i in range(0, len(code), 4)]
+        lines.append("static constexpr uint32_t {}[] = {{".format(to_identifier(moduleName)))
+
+        for i in range(0, len(words), 8):
+            lines.append("\t" + ", ".join("0x{:08x}".format(word) for word in words[i:i + 8]) + ",")
+
+        lines.append("};")
+        lines.append("")
+
+    # kept sorted by path, the lookup is a binary search
+    lines.append("static constexpr EmbeddedShader embeddedShaders[] = {")
+    for path, identifier in sorted(("shader/{}.spv".format(moduleName), to_identifier(moduleName)) for moduleName, _ in entries):
+        lines.append("\t{{ \"{}\", {}, sizeof({}) }},".format(path, identifier, identifier))
+    lines.append("};")
+    lines.append("")
+
+    content = "\n".join(lines)
+
+    # an unchanged table keeps its timestamp, so make does not rebuild the engine for nothing
+    if os.path.exists(outputPath):
+        with open(outputPath, "r") as outputFile:
+            if outputFile.read() == content:
+                return
+
+    with open(outputPath + ".tmp", "w") as outputFile:
+        outputFile.write(content)
+    os.replace(outputPath + ".tmp", outputPath)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--glslc", default="glslc", help="path of the glslc executable")
+    parser.add_argument("--output", default=OUTPUT_PATH, help="path of the generated table")
+    parser.add_argument("--spirv-dir", default=SPIRV_DIR, help="directory the compiled modules are written to")
+    args = parser.parse_args()
+
+    os.makedirs(args.spirv_dir, exist_ok=True)
+
+    entries = []
+    failedModules = []
+
+    for sourceName, moduleName, defines in collect_modules():
+        code = compile_module(args.glslc, args.spirv_dir, sourceName, moduleName, defines)
+        if code is None or len(code) % 4 != 0:
+            failedModules.append(moduleName)
+            continue
+
+        entries.append((moduleName, code))
+
+    if failedModules:
+        print("embed_shaders: failed to compile " + ", ".join(failedModules), file=sys.stderr)
+        return 1
+
+    write_table(entries, args.output)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())